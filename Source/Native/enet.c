@@ -21,5 +21,9 @@
  *  SOFTWARE.
  */
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+	#define _GNU_SOURCE
+#endif
+
 #define ENET_IMPLEMENTATION
 #include "enet.h"
\ No newline at end of file
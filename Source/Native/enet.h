@@ -60,6 +60,7 @@
 	#ifndef ENET_NO_PRAGMA_LINK
 		#pragma comment(lib, "ws2_32.lib")
 		#pragma comment(lib, "winmm.lib")
+		#pragma comment(lib, "advapi32.lib")
 	#endif
 
 	#if _MSC_VER >= 1910
@@ -77,6 +78,7 @@
 		#include <timezoneapi.h>
 		#include <profileapi.h>
 		#include <sysinfoapi.h>
+		#include <fibersapi.h>
 	#else
 		#define WIN32_LEAN_AND_MEAN
 	#endif
@@ -130,6 +132,7 @@
 	#include <string.h>
 	#include <errno.h>
 	#include <fcntl.h>
+	#include <pthread.h>
 
 	#ifdef __APPLE__
 		#include <mach/clock.h>
@@ -145,6 +148,54 @@
 		#define ENET_BUFFER_MAXIMUM MSG_MAXIOVLEN
 	#endif
 
+	#if defined(__linux__) && (defined(_GNU_SOURCE) || defined(__ANDROID__)) && !defined(ENET_NO_MMSG)
+		#define ENET_HAS_MMSG
+	#endif
+
+	#if defined(ENET_HAS_MMSG) && !defined(ENET_NO_SEGMENT)
+		#include <netinet/udp.h>
+
+		#ifndef UDP_SEGMENT
+			#define UDP_SEGMENT 103
+		#endif
+
+		#ifndef UDP_GRO
+			#define UDP_GRO 104
+		#endif
+
+		#define ENET_HAS_SEGMENT
+		#define ENET_SEGMENT_MAXIMUM_SIZE 65000
+		#define ENET_SEGMENT_MAXIMUM_COUNT 64
+		#define ENET_SEGMENT_MAXIMUM_BUFFERS 1024
+		#define ENET_SEGMENT_RECEIVE_SIZE 65535
+	#endif
+
+	#if defined(ENET_HAS_MMSG) && !defined(ENET_NO_TXTIME)
+		#ifndef SO_TXTIME
+			#define SO_TXTIME 61
+		#endif
+
+		#ifndef SCM_TXTIME
+			#define SCM_TXTIME SO_TXTIME
+		#endif
+
+		#define ENET_HAS_TXTIME
+	#endif
+
+	#if defined(__linux__) && !defined(ENET_NO_URING) && defined(__has_include)
+		#if __has_include(<linux/io_uring.h>)
+			#include <linux/io_uring.h>
+			#include <sys/mman.h>
+			#include <sys/syscall.h>
+
+			#if defined(IORING_RECV_MULTISHOT) && defined(IORING_ENTER_EXT_ARG)
+				#define ENET_HAS_URING
+				#define ENET_URING_BUFFER_COUNT 256
+				#define ENET_URING_COMPLETION_ENTRIES 1024
+			#endif
+		#endif
+	#endif
+
 	typedef int ENetSocket;
 
 	#define ENET_SOCKET_NULL -1
@@ -162,6 +213,54 @@
 	#define ENET_BUFFER_MAXIMUM (1 + 2 * ENET_PROTOCOL_MAXIMUM_PACKET_COMMANDS)
 #endif
 
+#ifndef ENET_HOST_RECEIVE_BATCH
+	#ifdef ENET_HAS_MMSG
+		#define ENET_HOST_RECEIVE_BATCH 32
+	#else
+		#define ENET_HOST_RECEIVE_BATCH 1
+	#endif
+#endif
+
+#ifndef ENET_HOST_SEND_BATCH
+	#ifdef ENET_HAS_MMSG
+		#define ENET_HOST_SEND_BATCH 32
+	#else
+		#define ENET_HOST_SEND_BATCH 1
+	#endif
+#endif
+
+#if (defined(__x86_64__) || defined(_M_X64)) && !defined(ENET_NO_PCLMUL)
+	#if defined(_MSC_VER)
+		#define ENET_HAS_PCLMUL
+		#define ENET_PCLMUL_TARGET
+	#elif defined(__GNUC__) || defined(__clang__)
+		#include <cpuid.h>
+		#include <immintrin.h>
+
+		#define ENET_HAS_PCLMUL
+		#define ENET_PCLMUL_TARGET __attribute__((target("pclmul,sse2")))
+	#endif
+#endif
+
+#if (defined(__x86_64__) || defined(_M_X64)) && !defined(ENET_NO_SSE42)
+	#if defined(_MSC_VER)
+		#define ENET_HAS_SSE42
+		#define ENET_SSE42_TARGET
+	#elif defined(__GNUC__) || defined(__clang__)
+		#include <cpuid.h>
+		#include <immintrin.h>
+
+		#define ENET_HAS_SSE42
+		#define ENET_SSE42_TARGET __attribute__((target("sse4.2")))
+	#endif
+#endif
+
+#if (defined(__x86_64__) || defined(_M_X64)) && !defined(ENET_NO_SSE2)
+	#include <emmintrin.h>
+
+	#define ENET_HAS_SSE2
+#endif
+
 #define ENET_HOST_ANY in6addr_any
 #define ENET_PORT_ANY 0
 #define ENET_HOST_SIZE 1025
@@ -265,19 +364,42 @@ extern "C" {
 		ENET_PROTOCOL_COMMAND_BANDWIDTH_LIMIT          = 10,
 		ENET_PROTOCOL_COMMAND_THROTTLE_CONFIGURE       = 11,
 		ENET_PROTOCOL_COMMAND_SEND_UNRELIABLE_FRAGMENT = 12,
-		ENET_PROTOCOL_COMMAND_COUNT                    = 13,
+		ENET_PROTOCOL_COMMAND_SELECTIVE_ACKNOWLEDGE    = 13,
+		ENET_PROTOCOL_COMMAND_PROBE                    = 14,
+		ENET_PROTOCOL_COMMAND_PIECE                    = 15,
+		ENET_PROTOCOL_COMMAND_COUNT                    = 16,
 		ENET_PROTOCOL_COMMAND_MASK                     = 0x0F
 	} ENetProtocolCommand;
 
 	typedef enum _ENetProtocolFlag {
 		ENET_PROTOCOL_COMMAND_FLAG_ACKNOWLEDGE = (1 << 7),
 		ENET_PROTOCOL_COMMAND_FLAG_UNSEQUENCED = (1 << 6),
+		ENET_PROTOCOL_COMMAND_FLAG_AGGREGATED  = (1 << 5),
+		ENET_PROTOCOL_HEADER_FLAG_COMPRESSED   = (1 << 15),
 		ENET_PROTOCOL_HEADER_FLAG_SENT_TIME    = (1 << 14),
-		ENET_PROTOCOL_HEADER_FLAG_MASK         = ENET_PROTOCOL_HEADER_FLAG_SENT_TIME,
+		ENET_PROTOCOL_HEADER_FLAG_MASK         = ENET_PROTOCOL_HEADER_FLAG_COMPRESSED | ENET_PROTOCOL_HEADER_FLAG_SENT_TIME,
 		ENET_PROTOCOL_HEADER_SESSION_MASK      = (3 << 12),
 		ENET_PROTOCOL_HEADER_SESSION_SHIFT     = 12
 	} ENetProtocolFlag;
 
+	/* Capabilities are offered in the bits of the connect channel count above the channel number. Hosts predating
+	them refuse a connect offering any without an answer. A client whose host enabled enet_host_set_legacy_connect
+	offers none once its connect stayed unanswered for ENET_PEER_LEGACY_CONNECT_DELAY, and a server answers such a
+	client with a plain channel count. The checksum and dictionary fields fall back the same way, an encrypting
+	client never does. Without the flag the connect keeps its capabilities until it times out. The public key of an
+	encrypting client and the 32-bit ID of a compression dictionary follow the connect in that order */
+	typedef enum _ENetProtocolCapability {
+		ENET_PROTOCOL_CAPABILITY_SELECTIVE_ACKNOWLEDGE = (1 << 8),
+		ENET_PROTOCOL_CAPABILITY_AGGREGATION           = (1 << 9),
+		ENET_PROTOCOL_CAPABILITY_PATH_MTU              = (1 << 10),
+		ENET_PROTOCOL_CAPABILITY_COMPRESSION           = (1 << 11),
+		ENET_PROTOCOL_CAPABILITY_DICTIONARY            = (1 << 12),
+		ENET_PROTOCOL_CAPABILITY_CHECKSUM_MASK         = (0x0F << 24),
+		ENET_PROTOCOL_CAPABILITY_CHECKSUM_SHIFT        = 24,
+		ENET_PROTOCOL_CAPABILITY_ENCRYPTION            = (1 << 28),
+		ENET_PROTOCOL_CAPABILITY_MASK                  = ~0xFF
+	} ENetProtocolCapability;
+
 	#ifdef _MSC_VER
 		#pragma pack(push, 1)
 		#define ENET_PACKED
@@ -304,6 +426,30 @@ extern "C" {
 		uint16_t receivedSentTime;
 	} ENET_PACKED ENetProtocolAcknowledge;
 
+	/* The reliable sequence number of the header carries the last command the receiver delivered in order on the channel */
+	typedef struct _ENetProtocolSelectiveAcknowledge {
+		ENetProtocolCommandHeader header;
+		uint16_t receivedReliableSequenceNumber;
+		uint16_t receivedSentTime;
+		uint32_t receivedMask;
+	} ENET_PACKED ENetProtocolSelectiveAcknowledge;
+
+	/* A probe is padded to probeLength, the reply echoes it back in receivedLength */
+	typedef struct _ENetProtocolProbe {
+		ENetProtocolCommandHeader header;
+		uint16_t probeSequenceNumber;
+		uint16_t probeLength;
+		uint16_t receivedLength;
+	} ENET_PACKED ENetProtocolProbe;
+
+	/* A slice of a reliable command that no longer fits the MTU, the command as sent whole followed by its data */
+	typedef struct _ENetProtocolPiece {
+		ENetProtocolCommandHeader header;
+		uint16_t pieceOffset;
+		uint16_t pieceLength;
+		uint16_t totalLength;
+	} ENET_PACKED ENetProtocolPiece;
+
 	typedef struct _ENetProtocolConnect {
 		ENetProtocolCommandHeader header;
 		uint16_t outgoingPeerID;
@@ -389,6 +535,9 @@ extern "C" {
 	typedef union _ENetProtocol {
 		ENetProtocolCommandHeader header;
 		ENetProtocolAcknowledge acknowledge;
+		ENetProtocolSelectiveAcknowledge selectiveAcknowledge;
+		ENetProtocolProbe probe;
+		ENetProtocolPiece piece;
 		ENetProtocolConnect connect;
 		ENetProtocolVerifyConnect verifyConnect;
 		ENetProtocolDisconnect disconnect;
@@ -436,7 +585,12 @@ extern "C" {
 		ENET_SOCKOPT_ERROR       = 8,
 		ENET_SOCKOPT_NODELAY     = 9,
 		ENET_SOCKOPT_IPV6_V6ONLY = 10,
-		ENET_SOCKOPT_TTL = 11
+		ENET_SOCKOPT_TTL = 11,
+		ENET_SOCKOPT_SEGMENT = 12,
+		ENET_SOCKOPT_GRO = 13,
+		ENET_SOCKOPT_REUSEPORT = 14,
+		ENET_SOCKOPT_TXTIME = 15,
+		ENET_SOCKOPT_DONTFRAGMENT = 16
 	} ENetSocketOption;
 
 	typedef enum _ENetSocketShutdown {
@@ -477,11 +631,14 @@ extern "C" {
 		ENetPacketFreeCallback freeCallback;
 		uint32_t referenceCount;
 		void* userData;
+		int sizeClass;
+		void* owner;
 	} ENetPacket;
 
 	typedef struct _ENetAcknowledgement {
 		ENetListNode acknowledgementList;
 		uint32_t sentTime;
+		uint32_t queueTime;
 		ENetProtocol command;
 	} ENetAcknowledgement;
 
@@ -492,9 +649,13 @@ extern "C" {
 		uint32_t sentTime;
 		uint32_t roundTripTimeout;
 		uint32_t queueTime;
+		uint32_t sendOrder;
 		uint32_t fragmentOffset;
 		uint16_t fragmentLength;
 		uint16_t sendAttempts;
+		uint16_t skippedAcknowledgements;
+		uint16_t pieceOffset;
+		uint8_t inTransit;
 		ENetProtocol command;
 		ENetPacket* packet;
 	} ENetOutgoingCommand;
@@ -507,6 +668,7 @@ extern "C" {
 		uint32_t fragmentCount;
 		uint32_t fragmentsRemaining;
 		uint32_t* fragments;
+		uint32_t aggregateOffset;
 		ENetPacket* packet;
 	} ENetIncomingCommand;
 
@@ -530,6 +692,13 @@ extern "C" {
 		ENET_HOST_DEFAULT_MTU                  = 1280,
 		ENET_HOST_DEFAULT_MAXIMUM_PACKET_SIZE  = 32 * 1024 * 1024,
 		ENET_HOST_DEFAULT_MAXIMUM_WAITING_DATA = 32 * 1024 * 1024,
+		ENET_HOST_DEFAULT_POOL_HIGH_WATER_MARK = 1024,
+		ENET_HOST_TIMER_LEVELS                 = 4,
+		ENET_HOST_TIMER_SLOT_BITS              = 8,
+		ENET_HOST_TIMER_SLOTS                  = 1 << ENET_HOST_TIMER_SLOT_BITS,
+		ENET_HOST_DICTIONARY_MAXIMUM           = 32 * 1024,
+		ENET_PACKET_POOL_CLASSES               = 6,
+		ENET_PACKET_POOL_HIGH_WATER_MARK       = 1024,
 		ENET_PEER_DEFAULT_ROUND_TRIP_TIME      = 1,
 		ENET_PEER_DEFAULT_PACKET_THROTTLE      = 32,
 		ENET_PEER_PACKET_THROTTLE_THRESHOLD    = 40,
@@ -543,14 +712,79 @@ extern "C" {
 		ENET_PEER_TIMEOUT_MINIMUM              = 5000,
 		ENET_PEER_TIMEOUT_MAXIMUM              = 30000,
 		ENET_PEER_PING_INTERVAL                = 250,
+		ENET_PEER_LEGACY_CONNECT_DELAY         = 1000,
 		ENET_PEER_UNSEQUENCED_WINDOWS          = 64,
 		ENET_PEER_UNSEQUENCED_WINDOW_SIZE      = 1024,
 		ENET_PEER_FREE_UNSEQUENCED_WINDOWS     = 32,
 		ENET_PEER_RELIABLE_WINDOWS             = 16,
 		ENET_PEER_RELIABLE_WINDOW_SIZE         = 0x1000,
-		ENET_PEER_FREE_RELIABLE_WINDOWS        = 8
+		ENET_PEER_FREE_RELIABLE_WINDOWS        = 8,
+		ENET_PEER_RELIABLE_RING_MINIMUM        = 64,
+		ENET_PEER_RELIABLE_RING_MAXIMUM        = (ENET_PEER_FREE_RELIABLE_WINDOWS - 1) * ENET_PEER_RELIABLE_WINDOW_SIZE,
+		ENET_PEER_SELECTIVE_ACKNOWLEDGE_RANGE  = 32,
+		ENET_PEER_CONGESTION_INITIAL_WINDOW    = 10,
+		ENET_PEER_CONGESTION_MINIMUM_WINDOW    = 4,
+		ENET_PEER_CONGESTION_DELAY_TARGET      = 25,
+		ENET_PEER_CONGESTION_RTT_WINDOW        = 10000,
+		ENET_PEER_CONGESTION_BANDWIDTH_ROUNDS  = 10,
+		ENET_PEER_CONGESTION_STARTUP_ROUNDS    = 3,
+		ENET_PEER_CONGESTION_PROBE_PHASES      = 8,
+		ENET_PEER_PACING_BURST                 = 4,
+		ENET_PEER_PACING_QUANTUM               = 2,
+		ENET_PEER_PACING_HORIZON               = 25,
+		ENET_PEER_MTU_PROBE_COUNT              = 3,
+		ENET_PEER_MTU_PROBE_TIMEOUT            = 100,
+		ENET_PEER_MTU_PROBE_STEP               = 32,
+		ENET_PEER_MTU_PROBE_INTERVAL           = 600000,
+		ENET_PEER_MTU_BLACK_HOLE_LIMIT         = 3,
+		ENET_PEER_PIECE_UNIT                   = ENET_PROTOCOL_MAXIMUM_MTU / 64,
+		ENET_PEER_COMPRESSION_MINIMUM          = 64,
+		ENET_PEER_COMPRESSION_BYPASS_LIMIT     = 6,
+		ENET_PEER_CIPHER_KEY_SIZE              = 32,
+		ENET_PEER_CIPHER_COUNTER_SIZE          = 4,
+		ENET_PEER_CIPHER_TAG_SIZE              = 16,
+		ENET_PEER_CIPHER_OVERHEAD              = ENET_PEER_CIPHER_COUNTER_SIZE + ENET_PEER_CIPHER_TAG_SIZE,
+		ENET_PEER_CIPHER_REPLAY_WINDOW         = 64
 	};
 
+	typedef enum _ENetCongestionControlType {
+		ENET_CONGESTION_CONTROL_LEGACY = 0,
+		ENET_CONGESTION_CONTROL_DELAY  = 1,
+		ENET_CONGESTION_CONTROL_BBR    = 2
+	} ENetCongestionControlType;
+
+	typedef enum _ENetPacingMode {
+		ENET_PACING_NONE   = 0,
+		ENET_PACING_HOST   = 1,
+		ENET_PACING_KERNEL = 2
+	} ENetPacingMode;
+
+	typedef enum _ENetChecksumType {
+		ENET_CHECKSUM_NONE     = 0,
+		ENET_CHECKSUM_CRC64    = 1,
+		ENET_CHECKSUM_CRC32C   = 2,
+		ENET_CHECKSUM_XXHASH64 = 3,
+		ENET_CHECKSUM_COUNT
+	} ENetChecksumType;
+
+	typedef struct _ENetCongestionState {
+		uint32_t window;
+		uint32_t threshold;
+		uint32_t minimumRoundTripTime;
+		uint32_t minimumRoundTripTimeEpoch;
+		uint32_t bandwidth;
+		uint32_t bandwidthRound;
+		uint32_t fullBandwidth;
+		uint32_t fullBandwidthCount;
+		uint32_t delivered;
+		uint32_t deliveredTime;
+		uint32_t round;
+		uint32_t pacingRate;
+		uint32_t phase;
+		uint32_t lossEpoch;
+		void* context;
+	} ENetCongestionState;
+
 	typedef struct _ENetChannel {
 		uint16_t outgoingReliableSequenceNumber;
 		uint16_t outgoingUnreliableSequenceNumber;
@@ -558,16 +792,41 @@ extern "C" {
 		uint16_t reliableWindows[ENET_PEER_RELIABLE_WINDOWS];
 		uint16_t incomingReliableSequenceNumber;
 		uint16_t incomingUnreliableSequenceNumber;
-		ENetList incomingReliableCommands;
+		ENetIncomingCommand** incomingReliableCommands;
+		uint32_t incomingReliableCapacity;
 		ENetList incomingUnreliableCommands;
+		ENetOutgoingCommand** sentReliableCommands;
+		uint32_t sentReliableCapacity;
+		uint8_t aggregation;
 	} ENetChannel;
 
+	/* The secret key only lives until the handshake completes, each direction has its own key and counter */
+	typedef struct _ENetCipher {
+		uint8_t secretKey[ENET_PEER_CIPHER_KEY_SIZE];
+		uint8_t publicKey[ENET_PEER_CIPHER_KEY_SIZE];
+		uint8_t sendKey[ENET_PEER_CIPHER_KEY_SIZE];
+		uint8_t receiveKey[ENET_PEER_CIPHER_KEY_SIZE];
+		uint64_t sendCounter;
+		uint64_t receiveCounter;
+		uint64_t receiveWindow;
+		uint8_t keyed;
+	} ENetCipher;
+
 	typedef struct _ENetPeer {
 		ENetListNode dispatchList;
 		struct _ENetHost* host;
+		size_t activeIndex;
+		uint32_t indexHash;
+		uint8_t indexed;
+		ENetListNode pendingList;
+		ENetListNode timerList;
+		uint32_t timerDeadline;
 		uint16_t outgoingPeerID;
 		uint16_t incomingPeerID;
 		uint32_t connectID;
+		uint32_t capabilities;
+		uint8_t checksum;
+		uint8_t checksumConfirmed;
 		uint8_t outgoingSessionID;
 		uint8_t incomingSessionID;
 		ENetAddress address;
@@ -589,6 +848,7 @@ extern "C" {
 		uint32_t earliestTimeout;
 		uint64_t totalPacketsSent;
 		uint64_t totalPacketsLost;
+		uint64_t totalFastRetransmits;
 		uint32_t packetThrottle;
 		uint32_t packetThrottleThreshold;
 		uint32_t packetThrottleLimit;
@@ -598,6 +858,12 @@ extern "C" {
 		uint32_t packetThrottleDeceleration;
 		uint32_t packetThrottleInterval;
 		uint32_t pingInterval;
+		uint32_t fastRetransmit;
+		uint32_t sendOrder;
+		uint32_t acknowledgementDelay;
+		uint32_t acknowledgementThreshold;
+		uint32_t acknowledgementCount;
+		uint32_t remoteAcknowledgementHold;
 		uint32_t timeoutLimit;
 		uint32_t timeoutMinimum;
 		uint32_t timeoutMaximum;
@@ -613,6 +879,8 @@ extern "C" {
 		uint16_t outgoingReliableSequenceNumber;
 		ENetList acknowledgements;
 		ENetList sentReliableCommands;
+		ENetOutgoingCommand** sentControlCommands;
+		uint32_t sentControlCapacity;
 		ENetList outgoingSendReliableCommands;
 		ENetList outgoingCommands;
 		ENetList dispatchedCommands;
@@ -623,6 +891,24 @@ extern "C" {
 		uint32_t unsequencedWindow[ENET_PEER_UNSEQUENCED_WINDOW_SIZE / 32];
 		uint32_t eventData;
 		size_t totalWaitingData;
+		ENetCongestionState congestion;
+		int32_t pacingCredit;
+		uint32_t pacingTime;
+		uint16_t mtuProbeSize;
+		uint16_t mtuProbeLow;
+		uint16_t mtuProbeHigh;
+		uint16_t mtuProbeSequenceNumber;
+		uint32_t mtuProbeCount;
+		uint32_t mtuProbeTime;
+		uint32_t mtuLosses;
+		uint8_t* pieceData;
+		uint64_t pieceMask;
+		uint16_t pieceLength;
+		uint16_t pieceSequenceNumber;
+		uint8_t pieceChannelID;
+		uint8_t compressionBypass;
+		uint8_t compressionFailures;
+		ENetCipher* cipher;
 	} ENetPeer;
 
 	typedef enum _ENetEventType {
@@ -643,8 +929,72 @@ extern "C" {
 
 	typedef uint64_t (ENET_CALLBACK *ENetChecksumCallback)(const ENetBuffer* buffers, int bufferCount);
 
+	/* Any callback except onAcknowledge and getWindow may be left NULL */
+	typedef struct _ENetCongestionControl {
+		void (ENET_CALLBACK *initialize)(ENetPeer* peer);
+		void (ENET_CALLBACK *onAcknowledge)(ENetPeer* peer, uint32_t roundTripTime, uint32_t acknowledgedBytes);
+		void (ENET_CALLBACK *onLoss)(ENetPeer* peer, uint32_t lostBytes);
+		void (ENET_CALLBACK *onSend)(ENetPeer* peer, uint32_t sentBytes);
+		uint32_t (ENET_CALLBACK *getWindow)(ENetPeer* peer);
+		uint32_t (ENET_CALLBACK *getPacingRate)(ENetPeer* peer);
+	} ENetCongestionControl;
+
 	typedef int (ENET_CALLBACK *ENetInterceptCallback)(ENetEvent* event, ENetAddress* address, uint8_t* receivedData, int receivedDataLength);
 
+	typedef void (ENET_CALLBACK *ENetMtuCallback)(ENetPeer* peer, uint32_t mtu);
+
+	/* Both sides must install the same compressor, a zero result from either callback means failure */
+	typedef struct _ENetCompressor {
+		void* context;
+		size_t (ENET_CALLBACK *compress)(void* context, const ENetBuffer* inBuffers, size_t inBufferCount, size_t inLimit, uint8_t* outData, size_t outLimit);
+		size_t (ENET_CALLBACK *decompress)(void* context, const uint8_t* inData, size_t inLimit, uint8_t* outData, size_t outLimit);
+		void (ENET_CALLBACK *destroy)(void* context);
+	} ENetCompressor;
+
+	typedef enum _ENetHostBackend {
+		ENET_HOST_BACKEND_POLL = 0,
+		ENET_HOST_BACKEND_URING = 1
+	} ENetHostBackend;
+
+	typedef struct _ENetHostOptions {
+		ENetHostBackend backend;
+		int reusePort;
+		size_t poolHighWaterMark;
+		size_t packetPoolPrewarm;
+	} ENetHostOptions;
+
+	typedef struct _ENetPool {
+		void* freeList;
+		size_t objectSize;
+		size_t freeCount;
+		size_t highWaterMark;
+		uint64_t allocations;
+		uint64_t heapAllocations;
+		uint64_t heapFrees;
+	} ENetPool;
+
+	typedef struct _ENetPacketPoolStats {
+		size_t dataSize;
+		size_t freeCount;
+		size_t highWaterMark;
+		uint64_t allocations;
+		uint64_t heapAllocations;
+		uint64_t heapFrees;
+	} ENetPacketPoolStats;
+
+	typedef struct _ENetHostMessage {
+		struct _ENetHostMessage* next;
+		ENetPeer* peer;
+		ENetPacket* packet;
+		uint8_t channelID;
+	} ENetHostMessage;
+
+	typedef struct _ENetAddressCount {
+		struct in6_addr address;
+		uint32_t hash;
+		uint32_t count;
+	} ENetAddressCount;
+
 	typedef struct _ENetHost {
 		ENetSocket socket;
 		ENetAddress address;
@@ -655,11 +1005,27 @@ extern "C" {
 		uint32_t randomSeed;
 		int recalculateBandwidthLimits;
 		uint8_t preventConnections;
+		uint8_t legacyConnect;
+		uint32_t capabilities;
 		ENetPeer* peers;
 		size_t peerCount;
+		ENetPeer** activePeers;
+		size_t activePeerCount;
+		ENetPeer** freePeers;
+		size_t freePeerHead;
+		size_t freePeerCount;
+		ENetPeer** connectionIndex;
+		ENetAddressCount* addressCounts;
+		size_t indexMask;
+		uint32_t indexSeed;
 		size_t channelLimit;
 		uint32_t serviceTime;
+		uint32_t serviceDeadline;
 		ENetList dispatchQueue;
+		ENetList pendingPeers;
+		ENetList timerWheel[ENET_HOST_TIMER_LEVELS][ENET_HOST_TIMER_SLOTS];
+		uint32_t timerTime;
+		size_t timerCount;
 		uint32_t totalQueued;
 		size_t packetSize;
 		uint16_t headerFlags;
@@ -667,16 +1033,54 @@ extern "C" {
 		uint32_t totalSentPackets;
 		uint32_t totalReceivedData;
 		uint32_t totalReceivedPackets;
-		ENetProtocol commands[ENET_PROTOCOL_MAXIMUM_PACKET_COMMANDS];
+		ENetProtocol* commands;
 		size_t commandCount;
-		ENetBuffer buffers[ENET_BUFFER_MAXIMUM];
+		ENetBuffer* buffers;
 		size_t bufferCount;
+		ENetProtocol sendCommands[ENET_HOST_SEND_BATCH][ENET_PROTOCOL_MAXIMUM_PACKET_COMMANDS];
+		ENetBuffer sendBuffers[ENET_HOST_SEND_BATCH][ENET_BUFFER_MAXIMUM];
+		size_t sendBufferCounts[ENET_HOST_SEND_BATCH];
+		uint8_t sendHeaderData[ENET_HOST_SEND_BATCH][sizeof(ENetProtocolHeader) + ENET_PEER_CIPHER_OVERHEAD];
+		ENetAddress sendAddresses[ENET_HOST_SEND_BATCH];
+		struct _ENetPeer* sendPeers[ENET_HOST_SEND_BATCH];
+		ENetList sendUnreliableCommands[ENET_HOST_SEND_BATCH];
+		uint32_t sendDelays[ENET_HOST_SEND_BATCH];
+		size_t sendCount;
+		int sendProbing;
+		int segmentation;
+		ENetPacingMode pacing;
+		ENetChecksumType checksum;
 		ENetChecksumCallback checksumCallback;
+		ENetCompressor compressor;
+		uint32_t compressionDictionary;
+		uint8_t presharedKey[ENET_PEER_CIPHER_KEY_SIZE];
+		uint8_t* stagingData;
+		const ENetCongestionControl* congestionControl;
 		uint8_t packetData[2][ENET_PROTOCOL_MAXIMUM_MTU];
+		uint8_t* receiveData;
+		uint8_t* receiveArena;
+		ENetBuffer receiveBuffers[ENET_HOST_RECEIVE_BATCH];
+		ENetAddress receiveAddresses[ENET_HOST_RECEIVE_BATCH];
+		int receiveLengths[ENET_HOST_RECEIVE_BATCH];
+		int receiveSegmentSizes[ENET_HOST_RECEIVE_BATCH];
+		size_t receiveIndex;
+		size_t receiveCount;
+		size_t receiveOffset;
+		int receiveCoalescing;
+		struct _ENetUring* uring;
+		ENetHostMessage* postedMessages;
+		ENetPacket** aggregatedPackets;
+		size_t aggregatedPacketCount;
+		size_t aggregatedPacketCapacity;
+		ENetPool outgoingCommandPool;
+		ENetPool incomingCommandPool;
+		ENetPool acknowledgementPool;
+		size_t packetPoolPrewarm;
 		ENetAddress receivedAddress;
 		uint8_t* receivedData;
 		size_t receivedDataLength;
 		ENetInterceptCallback interceptCallback;
+		ENetMtuCallback mtuCallback;
 		size_t connectedPeers;
 		size_t bandwidthLimitedPeers;
 		size_t duplicatePeers;
@@ -684,6 +1088,11 @@ extern "C" {
 		size_t maximumWaitingData;
 	} ENetHost;
 
+	typedef struct _ENetHostGroup {
+		ENetHost** hosts;
+		size_t hostCount;
+	} ENetHostGroup;
+
 /*
 =======================================================================
 
@@ -699,15 +1108,29 @@ extern "C" {
 	ENET_API int enet_array_is_zeroed(const uint8_t*, int);
 	ENET_API uint32_t enet_time_get(void);
 	ENET_API uint64_t enet_crc64(const ENetBuffer*, int);
+	ENET_API uint32_t enet_crc32c(const ENetBuffer*, int);
+	ENET_API uint64_t enet_xxhash64(const ENetBuffer*, int);
+
+	ENET_API void* enet_lz4_create(void);
+	ENET_API void enet_lz4_destroy(void*);
+	ENET_API size_t enet_lz4_compress(void*, const ENetBuffer*, size_t, size_t, uint8_t*, size_t);
+	ENET_API size_t enet_lz4_decompress(void*, const uint8_t*, size_t, uint8_t*, size_t);
+	ENET_API size_t enet_lz4_set_dictionary(void*, const void*, size_t);
+	ENET_API uint32_t enet_lz4_dictionary_id(const void*, size_t);
 
 	ENET_API ENetPacket* enet_packet_create(const void*, size_t, uint32_t);
 	ENET_API ENetPacket* enet_packet_create_offset(const void*, size_t, size_t, uint32_t);
 	ENET_API void enet_packet_destroy(ENetPacket*);
+	ENET_API void enet_packet_pool_prewarm(size_t);
+	ENET_API int enet_packet_pool_get_stats(size_t, ENetPacketPoolStats*);
 
 	ENET_API int enet_peer_send(ENetPeer*, uint8_t, ENetPacket*);
 	ENET_API ENetPacket* enet_peer_receive(ENetPeer*, uint8_t*);
 	ENET_API void enet_peer_ping(ENetPeer*);
 	ENET_API void enet_peer_ping_interval(ENetPeer*, uint32_t);
+	ENET_API void enet_peer_fast_retransmit(ENetPeer*, uint32_t);
+	ENET_API void enet_peer_acknowledgement_delay(ENetPeer*, uint32_t, uint32_t);
+	ENET_API int enet_peer_channel_aggregation(ENetPeer*, uint8_t, int);
 	ENET_API void enet_peer_timeout(ENetPeer*, uint32_t, uint32_t, uint32_t);
 	ENET_API void enet_peer_reset(ENetPeer*);
 	ENET_API void enet_peer_disconnect(ENetPeer*, uint32_t);
@@ -716,6 +1139,7 @@ extern "C" {
 	ENET_API void enet_peer_throttle_configure(ENetPeer*, uint32_t, uint32_t, uint32_t, uint32_t);
 
 	ENET_API ENetHost* enet_host_create(const ENetAddress*, size_t, size_t, uint32_t, uint32_t, int);
+	ENET_API ENetHost* enet_host_create_with_options(const ENetAddress*, size_t, size_t, uint32_t, uint32_t, int, const ENetHostOptions*);
 	ENET_API void enet_host_destroy(ENetHost*);
 	ENET_API void enet_host_prevent_connections(ENetHost*, uint8_t);
 	ENET_API ENetPeer* enet_host_connect(ENetHost*, const ENetAddress*, size_t, uint32_t);
@@ -727,6 +1151,11 @@ extern "C" {
 	ENET_API void enet_host_broadcast_selective(ENetHost*, uint8_t, ENetPacket*, ENetPeer**, size_t);
 	ENET_API void enet_host_channel_limit(ENetHost*, size_t);
 	ENET_API void enet_host_bandwidth_limit(ENetHost*, uint32_t, uint32_t);
+	ENET_API int enet_host_post(ENetHost*, ENetPeer*, uint8_t, ENetPacket*);
+
+	ENET_API ENetHostGroup* enet_host_group_create(const ENetAddress*, size_t, size_t, size_t, uint32_t, uint32_t, int, const ENetHostOptions*);
+	ENET_API void enet_host_group_destroy(ENetHostGroup*);
+	ENET_API int enet_host_group_broadcast(ENetHostGroup*, ENetHost*, uint8_t, ENetPacket*);
 
 	ENET_API int enet_address_set_ip(ENetAddress*, const char*);
 	ENET_API int enet_address_set_hostname(ENetAddress*, const char*);
@@ -740,7 +1169,9 @@ extern "C" {
 	ENET_API ENetSocket enet_socket_accept(ENetSocket, ENetAddress*);
 	ENET_API int enet_socket_connect(ENetSocket, const ENetAddress*);
 	ENET_API int enet_socket_send(ENetSocket, const ENetAddress*, const ENetBuffer*, size_t);
+	ENET_API int enet_socket_send_batch(ENetSocket, const ENetAddress*, ENetBuffer* const*, const size_t*, const size_t*, const uint32_t*, int*, size_t);
 	ENET_API int enet_socket_receive(ENetSocket, ENetAddress*, ENetBuffer*, size_t);
+	ENET_API int enet_socket_receive_batch(ENetSocket, ENetAddress*, ENetBuffer*, int*, int*, size_t);
 	ENET_API int enet_socket_wait(ENetSocket, uint32_t*, uint64_t);
 	ENET_API int enet_socket_set_option(ENetSocket, ENetSocketOption, int);
 	ENET_API int enet_socket_get_option(ENetSocket, ENetSocketOption, int*);
@@ -758,13 +1189,29 @@ extern "C" {
 	ENET_API void enet_packet_dispose(ENetPacket*);
 
 	ENET_API uint32_t enet_host_get_peers_count(const ENetHost*);
+	ENET_API ENetHostBackend enet_host_get_backend(const ENetHost*);
 	ENET_API uint32_t enet_host_get_packets_sent(const ENetHost*);
 	ENET_API uint32_t enet_host_get_packets_received(const ENetHost*);
 	ENET_API uint32_t enet_host_get_bytes_sent(const ENetHost*);
 	ENET_API uint32_t enet_host_get_bytes_received(const ENetHost*);
 	ENET_API void enet_host_set_max_duplicate_peers(ENetHost*, uint16_t);
 	ENET_API void enet_host_set_intercept_callback(ENetHost*, ENetInterceptCallback);
+	ENET_API void enet_host_set_mtu_callback(ENetHost*, ENetMtuCallback);
 	ENET_API void enet_host_set_checksum_callback(ENetHost*, ENetChecksumCallback);
+	ENET_API int enet_host_set_checksum(ENetHost*, ENetChecksumType);
+	ENET_API int enet_host_set_segmentation(ENetHost*, int);
+	ENET_API int enet_host_set_receive_coalescing(ENetHost*, int);
+	ENET_API int enet_host_set_pacing(ENetHost*, ENetPacingMode);
+	ENET_API int enet_host_set_path_mtu_discovery(ENetHost*, int);
+	ENET_API void enet_host_set_selective_acknowledgements(ENetHost*, int);
+	ENET_API void enet_host_set_aggregation(ENetHost*, int);
+	ENET_API void enet_host_set_legacy_connect(ENetHost*, int);
+	ENET_API int enet_host_compress(ENetHost*, const ENetCompressor*);
+	ENET_API int enet_host_compress_with_lz4(ENetHost*);
+	ENET_API int enet_host_compress_with_lz4_dictionary(ENetHost*, const void*, size_t);
+	ENET_API int enet_host_set_encryption(ENetHost*, int, const uint8_t*);
+	ENET_API void enet_host_set_congestion_control(ENetHost*, const ENetCongestionControl*);
+	ENET_API const ENetCongestionControl* enet_congestion_control_get(ENetCongestionControlType);
 
 	ENET_API uint32_t enet_peer_get_id(const ENetPeer*);
 	ENET_API int enet_peer_get_ip(const ENetPeer*, char*, size_t);
@@ -777,6 +1224,7 @@ extern "C" {
 	ENET_API uint32_t enet_peer_get_lastreceivetime(const ENetPeer*);
 	ENET_API uint64_t enet_peer_get_packets_sent(const ENetPeer*);
 	ENET_API uint64_t enet_peer_get_packets_lost(const ENetPeer*);
+	ENET_API uint64_t enet_peer_get_fast_retransmits(const ENetPeer*);
 	ENET_API float enet_peer_get_packets_throttle(const ENetPeer*);
 	ENET_API uint64_t enet_peer_get_bytes_sent(const ENetPeer*);
 	ENET_API uint64_t enet_peer_get_bytes_received(const ENetPeer*);
@@ -793,6 +1241,7 @@ extern "C" {
 
 	extern void enet_host_bandwidth_throttle(ENetHost*);
 	extern uint64_t enet_host_random_seed(void);
+	extern int enet_random_bytes(void*, size_t);
 
 	extern int enet_peer_throttle(ENetPeer*, uint32_t);
 	extern void enet_peer_reset_queues(ENetPeer*);
@@ -805,9 +1254,33 @@ extern "C" {
 	extern void enet_peer_dispatch_incoming_reliable_commands(ENetPeer*, ENetChannel*, ENetIncomingCommand*);
 	extern void enet_peer_on_connect(ENetPeer*);
 	extern void enet_peer_on_disconnect(ENetPeer*);
+	extern void enet_peer_activate(ENetPeer*);
+	extern void enet_peer_deactivate(ENetPeer*);
+	extern void enet_peer_mark_pending(ENetPeer*);
+	extern void enet_peer_schedule(ENetPeer*, uint32_t);
+	extern void enet_peer_unschedule(ENetPeer*);
+	extern void enet_peer_index(ENetPeer*);
+	extern void enet_peer_unindex(ENetPeer*);
+	extern ENetPeer* enet_host_find_connection(ENetHost*, const ENetAddress*, uint32_t);
+	extern uint32_t enet_host_count_address(ENetHost*, const struct in6_addr*);
 
 	extern size_t enet_protocol_command_size(uint8_t);
 
+	extern void enet_pool_initialize(ENetPool*, size_t, size_t);
+	extern void enet_pool_destroy(ENetPool*);
+	extern void* enet_pool_allocate(ENetPool*);
+	extern void enet_pool_free(ENetPool*, void*);
+	extern void enet_packet_pool_clear(void);
+
+	#ifdef ENET_HAS_URING
+		extern struct _ENetUring* enet_uring_create(ENetSocket);
+		extern void enet_uring_destroy(struct _ENetUring*);
+		extern int enet_uring_send_batch(struct _ENetUring*, const ENetAddress*, ENetBuffer* const*, const size_t*, int*, size_t, uint32_t);
+		extern int enet_uring_receive_batch(struct _ENetUring*, ENetAddress*, ENetBuffer*, int*, size_t);
+		extern int enet_uring_wait(struct _ENetUring*, uint32_t*, uint64_t);
+		extern int enet_uring_failed(const struct _ENetUring*);
+	#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -1058,6 +1531,60 @@ extern "C" {
 		callbacks.free(memory);
 	}
 
+	void enet_pool_initialize(ENetPool* pool, size_t objectSize, size_t highWaterMark) {
+		pool->freeList = NULL;
+		pool->objectSize = ENET_MAX(objectSize, sizeof(void*));
+		pool->freeCount = 0;
+		pool->highWaterMark = highWaterMark;
+		pool->allocations = 0;
+		pool->heapAllocations = 0;
+		pool->heapFrees = 0;
+	}
+
+	void enet_pool_destroy(ENetPool* pool) {
+		while (pool->freeList != NULL) {
+			void* object = pool->freeList;
+
+			pool->freeList = *(void**)object;
+
+			enet_free(object);
+		}
+
+		pool->freeCount = 0;
+	}
+
+	void* enet_pool_allocate(ENetPool* pool) {
+		void* object = pool->freeList;
+
+		++pool->allocations;
+
+		if (object != NULL) {
+			pool->freeList = *(void**)object;
+			--pool->freeCount;
+
+			return object;
+		}
+
+		++pool->heapAllocations;
+
+		return enet_malloc(pool->objectSize);
+	}
+
+	/* Freed objects are kept for reuse up to the high-water mark, anything beyond that goes back to the heap */
+	void enet_pool_free(ENetPool* pool, void* object) {
+		if (pool->freeCount >= pool->highWaterMark) {
+			++pool->heapFrees;
+
+			enet_free(object);
+
+			return;
+		}
+
+		*(void**)object = pool->freeList;
+		pool->freeList = object;
+		++pool->freeCount;
+	}
+
 /*
 =======================================================================
 
@@ -1395,3300 +1922,8211 @@ extern "C" {
 		UINT64_C(0x536fa08fdfd90e51), UINT64_C(0x29b7d047efec8728),
 	};
 
-	uint64_t enet_crc64(const ENetBuffer* buffers, int bufferCount) {
-		uint64_t crc = 0xFFFFFFFFFFFFFFFF;
+	/* Tables for a byte followed by one to seven more bytes of the same word, built from crcTable by enet_initialize */
+	static uint64_t crcSliceTable[7][256];
+	static int crcKernel = 0;
 
-		while (bufferCount-- > 0) {
-			const uint8_t* data = (const uint8_t*)buffers->data;
-			const uint8_t* dataEnd = &data[buffers->dataLength];
+	enum {
+		ENET_CRC64_KERNEL_SLICE  = 1,
+		ENET_CRC64_KERNEL_PCLMUL = 2,
+		ENET_CRC64_PCLMUL_MINIMUM = 64
+	};
 
-			while (data < dataEnd) {
-				crc = (crc >> 8) ^ crcTable[(uint8_t)crc ^* data++];
-			}
+	static uint64_t enet_crc64_slice(uint64_t crc, const uint8_t* data, size_t length) {
+		while (length >= 8) {
+			uint64_t word = crc ^ ((uint64_t)data[0] | ((uint64_t)data[1] << 8) | ((uint64_t)data[2] << 16) | ((uint64_t)data[3] << 24) | ((uint64_t)data[4] << 32) | ((uint64_t)data[5] << 40) | ((uint64_t)data[6] << 48) | ((uint64_t)data[7] << 56));
 
-			++buffers;
+			crc = crcSliceTable[6][word & 0xFF] ^ crcSliceTable[5][(word >> 8) & 0xFF] ^ crcSliceTable[4][(word >> 16) & 0xFF] ^ crcSliceTable[3][(word >> 24) & 0xFF] ^ crcSliceTable[2][(word >> 32) & 0xFF] ^ crcSliceTable[1][(word >> 40) & 0xFF] ^ crcSliceTable[0][(word >> 48) & 0xFF] ^ crcTable[word >> 56];
+			data += 8;
+			length -= 8;
 		}
 
-		return ENET_HOST_TO_NET_64(~crc);
+		while (length-- > 0) {
+			crc = (crc >> 8) ^ crcTable[(uint8_t)crc ^ *data++];
+		}
+
+		return crc;
 	}
 
-/*
-=======================================================================
+	#ifdef ENET_HAS_PCLMUL
+		static int enet_crc64_has_pclmul(void) {
+			#ifdef _MSC_VER
+				int info[4];
 
-	Packet
+				__cpuid(info, 1);
 
-=======================================================================
-*/
+				return (info[2] & (1 << 1)) != 0;
+			#else
+				unsigned int eax, ebx, ecx, edx;
 
-	ENetPacket* enet_packet_create(const void* data, size_t dataLength, uint32_t flags) {
-		ENetPacket* packet;
+				if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+					return 0;
 
-		if (flags & ENET_PACKET_FLAG_NO_ALLOCATE) {
-			packet = (ENetPacket*)enet_malloc(sizeof(ENetPacket));
+				return (ecx & bit_PCLMUL) != 0;
+			#endif
+		}
 
-			if (packet == NULL)
-				return NULL;
+		/* Folds 16 byte lanes forward with carry-less multiplies by x^n mod P in reflected form, the last lane is reduced through the tables */
+		ENET_PCLMUL_TARGET static uint64_t enet_crc64_pclmul(uint64_t crc, const uint8_t* data, size_t length) {
+			const __m128i fold16 = _mm_set_epi64x((long long)UINT64_C(0x381d0015c96f4444), (long long)UINT64_C(0xd9d7be7d505da32c));
+			const __m128i fold64 = _mm_set_epi64x((long long)UINT64_C(0xf49784a634f014e4), (long long)UINT64_C(0xaf86efb16d9ab4fb));
+			__m128i x0, x1, x2, x3;
+			uint8_t lane[16];
+			x0 = _mm_xor_si128(_mm_loadu_si128((const __m128i*)data), _mm_set_epi64x(0, (long long)crc));
+
+			if (length >= 128) {
+				x1 = _mm_loadu_si128((const __m128i*)(data + 16));
+				x2 = _mm_loadu_si128((const __m128i*)(data + 32));
+				x3 = _mm_loadu_si128((const __m128i*)(data + 48));
+				data += 64;
+				length -= 64;
+
+				while (length >= 64) {
+					x0 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x0, fold64, 0x00), _mm_clmulepi64_si128(x0, fold64, 0x11)), _mm_loadu_si128((const __m128i*)data));
+					x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, fold64, 0x00), _mm_clmulepi64_si128(x1, fold64, 0x11)), _mm_loadu_si128((const __m128i*)(data + 16)));
+					x2 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x2, fold64, 0x00), _mm_clmulepi64_si128(x2, fold64, 0x11)), _mm_loadu_si128((const __m128i*)(data + 32)));
+					x3 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x3, fold64, 0x00), _mm_clmulepi64_si128(x3, fold64, 0x11)), _mm_loadu_si128((const __m128i*)(data + 48)));
+					data += 64;
+					length -= 64;
+				}
 
-			packet->data = (uint8_t*)data;
-		} else {
-			packet = (ENetPacket*)enet_malloc(sizeof(ENetPacket) + dataLength);
+				x0 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x0, fold16, 0x00), _mm_clmulepi64_si128(x0, fold16, 0x11)), x1);
+				x0 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x0, fold16, 0x00), _mm_clmulepi64_si128(x0, fold16, 0x11)), x2);
+				x0 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x0, fold16, 0x00), _mm_clmulepi64_si128(x0, fold16, 0x11)), x3);
+			} else {
+				data += 16;
+				length -= 16;
+			}
 
-			if (packet == NULL)
-				return NULL;
+			while (length >= 16) {
+				x0 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x0, fold16, 0x00), _mm_clmulepi64_si128(x0, fold16, 0x11)), _mm_loadu_si128((const __m128i*)data));
+				data += 16;
+				length -= 16;
+			}
 
-			packet->data = (uint8_t*)packet + sizeof(ENetPacket);
+			_mm_storeu_si128((__m128i*)lane, x0);
 
-			if (data != NULL)
-				memcpy(packet->data, data, dataLength);
+			return enet_crc64_slice(enet_crc64_slice(0, lane, sizeof(lane)), data, length);
 		}
+	#endif
 
-		packet->referenceCount = 0;
-		packet->flags = flags;
-		packet->dataLength = dataLength;
-		packet->freeCallback = NULL;
-		packet->userData = NULL;
+	static void enet_crc64_initialize(void) {
+		int i, j, kernel = ENET_CRC64_KERNEL_SLICE;
 
-		return packet;
-	}
+		for (i = 0; i < 256; ++i) {
+			uint64_t crc = crcTable[i];
 
-	ENetPacket* enet_packet_create_offset(const void* data, size_t dataLength, size_t dataOffset, uint32_t flags) {
-		ENetPacket* packet;
+			for (j = 0; j < 7; ++j) {
+				crc = (crc >> 8) ^ crcTable[(uint8_t)crc];
+				crcSliceTable[j][i] = crc;
+			}
+		}
 
-		if (flags & ENET_PACKET_FLAG_NO_ALLOCATE) {
-			packet = (ENetPacket*)enet_malloc(sizeof(ENetPacket));
+		#ifdef ENET_HAS_PCLMUL
+			if (enet_crc64_has_pclmul())
+				kernel = ENET_CRC64_KERNEL_PCLMUL;
+		#endif
 
-			if (packet == NULL)
-				return NULL;
+		crcKernel = kernel;
+	}
 
-			packet->data = (uint8_t*)data;
-		} else {
-			packet = (ENetPacket*)enet_malloc(sizeof(ENetPacket) + dataLength - dataOffset);
+	uint64_t enet_crc64(const ENetBuffer* buffers, int bufferCount) {
+		uint64_t crc = 0xFFFFFFFFFFFFFFFF;
+		int kernel = crcKernel;
 
-			if (packet == NULL)
-				return NULL;
+		while (bufferCount-- > 0) {
+			#ifdef ENET_HAS_PCLMUL
+				if (kernel == ENET_CRC64_KERNEL_PCLMUL && buffers->dataLength >= ENET_CRC64_PCLMUL_MINIMUM)
+					crc = enet_crc64_pclmul(crc, (const uint8_t*)buffers->data, buffers->dataLength);
+				else
+			#endif
 
-			packet->data = (uint8_t*)packet + sizeof(ENetPacket);
+			crc = enet_crc64_slice(crc, (const uint8_t*)buffers->data, buffers->dataLength);
 
-			if (data != NULL)
-				memcpy(packet->data, (char*)data + dataOffset, dataLength - dataOffset);
+			++buffers;
 		}
 
-		packet->referenceCount = 0;
-		packet->flags = flags;
-		packet->dataLength = dataLength - dataOffset;
-		packet->freeCallback = NULL;
-		packet->userData = NULL;
-
-		return packet;
+		return ENET_HOST_TO_NET_64(~crc);
 	}
 
-	void enet_packet_destroy(ENetPacket* packet) {
-		if (packet == NULL)
-			return;
-
-		if (packet->freeCallback != NULL)
-			(*packet->freeCallback)((void*)packet);
-
-		enet_free(packet);
-	}
+	/* Castagnoli polynomial in reflected form, the tables are built by enet_initialize */
+	static uint32_t crc32cTable[8][256];
+	static int crc32cKernel = 0;
 
-/*
-=======================================================================
+	enum {
+		ENET_CRC32C_POLYNOMIAL   = 0x82F63B78,
+		ENET_CRC32C_KERNEL_SLICE = 1,
+		ENET_CRC32C_KERNEL_SSE42 = 2
+	};
 
-	Protocol
+	static uint32_t enet_crc32c_slice(uint32_t crc, const uint8_t* data, size_t length) {
+		while (length >= 8) {
+			uint32_t low = crc ^ ((uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24));
+			uint32_t high = (uint32_t)data[4] | ((uint32_t)data[5] << 8) | ((uint32_t)data[6] << 16) | ((uint32_t)data[7] << 24);
 
-=======================================================================
-*/
+			crc = crc32cTable[7][low & 0xFF] ^ crc32cTable[6][(low >> 8) & 0xFF] ^ crc32cTable[5][(low >> 16) & 0xFF] ^ crc32cTable[4][low >> 24] ^ crc32cTable[3][high & 0xFF] ^ crc32cTable[2][(high >> 8) & 0xFF] ^ crc32cTable[1][(high >> 16) & 0xFF] ^ crc32cTable[0][high >> 24];
+			data += 8;
+			length -= 8;
+		}
 
-	static size_t commandSizes[ENET_PROTOCOL_COMMAND_COUNT] = {
-		0,
-		sizeof(ENetProtocolAcknowledge),
-		sizeof(ENetProtocolConnect),
-		sizeof(ENetProtocolVerifyConnect),
-		sizeof(ENetProtocolDisconnect),
-		sizeof(ENetProtocolPing),
-		sizeof(ENetProtocolSendReliable),
-		sizeof(ENetProtocolSendUnreliable),
-		sizeof(ENetProtocolSendFragment),
-		sizeof(ENetProtocolSendUnsequenced),
-		sizeof(ENetProtocolBandwidthLimit),
-		sizeof(ENetProtocolThrottleConfigure),
-		sizeof(ENetProtocolSendFragment)
-	};
+		while (length-- > 0) {
+			crc = (crc >> 8) ^ crc32cTable[0][(uint8_t)crc ^ *data++];
+		}
 
-	size_t enet_protocol_command_size(uint8_t commandNumber) {
-		return commandSizes[commandNumber & ENET_PROTOCOL_COMMAND_MASK];
+		return crc;
 	}
 
-	static void enet_protocol_change_state(ENetHost* host, ENetPeer* peer, ENetPeerState state) {
-		if (state == ENET_PEER_STATE_CONNECTED || state == ENET_PEER_STATE_DISCONNECT_LATER)
-			enet_peer_on_connect(peer);
-		else
-			enet_peer_on_disconnect(peer);
+	#ifdef ENET_HAS_SSE42
+		static int enet_crc32c_has_sse42(void) {
+			#ifdef _MSC_VER
+				int info[4];
 
-		peer->state = state;
-	}
+				__cpuid(info, 1);
 
-	static void enet_protocol_dispatch_state(ENetHost* host, ENetPeer* peer, ENetPeerState state) {
-		enet_protocol_change_state(host, peer, state);
+				return (info[2] & (1 << 20)) != 0;
+			#else
+				unsigned int eax, ebx, ecx, edx;
 
-		if (!peer->needsDispatch) {
-			enet_list_insert(enet_list_end(&host->dispatchQueue), &peer->dispatchList);
+				if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+					return 0;
 
-			peer->needsDispatch = 1;
+				return (ecx & bit_SSE4_2) != 0;
+			#endif
 		}
-	}
 
-	static int enet_protocol_dispatch_incoming_commands(ENetHost* host, ENetEvent* event) {
-		while (!enet_list_empty(&host->dispatchQueue)) {
-			ENetPeer* peer = (ENetPeer*)enet_list_remove(enet_list_begin(&host->dispatchQueue));
-			peer->needsDispatch = 0;
+		ENET_SSE42_TARGET static uint32_t enet_crc32c_sse42(uint32_t crc, const uint8_t* data, size_t length) {
+			uint64_t word, state = crc;
 
-			switch (peer->state) {
-				case ENET_PEER_STATE_CONNECTION_PENDING:
-				case ENET_PEER_STATE_CONNECTION_SUCCEEDED:
-					enet_protocol_change_state(host, peer, ENET_PEER_STATE_CONNECTED);
+			while (length >= 8) {
+				memcpy(&word, data, sizeof(word));
 
-					event->type = ENET_EVENT_TYPE_CONNECT;
-					event->peer = peer;
-					event->data = peer->eventData;
+				state = _mm_crc32_u64(state, word);
+				data += 8;
+				length -= 8;
+			}
 
-					return 1;
+			crc = (uint32_t)state;
 
-				case ENET_PEER_STATE_ZOMBIE:
-					host->recalculateBandwidthLimits = 1;
-					event->type = ENET_EVENT_TYPE_DISCONNECT;
-					event->peer = peer;
-					event->data = peer->eventData;
+			while (length-- > 0) {
+				crc = _mm_crc32_u8(crc, *data++);
+			}
 
-					enet_peer_reset(peer);
+			return crc;
+		}
+	#endif
 
-					return 1;
+	static void enet_crc32c_initialize(void) {
+		int i, j, kernel = ENET_CRC32C_KERNEL_SLICE;
 
-				case ENET_PEER_STATE_CONNECTED:
-					if (enet_list_empty(&peer->dispatchedCommands))
-						continue;
+		for (i = 0; i < 256; ++i) {
+			uint32_t crc = (uint32_t)i;
 
-					event->packet = enet_peer_receive(peer, &event->channelID);
+			for (j = 0; j < 8; ++j) {
+				crc = (crc >> 1) ^ (ENET_CRC32C_POLYNOMIAL & (0 - (crc & 1)));
+			}
 
-					if (event->packet == NULL)
-						continue;
+			crc32cTable[0][i] = crc;
+		}
 
-					event->type = ENET_EVENT_TYPE_RECEIVE;
-					event->peer = peer;
+		for (i = 0; i < 256; ++i) {
+			for (j = 1; j < 8; ++j) {
+				crc32cTable[j][i] = (crc32cTable[j - 1][i] >> 8) ^ crc32cTable[0][crc32cTable[j - 1][i] & 0xFF];
+			}
+		}
 
-					if (!enet_list_empty(&peer->dispatchedCommands)) {
-						peer->needsDispatch = 1;
+		#ifdef ENET_HAS_SSE42
+			if (enet_crc32c_has_sse42())
+				kernel = ENET_CRC32C_KERNEL_SSE42;
+		#endif
 
-						enet_list_insert(enet_list_end(&host->dispatchQueue), &peer->dispatchList);
-					}
+		crc32cKernel = kernel;
+	}
 
-					return 1;
+	uint32_t enet_crc32c(const ENetBuffer* buffers, int bufferCount) {
+		uint32_t crc = 0xFFFFFFFF;
+		int kernel = crc32cKernel;
 
-				default:
-					break;
-			}
+		while (bufferCount-- > 0) {
+			#ifdef ENET_HAS_SSE42
+				if (kernel == ENET_CRC32C_KERNEL_SSE42)
+					crc = enet_crc32c_sse42(crc, (const uint8_t*)buffers->data, buffers->dataLength);
+				else
+			#endif
+
+			crc = enet_crc32c_slice(crc, (const uint8_t*)buffers->data, buffers->dataLength);
+
+			++buffers;
 		}
 
-		return 0;
+		return ENET_HOST_TO_NET_32(~crc);
 	}
 
-	static void enet_protocol_notify_connect(ENetHost* host, ENetPeer* peer, ENetEvent* event) {
-		host->recalculateBandwidthLimits = 1;
-
-		if (event != NULL) {
-			enet_protocol_change_state(host, peer, ENET_PEER_STATE_CONNECTED);
+	#define ENET_XXHASH64_PRIME1 UINT64_C(0x9E3779B185EBCA87)
+	#define ENET_XXHASH64_PRIME2 UINT64_C(0xC2B2AE3D27D4EB4F)
+	#define ENET_XXHASH64_PRIME3 UINT64_C(0x165667B19E3779F9)
+	#define ENET_XXHASH64_PRIME4 UINT64_C(0x85EBCA77C2B2AE63)
+	#define ENET_XXHASH64_PRIME5 UINT64_C(0x27D4EB2F165667C5)
+	#define ENET_XXHASH64_ROTATE(value, bits) (((value) << (bits)) | ((value) >> (64 - (bits))))
 
-			peer->totalDataSent = 0;
-			peer->totalDataReceived = 0;
-			peer->totalPacketsSent = 0;
-			peer->totalPacketsLost = 0;
-			event->type = ENET_EVENT_TYPE_CONNECT;
-			event->peer = peer;
-			event->data = peer->eventData;
-		} else {
-			enet_protocol_dispatch_state(host, peer, peer->state == ENET_PEER_STATE_CONNECTING ? ENET_PEER_STATE_CONNECTION_SUCCEEDED : ENET_PEER_STATE_CONNECTION_PENDING);
-		}
+	static uint64_t enet_xxhash64_read64(const uint8_t* data) {
+		return (uint64_t)data[0] | ((uint64_t)data[1] << 8) | ((uint64_t)data[2] << 16) | ((uint64_t)data[3] << 24) | ((uint64_t)data[4] << 32) | ((uint64_t)data[5] << 40) | ((uint64_t)data[6] << 48) | ((uint64_t)data[7] << 56);
 	}
 
-	static void enet_protocol_notify_disconnect(ENetHost* host, ENetPeer* peer, ENetEvent* event) {
-		if (peer->state >= ENET_PEER_STATE_CONNECTION_PENDING)
-			host->recalculateBandwidthLimits = 1;
+	static uint64_t enet_xxhash64_round(uint64_t accumulator, uint64_t input) {
+		accumulator += input * ENET_XXHASH64_PRIME2;
+		accumulator = ENET_XXHASH64_ROTATE(accumulator, 31);
 
-		if (peer->state != ENET_PEER_STATE_CONNECTING && peer->state < ENET_PEER_STATE_CONNECTION_SUCCEEDED) {
-			enet_peer_reset(peer);
-		} else if (event != NULL) {
-			event->type = ENET_EVENT_TYPE_DISCONNECT;
-			event->peer = peer;
-			event->data = 0;
+		return accumulator * ENET_XXHASH64_PRIME1;
+	}
 
-			enet_peer_reset(peer);
-		} else {
-			peer->eventData = 0;
+	static uint64_t enet_xxhash64_merge(uint64_t hash, uint64_t accumulator) {
+		hash ^= enet_xxhash64_round(0, accumulator);
 
-			enet_protocol_dispatch_state(host, peer, ENET_PEER_STATE_ZOMBIE);
-		}
+		return hash * ENET_XXHASH64_PRIME1 + ENET_XXHASH64_PRIME4;
 	}
 
-	static void enet_protocol_notify_disconnect_timeout(ENetHost* host, ENetPeer* peer, ENetEvent* event) {
-		if (peer->state >= ENET_PEER_STATE_CONNECTION_PENDING)
-			host->recalculateBandwidthLimits = 1;
+	static void enet_xxhash64_stripe(uint64_t* accumulators, const uint8_t* data) {
+		accumulators[0] = enet_xxhash64_round(accumulators[0], enet_xxhash64_read64(data));
+		accumulators[1] = enet_xxhash64_round(accumulators[1], enet_xxhash64_read64(data + 8));
+		accumulators[2] = enet_xxhash64_round(accumulators[2], enet_xxhash64_read64(data + 16));
+		accumulators[3] = enet_xxhash64_round(accumulators[3], enet_xxhash64_read64(data + 24));
+	}
 
-		if (peer->state != ENET_PEER_STATE_CONNECTING && peer->state < ENET_PEER_STATE_CONNECTION_SUCCEEDED) {
-			enet_peer_reset(peer);
-		} else if (event != NULL) {
-			event->type = ENET_EVENT_TYPE_DISCONNECT_TIMEOUT;
-			event->peer = peer;
-			event->data = 0;
+	/* Stripes that straddle two buffers are carried over in a 32 byte stash */
+	uint64_t enet_xxhash64(const ENetBuffer* buffers, int bufferCount) {
+		uint64_t accumulators[4] = { ENET_XXHASH64_PRIME1 + ENET_XXHASH64_PRIME2, ENET_XXHASH64_PRIME2, 0, 0 - ENET_XXHASH64_PRIME1 };
+		uint64_t hash, totalLength = 0;
+		uint8_t stash[32];
+		size_t stashLength = 0, i;
 
-			enet_peer_reset(peer);
-		} else {
-			peer->eventData = 0;
+		while (bufferCount-- > 0) {
+			const uint8_t* data = (const uint8_t*)buffers->data;
+			size_t length = buffers->dataLength;
 
-			enet_protocol_dispatch_state(host, peer, ENET_PEER_STATE_ZOMBIE);
-		}
-	}
+			totalLength += length;
 
-	static void enet_protocol_remove_sent_unreliable_commands(ENetPeer* peer, ENetList* sentUnreliableCommands) {
-		ENetOutgoingCommand* outgoingCommand;
+			if (stashLength > 0) {
+				size_t copy = ENET_MIN(length, sizeof(stash) - stashLength);
 
-		if (enet_list_empty(sentUnreliableCommands))
-			return;
+				memcpy(stash + stashLength, data, copy);
 
-		do {
-			outgoingCommand = (ENetOutgoingCommand*)enet_list_front(sentUnreliableCommands);
+				stashLength += copy;
+				data += copy;
+				length -= copy;
 
-			enet_list_remove(&outgoingCommand->outgoingCommandList);
+				if (stashLength == sizeof(stash)) {
+					enet_xxhash64_stripe(accumulators, stash);
 
-			if (outgoingCommand->packet != NULL) {
-				--outgoingCommand->packet->referenceCount;
+					stashLength = 0;
+				}
+			}
 
-				if (outgoingCommand->packet->referenceCount == 0) {
-					outgoingCommand->packet->flags |= ENET_PACKET_FLAG_SENT;
+			while (length >= sizeof(stash)) {
+				enet_xxhash64_stripe(accumulators, data);
 
-					enet_packet_destroy(outgoingCommand->packet);
-				}
+				data += sizeof(stash);
+				length -= sizeof(stash);
 			}
 
-			enet_free(outgoingCommand);
-		}
+			if (length > 0) {
+				memcpy(stash + stashLength, data, length);
 
-		while (!enet_list_empty(sentUnreliableCommands));
+				stashLength += length;
+			}
 
-		if (peer->state == ENET_PEER_STATE_DISCONNECT_LATER && !enet_peer_has_outgoing_commands(peer))
-			enet_peer_disconnect(peer, peer->eventData);
-	}
+			++buffers;
+		}
 
-	static ENetOutgoingCommand* enet_protocol_find_sent_reliable_command(ENetList* list, uint16_t reliableSequenceNumber, uint8_t channelID) {
-		ENetListIterator currentCommand;
+		if (totalLength >= sizeof(stash)) {
+			hash = ENET_XXHASH64_ROTATE(accumulators[0], 1) + ENET_XXHASH64_ROTATE(accumulators[1], 7) + ENET_XXHASH64_ROTATE(accumulators[2], 12) + ENET_XXHASH64_ROTATE(accumulators[3], 18);
 
-		for (currentCommand = enet_list_begin(list); currentCommand != enet_list_end(list); currentCommand = enet_list_next(currentCommand)) {
-			ENetOutgoingCommand* outgoingCommand = (ENetOutgoingCommand*)currentCommand;
+			for (i = 0; i < 4; ++i) {
+				hash = enet_xxhash64_merge(hash, accumulators[i]);
+			}
+		} else {
+			hash = ENET_XXHASH64_PRIME5;
+		}
 
-			if (!(outgoingCommand->command.header.command & ENET_PROTOCOL_COMMAND_FLAG_ACKNOWLEDGE))
-				continue;
+		hash += totalLength;
 
-			if (outgoingCommand->sendAttempts < 1)
-				break;
+		for (i = 0; i + 8 <= stashLength; i += 8) {
+			hash ^= enet_xxhash64_round(0, enet_xxhash64_read64(stash + i));
+			hash = ENET_XXHASH64_ROTATE(hash, 27) * ENET_XXHASH64_PRIME1 + ENET_XXHASH64_PRIME4;
+		}
 
-			if (outgoingCommand->reliableSequenceNumber == reliableSequenceNumber && outgoingCommand->command.header.channelID == channelID)
-				return outgoingCommand;
+		if (i + 4 <= stashLength) {
+			hash ^= ((uint64_t)stash[i] | ((uint64_t)stash[i + 1] << 8) | ((uint64_t)stash[i + 2] << 16) | ((uint64_t)stash[i + 3] << 24)) * ENET_XXHASH64_PRIME1;
+			hash = ENET_XXHASH64_ROTATE(hash, 23) * ENET_XXHASH64_PRIME2 + ENET_XXHASH64_PRIME3;
+			i += 4;
 		}
 
-		return NULL;
-	}
+		for (; i < stashLength; ++i) {
+			hash ^= stash[i] * ENET_XXHASH64_PRIME5;
+			hash = ENET_XXHASH64_ROTATE(hash, 11) * ENET_XXHASH64_PRIME1;
+		}
 
-	static ENetProtocolCommand enet_protocol_remove_sent_reliable_command(ENetPeer* peer, uint16_t reliableSequenceNumber, uint8_t channelID) {
-		ENetOutgoingCommand* outgoingCommand = NULL;
-		ENetListIterator currentCommand;
-		ENetProtocolCommand commandNumber;
+		hash ^= hash >> 33;
+		hash *= ENET_XXHASH64_PRIME2;
+		hash ^= hash >> 29;
+		hash *= ENET_XXHASH64_PRIME3;
+		hash ^= hash >> 32;
 
-		int wasSent = 1;
+		return ENET_HOST_TO_NET_64(hash);
+	}
 
-		for (currentCommand = enet_list_begin(&peer->sentReliableCommands); currentCommand != enet_list_end(&peer->sentReliableCommands); currentCommand = enet_list_next(currentCommand)) {
-			outgoingCommand = (ENetOutgoingCommand*)currentCommand;
+/*
+=======================================================================
 
-			if (outgoingCommand->reliableSequenceNumber == reliableSequenceNumber && outgoingCommand->command.header.channelID == channelID)
-				break;
-		}
+	Compressor
 
-		if (currentCommand == enet_list_end(&peer->sentReliableCommands)) {
-			outgoingCommand = enet_protocol_find_sent_reliable_command(&peer->outgoingCommands, reliableSequenceNumber, channelID);
+=======================================================================
+*/
 
-			if (outgoingCommand == NULL)
-		 		outgoingCommand = enet_protocol_find_sent_reliable_command(&peer->outgoingSendReliableCommands, reliableSequenceNumber, channelID);
+	/* LZ4 block format, matches are found through a small hash table that is rebuilt for every datagram */
+	enum {
+		ENET_LZ4_HASH_BITS            = 10,
+		ENET_LZ4_DICTIONARY_HASH_BITS = 12,
+		ENET_LZ4_MINIMUM_MATCH        = 4,
+		ENET_LZ4_LAST_LITERALS        = 5,
+		ENET_LZ4_MATCH_LIMIT          = 12,
+		ENET_LZ4_MAXIMUM_OFFSET       = 65535
+	};
 
-			wasSent = 0;
-		}
+	/* A dictionary sits in front of the datagram in the window, so matches may reach back into it */
+	typedef struct _ENetLz4 {
+		uint16_t table[1 << ENET_LZ4_DICTIONARY_HASH_BITS];
+		uint16_t dictionaryTable[1 << ENET_LZ4_DICTIONARY_HASH_BITS];
+		size_t dictionaryLength;
+		uint8_t window[ENET_HOST_DICTIONARY_MAXIMUM + ENET_PROTOCOL_MAXIMUM_MTU];
+	} ENetLz4;
 
-		if (outgoingCommand == NULL)
-			return ENET_PROTOCOL_COMMAND_NONE;
+	static uint32_t enet_lz4_read32(const uint8_t* data) {
+		uint32_t value;
 
-		if (channelID < peer->channelCount) {
-			ENetChannel* channel = &peer->channels[channelID];
-			uint16_t reliableWindow = reliableSequenceNumber / ENET_PEER_RELIABLE_WINDOW_SIZE;
+		memcpy(&value, data, sizeof(value));
 
-			if (channel->reliableWindows[reliableWindow] > 0) {
-				--channel->reliableWindows[reliableWindow];
+		return value;
+	}
 
-				if (!channel->reliableWindows[reliableWindow])
-					channel->usedReliableWindows &= ~(1u << reliableWindow);
-			}
+	static uint32_t enet_lz4_hash(uint32_t sequence, int hashBits) {
+		return (sequence * 2654435761U) >> (32 - hashBits);
+	}
+
+	static uint8_t* enet_lz4_write_length(uint8_t* output, size_t length) {
+		while (length >= 255) {
+			*output++ = 255;
+			length -= 255;
 		}
 
-		commandNumber = (ENetProtocolCommand)(outgoingCommand->command.header.command & ENET_PROTOCOL_COMMAND_MASK);
+		*output++ = (uint8_t)length;
 
-		enet_list_remove(&outgoingCommand->outgoingCommandList);
+		return output;
+	}
 
-		if (outgoingCommand->packet != NULL) {
-			if (wasSent)
-				peer->reliableDataInTransit -= outgoingCommand->fragmentLength;
+	static uint8_t* enet_lz4_write_sequence(uint8_t* output, const uint8_t* outputEnd, const uint8_t* literals, size_t literalLength, size_t offset, size_t matchLength) {
+		uint8_t* token = output;
 
-			--outgoingCommand->packet->referenceCount;
+		/* Token, literal length run, literals, offset and match length run */
+		if ((size_t)(outputEnd - output) < 1 + literalLength / 255 + 1 + literalLength + 2 + matchLength / 255 + 1)
+			return NULL;
 
-			if (outgoingCommand->packet->referenceCount == 0) {
-				outgoingCommand->packet->flags |= ENET_PACKET_FLAG_SENT;
+		*output++ = (uint8_t)((literalLength >= 15 ? 15 : literalLength) << 4);
 
-				enet_packet_destroy(outgoingCommand->packet);
-			}
-		}
+		if (literalLength >= 15)
+			output = enet_lz4_write_length(output, literalLength - 15);
 
-		enet_free(outgoingCommand);
+		memcpy(output, literals, literalLength);
 
-		if (enet_list_empty(&peer->sentReliableCommands))
-			return commandNumber;
+		output += literalLength;
 
-		outgoingCommand = (ENetOutgoingCommand*)enet_list_front(&peer->sentReliableCommands);
-		peer->nextTimeout = outgoingCommand->sentTime + outgoingCommand->roundTripTimeout;
+		if (offset == 0)
+			return output;
 
-		return commandNumber;
+		*output++ = (uint8_t)offset;
+		*output++ = (uint8_t)(offset >> 8);
+
+		matchLength -= ENET_LZ4_MINIMUM_MATCH;
+		*token |= (uint8_t)(matchLength >= 15 ? 15 : matchLength);
+
+		if (matchLength >= 15)
+			output = enet_lz4_write_length(output, matchLength - 15);
+
+		return output;
 	}
 
-	static ENetPeer* enet_protocol_handle_connect(ENetHost* host, ENetProtocolHeader* header, ENetProtocol* command) {
-		uint8_t incomingSessionID, outgoingSessionID;
-		uint32_t mtu, windowSize;
-		ENetChannel* channel;
-		size_t channelCount, duplicatePeers = 0;
-		ENetPeer* currentPeer, *peer = NULL;
-		ENetProtocol verifyCommand;
-		channelCount = ENET_NET_TO_HOST_32(command->connect.channelCount);
+	static size_t enet_lz4_decode(const uint8_t* inData, size_t inLimit, const uint8_t* windowStart, uint8_t* outData, size_t outLimit) {
+		const uint8_t* input = inData;
+		const uint8_t* inputEnd = inData + inLimit;
+		uint8_t* output = outData;
+		uint8_t* outputEnd = outData + outLimit;
 
-		if (channelCount < ENET_PROTOCOL_MINIMUM_CHANNEL_COUNT || channelCount > ENET_PROTOCOL_MAXIMUM_CHANNEL_COUNT)
-			return NULL;
+		while (input < inputEnd) {
+			uint8_t token = *input++, run;
+			size_t literalLength = token >> 4, matchLength = token & 15, offset;
+			const uint8_t* source;
 
-		for (currentPeer = host->peers; currentPeer < &host->peers[host->peerCount]; ++currentPeer) {
-			if (currentPeer->state == ENET_PEER_STATE_DISCONNECTED) {
-				if (peer == NULL)
-					peer = currentPeer;
-			} else if (currentPeer->state != ENET_PEER_STATE_CONNECTING && enet_in6_equal(currentPeer->address.ipv6, host->receivedAddress.ipv6)) {
-				if (currentPeer->address.port == host->receivedAddress.port && currentPeer->connectID == command->connect.connectID)
-					return NULL;
+			if (literalLength == 15) {
+				do {
+					if (input >= inputEnd)
+						return 0;
 
-				++duplicatePeers;
+					run = *input++;
+					literalLength += run;
+				} while (run == 255);
 			}
-		}
 
-		if (peer == NULL || duplicatePeers >= host->duplicatePeers)
-			return NULL;
+			if (literalLength > (size_t)(inputEnd - input) || literalLength > (size_t)(outputEnd - output))
+				return 0;
 
-		if (channelCount > host->channelLimit)
-			channelCount = host->channelLimit;
+			memcpy(output, input, literalLength);
 
-		peer->channels = (ENetChannel*)enet_malloc(channelCount * sizeof(ENetChannel));
+			input += literalLength;
+			output += literalLength;
 
-		if (peer->channels == NULL)
-			return NULL;
+			/* The last sequence carries only literals */
+			if (input == inputEnd)
+				break;
 
-		peer->channelCount = channelCount;
-		peer->state = ENET_PEER_STATE_ACKNOWLEDGING_CONNECT;
-		peer->connectID = command->connect.connectID;
-		peer->address = host->receivedAddress;
-		peer->outgoingPeerID = ENET_NET_TO_HOST_16(command->connect.outgoingPeerID);
-		peer->incomingBandwidth = ENET_NET_TO_HOST_32(command->connect.incomingBandwidth);
-		peer->outgoingBandwidth = ENET_NET_TO_HOST_32(command->connect.outgoingBandwidth);
-		peer->packetThrottleInterval = ENET_NET_TO_HOST_32(command->connect.packetThrottleInterval);
-		peer->packetThrottleAcceleration = ENET_NET_TO_HOST_32(command->connect.packetThrottleAcceleration);
-		peer->packetThrottleDeceleration = ENET_NET_TO_HOST_32(command->connect.packetThrottleDeceleration);
-		peer->eventData = ENET_NET_TO_HOST_32(command->connect.data);
-		incomingSessionID = command->connect.incomingSessionID == 0xFF ? peer->outgoingSessionID : command->connect.incomingSessionID;
-		incomingSessionID = (incomingSessionID + 1) & (ENET_PROTOCOL_HEADER_SESSION_MASK >> ENET_PROTOCOL_HEADER_SESSION_SHIFT);
+			if (inputEnd - input < 2)
+				return 0;
 
-		if (incomingSessionID == peer->outgoingSessionID)
-			incomingSessionID = (incomingSessionID + 1) & (ENET_PROTOCOL_HEADER_SESSION_MASK >> ENET_PROTOCOL_HEADER_SESSION_SHIFT);
+			offset = (size_t)input[0] | ((size_t)input[1] << 8);
+			input += 2;
 
-		peer->outgoingSessionID = incomingSessionID;
-		outgoingSessionID = command->connect.outgoingSessionID == 0xFF ? peer->incomingSessionID : command->connect.outgoingSessionID;
-		outgoingSessionID = (outgoingSessionID + 1) & (ENET_PROTOCOL_HEADER_SESSION_MASK >> ENET_PROTOCOL_HEADER_SESSION_SHIFT);
+			if (offset == 0 || offset > (size_t)(output - windowStart))
+				return 0;
 
-		if (outgoingSessionID == peer->incomingSessionID)
-			outgoingSessionID = (outgoingSessionID + 1) & (ENET_PROTOCOL_HEADER_SESSION_MASK >> ENET_PROTOCOL_HEADER_SESSION_SHIFT);
+			if (matchLength == 15) {
+				do {
+					if (input >= inputEnd)
+						return 0;
 
-		peer->incomingSessionID = outgoingSessionID;
+					run = *input++;
+					matchLength += run;
+				} while (run == 255);
+			}
 
-		for (channel = peer->channels; channel < &peer->channels[channelCount]; ++channel) {
-			channel->outgoingReliableSequenceNumber = 0;
-			channel->outgoingUnreliableSequenceNumber = 0;
-			channel->incomingReliableSequenceNumber = 0;
-			channel->incomingUnreliableSequenceNumber = 0;
+			matchLength += ENET_LZ4_MINIMUM_MATCH;
 
-			enet_list_clear(&channel->incomingReliableCommands);
-			enet_list_clear(&channel->incomingUnreliableCommands);
+			if (matchLength > (size_t)(outputEnd - output))
+				return 0;
 
-			channel->usedReliableWindows = 0;
+			/* Overlapping matches repeat with the period of the offset, so the copied span can double every step */
+			source = output - offset;
 
-			memset(channel->reliableWindows, 0, sizeof(channel->reliableWindows));
+			while (matchLength > 0) {
+				size_t chunk = ENET_MIN((size_t)(output - source), matchLength);
+
+				memcpy(output, source, chunk);
+
+				output += chunk;
+				matchLength -= chunk;
+			}
 		}
 
-		mtu = ENET_NET_TO_HOST_32(command->connect.mtu);
+		return (size_t)(output - outData);
+	}
 
-		if (mtu < ENET_PROTOCOL_MINIMUM_MTU)
-			mtu = ENET_PROTOCOL_MINIMUM_MTU;
-		else if (mtu > ENET_PROTOCOL_MAXIMUM_MTU)
-			mtu = ENET_PROTOCOL_MAXIMUM_MTU;
+	void* enet_lz4_create(void) {
+		ENetLz4* lz4 = (ENetLz4*)enet_malloc(sizeof(ENetLz4));
 
-		if (mtu < peer->mtu)
-			peer->mtu = mtu;
+		if (lz4 != NULL)
+			lz4->dictionaryLength = 0;
 
-		if (host->outgoingBandwidth == 0 && peer->incomingBandwidth == 0)
-			peer->windowSize = ENET_PROTOCOL_MAXIMUM_WINDOW_SIZE;
-		else if (host->outgoingBandwidth == 0 || peer->incomingBandwidth == 0)
-			peer->windowSize = (ENET_MAX(host->outgoingBandwidth, peer->incomingBandwidth) / ENET_PEER_WINDOW_SIZE_SCALE) * ENET_PROTOCOL_MINIMUM_WINDOW_SIZE;
-		else
-			peer->windowSize = (ENET_MIN(host->outgoingBandwidth, peer->incomingBandwidth) / ENET_PEER_WINDOW_SIZE_SCALE) * ENET_PROTOCOL_MINIMUM_WINDOW_SIZE;
+		return lz4;
+	}
 
-		if (peer->windowSize < ENET_PROTOCOL_MINIMUM_WINDOW_SIZE)
-			peer->windowSize = ENET_PROTOCOL_MINIMUM_WINDOW_SIZE;
-		else if (peer->windowSize > ENET_PROTOCOL_MAXIMUM_WINDOW_SIZE)
-			peer->windowSize = ENET_PROTOCOL_MAXIMUM_WINDOW_SIZE;
+	void enet_lz4_destroy(void* context) {
+		enet_free(context);
+	}
 
-		if (host->incomingBandwidth == 0)
-			windowSize = ENET_PROTOCOL_MAXIMUM_WINDOW_SIZE;
-		else
-			windowSize = (host->incomingBandwidth / ENET_PEER_WINDOW_SIZE_SCALE) * ENET_PROTOCOL_MINIMUM_WINDOW_SIZE;
+	/* Only the tail of a longer dictionary is kept, trainers put the most valuable content there */
+	size_t enet_lz4_set_dictionary(void* context, const void* dictionary, size_t dictionaryLength) {
+		ENetLz4* lz4 = (ENetLz4*)context;
+		size_t position;
 
-		if (windowSize > ENET_NET_TO_HOST_32(command->connect.windowSize))
-			windowSize = ENET_NET_TO_HOST_32(command->connect.windowSize);
+		if (dictionaryLength > ENET_HOST_DICTIONARY_MAXIMUM) {
+			dictionary = (const uint8_t*)dictionary + dictionaryLength - ENET_HOST_DICTIONARY_MAXIMUM;
+			dictionaryLength = ENET_HOST_DICTIONARY_MAXIMUM;
+		}
 
-		if (windowSize < ENET_PROTOCOL_MINIMUM_WINDOW_SIZE)
-			windowSize = ENET_PROTOCOL_MINIMUM_WINDOW_SIZE;
-		else if (windowSize > ENET_PROTOCOL_MAXIMUM_WINDOW_SIZE)
-			windowSize = ENET_PROTOCOL_MAXIMUM_WINDOW_SIZE;
+		memcpy(lz4->window, dictionary, dictionaryLength);
+		memset(lz4->dictionaryTable, 0, sizeof(lz4->dictionaryTable));
 
-		verifyCommand.header.command = ENET_PROTOCOL_COMMAND_VERIFY_CONNECT | ENET_PROTOCOL_COMMAND_FLAG_ACKNOWLEDGE;
-		verifyCommand.header.channelID = 0xFF;
-		verifyCommand.verifyConnect.outgoingPeerID = ENET_HOST_TO_NET_16(peer->incomingPeerID);
-		verifyCommand.verifyConnect.incomingSessionID = incomingSessionID;
-		verifyCommand.verifyConnect.outgoingSessionID = outgoingSessionID;
-		verifyCommand.verifyConnect.mtu = ENET_HOST_TO_NET_32(peer->mtu);
-		verifyCommand.verifyConnect.windowSize = ENET_HOST_TO_NET_32(windowSize);
-		verifyCommand.verifyConnect.channelCount = ENET_HOST_TO_NET_32(channelCount);
-		verifyCommand.verifyConnect.incomingBandwidth = ENET_HOST_TO_NET_32(host->incomingBandwidth);
-		verifyCommand.verifyConnect.outgoingBandwidth = ENET_HOST_TO_NET_32(host->outgoingBandwidth);
-		verifyCommand.verifyConnect.packetThrottleInterval = ENET_HOST_TO_NET_32(peer->packetThrottleInterval);
-		verifyCommand.verifyConnect.packetThrottleAcceleration = ENET_HOST_TO_NET_32(peer->packetThrottleAcceleration);
-		verifyCommand.verifyConnect.packetThrottleDeceleration = ENET_HOST_TO_NET_32(peer->packetThrottleDeceleration);
-		verifyCommand.verifyConnect.connectID = peer->connectID;
+		lz4->dictionaryLength = dictionaryLength;
 
-		enet_peer_queue_outgoing_command(peer, &verifyCommand, NULL, 0, 0);
+		for (position = 0; position + sizeof(uint32_t) <= dictionaryLength; ++position) {
+			lz4->dictionaryTable[enet_lz4_hash(enet_lz4_read32(&lz4->window[position]), ENET_LZ4_DICTIONARY_HASH_BITS)] = (uint16_t)position;
+		}
 
-		return peer;
+		return dictionaryLength;
 	}
 
-	static int enet_protocol_handle_send_reliable(ENetHost* host, ENetPeer* peer, const ENetProtocol* command, uint8_t** currentData) {
-		size_t dataLength;
+	size_t enet_lz4_compress(void* context, const ENetBuffer* inBuffers, size_t inBufferCount, size_t inLimit, uint8_t* outData, size_t outLimit) {
+		ENetLz4* lz4 = (ENetLz4*)context;
+		const uint8_t* window = lz4->window;
+		uint8_t* output = outData;
+		const uint8_t* outputEnd = outData + outLimit;
+		int hashBits = lz4->dictionaryLength > 0 ? ENET_LZ4_DICTIONARY_HASH_BITS : ENET_LZ4_HASH_BITS;
+		size_t windowLength = lz4->dictionaryLength, position = windowLength, anchor = windowLength;
 
-		if (command->header.channelID >= peer->channelCount || (peer->state != ENET_PEER_STATE_CONNECTED && peer->state != ENET_PEER_STATE_DISCONNECT_LATER))
-			return -1;
+		if (inLimit > ENET_PROTOCOL_MAXIMUM_MTU)
+			return 0;
 
-		dataLength = ENET_NET_TO_HOST_16(command->sendReliable.dataLength);
-		*currentData += dataLength;
+		while (inBufferCount-- > 0) {
+			if (inBuffers->dataLength > inLimit - (windowLength - lz4->dictionaryLength))
+				return 0;
 
-		if (dataLength > host->maximumPacketSize || *currentData < host->receivedData || *currentData > &host->receivedData[host->receivedDataLength])
-			return -1;
+			memcpy(&lz4->window[windowLength], inBuffers->data, inBuffers->dataLength);
 
-		if (enet_peer_queue_incoming_command(peer, command, (const uint8_t*)command + sizeof(ENetProtocolSendReliable), dataLength, ENET_PACKET_FLAG_RELIABLE, 0) == NULL)
-			return -1;
+			windowLength += inBuffers->dataLength;
+			++inBuffers;
+		}
 
-		return 0;
-	}
+		if (windowLength - lz4->dictionaryLength > ENET_LZ4_MATCH_LIMIT) {
+			size_t matchStartLimit = windowLength - ENET_LZ4_MATCH_LIMIT, matchEndLimit = windowLength - ENET_LZ4_LAST_LITERALS;
 
-	static int enet_protocol_handle_send_unsequenced(ENetHost* host, ENetPeer* peer, const ENetProtocol* command, uint8_t** currentData) {
-		uint32_t unsequencedGroup, index;
-		size_t dataLength;
+			if (lz4->dictionaryLength > 0)
+				memcpy(lz4->table, lz4->dictionaryTable, sizeof(lz4->table));
+			else
+				memset(lz4->table, 0, sizeof(uint16_t) << hashBits);
 
-		if (command->header.channelID >= peer->channelCount || (peer->state != ENET_PEER_STATE_CONNECTED && peer->state != ENET_PEER_STATE_DISCONNECT_LATER))
-			return -1;
+			while (position < matchStartLimit) {
+				uint32_t sequence = enet_lz4_read32(&window[position]), hash = enet_lz4_hash(sequence, hashBits);
+				size_t candidate = lz4->table[hash], matchLength = ENET_LZ4_MINIMUM_MATCH;
 
-		dataLength = ENET_NET_TO_HOST_16(command->sendUnsequenced.dataLength);
-		*currentData += dataLength;
+				lz4->table[hash] = (uint16_t)position;
 
-		if (dataLength > host->maximumPacketSize || *currentData < host->receivedData || *currentData > &host->receivedData[host->receivedDataLength])
-			return -1;
+				if (candidate >= position || position - candidate > ENET_LZ4_MAXIMUM_OFFSET || enet_lz4_read32(&window[candidate]) != sequence) {
+					/* Runs without matches are skipped with a growing step */
+					position += 1 + ((position - anchor) >> 6);
 
-		unsequencedGroup = ENET_NET_TO_HOST_16(command->sendUnsequenced.unsequencedGroup);
-		index = unsequencedGroup % ENET_PEER_UNSEQUENCED_WINDOW_SIZE;
+					continue;
+				}
 
-		if (unsequencedGroup < peer->incomingUnsequencedGroup)
-			unsequencedGroup += 0x10000;
+				while (position > anchor && candidate > 0 && window[position - 1] == window[candidate - 1]) {
+					--position;
+					--candidate;
+					++matchLength;
+				}
 
-		if (unsequencedGroup >= (uint32_t)peer->incomingUnsequencedGroup + ENET_PEER_FREE_UNSEQUENCED_WINDOWS * ENET_PEER_UNSEQUENCED_WINDOW_SIZE)
-			return 0;
+				while (position + matchLength < matchEndLimit && window[position + matchLength] == window[candidate + matchLength]) {
+					++matchLength;
+				}
 
-		unsequencedGroup &= 0xFFFF;
+				output = enet_lz4_write_sequence(output, outputEnd, &window[anchor], position - anchor, position - candidate, matchLength);
 
-		if (unsequencedGroup - index != peer->incomingUnsequencedGroup) {
-			peer->incomingUnsequencedGroup = unsequencedGroup - index;
+				if (output == NULL)
+					return 0;
 
-			memset(peer->unsequencedWindow, 0, sizeof(peer->unsequencedWindow));
-		} else if (peer->unsequencedWindow[index / 32] & (1u << (index % 32))) {
-			return 0;
+				position += matchLength;
+				anchor = position;
+
+				if (position - 2 < matchStartLimit)
+					lz4->table[enet_lz4_hash(enet_lz4_read32(&window[position - 2]), hashBits)] = (uint16_t)(position - 2);
+			}
 		}
 
-		if (enet_peer_queue_incoming_command(peer, command, (const uint8_t*)command + sizeof(ENetProtocolSendUnsequenced), dataLength, ENET_PACKET_FLAG_UNSEQUENCED, 0) == NULL)
-			return -1;
+		output = enet_lz4_write_sequence(output, outputEnd, &window[anchor], windowLength - anchor, 0, 0);
 
-		peer->unsequencedWindow[index / 32] |= 1u << (index % 32);
+		if (output == NULL)
+			return 0;
 
-		return 0;
+		return (size_t)(output - outData);
 	}
 
-	static int enet_protocol_handle_send_unreliable(ENetHost* host, ENetPeer* peer, const ENetProtocol* command, uint8_t** currentData) {
-		size_t dataLength;
-
-		if (command->header.channelID >= peer->channelCount || (peer->state != ENET_PEER_STATE_CONNECTED && peer->state != ENET_PEER_STATE_DISCONNECT_LATER))
-			return -1;
+	size_t enet_lz4_decompress(void* context, const uint8_t* inData, size_t inLimit, uint8_t* outData, size_t outLimit) {
+		ENetLz4* lz4 = (ENetLz4*)context;
+		uint8_t* output = &lz4->window[lz4->dictionaryLength];
+		size_t outputLength;
 
-		dataLength = ENET_NET_TO_HOST_16(command->sendUnreliable.dataLength);
-		*currentData += dataLength;
+		if (lz4->dictionaryLength == 0)
+			return enet_lz4_decode(inData, inLimit, outData, outData, outLimit);
 
-		if (dataLength > host->maximumPacketSize || *currentData < host->receivedData || *currentData > &host->receivedData[host->receivedDataLength])
-			return -1;
+		/* With a dictionary the datagram is expanded right behind it and copied out */
+		outputLength = enet_lz4_decode(inData, inLimit, lz4->window, output, ENET_MIN(outLimit, (size_t)ENET_PROTOCOL_MAXIMUM_MTU));
 
-		if (enet_peer_queue_incoming_command(peer, command, (const uint8_t*)command + sizeof(ENetProtocolSendUnreliable), dataLength, 0, 0) == NULL)
-			return -1;
+		memcpy(outData, output, outputLength);
 
-		return 0;
+		return outputLength;
 	}
 
-	static int enet_protocol_handle_send_fragment(ENetHost* host, ENetPeer* peer, const ENetProtocol* command, uint8_t** currentData) {
-		uint32_t fragmentNumber, fragmentCount, fragmentOffset, fragmentLength, startSequenceNumber, totalLength;
-		ENetChannel* channel;
-		uint16_t startWindow, currentWindow;
-		ENetListIterator currentCommand;
-		ENetIncomingCommand* startCommand = NULL;
+	/* The low half of the content hash, never zero so that zero can stand for no dictionary */
+	uint32_t enet_lz4_dictionary_id(const void* dictionary, size_t dictionaryLength) {
+		ENetBuffer buffer;
+		uint64_t hash;
 
-		if (command->header.channelID >= peer->channelCount || (peer->state != ENET_PEER_STATE_CONNECTED && peer->state != ENET_PEER_STATE_DISCONNECT_LATER))
-			return -1;
+		if (dictionaryLength > ENET_HOST_DICTIONARY_MAXIMUM) {
+			dictionary = (const uint8_t*)dictionary + dictionaryLength - ENET_HOST_DICTIONARY_MAXIMUM;
+			dictionaryLength = ENET_HOST_DICTIONARY_MAXIMUM;
+		}
 
-		fragmentLength = ENET_NET_TO_HOST_16(command->sendFragment.dataLength);
-		*currentData += fragmentLength;
+		buffer.data = (void*)dictionary;
+		buffer.dataLength = dictionaryLength;
+		hash = enet_xxhash64(&buffer, 1);
+		hash = ENET_NET_TO_HOST_64(hash);
 
-		if (fragmentLength <= 0 || fragmentLength > host->maximumPacketSize || *currentData < host->receivedData || *currentData > &host->receivedData[host->receivedDataLength])
-			return -1;
+		return (uint32_t)hash != 0 ? (uint32_t)hash : 1;
+	}
 
-		channel = &peer->channels[command->header.channelID];
-		startSequenceNumber = ENET_NET_TO_HOST_16(command->sendFragment.startSequenceNumber);
-		startWindow = startSequenceNumber / ENET_PEER_RELIABLE_WINDOW_SIZE;
-		currentWindow = channel->incomingReliableSequenceNumber / ENET_PEER_RELIABLE_WINDOW_SIZE;
+/*
+=======================================================================
 
-		if (startSequenceNumber < channel->incomingReliableSequenceNumber)
-			startWindow += ENET_PEER_RELIABLE_WINDOWS;
+	Cipher
 
-		if (startWindow < currentWindow || startWindow >= currentWindow + ENET_PEER_FREE_RELIABLE_WINDOWS - 1)
-			return 0;
+=======================================================================
+*/
 
-		fragmentNumber = ENET_NET_TO_HOST_32(command->sendFragment.fragmentNumber);
-		fragmentCount = ENET_NET_TO_HOST_32(command->sendFragment.fragmentCount);
-		fragmentOffset = ENET_NET_TO_HOST_32(command->sendFragment.fragmentOffset);
-		totalLength = ENET_NET_TO_HOST_32(command->sendFragment.totalLength);
+	/* ChaCha20-Poly1305 as in RFC 8439 and X25519 as in RFC 7748, the keystream is produced four blocks at a time */
+	typedef struct _ENetPoly1305 {
+		uint32_t r[5];
+		uint32_t h[5];
+		uint32_t pad[4];
+		uint8_t buffer[16];
+		size_t leftover;
+	} ENetPoly1305;
+
+	typedef struct _ENetAead {
+		uint32_t state[16];
+		uint8_t keystream[4 * 64];
+		size_t available;
+		ENetPoly1305 poly1305;
+	} ENetAead;
+
+	static uint32_t enet_cipher_load32(const uint8_t* data) {
+		return (uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+	}
 
-		if (fragmentCount > ENET_PROTOCOL_MAXIMUM_FRAGMENT_COUNT || fragmentNumber >= fragmentCount || totalLength > host->maximumPacketSize || totalLength < fragmentCount || fragmentOffset >= totalLength || fragmentLength > totalLength - fragmentOffset)
-			return -1;
+	static void enet_cipher_store32(uint8_t* data, uint32_t value) {
+		data[0] = (uint8_t)value;
+		data[1] = (uint8_t)(value >> 8);
+		data[2] = (uint8_t)(value >> 16);
+		data[3] = (uint8_t)(value >> 24);
+	}
 
-		for (currentCommand = enet_list_previous(enet_list_end(&channel->incomingReliableCommands)); currentCommand != enet_list_end(&channel->incomingReliableCommands); currentCommand = enet_list_previous(currentCommand)) {
-			ENetIncomingCommand* incomingCommand = (ENetIncomingCommand*)currentCommand;
+	static void enet_cipher_store64(uint8_t* data, uint64_t value) {
+		enet_cipher_store32(data, (uint32_t)value);
+		enet_cipher_store32(data + 4, (uint32_t)(value >> 32));
+	}
 
-			if (startSequenceNumber >= channel->incomingReliableSequenceNumber) {
-				if (incomingCommand->reliableSequenceNumber < channel->incomingReliableSequenceNumber)
-					continue;
-			} else if (incomingCommand->reliableSequenceNumber >= channel->incomingReliableSequenceNumber) {
-				break;
-			}
+	/* Writes through a volatile pointer, so clearing key material is not optimized away */
+	static void enet_cipher_wipe(void* data, size_t dataLength) {
+		volatile uint8_t* position = (volatile uint8_t*)data;
 
-			if (incomingCommand->reliableSequenceNumber <= startSequenceNumber) {
-				if (incomingCommand->reliableSequenceNumber < startSequenceNumber)
-					break;
+		while (dataLength-- > 0) {
+			*position++ = 0;
+		}
+	}
 
-				if ((incomingCommand->command.header.command & ENET_PROTOCOL_COMMAND_MASK) != ENET_PROTOCOL_COMMAND_SEND_FRAGMENT || totalLength != incomingCommand->packet->dataLength || fragmentCount != incomingCommand->fragmentCount)
-					return -1;
+	#define ENET_CHACHA20_ROTATE(value, bits) (((value) << (bits)) | ((value) >> (32 - (bits))))
 
-				startCommand = incomingCommand;
+	#define ENET_CHACHA20_QUARTER_ROUND(a, b, c, d) \
+		a += b; d ^= a; d = ENET_CHACHA20_ROTATE(d, 16); \
+		c += d; b ^= c; b = ENET_CHACHA20_ROTATE(b, 12); \
+		a += b; d ^= a; d = ENET_CHACHA20_ROTATE(d, 8); \
+		c += d; b ^= c; b = ENET_CHACHA20_ROTATE(b, 7);
 
-				break;
-			}
-		}
+	static void enet_chacha20_setup(uint32_t state[16], const uint8_t* key, uint32_t counter, const uint8_t* nonce) {
+		int i;
 
-		if (startCommand == NULL) {
-			ENetProtocol hostCommand = *command;
-			hostCommand.header.reliableSequenceNumber = startSequenceNumber;
-			startCommand = enet_peer_queue_incoming_command(peer, &hostCommand, NULL, totalLength, ENET_PACKET_FLAG_RELIABLE, fragmentCount);
+		state[0] = 0x61707865;
+		state[1] = 0x3320646E;
+		state[2] = 0x79622D32;
+		state[3] = 0x6B206574;
 
-			if (startCommand == NULL)
-				return -1;
+		for (i = 0; i < 8; ++i) {
+			state[4 + i] = enet_cipher_load32(&key[i * 4]);
 		}
 
-		if ((startCommand->fragments[fragmentNumber / 32] & (1u << (fragmentNumber % 32))) == 0) {
-			--startCommand->fragmentsRemaining;
-			startCommand->fragments[fragmentNumber / 32] |= (1u << (fragmentNumber % 32));
-
-			if (fragmentOffset + fragmentLength > startCommand->packet->dataLength)
-				fragmentLength = startCommand->packet->dataLength - fragmentOffset;
-
-			memcpy(startCommand->packet->data + fragmentOffset, (uint8_t*)command + sizeof(ENetProtocolSendFragment), fragmentLength);
+		state[12] = counter;
+		state[13] = enet_cipher_load32(&nonce[0]);
+		state[14] = enet_cipher_load32(&nonce[4]);
+		state[15] = enet_cipher_load32(&nonce[8]);
+	}
 
-			if (startCommand->fragmentsRemaining <= 0)
-				enet_peer_dispatch_incoming_reliable_commands(peer, channel, NULL);
+	static void enet_chacha20_rounds(uint32_t x[16]) {
+		int i;
+
+		for (i = 0; i < 10; ++i) {
+			ENET_CHACHA20_QUARTER_ROUND(x[0], x[4], x[8], x[12]);
+			ENET_CHACHA20_QUARTER_ROUND(x[1], x[5], x[9], x[13]);
+			ENET_CHACHA20_QUARTER_ROUND(x[2], x[6], x[10], x[14]);
+			ENET_CHACHA20_QUARTER_ROUND(x[3], x[7], x[11], x[15]);
+			ENET_CHACHA20_QUARTER_ROUND(x[0], x[5], x[10], x[15]);
+			ENET_CHACHA20_QUARTER_ROUND(x[1], x[6], x[11], x[12]);
+			ENET_CHACHA20_QUARTER_ROUND(x[2], x[7], x[8], x[13]);
+			ENET_CHACHA20_QUARTER_ROUND(x[3], x[4], x[9], x[14]);
 		}
-
-		return 0;
 	}
 
-	static int enet_protocol_handle_send_unreliable_fragment(ENetHost* host, ENetPeer* peer, const ENetProtocol* command, uint8_t** currentData) {
-		uint32_t fragmentNumber, fragmentCount, fragmentOffset, fragmentLength, reliableSequenceNumber, startSequenceNumber, totalLength;
-		uint16_t reliableWindow, currentWindow;
-		ENetChannel* channel;
-		ENetListIterator currentCommand;
-		ENetIncomingCommand* startCommand = NULL;
+	static void enet_chacha20_block(uint32_t state[16], uint8_t* out) {
+		uint32_t x[16];
+		int i;
 
-		if (command->header.channelID >= peer->channelCount || (peer->state != ENET_PEER_STATE_CONNECTED && peer->state != ENET_PEER_STATE_DISCONNECT_LATER))
-			return -1;
+		memcpy(x, state, sizeof(x));
 
-		fragmentLength = ENET_NET_TO_HOST_16(command->sendFragment.dataLength);
-		*currentData += fragmentLength;
+		enet_chacha20_rounds(x);
 
-		if (fragmentLength > host->maximumPacketSize || *currentData < host->receivedData || *currentData > &host->receivedData[host->receivedDataLength])
-			return -1;
+		for (i = 0; i < 16; ++i) {
+			enet_cipher_store32(&out[i * 4], x[i] + state[i]);
+		}
 
-		channel = &peer->channels[command->header.channelID];
-		reliableSequenceNumber = command->header.reliableSequenceNumber;
-		startSequenceNumber = ENET_NET_TO_HOST_16(command->sendFragment.startSequenceNumber);
-		reliableWindow = reliableSequenceNumber / ENET_PEER_RELIABLE_WINDOW_SIZE;
-		currentWindow = channel->incomingReliableSequenceNumber / ENET_PEER_RELIABLE_WINDOW_SIZE;
+		++state[12];
+	}
 
-		if (reliableSequenceNumber < channel->incomingReliableSequenceNumber)
-			reliableWindow += ENET_PEER_RELIABLE_WINDOWS;
+	#ifdef ENET_HAS_SSE2
+		#define ENET_CHACHA20_ROTATE_SSE2(value, bits) _mm_or_si128(_mm_slli_epi32(value, bits), _mm_srli_epi32(value, 32 - (bits)))
 
-		if (reliableWindow < currentWindow || reliableWindow >= currentWindow + ENET_PEER_FREE_RELIABLE_WINDOWS - 1)
-			return 0;
+		#define ENET_CHACHA20_QUARTER_ROUND_SSE2(a, b, c, d) \
+			a = _mm_add_epi32(a, b); d = _mm_xor_si128(d, a); d = ENET_CHACHA20_ROTATE_SSE2(d, 16); \
+			c = _mm_add_epi32(c, d); b = _mm_xor_si128(b, c); b = ENET_CHACHA20_ROTATE_SSE2(b, 12); \
+			a = _mm_add_epi32(a, b); d = _mm_xor_si128(d, a); d = ENET_CHACHA20_ROTATE_SSE2(d, 8); \
+			c = _mm_add_epi32(c, d); b = _mm_xor_si128(b, c); b = ENET_CHACHA20_ROTATE_SSE2(b, 7);
 
-		if (reliableSequenceNumber == channel->incomingReliableSequenceNumber && startSequenceNumber <= channel->incomingUnreliableSequenceNumber)
-			return 0;
+		/* Each lane runs its own block, the rows are transposed back into four consecutive blocks at the end */
+		static void enet_chacha20_blocks(uint32_t state[16], uint8_t* out) {
+			__m128i x[16], input[16];
+			int i;
 
-		fragmentNumber = ENET_NET_TO_HOST_32(command->sendFragment.fragmentNumber);
-		fragmentCount = ENET_NET_TO_HOST_32(command->sendFragment.fragmentCount);
-		fragmentOffset = ENET_NET_TO_HOST_32(command->sendFragment.fragmentOffset);
-		totalLength = ENET_NET_TO_HOST_32(command->sendFragment.totalLength);
+			for (i = 0; i < 16; ++i) {
+				input[i] = _mm_set1_epi32((int)state[i]);
+			}
 
-		if (fragmentCount > ENET_PROTOCOL_MAXIMUM_FRAGMENT_COUNT || fragmentNumber >= fragmentCount || totalLength > host->maximumPacketSize || fragmentOffset >= totalLength || fragmentLength > totalLength - fragmentOffset)
-			return -1;
+			input[12] = _mm_add_epi32(input[12], _mm_set_epi32(3, 2, 1, 0));
 
-			for (currentCommand = enet_list_previous(enet_list_end(&channel->incomingUnreliableCommands)); currentCommand != enet_list_end(&channel->incomingUnreliableCommands); currentCommand = enet_list_previous(currentCommand)) {
-				ENetIncomingCommand* incomingCommand = (ENetIncomingCommand*)currentCommand;
+			memcpy(x, input, sizeof(x));
 
-				if (reliableSequenceNumber >= channel->incomingReliableSequenceNumber) {
-					if (incomingCommand->reliableSequenceNumber < channel->incomingReliableSequenceNumber)
-						continue;
-				} else if (incomingCommand->reliableSequenceNumber >= channel->incomingReliableSequenceNumber) {
-					break;
-				}
+			for (i = 0; i < 10; ++i) {
+				ENET_CHACHA20_QUARTER_ROUND_SSE2(x[0], x[4], x[8], x[12]);
+				ENET_CHACHA20_QUARTER_ROUND_SSE2(x[1], x[5], x[9], x[13]);
+				ENET_CHACHA20_QUARTER_ROUND_SSE2(x[2], x[6], x[10], x[14]);
+				ENET_CHACHA20_QUARTER_ROUND_SSE2(x[3], x[7], x[11], x[15]);
+				ENET_CHACHA20_QUARTER_ROUND_SSE2(x[0], x[5], x[10], x[15]);
+				ENET_CHACHA20_QUARTER_ROUND_SSE2(x[1], x[6], x[11], x[12]);
+				ENET_CHACHA20_QUARTER_ROUND_SSE2(x[2], x[7], x[8], x[13]);
+				ENET_CHACHA20_QUARTER_ROUND_SSE2(x[3], x[4], x[9], x[14]);
+			}
 
-				if (incomingCommand->reliableSequenceNumber < reliableSequenceNumber)
-					break;
+			for (i = 0; i < 16; i += 4) {
+				__m128i a = _mm_add_epi32(x[i], input[i]);
+				__m128i b = _mm_add_epi32(x[i + 1], input[i + 1]);
+				__m128i c = _mm_add_epi32(x[i + 2], input[i + 2]);
+				__m128i d = _mm_add_epi32(x[i + 3], input[i + 3]);
+				__m128i ab0 = _mm_unpacklo_epi32(a, b), ab1 = _mm_unpackhi_epi32(a, b);
+				__m128i cd0 = _mm_unpacklo_epi32(c, d), cd1 = _mm_unpackhi_epi32(c, d);
+
+				_mm_storeu_si128((__m128i*)&out[0 * 64 + i * 4], _mm_unpacklo_epi64(ab0, cd0));
+				_mm_storeu_si128((__m128i*)&out[1 * 64 + i * 4], _mm_unpackhi_epi64(ab0, cd0));
+				_mm_storeu_si128((__m128i*)&out[2 * 64 + i * 4], _mm_unpacklo_epi64(ab1, cd1));
+				_mm_storeu_si128((__m128i*)&out[3 * 64 + i * 4], _mm_unpackhi_epi64(ab1, cd1));
+			}
 
-				if (incomingCommand->reliableSequenceNumber > reliableSequenceNumber)
-					continue;
+			state[12] += 4;
+		}
+	#else
+		static void enet_chacha20_blocks(uint32_t state[16], uint8_t* out) {
+			int i;
 
-				if (incomingCommand->unreliableSequenceNumber <= startSequenceNumber) {
-					if (incomingCommand->unreliableSequenceNumber < startSequenceNumber)
-						break;
+			for (i = 0; i < 4; ++i) {
+				enet_chacha20_block(state, &out[i * 64]);
+			}
+		}
+	#endif
 
-					if ((incomingCommand->command.header.command & ENET_PROTOCOL_COMMAND_MASK) != ENET_PROTOCOL_COMMAND_SEND_UNRELIABLE_FRAGMENT || totalLength != incomingCommand->packet->dataLength || fragmentCount != incomingCommand->fragmentCount)
-						return -1;
+	/* The extraction step of XChaCha20, it turns a Diffie-Hellman output into a uniform key */
+	static void enet_hchacha20(uint8_t* out, const uint8_t* key, const uint8_t* input) {
+		uint32_t x[16];
+		int i;
 
-					startCommand = incomingCommand;
+		enet_chacha20_setup(x, key, enet_cipher_load32(input), &input[4]);
+		enet_chacha20_rounds(x);
 
-					break;
-				}
-			}
+		for (i = 0; i < 4; ++i) {
+			enet_cipher_store32(&out[i * 4], x[i]);
+			enet_cipher_store32(&out[16 + i * 4], x[12 + i]);
+		}
 
-			if (startCommand == NULL) {
-				startCommand = enet_peer_queue_incoming_command(peer, command, NULL, totalLength, ENET_PACKET_FLAG_UNRELIABLE_FRAGMENTED, fragmentCount);
+		enet_cipher_wipe(x, sizeof(x));
+	}
 
-				if (startCommand == NULL)
-					return -1;
-			}
+	static void enet_poly1305_init(ENetPoly1305* poly1305, const uint8_t* key) {
+		int i;
 
-			if ((startCommand->fragments[fragmentNumber / 32] & (1u << (fragmentNumber % 32))) == 0) {
-				--startCommand->fragmentsRemaining;
-				startCommand->fragments[fragmentNumber / 32] |= (1u << (fragmentNumber % 32));
+		poly1305->r[0] = enet_cipher_load32(&key[0]) & 0x3FFFFFF;
+		poly1305->r[1] = (enet_cipher_load32(&key[3]) >> 2) & 0x3FFFF03;
+		poly1305->r[2] = (enet_cipher_load32(&key[6]) >> 4) & 0x3FFC0FF;
+		poly1305->r[3] = (enet_cipher_load32(&key[9]) >> 6) & 0x3F03FFF;
+		poly1305->r[4] = (enet_cipher_load32(&key[12]) >> 8) & 0x00FFFFF;
 
-			if (fragmentOffset + fragmentLength > startCommand->packet->dataLength)
-				fragmentLength = startCommand->packet->dataLength - fragmentOffset;
+		for (i = 0; i < 4; ++i) {
+			poly1305->pad[i] = enet_cipher_load32(&key[16 + i * 4]);
+		}
 
-			memcpy(startCommand->packet->data + fragmentOffset, (uint8_t*)command + sizeof(ENetProtocolSendFragment), fragmentLength);
+		memset(poly1305->h, 0, sizeof(poly1305->h));
 
-			if (startCommand->fragmentsRemaining <= 0)
-				enet_peer_dispatch_incoming_unreliable_commands(peer, channel, NULL);
+		poly1305->leftover = 0;
+	}
+
+	static void enet_poly1305_blocks(ENetPoly1305* poly1305, const uint8_t* data, size_t dataLength, uint32_t highBit) {
+		const uint32_t r0 = poly1305->r[0], r1 = poly1305->r[1], r2 = poly1305->r[2], r3 = poly1305->r[3], r4 = poly1305->r[4];
+		const uint32_t s1 = r1 * 5, s2 = r2 * 5, s3 = r3 * 5, s4 = r4 * 5;
+		uint32_t h0 = poly1305->h[0], h1 = poly1305->h[1], h2 = poly1305->h[2], h3 = poly1305->h[3], h4 = poly1305->h[4];
+
+		while (dataLength >= 16) {
+			uint64_t d0, d1, d2, d3, d4;
+			uint32_t carry;
+
+			h0 += enet_cipher_load32(&data[0]) & 0x3FFFFFF;
+			h1 += (enet_cipher_load32(&data[3]) >> 2) & 0x3FFFFFF;
+			h2 += (enet_cipher_load32(&data[6]) >> 4) & 0x3FFFFFF;
+			h3 += (enet_cipher_load32(&data[9]) >> 6) & 0x3FFFFFF;
+			h4 += (enet_cipher_load32(&data[12]) >> 8) | highBit;
+
+			d0 = (uint64_t)h0 * r0 + (uint64_t)h1 * s4 + (uint64_t)h2 * s3 + (uint64_t)h3 * s2 + (uint64_t)h4 * s1;
+			d1 = (uint64_t)h0 * r1 + (uint64_t)h1 * r0 + (uint64_t)h2 * s4 + (uint64_t)h3 * s3 + (uint64_t)h4 * s2;
+			d2 = (uint64_t)h0 * r2 + (uint64_t)h1 * r1 + (uint64_t)h2 * r0 + (uint64_t)h3 * s4 + (uint64_t)h4 * s3;
+			d3 = (uint64_t)h0 * r3 + (uint64_t)h1 * r2 + (uint64_t)h2 * r1 + (uint64_t)h3 * r0 + (uint64_t)h4 * s4;
+			d4 = (uint64_t)h0 * r4 + (uint64_t)h1 * r3 + (uint64_t)h2 * r2 + (uint64_t)h3 * r1 + (uint64_t)h4 * r0;
+
+			carry = (uint32_t)(d0 >> 26);
+			h0 = (uint32_t)d0 & 0x3FFFFFF;
+			d1 += carry;
+			carry = (uint32_t)(d1 >> 26);
+			h1 = (uint32_t)d1 & 0x3FFFFFF;
+			d2 += carry;
+			carry = (uint32_t)(d2 >> 26);
+			h2 = (uint32_t)d2 & 0x3FFFFFF;
+			d3 += carry;
+			carry = (uint32_t)(d3 >> 26);
+			h3 = (uint32_t)d3 & 0x3FFFFFF;
+			d4 += carry;
+			carry = (uint32_t)(d4 >> 26);
+			h4 = (uint32_t)d4 & 0x3FFFFFF;
+			h0 += carry * 5;
+			carry = h0 >> 26;
+			h0 &= 0x3FFFFFF;
+			h1 += carry;
+
+			data += 16;
+			dataLength -= 16;
 		}
 
-		return 0;
+		poly1305->h[0] = h0;
+		poly1305->h[1] = h1;
+		poly1305->h[2] = h2;
+		poly1305->h[3] = h3;
+		poly1305->h[4] = h4;
 	}
 
-	static int enet_protocol_handle_ping(ENetHost* host, ENetPeer* peer, const ENetProtocol* command) {
-		if (peer->state != ENET_PEER_STATE_CONNECTED && peer->state != ENET_PEER_STATE_DISCONNECT_LATER)
-			return -1;
+	static void enet_poly1305_update(ENetPoly1305* poly1305, const uint8_t* data, size_t dataLength) {
+		if (poly1305->leftover > 0) {
+			size_t length = ENET_MIN(16 - poly1305->leftover, dataLength);
 
-		return 0;
-	}
+			memcpy(&poly1305->buffer[poly1305->leftover], data, length);
 
-	static int enet_protocol_handle_bandwidth_limit(ENetHost* host, ENetPeer* peer, const ENetProtocol* command) {
-		if (peer->state != ENET_PEER_STATE_CONNECTED && peer->state != ENET_PEER_STATE_DISCONNECT_LATER)
-			return -1;
+			poly1305->leftover += length;
+			data += length;
+			dataLength -= length;
 
-		if (peer->incomingBandwidth != 0)
-			--host->bandwidthLimitedPeers;
+			if (poly1305->leftover < 16)
+				return;
 
-		peer->incomingBandwidth = ENET_NET_TO_HOST_32(command->bandwidthLimit.incomingBandwidth);
-		peer->outgoingBandwidth = ENET_NET_TO_HOST_32(command->bandwidthLimit.outgoingBandwidth);
+			enet_poly1305_blocks(poly1305, poly1305->buffer, 16, 1 << 24);
 
-		if (peer->incomingBandwidth != 0)
-			++host->bandwidthLimitedPeers;
+			poly1305->leftover = 0;
+		}
 
-		if (peer->incomingBandwidth == 0 && host->outgoingBandwidth == 0)
-			peer->windowSize = ENET_PROTOCOL_MAXIMUM_WINDOW_SIZE;
-		else if (peer->incomingBandwidth == 0 || host->outgoingBandwidth == 0)
-			peer->windowSize = (ENET_MAX(peer->incomingBandwidth, host->outgoingBandwidth) / ENET_PEER_WINDOW_SIZE_SCALE) * ENET_PROTOCOL_MINIMUM_WINDOW_SIZE;
-		else
-			peer->windowSize = (ENET_MIN(peer->incomingBandwidth, host->outgoingBandwidth) / ENET_PEER_WINDOW_SIZE_SCALE) * ENET_PROTOCOL_MINIMUM_WINDOW_SIZE;
+		if (dataLength >= 16) {
+			size_t length = dataLength & ~(size_t)15;
 
-		if (peer->windowSize < ENET_PROTOCOL_MINIMUM_WINDOW_SIZE)
-			peer->windowSize = ENET_PROTOCOL_MINIMUM_WINDOW_SIZE;
-		else if (peer->windowSize > ENET_PROTOCOL_MAXIMUM_WINDOW_SIZE)
-			peer->windowSize = ENET_PROTOCOL_MAXIMUM_WINDOW_SIZE;
+			enet_poly1305_blocks(poly1305, data, length, 1 << 24);
 
-		return 0;
-	}
+			data += length;
+			dataLength -= length;
+		}
 
-	static int enet_protocol_handle_throttle_configure(ENetHost* host, ENetPeer* peer, const ENetProtocol* command) {
-		if (peer->state != ENET_PEER_STATE_CONNECTED && peer->state != ENET_PEER_STATE_DISCONNECT_LATER)
-			return -1;
+		if (dataLength > 0) {
+			memcpy(poly1305->buffer, data, dataLength);
 
-		peer->packetThrottleInterval = ENET_NET_TO_HOST_32(command->throttleConfigure.packetThrottleInterval);
-		peer->packetThrottleAcceleration = ENET_NET_TO_HOST_32(command->throttleConfigure.packetThrottleAcceleration);
-		peer->packetThrottleDeceleration = ENET_NET_TO_HOST_32(command->throttleConfigure.packetThrottleDeceleration);
+			poly1305->leftover = dataLength;
+		}
+	}
 
-		return 0;
+	/* The AEAD construction pads both the additional data and the ciphertext to whole blocks */
+	static void enet_poly1305_pad(ENetPoly1305* poly1305) {
+		static const uint8_t zeros[16] = { 0 };
+
+		if (poly1305->leftover > 0)
+			enet_poly1305_update(poly1305, zeros, 16 - poly1305->leftover);
 	}
 
-	static int enet_protocol_handle_disconnect(ENetHost* host, ENetPeer* peer, const ENetProtocol* command) {
-		if (peer->state == ENET_PEER_STATE_DISCONNECTED || peer->state == ENET_PEER_STATE_ZOMBIE || peer->state == ENET_PEER_STATE_ACKNOWLEDGING_DISCONNECT)
-			return 0;
+	static void enet_poly1305_finish(ENetPoly1305* poly1305, uint8_t* tag) {
+		uint32_t h0, h1, h2, h3, h4, g0, g1, g2, g3, g4, carry, mask;
+		uint64_t f;
 
-		enet_peer_reset_queues(peer);
+		if (poly1305->leftover > 0) {
+			poly1305->buffer[poly1305->leftover] = 1;
 
-		if (peer->state == ENET_PEER_STATE_CONNECTION_SUCCEEDED || peer->state == ENET_PEER_STATE_DISCONNECTING || peer->state == ENET_PEER_STATE_CONNECTING) {
-			enet_protocol_dispatch_state(host, peer, ENET_PEER_STATE_ZOMBIE);
-		} else if (peer->state != ENET_PEER_STATE_CONNECTED && peer->state != ENET_PEER_STATE_DISCONNECT_LATER) {
-			if (peer->state == ENET_PEER_STATE_CONNECTION_PENDING)
-				host->recalculateBandwidthLimits = 1;
+			memset(&poly1305->buffer[poly1305->leftover + 1], 0, 16 - poly1305->leftover - 1);
 
-			enet_peer_reset(peer);
-		} else if (command->header.command & ENET_PROTOCOL_COMMAND_FLAG_ACKNOWLEDGE) {
-			enet_protocol_change_state(host, peer, ENET_PEER_STATE_ACKNOWLEDGING_DISCONNECT);
-		} else {
-			enet_protocol_dispatch_state(host, peer, ENET_PEER_STATE_ZOMBIE);
+			enet_poly1305_blocks(poly1305, poly1305->buffer, 16, 0);
 		}
 
-		if (peer->state != ENET_PEER_STATE_DISCONNECTED)
-			peer->eventData = ENET_NET_TO_HOST_32(command->disconnect.data);
+		h0 = poly1305->h[0];
+		h1 = poly1305->h[1];
+		h2 = poly1305->h[2];
+		h3 = poly1305->h[3];
+		h4 = poly1305->h[4];
+
+		carry = h1 >> 26; h1 &= 0x3FFFFFF; h2 += carry;
+		carry = h2 >> 26; h2 &= 0x3FFFFFF; h3 += carry;
+		carry = h3 >> 26; h3 &= 0x3FFFFFF; h4 += carry;
+		carry = h4 >> 26; h4 &= 0x3FFFFFF; h0 += carry * 5;
+		carry = h0 >> 26; h0 &= 0x3FFFFFF; h1 += carry;
+
+		/* h - p is selected when it does not borrow */
+		g0 = h0 + 5; carry = g0 >> 26; g0 &= 0x3FFFFFF;
+		g1 = h1 + carry; carry = g1 >> 26; g1 &= 0x3FFFFFF;
+		g2 = h2 + carry; carry = g2 >> 26; g2 &= 0x3FFFFFF;
+		g3 = h3 + carry; carry = g3 >> 26; g3 &= 0x3FFFFFF;
+		g4 = h4 + carry - (1 << 26);
+
+		mask = (g4 >> 31) - 1;
+		h0 = (h0 & ~mask) | (g0 & mask);
+		h1 = (h1 & ~mask) | (g1 & mask);
+		h2 = (h2 & ~mask) | (g2 & mask);
+		h3 = (h3 & ~mask) | (g3 & mask);
+		h4 = (h4 & ~mask) | (g4 & mask);
+
+		h0 = h0 | (h1 << 26);
+		h1 = (h1 >> 6) | (h2 << 20);
+		h2 = (h2 >> 12) | (h3 << 14);
+		h3 = (h3 >> 18) | (h4 << 8);
+
+		f = (uint64_t)h0 + poly1305->pad[0];
+		enet_cipher_store32(&tag[0], (uint32_t)f);
+		f = (uint64_t)h1 + poly1305->pad[1] + (f >> 32);
+		enet_cipher_store32(&tag[4], (uint32_t)f);
+		f = (uint64_t)h2 + poly1305->pad[2] + (f >> 32);
+		enet_cipher_store32(&tag[8], (uint32_t)f);
+		f = (uint64_t)h3 + poly1305->pad[3] + (f >> 32);
+		enet_cipher_store32(&tag[12], (uint32_t)f);
+
+		enet_cipher_wipe(poly1305, sizeof(ENetPoly1305));
+	}
 
-		return 0;
+	/* The first keystream block keys Poly1305, the remaining ones encrypt the payload */
+	static void enet_aead_start(ENetAead* aead, const uint8_t* key, const uint8_t* nonce, const uint8_t* additionalData, size_t additionalDataLength) {
+		enet_chacha20_setup(aead->state, key, 0, nonce);
+		enet_chacha20_blocks(aead->state, aead->keystream);
+		enet_poly1305_init(&aead->poly1305, aead->keystream);
+		enet_poly1305_update(&aead->poly1305, additionalData, additionalDataLength);
+		enet_poly1305_pad(&aead->poly1305);
+
+		aead->available = sizeof(aead->keystream) - 64;
 	}
 
-	static int enet_protocol_handle_acknowledge(ENetHost* host, ENetEvent* event, ENetPeer* peer, const ENetProtocol* command) {
-		uint32_t roundTripTime, receivedSentTime, receivedReliableSequenceNumber;
-		ENetProtocolCommand commandNumber;
+	static void enet_aead_xor(ENetAead* aead, const uint8_t* in, uint8_t* out, size_t length) {
+		while (length > 0) {
+			const uint8_t* keystream;
+			size_t chunk, i;
 
-		if (peer->state == ENET_PEER_STATE_DISCONNECTED || peer->state == ENET_PEER_STATE_ZOMBIE)
-			return 0;
+			if (aead->available == 0) {
+				enet_chacha20_blocks(aead->state, aead->keystream);
 
-		receivedSentTime = ENET_NET_TO_HOST_16(command->acknowledge.receivedSentTime);
-		receivedSentTime |= host->serviceTime & 0xFFFF0000;
+				aead->available = sizeof(aead->keystream);
+			}
 
-		if ((receivedSentTime & 0x8000) > (host->serviceTime & 0x8000))
-			receivedSentTime -= 0x10000;
+			keystream = &aead->keystream[sizeof(aead->keystream) - aead->available];
+			chunk = ENET_MIN(length, aead->available);
 
-		if (ENET_TIME_LESS(host->serviceTime, receivedSentTime))
-			return 0;
+			for (i = 0; i + sizeof(uint64_t) <= chunk; i += sizeof(uint64_t)) {
+				uint64_t value, mask;
 
-		roundTripTime = ENET_TIME_DIFFERENCE(host->serviceTime, receivedSentTime);
+				memcpy(&value, &in[i], sizeof(uint64_t));
+				memcpy(&mask, &keystream[i], sizeof(uint64_t));
 
-		if (roundTripTime == 0)
-			roundTripTime = 1;
-
-		enet_peer_throttle(peer, roundTripTime);
-
-		if (peer->lastReceiveTime > 0) {
-			if (roundTripTime >= peer->roundTripTime) {
-				uint32_t diff = roundTripTime - peer->roundTripTime;
-				peer->roundTripTimeVariance -= peer->roundTripTimeVariance / 4;
-				peer->roundTripTimeVariance += diff / 4;
-				peer->roundTripTime += diff / 8;
-			} else {
-				uint32_t diff = peer->roundTripTime - roundTripTime;
+				value ^= mask;
 
-				if (diff <= peer->roundTripTimeVariance) {
-					peer->roundTripTimeVariance -= peer->roundTripTimeVariance / 4;
-					peer->roundTripTimeVariance += diff / 4;
-				} else {
-					peer->roundTripTimeVariance -= peer->roundTripTimeVariance / 32;
-					peer->roundTripTimeVariance += diff / 32;
-				}
+				memcpy(&out[i], &value, sizeof(uint64_t));
+			}
 
-				peer->roundTripTime -= diff / 8;
+			for (; i < chunk; ++i) {
+				out[i] = in[i] ^ keystream[i];
 			}
-		} else {
-			peer->roundTripTime = roundTripTime;
-			peer->roundTripTimeVariance = roundTripTime / 2;
+
+			aead->available -= chunk;
+			in += chunk;
+			out += chunk;
+			length -= chunk;
 		}
+	}
 
-		if (peer->roundTripTime < peer->lowestRoundTripTime)
-			peer->lowestRoundTripTime = peer->roundTripTime;
+	static void enet_aead_finish(ENetAead* aead, size_t additionalDataLength, size_t dataLength, uint8_t* tag) {
+		uint8_t lengths[16];
 
-		if (peer->roundTripTimeVariance > peer->highestRoundTripTimeVariance)
-			peer->highestRoundTripTimeVariance = peer->roundTripTimeVariance;
+		enet_poly1305_pad(&aead->poly1305);
+		enet_cipher_store64(&lengths[0], additionalDataLength);
+		enet_cipher_store64(&lengths[8], dataLength);
+		enet_poly1305_update(&aead->poly1305, lengths, sizeof(lengths));
+		enet_poly1305_finish(&aead->poly1305, tag);
+	}
 
-		if (peer->packetThrottleEpoch == 0 || ENET_TIME_DIFFERENCE(host->serviceTime, peer->packetThrottleEpoch) >= peer->packetThrottleInterval) {
-			peer->lastRoundTripTime = peer->lowestRoundTripTime;
-			peer->lastRoundTripTimeVariance = peer->highestRoundTripTimeVariance;
-			peer->lowestRoundTripTime = peer->roundTripTime;
-			peer->highestRoundTripTimeVariance = peer->roundTripTimeVariance;
-			peer->packetThrottleEpoch = host->serviceTime;
+	/* The buffers are gathered into out while they are encrypted, out may also be the only input buffer itself */
+	static size_t enet_aead_seal(const uint8_t* key, const uint8_t* nonce, const uint8_t* additionalData, size_t additionalDataLength, const ENetBuffer* buffers, size_t bufferCount, uint8_t* out, uint8_t* tag) {
+		ENetAead aead;
+		size_t dataLength = 0, i;
+
+		enet_aead_start(&aead, key, nonce, additionalData, additionalDataLength);
+
+		for (i = 0; i < bufferCount; ++i) {
+			enet_aead_xor(&aead, (const uint8_t*)buffers[i].data, &out[dataLength], buffers[i].dataLength);
+			enet_poly1305_update(&aead.poly1305, &out[dataLength], buffers[i].dataLength);
+
+			dataLength += buffers[i].dataLength;
 		}
 
-		peer->lastReceiveTime = ENET_MAX(host->serviceTime, 1);
-		peer->earliestTimeout = 0;
+		enet_aead_finish(&aead, additionalDataLength, dataLength, tag);
+		enet_cipher_wipe(&aead, sizeof(aead));
 
-		receivedReliableSequenceNumber = ENET_NET_TO_HOST_16(command->acknowledge.receivedReliableSequenceNumber);
-		commandNumber = enet_protocol_remove_sent_reliable_command(peer, receivedReliableSequenceNumber, command->header.channelID);
+		return dataLength;
+	}
 
-		switch (peer->state) {
-			case ENET_PEER_STATE_ACKNOWLEDGING_CONNECT:
-				if (commandNumber != ENET_PROTOCOL_COMMAND_VERIFY_CONNECT)
-					return -1;
+	/* The tag is checked before anything is decrypted, a forged datagram is left as it arrived */
+	static int enet_aead_open(const uint8_t* key, const uint8_t* nonce, const uint8_t* additionalData, size_t additionalDataLength, uint8_t* data, size_t dataLength, const uint8_t* tag) {
+		ENetAead aead;
+		uint8_t desiredTag[ENET_PEER_CIPHER_TAG_SIZE];
+		uint8_t difference = 0;
+		int i;
 
-				enet_protocol_notify_connect(host, peer, event);
+		enet_aead_start(&aead, key, nonce, additionalData, additionalDataLength);
+		enet_poly1305_update(&aead.poly1305, data, dataLength);
+		enet_aead_finish(&aead, additionalDataLength, dataLength, desiredTag);
 
-				break;
+		for (i = 0; i < ENET_PEER_CIPHER_TAG_SIZE; ++i) {
+			difference |= desiredTag[i] ^ tag[i];
+		}
 
-			case ENET_PEER_STATE_DISCONNECTING:
-				if (commandNumber != ENET_PROTOCOL_COMMAND_DISCONNECT)
-					return -1;
+		if (difference == 0)
+			enet_aead_xor(&aead, data, data, dataLength);
 
-				enet_protocol_notify_disconnect(host, peer, event);
+		enet_cipher_wipe(&aead, sizeof(aead));
 
-				break;
+		return difference == 0 ? 0 : -1;
+	}
 
-			case ENET_PEER_STATE_DISCONNECT_LATER:
-				if (!enet_peer_has_outgoing_commands(peer))
-					enet_peer_disconnect(peer, peer->eventData);
+	/* Field elements have ten limbs of alternately 26 and 25 bits, so products of two sums still fit into 64 bits */
+	static int enet_x25519_limb_bits(int limb) {
+		return (limb & 1) ? 25 : 26;
+	}
 
-				break;
+	static void enet_x25519_carry(uint64_t h[10]) {
+		uint64_t carry;
+		int i;
 
-			default:
-				break;
+		for (i = 0; i < 9; ++i) {
+			carry = h[i] >> enet_x25519_limb_bits(i);
+			h[i] &= ((uint64_t)1 << enet_x25519_limb_bits(i)) - 1;
+			h[i + 1] += carry;
 		}
 
-		return 0;
+		carry = h[9] >> 25;
+		h[9] &= ((uint64_t)1 << 25) - 1;
+		h[0] += carry * 19;
+		carry = h[0] >> 26;
+		h[0] &= ((uint64_t)1 << 26) - 1;
+		h[1] += carry;
 	}
 
-	static int enet_protocol_handle_verify_connect(ENetHost* host, ENetEvent* event, ENetPeer* peer, const ENetProtocol* command) {
-		uint32_t mtu, windowSize;
-		size_t channelCount;
+	static void enet_x25519_add(uint64_t out[10], const uint64_t a[10], const uint64_t b[10]) {
+		int i;
 
-		if (peer->state != ENET_PEER_STATE_CONNECTING)
-			return 0;
+		for (i = 0; i < 10; ++i) {
+			out[i] = a[i] + b[i];
+		}
+	}
 
-		channelCount = ENET_NET_TO_HOST_32(command->verifyConnect.channelCount);
+	/* Four times p is added first, so the limbs never go negative */
+	static void enet_x25519_subtract(uint64_t out[10], const uint64_t a[10], const uint64_t b[10]) {
+		int i;
 
-		if (channelCount < ENET_PROTOCOL_MINIMUM_CHANNEL_COUNT || channelCount > ENET_PROTOCOL_MAXIMUM_CHANNEL_COUNT || ENET_NET_TO_HOST_32(command->verifyConnect.packetThrottleInterval) != peer->packetThrottleInterval || ENET_NET_TO_HOST_32(command->verifyConnect.packetThrottleAcceleration) != peer->packetThrottleAcceleration || ENET_NET_TO_HOST_32(command->verifyConnect.packetThrottleDeceleration) != peer->packetThrottleDeceleration || command->verifyConnect.connectID != peer->connectID) {
-			peer->eventData = 0;
+		for (i = 0; i < 10; ++i) {
+			out[i] = a[i] + ((((uint64_t)1 << enet_x25519_limb_bits(i)) - (i == 0 ? 19 : 1)) << 2) - b[i];
+		}
 
-			enet_protocol_dispatch_state(host, peer, ENET_PEER_STATE_ZOMBIE);
+		enet_x25519_carry(out);
+	}
 
-			return -1;
-		}
+	static void enet_x25519_multiply(uint64_t out[10], const uint64_t a[10], const uint64_t b[10]) {
+		uint64_t h[10] = { 0 };
+		int i, j;
 
-		enet_protocol_remove_sent_reliable_command(peer, 1, 0xFF);
+		for (i = 0; i < 10; ++i) {
+			for (j = 0; j < 10; ++j) {
+				uint64_t product = a[i] * ((i & j & 1) ? b[j] << 1 : b[j]);
 
-		if (channelCount < peer->channelCount)
-			peer->channelCount = channelCount;
+				if (i + j >= 10)
+					h[i + j - 10] += product * 19;
+				else
+					h[i + j] += product;
+			}
+		}
 
-		peer->outgoingPeerID = ENET_NET_TO_HOST_16(command->verifyConnect.outgoingPeerID);
-		peer->incomingSessionID = command->verifyConnect.incomingSessionID;
-		peer->outgoingSessionID = command->verifyConnect.outgoingSessionID;
-		mtu = ENET_NET_TO_HOST_32(command->verifyConnect.mtu);
+		enet_x25519_carry(h);
 
-		if (mtu < ENET_PROTOCOL_MINIMUM_MTU)
-			mtu = ENET_PROTOCOL_MINIMUM_MTU;
-		else if (mtu > ENET_PROTOCOL_MAXIMUM_MTU)
-			mtu = ENET_PROTOCOL_MAXIMUM_MTU;
+		memcpy(out, h, sizeof(h));
+	}
 
-		if (mtu < peer->mtu)
-			peer->mtu = mtu;
+	static void enet_x25519_multiply_small(uint64_t out[10], const uint64_t a[10], uint32_t b) {
+		int i;
 
-		windowSize = ENET_NET_TO_HOST_32(command->verifyConnect.windowSize);
+		for (i = 0; i < 10; ++i) {
+			out[i] = a[i] * b;
+		}
 
-		if (windowSize < ENET_PROTOCOL_MINIMUM_WINDOW_SIZE)
-			windowSize = ENET_PROTOCOL_MINIMUM_WINDOW_SIZE;
+		enet_x25519_carry(out);
+	}
 
-		if (windowSize > ENET_PROTOCOL_MAXIMUM_WINDOW_SIZE)
-			windowSize = ENET_PROTOCOL_MAXIMUM_WINDOW_SIZE;
+	/* Fermat inversion, raises to p - 2 whose bits are all set except bits two and four */
+	static void enet_x25519_invert(uint64_t out[10], const uint64_t a[10]) {
+		uint64_t c[10];
+		int i;
 
-		if (windowSize < peer->windowSize)
-			peer->windowSize = windowSize;
+		memcpy(c, a, sizeof(c));
 
-		peer->incomingBandwidth = ENET_NET_TO_HOST_32(command->verifyConnect.incomingBandwidth);
-		peer->outgoingBandwidth = ENET_NET_TO_HOST_32(command->verifyConnect.outgoingBandwidth);
+		for (i = 253; i >= 0; --i) {
+			enet_x25519_multiply(c, c, c);
 
-		enet_protocol_notify_connect(host, peer, event);
+			if (i != 2 && i != 4)
+				enet_x25519_multiply(c, c, a);
+		}
 
-		return 0;
+		memcpy(out, c, sizeof(c));
 	}
 
-	static int enet_protocol_handle_incoming_commands(ENetHost* host, ENetEvent* event) {
-		ENetProtocolHeader* header;
-		ENetProtocol* command;
-		ENetPeer* peer;
-		uint8_t* currentData;
-		size_t headerSize;
-		uint16_t peerID, flags;
-		uint8_t sessionID;
+	static void enet_x25519_swap(uint64_t a[10], uint64_t b[10], uint64_t swap) {
+		uint64_t mask = 0 - swap;
+		int i;
 
-		if (host->receivedDataLength < (size_t)&((ENetProtocolHeader*)0)->sentTime)
-			return 0;
+		for (i = 0; i < 10; ++i) {
+			uint64_t difference = mask & (a[i] ^ b[i]);
 
-		header = (ENetProtocolHeader*)host->receivedData;
-		peerID = ENET_NET_TO_HOST_16(header->peerID);
-		sessionID = (peerID & ENET_PROTOCOL_HEADER_SESSION_MASK) >> ENET_PROTOCOL_HEADER_SESSION_SHIFT;
-		flags = peerID & ENET_PROTOCOL_HEADER_FLAG_MASK;
-		peerID &= ~(ENET_PROTOCOL_HEADER_FLAG_MASK | ENET_PROTOCOL_HEADER_SESSION_MASK);
-		headerSize = (flags & ENET_PROTOCOL_HEADER_FLAG_SENT_TIME ? sizeof(ENetProtocolHeader) : (size_t)&((ENetProtocolHeader*)0)->sentTime);
+			a[i] ^= difference;
+			b[i] ^= difference;
+		}
+	}
 
-		if (host->checksumCallback != NULL)
-			headerSize += sizeof(enet_checksum);
+	static void enet_x25519_unpack(uint64_t out[10], const uint8_t* in) {
+		uint64_t accumulator = 0;
+		int bits = 0, position = 0, i;
 
-		if (peerID == ENET_PROTOCOL_MAXIMUM_PEER_ID) {
-			peer = NULL;
-		} else if (peerID >= host->peerCount) {
-			return 0;
-		} else {
-			peer = &host->peers[peerID];
+		for (i = 0; i < 10; ++i) {
+			int limbBits = enet_x25519_limb_bits(i);
 
-			if (peer->state == ENET_PEER_STATE_DISCONNECTED || peer->state == ENET_PEER_STATE_ZOMBIE || ((!enet_in6_equal(host->receivedAddress.ipv6, peer->address.ipv6) || host->receivedAddress.port != peer->address.port) && peer->address.ipv4.ip.s_addr != INADDR_BROADCAST) || (peer->outgoingPeerID < ENET_PROTOCOL_MAXIMUM_PEER_ID && sessionID != peer->incomingSessionID))
-				return 0;
+			while (bits < limbBits) {
+				accumulator |= (uint64_t)(position == 31 ? in[position] & 0x7F : in[position]) << bits;
+				bits += 8;
+				++position;
+			}
+
+			out[i] = accumulator & (((uint64_t)1 << limbBits) - 1);
+			accumulator >>= limbBits;
+			bits -= limbBits;
 		}
+	}
+
+	/* Fully reduces modulo p, adding 19 carries into bit 255 exactly when the value is at least p */
+	static void enet_x25519_pack(uint8_t* out, const uint64_t a[10]) {
+		uint64_t h[10], t[10], carry, mask, accumulator = 0;
+		int bits = 0, position = 0, i;
 
-		if (host->checksumCallback != NULL) {
-			enet_checksum* checksum = (enet_checksum*)&host->receivedData[headerSize - sizeof(enet_checksum)];
-			enet_checksum desiredChecksum, newChecksum;
-			ENetBuffer buffer;
+		memcpy(h, a, sizeof(h));
 
-			memcpy(&desiredChecksum, checksum, sizeof(enet_checksum));
+		enet_x25519_carry(h);
+		enet_x25519_carry(h);
 
-			newChecksum = peer != NULL ? peer->connectID : 0;
+		for (i = 0; i < 9; ++i) {
+			carry = h[i] >> enet_x25519_limb_bits(i);
+			h[i] &= ((uint64_t)1 << enet_x25519_limb_bits(i)) - 1;
+			h[i + 1] += carry;
+		}
 
-			memcpy(checksum, &newChecksum, sizeof(enet_checksum));
+		memcpy(t, h, sizeof(t));
 
-			buffer.data = host->receivedData;
-			buffer.dataLength = host->receivedDataLength;
+		t[0] += 19;
 
-			if (host->checksumCallback(&buffer, 1) != desiredChecksum)
-				return 0;
+		for (i = 0; i < 9; ++i) {
+			carry = t[i] >> enet_x25519_limb_bits(i);
+			t[i] &= ((uint64_t)1 << enet_x25519_limb_bits(i)) - 1;
+			t[i + 1] += carry;
 		}
 
-		if (peer != NULL) {
-			peer->address.ipv6 = host->receivedAddress.ipv6;
-			peer->address.port = host->receivedAddress.port;
-			peer->incomingDataTotal += host->receivedDataLength;
-			peer->totalDataReceived += host->receivedDataLength;
+		mask = 0 - (t[9] >> 25);
+		t[9] &= ((uint64_t)1 << 25) - 1;
+
+		for (i = 0; i < 10; ++i) {
+			h[i] = (t[i] & mask) | (h[i] & ~mask);
 		}
 
-		currentData = host->receivedData + headerSize;
+		for (i = 0; i < 10; ++i) {
+			accumulator |= h[i] << bits;
+			bits += enet_x25519_limb_bits(i);
 
-		while (currentData < &host->receivedData[host->receivedDataLength]) {
-			uint8_t commandNumber;
-			size_t commandSize;
-			command = (ENetProtocol*)currentData;
+			while (bits >= 8) {
+				out[position++] = (uint8_t)accumulator;
+				accumulator >>= 8;
+				bits -= 8;
+			}
+		}
 
-			if (currentData + sizeof(ENetProtocolCommandHeader) > &host->receivedData[host->receivedDataLength])
-				break;
+		out[position] = (uint8_t)accumulator;
+	}
 
-			commandNumber = command->header.command & ENET_PROTOCOL_COMMAND_MASK;
+	/* The Montgomery ladder of RFC 7748, every step swaps in constant time */
+	static void enet_x25519(uint8_t* out, const uint8_t* scalar, const uint8_t* point) {
+		uint64_t x1[10], x2[10] = { 1 }, z2[10] = { 0 }, x3[10], z3[10] = { 1 };
+		uint64_t a[10], aa[10], b[10], bb[10], e[10], c[10], d[10], da[10], cb[10];
+		uint64_t swap = 0;
+		uint8_t k[32];
+		int i;
+
+		memcpy(k, scalar, sizeof(k));
+
+		k[0] &= 248;
+		k[31] &= 127;
+		k[31] |= 64;
+
+		enet_x25519_unpack(x1, point);
+
+		memcpy(x3, x1, sizeof(x3));
+
+		for (i = 254; i >= 0; --i) {
+			uint64_t bit = (k[i >> 3] >> (i & 7)) & 1;
+
+			swap ^= bit;
+
+			enet_x25519_swap(x2, x3, swap);
+			enet_x25519_swap(z2, z3, swap);
+
+			swap = bit;
+
+			enet_x25519_add(a, x2, z2);
+			enet_x25519_multiply(aa, a, a);
+			enet_x25519_subtract(b, x2, z2);
+			enet_x25519_multiply(bb, b, b);
+			enet_x25519_subtract(e, aa, bb);
+			enet_x25519_add(c, x3, z3);
+			enet_x25519_subtract(d, x3, z3);
+			enet_x25519_multiply(da, d, a);
+			enet_x25519_multiply(cb, c, b);
+			enet_x25519_add(x3, da, cb);
+			enet_x25519_multiply(x3, x3, x3);
+			enet_x25519_subtract(z3, da, cb);
+			enet_x25519_multiply(z3, z3, z3);
+			enet_x25519_multiply(z3, z3, x1);
+			enet_x25519_multiply(x2, aa, bb);
+			enet_x25519_multiply_small(z2, e, 121665);
+			enet_x25519_add(z2, z2, aa);
+			enet_x25519_multiply(z2, z2, e);
+		}
 
-			if (commandNumber >= ENET_PROTOCOL_COMMAND_COUNT)
-				break;
+		enet_x25519_swap(x2, x3, swap);
+		enet_x25519_swap(z2, z3, swap);
+		enet_x25519_invert(z2, z2);
+		enet_x25519_multiply(x2, x2, z2);
+		enet_x25519_pack(out, x2);
+
+		enet_cipher_wipe(k, sizeof(k));
+		enet_cipher_wipe(x2, sizeof(x2));
+		enet_cipher_wipe(x3, sizeof(x3));
+		enet_cipher_wipe(z2, sizeof(z2));
+		enet_cipher_wipe(z3, sizeof(z3));
+	}
 
-			commandSize = commandSizes[commandNumber];
+	static void enet_cipher_destroy(ENetPeer* peer) {
+		if (peer->cipher == NULL)
+			return;
 
-			if (commandSize == 0 || currentData + commandSize > &host->receivedData[host->receivedDataLength])
-				break;
+		enet_cipher_wipe(peer->cipher, sizeof(ENetCipher));
+		enet_free(peer->cipher);
 
-			currentData += commandSize;
+		peer->cipher = NULL;
+	}
 
-			if (peer == NULL && (commandNumber != ENET_PROTOCOL_COMMAND_CONNECT || currentData < &host->receivedData[host->receivedDataLength]))
-				break;
+	/* Every connection uses a fresh key pair, so recorded traffic stays sealed even if a host is compromised later */
+	static int enet_cipher_create(ENetPeer* peer) {
+		static const uint8_t basePoint[ENET_PEER_CIPHER_KEY_SIZE] = { 9 };
 
-			command->header.reliableSequenceNumber = ENET_NET_TO_HOST_16(command->header.reliableSequenceNumber);
+		peer->cipher = (ENetCipher*)enet_malloc(sizeof(ENetCipher));
 
-			switch (commandNumber) {
-				case ENET_PROTOCOL_COMMAND_ACKNOWLEDGE:
-					if (enet_protocol_handle_acknowledge(host, event, peer, command))
-						goto commandError;
+		if (peer->cipher == NULL)
+			return -1;
 
-					break;
+		memset(peer->cipher, 0, sizeof(ENetCipher));
 
-				case ENET_PROTOCOL_COMMAND_CONNECT:
-					if (peer != NULL)
-						goto commandError;
+		if (enet_random_bytes(peer->cipher->secretKey, sizeof(peer->cipher->secretKey)) < 0) {
+			enet_cipher_destroy(peer);
 
-					if (host->preventConnections == 0) {
-						peer = enet_protocol_handle_connect(host, header, command);
+			return -1;
+		}
 
-						if (peer == NULL)
-							goto commandError;
-					}
+		enet_x25519(peer->cipher->publicKey, peer->cipher->secretKey, basePoint);
 
-					break;
+		return 0;
+	}
 
-				case ENET_PROTOCOL_COMMAND_VERIFY_CONNECT:
-					if (enet_protocol_handle_verify_connect(host, event, peer, command))
-						goto commandError;
+	/* The shared secret is mixed with the pre-shared key and the connect ID, the first half of the expanded block keys the direction from the connecting side */
+	static int enet_cipher_derive(ENetPeer* peer, const uint8_t* remoteKey, uint32_t connectID, int initiator) {
+		static const uint8_t input[16] = { 0 };
+		ENetCipher* cipher = peer->cipher;
+		uint8_t shared[ENET_PEER_CIPHER_KEY_SIZE], keys[64], nonce[12] = { 0 };
+		uint32_t state[16];
+		uint8_t nonzero = 0;
+		int i;
+
+		enet_x25519(shared, cipher->secretKey, remoteKey);
+		enet_cipher_wipe(cipher->secretKey, sizeof(cipher->secretKey));
+
+		/* A low order point from the remote would force an all zero secret */
+		for (i = 0; i < ENET_PEER_CIPHER_KEY_SIZE; ++i) {
+			nonzero |= shared[i];
+			shared[i] ^= peer->host->presharedKey[i];
+		}
 
-					break;
+		memcpy(nonce, &connectID, sizeof(uint32_t));
 
-				case ENET_PROTOCOL_COMMAND_DISCONNECT:
-					if (enet_protocol_handle_disconnect(host, peer, command))
-						goto commandError;
+		enet_hchacha20(shared, shared, input);
+		enet_chacha20_setup(state, shared, 0, nonce);
+		enet_chacha20_block(state, keys);
 
-					break;
+		memcpy(initiator ? cipher->sendKey : cipher->receiveKey, &keys[0], ENET_PEER_CIPHER_KEY_SIZE);
+		memcpy(initiator ? cipher->receiveKey : cipher->sendKey, &keys[ENET_PEER_CIPHER_KEY_SIZE], ENET_PEER_CIPHER_KEY_SIZE);
 
-				case ENET_PROTOCOL_COMMAND_PING:
-					if (enet_protocol_handle_ping(host, peer, command))
-						goto commandError;
+		enet_cipher_wipe(shared, sizeof(shared));
+		enet_cipher_wipe(keys, sizeof(keys));
+		enet_cipher_wipe(state, sizeof(state));
 
-					break;
+		cipher->keyed = 1;
 
-				case ENET_PROTOCOL_COMMAND_SEND_RELIABLE:
-					if (enet_protocol_handle_send_reliable(host, peer, command, &currentData))
-						goto commandError;
+		return nonzero != 0 ? 0 : -1;
+	}
 
-					break;
+/*
+=======================================================================
 
-				case ENET_PROTOCOL_COMMAND_SEND_UNRELIABLE:
-					if (enet_protocol_handle_send_unreliable(host, peer, command, &currentData))
-						goto commandError;
+	Packet
 
-					break;
+=======================================================================
+*/
 
-				case ENET_PROTOCOL_COMMAND_SEND_UNSEQUENCED:
-					if (enet_protocol_handle_send_unsequenced(host, peer, command, &currentData))
-						goto commandError;
+	#ifdef _MSC_VER
+		#define ENET_THREAD_LOCAL __declspec(thread)
+	#elif defined(__GNUC__) || defined(__clang__)
+		#define ENET_THREAD_LOCAL __thread
+	#else
+		#define ENET_THREAD_LOCAL _Thread_local
+	#endif
 
-					break;
+	typedef struct _ENetPacketPools {
+		struct _ENetPacketPools* next;
+		void* foreignFrees[ENET_PACKET_POOL_CLASSES];
+		int owned;
+		ENetPool pools[ENET_PACKET_POOL_CLASSES];
+	} ENetPacketPools;
 
-				case ENET_PROTOCOL_COMMAND_SEND_FRAGMENT:
-					if (enet_protocol_handle_send_fragment(host, peer, command, &currentData))
-						goto commandError;
+	static const size_t enet_packet_pool_sizes[ENET_PACKET_POOL_CLASSES] = { 64, 128, 256, 512, 1024, ENET_PROTOCOL_MAXIMUM_MTU };
 
-					break;
+	/* Every thread allocates from and frees into its own size classes, the registry is only locked when a thread makes its first packet */
+	static ENET_THREAD_LOCAL ENetPacketPools* enet_packet_pools_local;
+	static ENetPacketPools* enet_packet_pools_registry;
+	static int enet_packet_pools_lock;
 
-				case ENET_PROTOCOL_COMMAND_BANDWIDTH_LIMIT:
-					if (enet_protocol_handle_bandwidth_limit(host, peer, command))
-						goto commandError;
+	#ifdef _WIN32
+		static DWORD enet_packet_pools_key = FLS_OUT_OF_INDEXES;
+	#else
+		static pthread_key_t enet_packet_pools_key;
+		static int enet_packet_pools_keyed;
+	#endif
 
-					break;
+	static void enet_packet_pools_acquire(void) {
+		while (ENET_ATOMIC_CAS(&enet_packet_pools_lock, 0, 1) != 0) {
+			continue;
+		}
+	}
 
-				case ENET_PROTOCOL_COMMAND_THROTTLE_CONFIGURE:
-					if (enet_protocol_handle_throttle_configure(host, peer, command))
-						goto commandError;
+	static void enet_packet_pools_release(void) {
+		ENET_ATOMIC_WRITE(&enet_packet_pools_lock, 0);
+	}
 
-					break;
+	/* Blocks of packets destroyed on other threads wait on a list of the owner, which takes the whole list back at once */
+	static void enet_packet_pools_reclaim(ENetPacketPools* pools, int sizeClass) {
+		void* object = (void*)ENET_ATOMIC_READ(&pools->foreignFrees[sizeClass]);
 
-				case ENET_PROTOCOL_COMMAND_SEND_UNRELIABLE_FRAGMENT:
-					if (enet_protocol_handle_send_unreliable_fragment(host, peer, command, &currentData))
-						goto commandError;
+		if (object == NULL)
+			return;
 
-					break;
+		while (ENET_ATOMIC_CAS(&pools->foreignFrees[sizeClass], object, NULL) != object) {
+			object = (void*)ENET_ATOMIC_READ(&pools->foreignFrees[sizeClass]);
+		}
 
-				default:
-					goto commandError;
-			}
+		while (object != NULL) {
+			void* next = *(void**)object;
 
-			if (peer != NULL && (command->header.command & ENET_PROTOCOL_COMMAND_FLAG_ACKNOWLEDGE) != 0) {
-				uint16_t sentTime;
+			enet_pool_free(&pools->pools[sizeClass], object);
 
-				if (!(flags & ENET_PROTOCOL_HEADER_FLAG_SENT_TIME))
-					break;
+			object = next;
+		}
+	}
 
-				sentTime = ENET_NET_TO_HOST_16(header->sentTime);
+	/* Runs on the thread that owns the size classes as it exits, the blocks go back to the heap and the record waits for the next thread */
+	static void enet_packet_pools_detach(ENetPacketPools* pools) {
+		int sizeClass;
 
-				switch (peer->state) {
-					case ENET_PEER_STATE_DISCONNECTING:
-					case ENET_PEER_STATE_ACKNOWLEDGING_CONNECT:
-					case ENET_PEER_STATE_DISCONNECTED:
-					case ENET_PEER_STATE_ZOMBIE:
-						break;
-
-					case ENET_PEER_STATE_ACKNOWLEDGING_DISCONNECT:
-						if ((command->header.command & ENET_PROTOCOL_COMMAND_MASK) == ENET_PROTOCOL_COMMAND_DISCONNECT)
-							enet_peer_queue_acknowledgement(peer, command, sentTime);
+		for (sizeClass = 0; sizeClass < ENET_PACKET_POOL_CLASSES; ++sizeClass) {
+			enet_packet_pools_reclaim(pools, sizeClass);
+			enet_pool_destroy(&pools->pools[sizeClass]);
+		}
 
-						break;
+		enet_packet_pools_local = NULL;
 
-					default:
-						enet_peer_queue_acknowledgement(peer, command, sentTime);
+		ENET_ATOMIC_WRITE(&pools->owned, 0);
+	}
 
-						break;
-				}
-			}
+	#ifdef _WIN32
+		static void WINAPI enet_packet_pools_exit(void* pools) {
+			if (pools != NULL)
+				enet_packet_pools_detach((ENetPacketPools*)pools);
 		}
+	#else
+		static void enet_packet_pools_exit(void* pools) {
+			enet_packet_pools_detach((ENetPacketPools*)pools);
+		}
+	#endif
 
-		commandError:
-
-		if (event != NULL && event->type != ENET_EVENT_TYPE_NONE)
-			return 1;
+	static ENetPacketPools* enet_packet_pools_get(void) {
+		ENetPacketPools* pools = enet_packet_pools_local;
+		int sizeClass;
 
-		return 0;
-	}
+		if (pools != NULL)
+			return pools;
 
-	static int enet_protocol_receive_incoming_commands(ENetHost* host, ENetEvent* event) {
-		int packets;
+		enet_packet_pools_acquire();
 
-		for (packets = 0; packets < 256; ++packets) {
-			int receivedLength;
-			ENetBuffer buffer;
-			buffer.data = host->packetData[0];
-			buffer.dataLength = host->mtu;
-			receivedLength = enet_socket_receive(host->socket, &host->receivedAddress, &buffer, 1);
+		/* The key only serves to tear the size classes down on thread exit, it lives as long as the process */
+		#ifdef _WIN32
+			if (enet_packet_pools_key == FLS_OUT_OF_INDEXES)
+				enet_packet_pools_key = FlsAlloc(enet_packet_pools_exit);
+		#else
+			if (!enet_packet_pools_keyed)
+				enet_packet_pools_keyed = pthread_key_create(&enet_packet_pools_key, enet_packet_pools_exit) == 0;
+		#endif
 
-			if (receivedLength == -2)
-				continue;
+		for (pools = enet_packet_pools_registry; pools != NULL && ENET_ATOMIC_READ(&pools->owned) != 0; pools = pools->next) {
+			continue;
+		}
 
-			if (receivedLength < 0)
-				return -1;
+		if (pools == NULL) {
+			pools = (ENetPacketPools*)enet_malloc(sizeof(ENetPacketPools));
 
-			if (receivedLength == 0)
-				return 0;
+			if (pools != NULL) {
+				memset(pools->foreignFrees, 0, sizeof(pools->foreignFrees));
 
-			host->receivedData = host->packetData[0];
-			host->receivedDataLength = receivedLength;
-			host->totalReceivedData += receivedLength;
-			host->totalReceivedPackets++;
+				pools->next = enet_packet_pools_registry;
+				enet_packet_pools_registry = pools;
+			}
+		}
 
-			if (host->interceptCallback != NULL) {
-				switch (host->interceptCallback(event, &host->receivedAddress, host->receivedData, host->receivedDataLength)) {
-					case 1:
-						if (event != NULL && event->type != ENET_EVENT_TYPE_NONE)
-							return 1;
+		if (pools != NULL)
+			ENET_ATOMIC_WRITE(&pools->owned, 1);
 
-						continue;
+		enet_packet_pools_release();
 
-					case -1:
-						return -1;
+		if (pools == NULL)
+			return NULL;
 
-					default:
-						break;
-				}
-			}
+		for (sizeClass = 0; sizeClass < ENET_PACKET_POOL_CLASSES; ++sizeClass) {
+			enet_pool_initialize(&pools->pools[sizeClass], sizeof(ENetPacket) + enet_packet_pool_sizes[sizeClass], ENET_PACKET_POOL_HIGH_WATER_MARK);
+		}
 
-			switch (enet_protocol_handle_incoming_commands(host, event)) {
-				case 1:
-					return 1;
+		#ifdef _WIN32
+			if (enet_packet_pools_key != FLS_OUT_OF_INDEXES)
+				FlsSetValue(enet_packet_pools_key, pools);
+		#else
+			if (enet_packet_pools_keyed)
+				pthread_setspecific(enet_packet_pools_key, pools);
+		#endif
 
-				case -1:
-					return -1;
+		enet_packet_pools_local = pools;
 
-				default:
-					break;
-			}
+		/* A record taken over from an exited thread may still get back blocks of packets that outlived it */
+		for (sizeClass = 0; sizeClass < ENET_PACKET_POOL_CLASSES; ++sizeClass) {
+			enet_packet_pools_reclaim(pools, sizeClass);
 		}
 
-		return 0;
+		return pools;
 	}
 
-	static void enet_protocol_send_acknowledgements(ENetHost* host, ENetPeer* peer) {
-		ENetProtocol* command = &host->commands[host->commandCount];
-		ENetBuffer* buffer = &host->buffers[host->bufferCount];
-		ENetAcknowledgement* acknowledgement;
-		ENetListIterator currentAcknowledgement;
-		uint16_t reliableSequenceNumber;
-		currentAcknowledgement = enet_list_begin(&peer->acknowledgements);
-
-		while (currentAcknowledgement != enet_list_end(&peer->acknowledgements)) {
-			if (command >= &host->commands[sizeof(host->commands) / sizeof(ENetProtocol)] || buffer >= &host->buffers[sizeof(host->buffers) / sizeof(ENetBuffer)] || peer->mtu - host->packetSize < sizeof(ENetProtocolAcknowledge)) {
-				peer->continueSending = 1;
+	static ENetPacket* enet_packet_allocate(size_t dataLength) {
+		ENetPacketPools* pools = enet_packet_pools_get();
+		ENetPacket* packet;
+		int sizeClass;
 
+		for (sizeClass = 0; sizeClass < ENET_PACKET_POOL_CLASSES; ++sizeClass) {
+			if (dataLength <= enet_packet_pool_sizes[sizeClass])
 				break;
-			}
+		}
 
-			acknowledgement = (ENetAcknowledgement*)currentAcknowledgement;
-			currentAcknowledgement = enet_list_next(currentAcknowledgement);
-			buffer->data = command;
-			buffer->dataLength = sizeof(ENetProtocolAcknowledge);
-			host->packetSize += buffer->dataLength;
-			reliableSequenceNumber = ENET_HOST_TO_NET_16(acknowledgement->command.header.reliableSequenceNumber);
-			command->header.command = ENET_PROTOCOL_COMMAND_ACKNOWLEDGE;
-			command->header.channelID = acknowledgement->command.header.channelID;
-			command->header.reliableSequenceNumber = reliableSequenceNumber;
-			command->acknowledge.receivedReliableSequenceNumber = reliableSequenceNumber;
-			command->acknowledge.receivedSentTime = ENET_HOST_TO_NET_16(acknowledgement->sentTime);
+		if (pools == NULL || sizeClass == ENET_PACKET_POOL_CLASSES) {
+			packet = (ENetPacket*)enet_malloc(sizeof(ENetPacket) + dataLength);
 
-			if ((acknowledgement->command.header.command & ENET_PROTOCOL_COMMAND_MASK) == ENET_PROTOCOL_COMMAND_DISCONNECT)
-				enet_protocol_dispatch_state(host, peer, ENET_PEER_STATE_ZOMBIE);
+			if (packet != NULL)
+				packet->sizeClass = -1;
 
-			enet_list_remove(&acknowledgement->acknowledgementList);
-			enet_free(acknowledgement);
+			return packet;
+		}
 
-			++command;
-			++buffer;
+		if (pools->pools[sizeClass].freeList == NULL)
+			enet_packet_pools_reclaim(pools, sizeClass);
+
+		packet = (ENetPacket*)enet_pool_allocate(&pools->pools[sizeClass]);
+
+		if (packet != NULL) {
+			packet->sizeClass = sizeClass;
+			packet->owner = pools;
 		}
 
-		host->commandCount = command - host->commands;
-		host->bufferCount = buffer - host->buffers;
+		return packet;
 	}
 
-	static int enet_protocol_check_timeouts(ENetHost* host, ENetPeer* peer, ENetEvent* event) {
-		ENetOutgoingCommand* outgoingCommand;
-		ENetListIterator currentCommand, insertPosition, insertSendReliablePosition;
-		currentCommand = enet_list_begin(&peer->sentReliableCommands);
-		insertPosition = enet_list_begin(&peer->outgoingCommands);
-		insertSendReliablePosition = enet_list_begin(&peer->outgoingSendReliableCommands);
+	/* Only the calling thread's size classes are filled, threads that create packets for a host other than the one servicing it call this themselves */
+	void enet_packet_pool_prewarm(size_t count) {
+		ENetPacketPools* pools = enet_packet_pools_get();
+		int sizeClass;
 
-		while (currentCommand != enet_list_end(&peer->sentReliableCommands)) {
-			outgoingCommand = (ENetOutgoingCommand*)currentCommand;
-			currentCommand = enet_list_next(currentCommand);
+		if (pools == NULL)
+			return;
 
-			if (ENET_TIME_DIFFERENCE(host->serviceTime, outgoingCommand->sentTime) < outgoingCommand->roundTripTimeout)
-				continue;
+		for (sizeClass = 0; sizeClass < ENET_PACKET_POOL_CLASSES; ++sizeClass) {
+			ENetPool* pool = &pools->pools[sizeClass];
 
-			if (peer->earliestTimeout == 0 || ENET_TIME_LESS(outgoingCommand->sentTime, peer->earliestTimeout))
-				peer->earliestTimeout = outgoingCommand->sentTime;
+			enet_packet_pools_reclaim(pools, sizeClass);
 
-			if (peer->earliestTimeout != 0 && (ENET_TIME_DIFFERENCE(host->serviceTime, peer->earliestTimeout) >= peer->timeoutMaximum || ((uint32_t)(1u << ((outgoingCommand->sendAttempts - 1) % 32)) >= peer->timeoutLimit && ENET_TIME_DIFFERENCE(host->serviceTime, peer->earliestTimeout) >= peer->timeoutMinimum))) {
-				enet_protocol_notify_disconnect_timeout(host, peer, event);
+			while (pool->freeCount < ENET_MIN(count, pool->highWaterMark)) {
+				void* object = enet_malloc(pool->objectSize);
 
-				return 1;
+				if (object == NULL)
+					break;
+
+				enet_pool_free(pool, object);
 			}
+		}
+	}
 
-			++peer->totalPacketsLost;
-			outgoingCommand->roundTripTimeout = peer->roundTripTime + 4 * peer->roundTripTimeVariance;
+	/* Statistics are those of the calling thread's size class, blocks other threads gave back included */
+	int enet_packet_pool_get_stats(size_t sizeClass, ENetPacketPoolStats* stats) {
+		ENetPacketPools* pools;
+		ENetPool* pool;
 
-			if (outgoingCommand->packet != NULL) {
-				peer->reliableDataInTransit -= outgoingCommand->fragmentLength;
+		if (sizeClass >= ENET_PACKET_POOL_CLASSES)
+			return -1;
 
-				enet_list_insert(insertSendReliablePosition, enet_list_remove(&outgoingCommand->outgoingCommandList));
-	  		} else {
-				enet_list_insert(insertPosition, enet_list_remove(&outgoingCommand->outgoingCommandList));
-			}
+		pools = enet_packet_pools_get();
 
-			if (currentCommand == enet_list_begin(&peer->sentReliableCommands) && !enet_list_empty(&peer->sentReliableCommands)) {
-				outgoingCommand = (ENetOutgoingCommand*)currentCommand;
-				peer->nextTimeout = outgoingCommand->sentTime + outgoingCommand->roundTripTimeout;
-			}
-		}
+		if (pools == NULL)
+			return -1;
+
+		enet_packet_pools_reclaim(pools, (int)sizeClass);
+
+		pool = &pools->pools[sizeClass];
+		stats->dataSize = enet_packet_pool_sizes[sizeClass];
+		stats->freeCount = pool->freeCount;
+		stats->highWaterMark = pool->highWaterMark;
+		stats->allocations = pool->allocations;
+		stats->heapAllocations = pool->heapAllocations;
+		stats->heapFrees = pool->heapFrees;
 
 		return 0;
 	}
 
-	static int enet_protocol_check_outgoing_commands(ENetHost* host, ENetPeer* peer, ENetList* sentUnreliableCommands) {
-		ENetProtocol* command = &host->commands[host->commandCount];
-		ENetBuffer* buffer = &host->buffers[host->bufferCount];
-		ENetOutgoingCommand* outgoingCommand;
-		ENetListIterator currentCommand, currentSendReliableCommand;
-		ENetChannel* channel = NULL;
-		uint16_t reliableWindow = 0;
-		size_t commandSize = 0;
-		int windowWrap = 0, canPing = 1;
+	/* Only the calling thread's size classes are released, other threads release theirs as they exit */
+	void enet_packet_pool_clear(void) {
+		ENetPacketPools* pools = enet_packet_pools_local;
+		int sizeClass;
 
-		currentCommand = enet_list_begin(&peer->outgoingCommands);
-		currentSendReliableCommand = enet_list_begin(&peer->outgoingSendReliableCommands);
+		if (pools == NULL)
+			return;
 
-		for (;;) {
-			if (currentCommand != enet_list_end(&peer->outgoingCommands)) {
-				outgoingCommand = (ENetOutgoingCommand*)currentCommand;
+		for (sizeClass = 0; sizeClass < ENET_PACKET_POOL_CLASSES; ++sizeClass) {
+			enet_packet_pools_reclaim(pools, sizeClass);
+			enet_pool_destroy(&pools->pools[sizeClass]);
+		}
+	}
 
-				if (currentSendReliableCommand != enet_list_end(&peer->outgoingSendReliableCommands) && ENET_TIME_LESS(((ENetOutgoingCommand*)currentSendReliableCommand)->queueTime, outgoingCommand->queueTime))
-					goto useSendReliableCommand;
+	ENetPacket* enet_packet_create(const void* data, size_t dataLength, uint32_t flags) {
+		ENetPacket* packet;
 
-					currentCommand = enet_list_next(currentCommand);
-				}
-				else if (currentSendReliableCommand != enet_list_end(&peer->outgoingSendReliableCommands)) {
-					useSendReliableCommand:
+		if (flags & ENET_PACKET_FLAG_NO_ALLOCATE) {
+			packet = enet_packet_allocate(0);
 
-					outgoingCommand = (ENetOutgoingCommand*)currentSendReliableCommand;
-					currentSendReliableCommand = enet_list_next(currentSendReliableCommand);
-				}
-				else {
-					break;
-				}
+			if (packet == NULL)
+				return NULL;
 
-			if (outgoingCommand->command.header.command & ENET_PROTOCOL_COMMAND_FLAG_ACKNOWLEDGE) {
-				channel = outgoingCommand->command.header.channelID < peer->channelCount ? &peer->channels[outgoingCommand->command.header.channelID] : NULL;
-				reliableWindow = outgoingCommand->reliableSequenceNumber / ENET_PEER_RELIABLE_WINDOW_SIZE;
+			packet->data = (uint8_t*)data;
+		} else {
+			packet = enet_packet_allocate(dataLength);
 
-				if (channel != NULL) {
-					if (windowWrap) {
-			   			continue;
-					} else if (outgoingCommand->sendAttempts < 1 && !(outgoingCommand->reliableSequenceNumber % ENET_PEER_RELIABLE_WINDOW_SIZE) && (channel->reliableWindows[(reliableWindow + ENET_PEER_RELIABLE_WINDOWS - 1) % ENET_PEER_RELIABLE_WINDOWS] >= ENET_PEER_RELIABLE_WINDOW_SIZE || channel->usedReliableWindows & ((((1u << (ENET_PEER_FREE_RELIABLE_WINDOWS + 2)) - 1) << reliableWindow) | (((1u << (ENET_PEER_FREE_RELIABLE_WINDOWS + 2)) - 1) >> (ENET_PEER_RELIABLE_WINDOWS - reliableWindow))))) {
-						windowWrap = 1;
-						currentSendReliableCommand = enet_list_end(&peer->outgoingSendReliableCommands);
+			if (packet == NULL)
+				return NULL;
 
-						continue;
-					}
-				}
+			packet->data = (uint8_t*)packet + sizeof(ENetPacket);
 
-				if (outgoingCommand->packet != NULL) {
-					uint32_t windowSize = (peer->packetThrottle * peer->windowSize) / ENET_PEER_PACKET_THROTTLE_SCALE;
+			if (data != NULL)
+				memcpy(packet->data, data, dataLength);
+		}
 
-					if (peer->reliableDataInTransit + outgoingCommand->fragmentLength > ENET_MAX(windowSize, peer->mtu)) {
-						currentSendReliableCommand = enet_list_end(&peer->outgoingSendReliableCommands);
+		packet->referenceCount = 0;
+		packet->flags = flags;
+		packet->dataLength = dataLength;
+		packet->freeCallback = NULL;
+		packet->userData = NULL;
 
-						continue;
-					}
-				}
+		return packet;
+	}
 
-				canPing = 0;
-			}
+	ENetPacket* enet_packet_create_offset(const void* data, size_t dataLength, size_t dataOffset, uint32_t flags) {
+		ENetPacket* packet;
 
-			commandSize = commandSizes[outgoingCommand->command.header.command & ENET_PROTOCOL_COMMAND_MASK];
+		if (flags & ENET_PACKET_FLAG_NO_ALLOCATE) {
+			packet = enet_packet_allocate(0);
 
-			if (command >= &host->commands[sizeof(host->commands) / sizeof(ENetProtocol)] || buffer + 1 >= &host->buffers[sizeof(host->buffers) / sizeof(ENetBuffer)] || peer->mtu - host->packetSize < commandSize || (outgoingCommand->packet != NULL && (uint16_t)(peer->mtu - host->packetSize) < (uint16_t)(commandSize + outgoingCommand->fragmentLength))) {
-				peer->continueSending = 1;
+			if (packet == NULL)
+				return NULL;
 
-				break;
-			}
+			packet->data = (uint8_t*)data;
+		} else {
+			packet = enet_packet_allocate(dataLength - dataOffset);
 
-			if (outgoingCommand->command.header.command & ENET_PROTOCOL_COMMAND_FLAG_ACKNOWLEDGE) {
-				if (channel != NULL && outgoingCommand->sendAttempts < 1) {
-					channel->usedReliableWindows |= 1u << reliableWindow;
-					++channel->reliableWindows[reliableWindow];
-				}
+			if (packet == NULL)
+				return NULL;
 
-				++outgoingCommand->sendAttempts;
+			packet->data = (uint8_t*)packet + sizeof(ENetPacket);
 
-				if (outgoingCommand->roundTripTimeout == 0)
-					outgoingCommand->roundTripTimeout = peer->roundTripTime + 4 * peer->roundTripTimeVariance;
+			if (data != NULL)
+				memcpy(packet->data, (char*)data + dataOffset, dataLength - dataOffset);
+		}
 
-				if (enet_list_empty(&peer->sentReliableCommands))
-					peer->nextTimeout = host->serviceTime + outgoingCommand->roundTripTimeout;
+		packet->referenceCount = 0;
+		packet->flags = flags;
+		packet->dataLength = dataLength - dataOffset;
+		packet->freeCallback = NULL;
+		packet->userData = NULL;
 
-				enet_list_insert(enet_list_end(&peer->sentReliableCommands),
-				enet_list_remove(&outgoingCommand->outgoingCommandList));
+		return packet;
+	}
 
-				outgoingCommand->sentTime = host->serviceTime;
-				host->headerFlags |= ENET_PROTOCOL_HEADER_FLAG_SENT_TIME;
-				peer->reliableDataInTransit += outgoingCommand->fragmentLength;
-			} else {
-				if (outgoingCommand->packet != NULL && outgoingCommand->fragmentOffset == 0 && !(outgoingCommand->packet->flags & (ENET_PACKET_FLAG_UNTHROTTLED))) {
-					peer->packetThrottleCounter += ENET_PEER_PACKET_THROTTLE_COUNTER;
-					peer->packetThrottleCounter %= ENET_PEER_PACKET_THROTTLE_SCALE;
+	void enet_packet_destroy(ENetPacket* packet) {
+		ENetPacketPools* pools;
+		int sizeClass;
 
-					if (peer->packetThrottleCounter > peer->packetThrottle) {
-						uint16_t reliableSequenceNumber = outgoingCommand->reliableSequenceNumber,
+		if (packet == NULL)
+			return;
 
-						unreliableSequenceNumber = outgoingCommand->unreliableSequenceNumber;
+		if (packet->freeCallback != NULL)
+			(*packet->freeCallback)((void*)packet);
 
-						for (;;) {
-							--outgoingCommand->packet->referenceCount;
+		sizeClass = packet->sizeClass;
 
-							if (outgoingCommand->packet->referenceCount == 0)
-								enet_packet_destroy(outgoingCommand->packet);
+		if (sizeClass < 0) {
+			enet_free(packet);
 
-							enet_list_remove(&outgoingCommand->outgoingCommandList);
-							enet_free(outgoingCommand);
+			return;
+		}
 
-							if (currentCommand == enet_list_end(&peer->outgoingCommands))
-								break;
+		pools = (ENetPacketPools*)packet->owner;
 
-							outgoingCommand = (ENetOutgoingCommand*)currentCommand;
+		/* A packet destroyed on another thread than the one that created it goes back to the size class it came from */
+		if (pools != enet_packet_pools_local) {
+			void* head;
 
-							if (outgoingCommand->reliableSequenceNumber != reliableSequenceNumber || outgoingCommand->unreliableSequenceNumber != unreliableSequenceNumber)
-								break;
+			do {
+				head = (void*)ENET_ATOMIC_READ(&pools->foreignFrees[sizeClass]);
+				*(void**)packet = head;
+			}
 
-							currentCommand = enet_list_next(currentCommand);
-						}
-
-						continue;
-					}
-				}
+			while (ENET_ATOMIC_CAS(&pools->foreignFrees[sizeClass], head, (void*)packet) != head);
 
-				enet_list_remove(&outgoingCommand->outgoingCommandList);
+			return;
+		}
 
-				if (outgoingCommand->packet != NULL)
-					enet_list_insert(enet_list_end(sentUnreliableCommands), outgoingCommand);
-			}
+		enet_pool_free(&pools->pools[sizeClass], packet);
+	}
 
-			buffer->data = command;
-			buffer->dataLength = commandSize;
-			host->packetSize += buffer->dataLength;
-			*command = outgoingCommand->command;
+	/* Aggregated messages are prefixed with their length, one byte below 0x80 and two bytes with the high bit set above */
+	static size_t enet_packet_read_aggregate(const uint8_t* data, size_t dataLength, size_t* messageLength) {
+		if (dataLength < 1)
+			return 0;
 
-			if (outgoingCommand->packet != NULL) {
-				++buffer;
-				buffer->data = outgoingCommand->packet->data + outgoingCommand->fragmentOffset;
-				buffer->dataLength = outgoingCommand->fragmentLength;
-				host->packetSize += outgoingCommand->fragmentLength;
-			} else if (!(outgoingCommand->command.header.command & ENET_PROTOCOL_COMMAND_FLAG_ACKNOWLEDGE)) {
-				enet_free(outgoingCommand);
-			}
+		if (!(data[0] & 0x80)) {
+			*messageLength = data[0];
 
-			++peer->totalPacketsSent;
-			++command;
-			++buffer;
+			return *messageLength <= dataLength - 1 ? 1 : 0;
 		}
 
-		host->commandCount = command - host->commands;
-		host->bufferCount = buffer - host->buffers;
+		if (dataLength < 2)
+			return 0;
 
-		if (peer->state == ENET_PEER_STATE_DISCONNECT_LATER && !enet_peer_has_outgoing_commands(peer) && enet_list_empty(sentUnreliableCommands))
-			enet_peer_disconnect(peer, peer->eventData);
+		*messageLength = ((size_t)(data[0] & 0x7F) << 8) | data[1];
 
-		return canPing;
+		return *messageLength <= dataLength - 2 ? 2 : 0;
 	}
 
-	static int enet_protocol_send_outgoing_commands(ENetHost* host, ENetEvent* event, int checkForTimeouts) {
-		uint8_t headerData[sizeof(ENetProtocolHeader) + sizeof(enet_checksum)];
-		ENetProtocolHeader* header = (ENetProtocolHeader*)headerData;
-		int sentLength = 0;
-		ENetList sentUnreliableCommands;
+	static size_t enet_packet_write_aggregate(uint8_t* data, size_t messageLength) {
+		if (messageLength < 0x80) {
+			data[0] = (uint8_t)messageLength;
 
-		enet_list_clear(&sentUnreliableCommands);
+			return 1;
+		}
 
-		for (int sendPass = 0, continueSending = 0; sendPass <= continueSending; ++sendPass) {
-			for (ENetPeer* currentPeer = host->peers; currentPeer < &host->peers[host->peerCount]; ++currentPeer) {
-				if (currentPeer->state == ENET_PEER_STATE_DISCONNECTED || currentPeer->state == ENET_PEER_STATE_ZOMBIE || (sendPass > 0 && !currentPeer->continueSending))
-					continue;
+		data[0] = (uint8_t)(0x80 | (messageLength >> 8));
+		data[1] = (uint8_t)messageLength;
 
-				currentPeer->continueSending = 0;
+		return 2;
+	}
 
-				host->headerFlags = 0;
-				host->commandCount = 0;
-				host->bufferCount = 1;
-				host->packetSize = sizeof(ENetProtocolHeader);
+/*
+=======================================================================
 
-				if (host->checksumCallback != NULL)
-					host->packetSize += sizeof(enet_checksum);
+	Protocol
 
-				if (!enet_list_empty(&currentPeer->acknowledgements))
-					enet_protocol_send_acknowledgements(host, currentPeer);
+=======================================================================
+*/
 
-				if (checkForTimeouts != 0 && !enet_list_empty(&currentPeer->sentReliableCommands) && ENET_TIME_GREATER_EQUAL(host->serviceTime, currentPeer->nextTimeout) && enet_protocol_check_timeouts(host, currentPeer, event) == 1) {
-					if (event != NULL && event->type != ENET_EVENT_TYPE_NONE)
-						return 1;
-					else
-						goto nextPeer;
-				}
+	static size_t commandSizes[ENET_PROTOCOL_COMMAND_COUNT] = {
+		0,
+		sizeof(ENetProtocolAcknowledge),
+		sizeof(ENetProtocolConnect),
+		sizeof(ENetProtocolVerifyConnect),
+		sizeof(ENetProtocolDisconnect),
+		sizeof(ENetProtocolPing),
+		sizeof(ENetProtocolSendReliable),
+		sizeof(ENetProtocolSendUnreliable),
+		sizeof(ENetProtocolSendFragment),
+		sizeof(ENetProtocolSendUnsequenced),
+		sizeof(ENetProtocolBandwidthLimit),
+		sizeof(ENetProtocolThrottleConfigure),
+		sizeof(ENetProtocolSendFragment),
+		sizeof(ENetProtocolSelectiveAcknowledge),
+		sizeof(ENetProtocolProbe),
+		sizeof(ENetProtocolPiece)
+	};
 
-				if (((enet_list_empty(&currentPeer->outgoingCommands) && enet_list_empty(&currentPeer->outgoingSendReliableCommands)) || enet_protocol_check_outgoing_commands(host, currentPeer, &sentUnreliableCommands)) && enet_list_empty(&currentPeer->sentReliableCommands) && ENET_TIME_DIFFERENCE(host->serviceTime, currentPeer->lastReceiveTime) >= currentPeer->pingInterval && currentPeer->mtu - host->packetSize >= sizeof(ENetProtocolPing)) {
-					enet_peer_ping(currentPeer);
-					enet_protocol_check_outgoing_commands(host, currentPeer, &sentUnreliableCommands);
-				}
+	size_t enet_protocol_command_size(uint8_t commandNumber) {
+		return commandSizes[commandNumber & ENET_PROTOCOL_COMMAND_MASK];
+	}
 
-				if (host->commandCount == 0)
-					goto nextPeer;
+	static void enet_protocol_change_state(ENetHost* host, ENetPeer* peer, ENetPeerState state) {
+		if (state == ENET_PEER_STATE_CONNECTED || state == ENET_PEER_STATE_DISCONNECT_LATER)
+			enet_peer_on_connect(peer);
+		else
+			enet_peer_on_disconnect(peer);
 
-				host->buffers->data = headerData;
+		peer->state = state;
+	}
 
-				if (host->headerFlags & ENET_PROTOCOL_HEADER_FLAG_SENT_TIME) {
-					header->sentTime = ENET_HOST_TO_NET_16(host->serviceTime & 0xFFFF);
-					host->buffers->dataLength = sizeof(ENetProtocolHeader);
-				} else {
-					host->buffers->dataLength = (size_t)&((ENetProtocolHeader*)0)->sentTime;
-				}
+	static void enet_protocol_dispatch_state(ENetHost* host, ENetPeer* peer, ENetPeerState state) {
+		enet_protocol_change_state(host, peer, state);
 
-				if (currentPeer->outgoingPeerID < ENET_PROTOCOL_MAXIMUM_PEER_ID)
-					host->headerFlags |= currentPeer->outgoingSessionID << ENET_PROTOCOL_HEADER_SESSION_SHIFT;
+		if (!peer->needsDispatch) {
+			enet_list_insert(enet_list_end(&host->dispatchQueue), &peer->dispatchList);
 
-				header->peerID = ENET_HOST_TO_NET_16(currentPeer->outgoingPeerID | host->headerFlags);
+			peer->needsDispatch = 1;
+		}
+	}
+
+	static int enet_protocol_dispatch_incoming_commands(ENetHost* host, ENetEvent* event) {
+		while (!enet_list_empty(&host->dispatchQueue)) {
+			ENetPeer* peer = (ENetPeer*)enet_list_remove(enet_list_begin(&host->dispatchQueue));
+			peer->needsDispatch = 0;
 
-				if (host->checksumCallback != NULL) {
-					enet_checksum* checksum = (enet_checksum*)&headerData[host->buffers->dataLength];
-					enet_checksum newChecksum = currentPeer->outgoingPeerID < ENET_PROTOCOL_MAXIMUM_PEER_ID ? currentPeer->connectID : 0;
+			switch (peer->state) {
+				case ENET_PEER_STATE_CONNECTION_PENDING:
+				case ENET_PEER_STATE_CONNECTION_SUCCEEDED:
+					enet_protocol_change_state(host, peer, ENET_PEER_STATE_CONNECTED);
 
-					memcpy(checksum, &newChecksum, sizeof(enet_checksum));
+					event->type = ENET_EVENT_TYPE_CONNECT;
+					event->peer = peer;
+					event->data = peer->eventData;
 
-					host->buffers->dataLength += sizeof(enet_checksum);
-					newChecksum = host->checksumCallback(host->buffers, host->bufferCount);
+					return 1;
 
-					memcpy(checksum, &newChecksum, sizeof(enet_checksum));
-				}
+				case ENET_PEER_STATE_ZOMBIE:
+					host->recalculateBandwidthLimits = 1;
+					event->type = ENET_EVENT_TYPE_DISCONNECT;
+					event->peer = peer;
+					event->data = peer->eventData;
 
-				currentPeer->lastSendTime = host->serviceTime;
-				sentLength = enet_socket_send(host->socket, &currentPeer->address, host->buffers, host->bufferCount);
+					enet_peer_reset(peer);
 
-				enet_protocol_remove_sent_unreliable_commands(currentPeer, &sentUnreliableCommands);
+					return 1;
 
-				if (sentLength < 0)
-					return -1;
+				case ENET_PEER_STATE_CONNECTED:
+					if (enet_list_empty(&peer->dispatchedCommands))
+						continue;
 
-				host->totalSentData += sentLength;
-				currentPeer->totalDataSent += sentLength;
-				host->totalSentPackets++;
+					event->packet = enet_peer_receive(peer, &event->channelID);
 
-				nextPeer:
+					if (event->packet == NULL)
+						continue;
 
-				if (currentPeer->continueSending)
-					continueSending = sendPass + 1;
+					event->type = ENET_EVENT_TYPE_RECEIVE;
+					event->peer = peer;
+
+					if (!enet_list_empty(&peer->dispatchedCommands)) {
+						peer->needsDispatch = 1;
+
+						enet_list_insert(enet_list_end(&host->dispatchQueue), &peer->dispatchList);
+					}
+
+					return 1;
+
+				default:
+					break;
 			}
 		}
 
 		return 0;
 	}
 
-	void enet_host_flush(ENetHost* host) {
-		host->serviceTime = enet_time_get();
+	static void enet_protocol_notify_connect(ENetHost* host, ENetPeer* peer, ENetEvent* event) {
+		host->recalculateBandwidthLimits = 1;
 
-		enet_protocol_send_outgoing_commands(host, NULL, 0);
-	}
+		if (event != NULL) {
+			enet_protocol_change_state(host, peer, ENET_PEER_STATE_CONNECTED);
 
-	int enet_host_check_events(ENetHost* host, ENetEvent* event) {
-		if (event == NULL)
-			return -1;
+			peer->totalDataSent = 0;
+			peer->totalDataReceived = 0;
+			peer->totalPacketsSent = 0;
+			peer->totalPacketsLost = 0;
+			peer->totalFastRetransmits = 0;
+			event->type = ENET_EVENT_TYPE_CONNECT;
+			event->peer = peer;
+			event->data = peer->eventData;
+		} else {
+			enet_protocol_dispatch_state(host, peer, peer->state == ENET_PEER_STATE_CONNECTING ? ENET_PEER_STATE_CONNECTION_SUCCEEDED : ENET_PEER_STATE_CONNECTION_PENDING);
+		}
+	}
 
-		event->type = ENET_EVENT_TYPE_NONE;
-		event->peer = NULL;
-		event->packet = NULL;
+	static void enet_protocol_notify_disconnect(ENetHost* host, ENetPeer* peer, ENetEvent* event) {
+		if (peer->state >= ENET_PEER_STATE_CONNECTION_PENDING)
+			host->recalculateBandwidthLimits = 1;
 
-		return enet_protocol_dispatch_incoming_commands(host, event);
-	}
+		if (peer->state != ENET_PEER_STATE_CONNECTING && peer->state < ENET_PEER_STATE_CONNECTION_SUCCEEDED) {
+			enet_peer_reset(peer);
+		} else if (event != NULL) {
+			event->type = ENET_EVENT_TYPE_DISCONNECT;
+			event->peer = peer;
+			event->data = 0;
 
-	int enet_host_service(ENetHost* host, ENetEvent* event, uint32_t timeout) {
-		uint32_t waitCondition;
+			enet_peer_reset(peer);
+		} else {
+			peer->eventData = 0;
 
-		if (event != NULL) {
-			event->type = ENET_EVENT_TYPE_NONE;
-			event->peer = NULL;
-			event->packet = NULL;
+			enet_protocol_dispatch_state(host, peer, ENET_PEER_STATE_ZOMBIE);
+		}
+	}
 
-			switch (enet_protocol_dispatch_incoming_commands(host, event)) {
-				case 1:
-					return 1;
+	static void enet_protocol_notify_disconnect_timeout(ENetHost* host, ENetPeer* peer, ENetEvent* event) {
+		if (peer->state >= ENET_PEER_STATE_CONNECTION_PENDING)
+			host->recalculateBandwidthLimits = 1;
 
-				case -1:
-					#ifdef ENET_DEBUG
-						perror("Error dispatching incoming packets");
-					#endif
+		if (peer->state != ENET_PEER_STATE_CONNECTING && peer->state < ENET_PEER_STATE_CONNECTION_SUCCEEDED) {
+			enet_peer_reset(peer);
+		} else if (event != NULL) {
+			event->type = ENET_EVENT_TYPE_DISCONNECT_TIMEOUT;
+			event->peer = peer;
+			event->data = 0;
 
-					return -1;
+			enet_peer_reset(peer);
+		} else {
+			peer->eventData = 0;
 
-				default:
-					break;
-			}
+			enet_protocol_dispatch_state(host, peer, ENET_PEER_STATE_ZOMBIE);
 		}
+	}
 
-		host->serviceTime = enet_time_get();
-		timeout += host->serviceTime;
+	static void enet_protocol_remove_sent_unreliable_commands(ENetPeer* peer, ENetList* sentUnreliableCommands) {
+		ENetOutgoingCommand* outgoingCommand;
+
+		if (enet_list_empty(sentUnreliableCommands))
+			return;
 
 		do {
-			if (ENET_TIME_DIFFERENCE(host->serviceTime, host->bandwidthThrottleEpoch) >= ENET_HOST_BANDWIDTH_THROTTLE_INTERVAL)
-				enet_host_bandwidth_throttle(host);
+			outgoingCommand = (ENetOutgoingCommand*)enet_list_front(sentUnreliableCommands);
 
-			switch (enet_protocol_send_outgoing_commands(host, event, 1)) {
-				case 1:
-					return 1;
+			enet_list_remove(&outgoingCommand->outgoingCommandList);
 
-				case -1:
-					#ifdef ENET_DEBUG
-						perror("Error sending outgoing packets");
-					#endif
+			if (outgoingCommand->packet != NULL) {
+				--outgoingCommand->packet->referenceCount;
 
-					return -1;
+				if (outgoingCommand->packet->referenceCount == 0) {
+					outgoingCommand->packet->flags |= ENET_PACKET_FLAG_SENT;
 
-				default:
-					break;
+					enet_packet_destroy(outgoingCommand->packet);
+				}
 			}
 
-			switch (enet_protocol_receive_incoming_commands(host, event)) {
-				case 1:
-					return 1;
+			enet_pool_free(&peer->host->outgoingCommandPool, outgoingCommand);
+		}
 
-				case -1:
-					#ifdef ENET_DEBUG
-						perror("Error receiving incoming packets");
-					#endif
+		while (!enet_list_empty(sentUnreliableCommands));
 
-					return -1;
+		if (peer->state == ENET_PEER_STATE_DISCONNECT_LATER && !enet_peer_has_outgoing_commands(peer))
+			enet_peer_disconnect(peer, peer->eventData);
+	}
 
-				default:
-					break;
-			}
+	/* Reliable commands that have been sent at least once are indexed by sequence number in a ring per channel, the ring doubles whenever two in-flight sequence numbers would share a slot */
+	static int enet_protocol_index_sent_reliable_command(ENetPeer* peer, ENetOutgoingCommand* outgoingCommand) {
+		ENetOutgoingCommand*** commands;
+		ENetOutgoingCommand** grownCommands;
+		uint32_t* capacity;
+		uint32_t grownCapacity, i;
 
-			switch (enet_protocol_send_outgoing_commands(host, event, 1)) {
-				case 1:
-					return 1;
+		if (outgoingCommand->command.header.channelID == 0xFF) {
+			commands = &peer->sentControlCommands;
+			capacity = &peer->sentControlCapacity;
+		} else {
+			commands = &peer->channels[outgoingCommand->command.header.channelID].sentReliableCommands;
+			capacity = &peer->channels[outgoingCommand->command.header.channelID].sentReliableCapacity;
+		}
 
-				case -1:
-					#ifdef ENET_DEBUG
-						perror("Error sending outgoing packets");
-					#endif
+		if (*capacity > 0) {
+			ENetOutgoingCommand* sentCommand = (*commands)[outgoingCommand->reliableSequenceNumber & (*capacity - 1)];
 
-					return -1;
+			if (sentCommand == NULL) {
+				(*commands)[outgoingCommand->reliableSequenceNumber & (*capacity - 1)] = outgoingCommand;
 
-				default:
-					break;
+				return 0;
 			}
 
-			if (event != NULL) {
-				switch (enet_protocol_dispatch_incoming_commands(host, event)) {
-					case 1:
-						return 1;
-
-					case -1:
-						#ifdef ENET_DEBUG
-							perror("Error dispatching incoming packets");
-						#endif
-
-						return -1;
+			/* A sequence number still in flight from a wrapped-around counter can't be told apart, the command waits until the older one is acknowledged */
+			if (sentCommand->reliableSequenceNumber == outgoingCommand->reliableSequenceNumber)
+				return -1;
+		}
 
-					default:
-						break;
-				}
-			}
+		grownCapacity = *capacity > 0 ? *capacity : ENET_PEER_RELIABLE_RING_MINIMUM / 2;
 
-			if (ENET_TIME_GREATER_EQUAL(host->serviceTime, timeout))
-				return 0;
+		growCommands:
 
-			do {
-				host->serviceTime = enet_time_get();
+		grownCapacity <<= 1;
 
-				if (ENET_TIME_GREATER_EQUAL(host->serviceTime, timeout))
-					return 0;
+		/* Distinct 16-bit sequence numbers always fit once the ring spans the whole sequence space */
+		if (grownCapacity > ENET_PEER_RELIABLE_WINDOWS * ENET_PEER_RELIABLE_WINDOW_SIZE)
+			return -1;
+		grownCommands = (ENetOutgoingCommand**)enet_malloc(grownCapacity * sizeof(ENetOutgoingCommand*));
 
-				waitCondition = ENET_SOCKET_WAIT_RECEIVE | ENET_SOCKET_WAIT_INTERRUPT;
+		if (grownCommands == NULL)
+			return -1;
 
-				if (enet_socket_wait(host->socket, &waitCondition, ENET_TIME_DIFFERENCE(timeout, host->serviceTime)) != 0)
-					return -1;
-			}
+		memset(grownCommands, 0, grownCapacity * sizeof(ENetOutgoingCommand*));
 
-			while (waitCondition & ENET_SOCKET_WAIT_INTERRUPT);
+		grownCommands[outgoingCommand->reliableSequenceNumber & (grownCapacity - 1)] = outgoingCommand;
 
-			host->serviceTime = enet_time_get();
-		}
+		for (i = 0; i < *capacity; ++i) {
+			ENetOutgoingCommand* sentCommand = (*commands)[i];
 
-		while (waitCondition & ENET_SOCKET_WAIT_RECEIVE);
+			if (sentCommand == NULL)
+				continue;
 
-		return 0;
-	}
+			if (grownCommands[sentCommand->reliableSequenceNumber & (grownCapacity - 1)] != NULL) {
+				enet_free(grownCommands);
 
-/*
-=======================================================================
+				goto growCommands;
+			}
 
-	Peer
+			grownCommands[sentCommand->reliableSequenceNumber & (grownCapacity - 1)] = sentCommand;
+		}
 
-=======================================================================
-*/
+		if (*commands != NULL)
+			enet_free(*commands);
 
-	void enet_peer_throttle_configure(ENetPeer* peer, uint32_t interval, uint32_t acceleration, uint32_t deceleration, uint32_t threshold) {
-		ENetProtocol command;
-		peer->packetThrottleThreshold = threshold;
-		peer->packetThrottleInterval = interval;
-		peer->packetThrottleAcceleration = acceleration;
-		peer->packetThrottleDeceleration = deceleration;
-		command.header.command = ENET_PROTOCOL_COMMAND_THROTTLE_CONFIGURE | ENET_PROTOCOL_COMMAND_FLAG_ACKNOWLEDGE;
-		command.header.channelID = 0xFF;
-		command.throttleConfigure.packetThrottleInterval = ENET_HOST_TO_NET_32(interval);
-		command.throttleConfigure.packetThrottleAcceleration = ENET_HOST_TO_NET_32(acceleration);
-		command.throttleConfigure.packetThrottleDeceleration = ENET_HOST_TO_NET_32(deceleration);
+		*commands = grownCommands;
+		*capacity = grownCapacity;
 
-		enet_peer_queue_outgoing_command(peer, &command, NULL, 0, 0);
+		return 0;
 	}
 
-	int enet_peer_throttle(ENetPeer* peer, uint32_t rtt) {
-		if (peer->lastRoundTripTime <= peer->lastRoundTripTimeVariance) {
-			peer->packetThrottle = peer->packetThrottleLimit;
-		} else if (rtt < peer->lastRoundTripTime + (peer->lastRoundTripTimeVariance + 1) / 2) {
-			peer->packetThrottle += peer->packetThrottleAcceleration;
-
-			if (peer->packetThrottle > peer->packetThrottleLimit)
-				peer->packetThrottle = peer->packetThrottleLimit;
-
-			return 1;
-		} else if (rtt > peer->lastRoundTripTime + peer->packetThrottleThreshold + 2 * peer->lastRoundTripTimeVariance) {
-			if (peer->packetThrottle > peer->packetThrottleDeceleration)
-				peer->packetThrottle -= peer->packetThrottleDeceleration;
-			else
-				peer->packetThrottle = 0;
+	/* A command that only fits a datagram above the minimum MTU tells whether the MTU in use still gets through */
+	static int enet_protocol_above_mtu_minimum(const ENetPeer* peer, const ENetOutgoingCommand* outgoingCommand) {
+		return (peer->capabilities & ENET_PROTOCOL_CAPABILITY_PATH_MTU) && peer->mtu > ENET_PROTOCOL_MINIMUM_MTU && sizeof(ENetProtocolHeader) + enet_protocol_command_size(outgoingCommand->command.header.command) + outgoingCommand->fragmentLength > ENET_PROTOCOL_MINIMUM_MTU;
+	}
 
-			return -1;
-		}
+	/* The remote hides how long it held an acknowledgement from the round trip sample, a command sent once shows it as the rest of the time since sending, and the retransmission timeout leaves room for it */
+	static void enet_protocol_update_acknowledgement_hold(ENetPeer* peer, const ENetOutgoingCommand* outgoingCommand, uint32_t roundTripTime) {
+		uint32_t elapsed = ENET_TIME_DIFFERENCE(peer->host->serviceTime, outgoingCommand->sentTime);
+		uint32_t hold = elapsed > roundTripTime ? elapsed - roundTripTime : 0;
 
-		return 0;
+		if (hold >= peer->remoteAcknowledgementHold)
+			peer->remoteAcknowledgementHold = hold;
+		else
+			peer->remoteAcknowledgementHold -= (peer->remoteAcknowledgementHold - hold) / 8;
 	}
 
-	int enet_peer_send(ENetPeer* peer, uint8_t channelID, ENetPacket* packet) {
-		ENetChannel* channel;
-		ENetProtocol command;
-		size_t fragmentLength;
+	static ENetProtocolCommand enet_protocol_remove_sent_reliable_command(ENetPeer* peer, uint16_t reliableSequenceNumber, uint8_t channelID, uint32_t roundTripTime, uint32_t* sendOrder) {
+		ENetOutgoingCommand* outgoingCommand = NULL;
+		ENetOutgoingCommand** slot = NULL;
+		ENetProtocolCommand commandNumber;
 
-		if (peer->state != ENET_PEER_STATE_CONNECTED || channelID >= peer->channelCount || packet->dataLength > peer->host->maximumPacketSize)
-			return -1;
+		if (channelID == 0xFF) {
+			if (peer->sentControlCapacity > 0)
+				slot = &peer->sentControlCommands[reliableSequenceNumber & (peer->sentControlCapacity - 1)];
+		} else if (channelID < peer->channelCount && peer->channels[channelID].sentReliableCapacity > 0) {
+			slot = &peer->channels[channelID].sentReliableCommands[reliableSequenceNumber & (peer->channels[channelID].sentReliableCapacity - 1)];
+		}
 
- 		channel = &peer->channels[channelID];
-		fragmentLength = peer->mtu - sizeof(ENetProtocolHeader) - sizeof(ENetProtocolSendFragment) - sizeof(ENetProtocolAcknowledge);
+		if (slot != NULL && *slot != NULL && (*slot)->reliableSequenceNumber == reliableSequenceNumber) {
+			outgoingCommand = *slot;
+			*slot = NULL;
+		}
 
-		if (peer->host->checksumCallback != NULL)
-			fragmentLength -= sizeof(enet_checksum);
+		if (outgoingCommand == NULL)
+			return ENET_PROTOCOL_COMMAND_NONE;
 
-		if (packet->dataLength > fragmentLength) {
-			uint32_t fragmentCount = (packet->dataLength + fragmentLength - 1) / fragmentLength, fragmentNumber, fragmentOffset;
-			uint8_t commandNumber;
-			uint16_t startSequenceNumber;
-			ENetList fragments;
-			ENetOutgoingCommand* fragment;
+		if (channelID < peer->channelCount) {
+			ENetChannel* channel = &peer->channels[channelID];
+			uint16_t reliableWindow = reliableSequenceNumber / ENET_PEER_RELIABLE_WINDOW_SIZE;
 
-			if (fragmentCount > ENET_PROTOCOL_MAXIMUM_FRAGMENT_COUNT)
-				return -1;
+			if (channel->reliableWindows[reliableWindow] > 0) {
+				--channel->reliableWindows[reliableWindow];
 
-			if ((packet->flags & (ENET_PACKET_FLAG_RELIABLE | ENET_PACKET_FLAG_UNRELIABLE_FRAGMENTED)) == ENET_PACKET_FLAG_UNRELIABLE_FRAGMENTED && channel->outgoingUnreliableSequenceNumber < 0xFFFF) {
-				commandNumber = ENET_PROTOCOL_COMMAND_SEND_UNRELIABLE_FRAGMENT;
-				startSequenceNumber = ENET_HOST_TO_NET_16(channel->outgoingUnreliableSequenceNumber + 1);
-			} else {
-				commandNumber = ENET_PROTOCOL_COMMAND_SEND_FRAGMENT | ENET_PROTOCOL_COMMAND_FLAG_ACKNOWLEDGE;
-				startSequenceNumber = ENET_HOST_TO_NET_16(channel->outgoingReliableSequenceNumber + 1);
+				if (!channel->reliableWindows[reliableWindow])
+					channel->usedReliableWindows &= ~(1u << reliableWindow);
 			}
+		}
 
-			enet_list_clear(&fragments);
-
-			for (fragmentNumber = 0, fragmentOffset = 0; fragmentOffset < packet->dataLength; ++fragmentNumber, fragmentOffset += fragmentLength) {
-				if (packet->dataLength - fragmentOffset < fragmentLength)
-					fragmentLength = packet->dataLength - fragmentOffset;
-
-				fragment = (ENetOutgoingCommand*)enet_malloc(sizeof(ENetOutgoingCommand));
+		commandNumber = (ENetProtocolCommand)(outgoingCommand->command.header.command & ENET_PROTOCOL_COMMAND_MASK);
 
-				if (fragment == NULL) {
-					while (!enet_list_empty(&fragments)) {
-						fragment = (ENetOutgoingCommand*)enet_list_remove(enet_list_begin(&fragments));
+		if (enet_protocol_above_mtu_minimum(peer, outgoingCommand))
+			peer->mtuLosses = 0;
 
-						enet_free(fragment);
-					}
+		/* Only a command sent once tells for certain which transmission was acknowledged */
+		if (sendOrder != NULL && outgoingCommand->sendAttempts == 1 && (*sendOrder == 0 || (int32_t)(*sendOrder - outgoingCommand->sendOrder) < 0))
+			*sendOrder = outgoingCommand->sendOrder;
 
-					return -1;
-				}
+		if (roundTripTime != 0 && outgoingCommand->sendAttempts == 1)
+			enet_protocol_update_acknowledgement_hold(peer, outgoingCommand, roundTripTime);
 
-				fragment->fragmentOffset = fragmentOffset;
-				fragment->fragmentLength = fragmentLength;
-				fragment->packet = packet;
-				fragment->command.header.command = commandNumber;
-				fragment->command.header.channelID = channelID;
-				fragment->command.sendFragment.startSequenceNumber = startSequenceNumber;
-				fragment->command.sendFragment.dataLength = ENET_HOST_TO_NET_16(fragmentLength);
-				fragment->command.sendFragment.fragmentCount = ENET_HOST_TO_NET_32(fragmentCount);
-				fragment->command.sendFragment.fragmentNumber = ENET_HOST_TO_NET_32(fragmentNumber);
-				fragment->command.sendFragment.totalLength = ENET_HOST_TO_NET_32(packet->dataLength);
-				fragment->command.sendFragment.fragmentOffset = ENET_NET_TO_HOST_32(fragmentOffset);
+		enet_list_remove(&outgoingCommand->outgoingCommandList);
 
-				enet_list_insert(enet_list_end(&fragments), fragment);
-			}
+		if (outgoingCommand->packet != NULL) {
+			if (outgoingCommand->inTransit)
+				peer->reliableDataInTransit -= outgoingCommand->fragmentLength;
 
-			packet->referenceCount += fragmentNumber;
+			--outgoingCommand->packet->referenceCount;
 
-			while (!enet_list_empty(&fragments)) {
-				fragment = (ENetOutgoingCommand*)enet_list_remove(enet_list_begin(&fragments));
+			if (outgoingCommand->packet->referenceCount == 0) {
+				outgoingCommand->packet->flags |= ENET_PACKET_FLAG_SENT;
 
-				enet_peer_setup_outgoing_command(peer, fragment);
+				enet_packet_destroy(outgoingCommand->packet);
 			}
-
-			return 0;
 		}
 
-		command.header.channelID = channelID;
-
-		if ((packet->flags & (ENET_PACKET_FLAG_RELIABLE | ENET_PACKET_FLAG_UNSEQUENCED)) == ENET_PACKET_FLAG_UNSEQUENCED) {
-			command.header.command = ENET_PROTOCOL_COMMAND_SEND_UNSEQUENCED | ENET_PROTOCOL_COMMAND_FLAG_UNSEQUENCED;
-			command.sendUnsequenced.dataLength = ENET_HOST_TO_NET_16(packet->dataLength);
-		} else if (packet->flags & ENET_PACKET_FLAG_RELIABLE || channel->outgoingUnreliableSequenceNumber >= 0xFFFF) {
-			command.header.command = ENET_PROTOCOL_COMMAND_SEND_RELIABLE | ENET_PROTOCOL_COMMAND_FLAG_ACKNOWLEDGE;
-			command.sendReliable.dataLength = ENET_HOST_TO_NET_16(packet->dataLength);
-		} else {
-			command.header.command = ENET_PROTOCOL_COMMAND_SEND_UNRELIABLE;
-			command.sendUnreliable.dataLength = ENET_HOST_TO_NET_16(packet->dataLength);
-		}
+		enet_pool_free(&peer->host->outgoingCommandPool, outgoingCommand);
 
-		if (enet_peer_queue_outgoing_command(peer, &command, packet, 0, packet->dataLength) == NULL)
-			return -1;
+		if (enet_list_empty(&peer->sentReliableCommands))
+			return commandNumber;
 
-		if (packet->flags & ENET_PACKET_FLAG_INSTANT)
-			enet_host_flush(peer->host);
+		outgoingCommand = (ENetOutgoingCommand*)enet_list_front(&peer->sentReliableCommands);
+		peer->nextTimeout = outgoingCommand->sentTime + outgoingCommand->roundTripTimeout;
 
-		return 0;
+		return commandNumber;
 	}
 
-	ENetPacket* enet_peer_receive(ENetPeer* peer, uint8_t* channelID) {
-		ENetIncomingCommand* incomingCommand;
-		ENetPacket* packet;
+	static ENetPeer* enet_protocol_handle_connect(ENetHost* host, ENetProtocolHeader* header, ENetProtocol* command, uint8_t** currentData) {
+		uint8_t incomingSessionID, outgoingSessionID;
+		uint32_t mtu, windowSize;
+		ENetChannel* channel;
+		size_t channelCount;
+		ENetPeer* peer;
+		ENetPacket* keyPacket = NULL;
+		ENetProtocol verifyCommand;
+		uint32_t capabilities, checksumType, dictionary = 0;
+		channelCount = ENET_NET_TO_HOST_32(command->connect.channelCount);
+		capabilities = (uint32_t)channelCount & ENET_PROTOCOL_CAPABILITY_MASK;
+		checksumType = (capabilities & ENET_PROTOCOL_CAPABILITY_CHECKSUM_MASK) >> ENET_PROTOCOL_CAPABILITY_CHECKSUM_SHIFT;
+		channelCount &= ~ENET_PROTOCOL_CAPABILITY_MASK;
 
-		if (enet_list_empty(&peer->dispatchedCommands))
+		if (channelCount < ENET_PROTOCOL_MINIMUM_CHANNEL_COUNT || channelCount > ENET_PROTOCOL_MAXIMUM_CHANNEL_COUNT)
 			return NULL;
 
-		incomingCommand = (ENetIncomingCommand*)enet_list_remove(enet_list_begin(&peer->dispatchedCommands));
-
-		if (channelID != NULL)
-			*channelID = incomingCommand->command.header.channelID;
-
-		packet = incomingCommand->packet;
-		--packet->referenceCount;
-
-		if (incomingCommand->fragments != NULL)
-			enet_free(incomingCommand->fragments);
+		/* Encryption is never negotiated away, a client that would talk in the clear to an encrypting host is refused and the other way around */
+		if ((capabilities ^ host->capabilities) & ENET_PROTOCOL_CAPABILITY_ENCRYPTION)
+			return NULL;
 
-		enet_free(incomingCommand);
+		if (host->freePeerCount == 0 || enet_host_find_connection(host, &host->receivedAddress, command->connect.connectID) != NULL || enet_host_count_address(host, &host->receivedAddress.ipv6) >= host->duplicatePeers)
+			return NULL;
 
-		peer->totalWaitingData -= packet->dataLength;
+		peer = host->freePeers[host->freePeerHead];
 
-		return packet;
-	}
+		if (capabilities & ENET_PROTOCOL_CAPABILITY_ENCRYPTION) {
+			const uint8_t* remoteKey = *currentData;
 
-	static void enet_peer_reset_outgoing_commands(ENetList* queue) {
-		ENetOutgoingCommand* outgoingCommand;
+			*currentData += ENET_PEER_CIPHER_KEY_SIZE;
 
-		while (!enet_list_empty(queue)) {
-			outgoingCommand = (ENetOutgoingCommand*)enet_list_remove(enet_list_begin(queue));
+			if (enet_cipher_create(peer) < 0)
+				return NULL;
 
-			if (outgoingCommand->packet != NULL) {
-				--outgoingCommand->packet->referenceCount;
+			if (enet_cipher_derive(peer, remoteKey, command->connect.connectID, 0) < 0 || (keyPacket = enet_packet_create(peer->cipher->publicKey, ENET_PEER_CIPHER_KEY_SIZE, ENET_PACKET_FLAG_RELIABLE)) == NULL) {
+				enet_cipher_destroy(peer);
 
-				if (outgoingCommand->packet->referenceCount == 0)
-					enet_packet_destroy(outgoingCommand->packet);
+				return NULL;
 			}
-
-			enet_free(outgoingCommand);
 		}
-	}
 
-	static void enet_peer_remove_incoming_commands(ENetList* queue, ENetListIterator startCommand, ENetListIterator endCommand, ENetIncomingCommand* excludeCommand) {
-		ENetListIterator currentCommand;
-
-		for (currentCommand = startCommand; currentCommand != endCommand;) {
-			ENetIncomingCommand* incomingCommand = (ENetIncomingCommand*)currentCommand;
-			currentCommand = enet_list_next(currentCommand);
+		if (capabilities & ENET_PROTOCOL_CAPABILITY_DICTIONARY) {
+			memcpy(&dictionary, *currentData, sizeof(uint32_t));
 
-			if (incomingCommand == excludeCommand)
-				continue;
+			dictionary = ENET_NET_TO_HOST_32(dictionary);
+			*currentData += sizeof(uint32_t);
+		}
 
-			enet_list_remove(&incomingCommand->incomingCommandList);
+		if (channelCount > host->channelLimit)
+			channelCount = host->channelLimit;
 
-			if (incomingCommand->packet != NULL) {
-				--incomingCommand->packet->referenceCount;
+		peer->channels = (ENetChannel*)enet_malloc(channelCount * sizeof(ENetChannel));
 
-				if (incomingCommand->packet->referenceCount == 0)
-					enet_packet_destroy(incomingCommand->packet);
+		if (peer->channels == NULL) {
+			if (keyPacket != NULL) {
+				enet_packet_destroy(keyPacket);
+				enet_cipher_destroy(peer);
 			}
 
-			if (incomingCommand->fragments != NULL)
-				enet_free(incomingCommand->fragments);
-
-			enet_free(incomingCommand);
+			return NULL;
 		}
-	}
 
-	static void enet_peer_reset_incoming_commands(ENetList* queue) {
-		enet_peer_remove_incoming_commands(queue, enet_list_begin(queue), enet_list_end(queue), NULL);
-	}
+		enet_peer_activate(peer);
 
-	void enet_peer_reset_queues(ENetPeer* peer) {
-		ENetChannel* channel;
+		peer->channelCount = channelCount;
+		peer->state = ENET_PEER_STATE_ACKNOWLEDGING_CONNECT;
+		peer->connectID = command->connect.connectID;
+		peer->capabilities = capabilities & host->capabilities;
+		peer->address = host->receivedAddress;
+
+		/* Datagrams compressed against a different dictionary would decode into garbage, the client learns from the verify that compression is off */
+		if (dictionary != host->compressionDictionary)
+			peer->capabilities &= ~ENET_PROTOCOL_CAPABILITY_COMPRESSION;
+
+		/* Any built-in algorithm the client offers is implemented on both sides, so the server preference wins */
+		if (host->checksum != ENET_CHECKSUM_NONE && checksumType != ENET_CHECKSUM_NONE && checksumType < ENET_CHECKSUM_COUNT)
+			peer->checksum = (uint8_t)host->checksum;
+
+		enet_peer_index(peer);
+		peer->outgoingPeerID = ENET_NET_TO_HOST_16(command->connect.outgoingPeerID);
+		peer->incomingBandwidth = ENET_NET_TO_HOST_32(command->connect.incomingBandwidth);
+		peer->outgoingBandwidth = ENET_NET_TO_HOST_32(command->connect.outgoingBandwidth);
+		peer->packetThrottleInterval = ENET_NET_TO_HOST_32(command->connect.packetThrottleInterval);
+		peer->packetThrottleAcceleration = ENET_NET_TO_HOST_32(command->connect.packetThrottleAcceleration);
+		peer->packetThrottleDeceleration = ENET_NET_TO_HOST_32(command->connect.packetThrottleDeceleration);
+		peer->eventData = ENET_NET_TO_HOST_32(command->connect.data);
+		incomingSessionID = command->connect.incomingSessionID == 0xFF ? peer->outgoingSessionID : command->connect.incomingSessionID;
+		incomingSessionID = (incomingSessionID + 1) & (ENET_PROTOCOL_HEADER_SESSION_MASK >> ENET_PROTOCOL_HEADER_SESSION_SHIFT);
+
+		if (incomingSessionID == peer->outgoingSessionID)
+			incomingSessionID = (incomingSessionID + 1) & (ENET_PROTOCOL_HEADER_SESSION_MASK >> ENET_PROTOCOL_HEADER_SESSION_SHIFT);
+
+		peer->outgoingSessionID = incomingSessionID;
+		outgoingSessionID = command->connect.outgoingSessionID == 0xFF ? peer->incomingSessionID : command->connect.outgoingSessionID;
+		outgoingSessionID = (outgoingSessionID + 1) & (ENET_PROTOCOL_HEADER_SESSION_MASK >> ENET_PROTOCOL_HEADER_SESSION_SHIFT);
+
+		if (outgoingSessionID == peer->incomingSessionID)
+			outgoingSessionID = (outgoingSessionID + 1) & (ENET_PROTOCOL_HEADER_SESSION_MASK >> ENET_PROTOCOL_HEADER_SESSION_SHIFT);
+
+		peer->incomingSessionID = outgoingSessionID;
+
+		for (channel = peer->channels; channel < &peer->channels[channelCount]; ++channel) {
+			channel->outgoingReliableSequenceNumber = 0;
+			channel->outgoingUnreliableSequenceNumber = 0;
+			channel->incomingReliableSequenceNumber = 0;
+			channel->incomingUnreliableSequenceNumber = 0;
+
+			enet_list_clear(&channel->incomingUnreliableCommands);
+
+			channel->incomingReliableCommands = NULL;
+			channel->incomingReliableCapacity = 0;
+			channel->sentReliableCommands = NULL;
+			channel->sentReliableCapacity = 0;
+
+			channel->usedReliableWindows = 0;
+			channel->aggregation = 0;
+
+			memset(channel->reliableWindows, 0, sizeof(channel->reliableWindows));
+		}
+
+		mtu = ENET_NET_TO_HOST_32(command->connect.mtu);
+
+		if (mtu < ENET_PROTOCOL_MINIMUM_MTU)
+			mtu = ENET_PROTOCOL_MINIMUM_MTU;
+		else if (mtu > ENET_PROTOCOL_MAXIMUM_MTU)
+			mtu = ENET_PROTOCOL_MAXIMUM_MTU;
+
+		if (mtu < peer->mtu)
+			peer->mtu = mtu;
+
+		if (host->outgoingBandwidth == 0 && peer->incomingBandwidth == 0)
+			peer->windowSize = ENET_PROTOCOL_MAXIMUM_WINDOW_SIZE;
+		else if (host->outgoingBandwidth == 0 || peer->incomingBandwidth == 0)
+			peer->windowSize = (ENET_MAX(host->outgoingBandwidth, peer->incomingBandwidth) / ENET_PEER_WINDOW_SIZE_SCALE) * ENET_PROTOCOL_MINIMUM_WINDOW_SIZE;
+		else
+			peer->windowSize = (ENET_MIN(host->outgoingBandwidth, peer->incomingBandwidth) / ENET_PEER_WINDOW_SIZE_SCALE) * ENET_PROTOCOL_MINIMUM_WINDOW_SIZE;
+
+		if (peer->windowSize < ENET_PROTOCOL_MINIMUM_WINDOW_SIZE)
+			peer->windowSize = ENET_PROTOCOL_MINIMUM_WINDOW_SIZE;
+		else if (peer->windowSize > ENET_PROTOCOL_MAXIMUM_WINDOW_SIZE)
+			peer->windowSize = ENET_PROTOCOL_MAXIMUM_WINDOW_SIZE;
+
+		if (host->incomingBandwidth == 0)
+			windowSize = ENET_PROTOCOL_MAXIMUM_WINDOW_SIZE;
+		else
+			windowSize = (host->incomingBandwidth / ENET_PEER_WINDOW_SIZE_SCALE) * ENET_PROTOCOL_MINIMUM_WINDOW_SIZE;
+
+		if (windowSize > ENET_NET_TO_HOST_32(command->connect.windowSize))
+			windowSize = ENET_NET_TO_HOST_32(command->connect.windowSize);
+
+		if (windowSize < ENET_PROTOCOL_MINIMUM_WINDOW_SIZE)
+			windowSize = ENET_PROTOCOL_MINIMUM_WINDOW_SIZE;
+		else if (windowSize > ENET_PROTOCOL_MAXIMUM_WINDOW_SIZE)
+			windowSize = ENET_PROTOCOL_MAXIMUM_WINDOW_SIZE;
+
+		verifyCommand.header.command = ENET_PROTOCOL_COMMAND_VERIFY_CONNECT | ENET_PROTOCOL_COMMAND_FLAG_ACKNOWLEDGE;
+		verifyCommand.header.channelID = 0xFF;
+		verifyCommand.verifyConnect.outgoingPeerID = ENET_HOST_TO_NET_16(peer->incomingPeerID);
+		verifyCommand.verifyConnect.incomingSessionID = incomingSessionID;
+		verifyCommand.verifyConnect.outgoingSessionID = outgoingSessionID;
+		verifyCommand.verifyConnect.mtu = ENET_HOST_TO_NET_32(peer->mtu);
+		verifyCommand.verifyConnect.windowSize = ENET_HOST_TO_NET_32(windowSize);
+		verifyCommand.verifyConnect.channelCount = ENET_HOST_TO_NET_32(capabilities != 0 ? channelCount | peer->capabilities | ((uint32_t)peer->checksum << ENET_PROTOCOL_CAPABILITY_CHECKSUM_SHIFT) : channelCount);
+		verifyCommand.verifyConnect.incomingBandwidth = ENET_HOST_TO_NET_32(host->incomingBandwidth);
+		verifyCommand.verifyConnect.outgoingBandwidth = ENET_HOST_TO_NET_32(host->outgoingBandwidth);
+		verifyCommand.verifyConnect.packetThrottleInterval = ENET_HOST_TO_NET_32(peer->packetThrottleInterval);
+		verifyCommand.verifyConnect.packetThrottleAcceleration = ENET_HOST_TO_NET_32(peer->packetThrottleAcceleration);
+		verifyCommand.verifyConnect.packetThrottleDeceleration = ENET_HOST_TO_NET_32(peer->packetThrottleDeceleration);
+		verifyCommand.verifyConnect.connectID = peer->connectID;
+
+		if (enet_peer_queue_outgoing_command(peer, &verifyCommand, keyPacket, 0, keyPacket != NULL ? ENET_PEER_CIPHER_KEY_SIZE : 0) == NULL && keyPacket != NULL)
+			enet_packet_destroy(keyPacket);
+
+		return peer;
+	}
+
+	static int enet_protocol_check_aggregate(ENetPeer* peer, const ENetProtocol* command, const uint8_t* data, size_t dataLength) {
+		size_t headerLength, messageLength;
+
+		if (!(command->header.command & ENET_PROTOCOL_COMMAND_FLAG_AGGREGATED))
+			return 0;
+
+		if (!(peer->capabilities & ENET_PROTOCOL_CAPABILITY_AGGREGATION) || dataLength == 0)
+			return -1;
+
+		while (dataLength > 0) {
+			headerLength = enet_packet_read_aggregate(data, dataLength, &messageLength);
+
+			if (headerLength == 0)
+				return -1;
+
+			data += headerLength + messageLength;
+			dataLength -= headerLength + messageLength;
+		}
+
+		return 0;
+	}
+
+	static int enet_protocol_handle_send_reliable(ENetHost* host, ENetPeer* peer, const ENetProtocol* command, uint8_t** currentData) {
+		size_t dataLength;
+
+		if (command->header.channelID >= peer->channelCount || (peer->state != ENET_PEER_STATE_CONNECTED && peer->state != ENET_PEER_STATE_DISCONNECT_LATER))
+			return -1;
+
+		dataLength = ENET_NET_TO_HOST_16(command->sendReliable.dataLength);
+		*currentData += dataLength;
+
+		if (dataLength > host->maximumPacketSize || *currentData < host->receivedData || *currentData > &host->receivedData[host->receivedDataLength])
+			return -1;
+
+		if (enet_protocol_check_aggregate(peer, command, (const uint8_t*)command + sizeof(ENetProtocolSendReliable), dataLength) < 0)
+			return -1;
+
+		if (enet_peer_queue_incoming_command(peer, command, (const uint8_t*)command + sizeof(ENetProtocolSendReliable), dataLength, ENET_PACKET_FLAG_RELIABLE, 0) == NULL)
+			return -1;
+
+		return 0;
+	}
+
+	static int enet_protocol_handle_send_unsequenced(ENetHost* host, ENetPeer* peer, const ENetProtocol* command, uint8_t** currentData) {
+		uint32_t unsequencedGroup, index;
+		size_t dataLength;
+
+		if (command->header.channelID >= peer->channelCount || (peer->state != ENET_PEER_STATE_CONNECTED && peer->state != ENET_PEER_STATE_DISCONNECT_LATER))
+			return -1;
+
+		dataLength = ENET_NET_TO_HOST_16(command->sendUnsequenced.dataLength);
+		*currentData += dataLength;
+
+		if (dataLength > host->maximumPacketSize || *currentData < host->receivedData || *currentData > &host->receivedData[host->receivedDataLength])
+			return -1;
+
+		if (enet_protocol_check_aggregate(peer, command, (const uint8_t*)command + sizeof(ENetProtocolSendUnsequenced), dataLength) < 0)
+			return -1;
+
+		unsequencedGroup = ENET_NET_TO_HOST_16(command->sendUnsequenced.unsequencedGroup);
+		index = unsequencedGroup % ENET_PEER_UNSEQUENCED_WINDOW_SIZE;
+
+		if (unsequencedGroup < peer->incomingUnsequencedGroup)
+			unsequencedGroup += 0x10000;
+
+		if (unsequencedGroup >= (uint32_t)peer->incomingUnsequencedGroup + ENET_PEER_FREE_UNSEQUENCED_WINDOWS * ENET_PEER_UNSEQUENCED_WINDOW_SIZE)
+			return 0;
+
+		unsequencedGroup &= 0xFFFF;
+
+		if (unsequencedGroup - index != peer->incomingUnsequencedGroup) {
+			peer->incomingUnsequencedGroup = unsequencedGroup - index;
+
+			memset(peer->unsequencedWindow, 0, sizeof(peer->unsequencedWindow));
+		} else if (peer->unsequencedWindow[index / 32] & (1u << (index % 32))) {
+			return 0;
+		}
+
+		if (enet_peer_queue_incoming_command(peer, command, (const uint8_t*)command + sizeof(ENetProtocolSendUnsequenced), dataLength, ENET_PACKET_FLAG_UNSEQUENCED, 0) == NULL)
+			return -1;
+
+		peer->unsequencedWindow[index / 32] |= 1u << (index % 32);
+
+		return 0;
+	}
+
+	static int enet_protocol_handle_send_unreliable(ENetHost* host, ENetPeer* peer, const ENetProtocol* command, uint8_t** currentData) {
+		size_t dataLength;
+
+		if (command->header.channelID >= peer->channelCount || (peer->state != ENET_PEER_STATE_CONNECTED && peer->state != ENET_PEER_STATE_DISCONNECT_LATER))
+			return -1;
+
+		dataLength = ENET_NET_TO_HOST_16(command->sendUnreliable.dataLength);
+		*currentData += dataLength;
+
+		if (dataLength > host->maximumPacketSize || *currentData < host->receivedData || *currentData > &host->receivedData[host->receivedDataLength])
+			return -1;
+
+		if (enet_protocol_check_aggregate(peer, command, (const uint8_t*)command + sizeof(ENetProtocolSendUnreliable), dataLength) < 0)
+			return -1;
+
+		if (enet_peer_queue_incoming_command(peer, command, (const uint8_t*)command + sizeof(ENetProtocolSendUnreliable), dataLength, 0, 0) == NULL)
+			return -1;
+
+		return 0;
+	}
+
+	static int enet_protocol_handle_send_fragment(ENetHost* host, ENetPeer* peer, const ENetProtocol* command, uint8_t** currentData) {
+		uint32_t fragmentNumber, fragmentCount, fragmentOffset, fragmentLength, startSequenceNumber, totalLength;
+		ENetChannel* channel;
+		uint16_t startWindow, currentWindow;
+		ENetIncomingCommand* startCommand = NULL;
+
+		if (command->header.channelID >= peer->channelCount || (peer->state != ENET_PEER_STATE_CONNECTED && peer->state != ENET_PEER_STATE_DISCONNECT_LATER))
+			return -1;
+
+		fragmentLength = ENET_NET_TO_HOST_16(command->sendFragment.dataLength);
+		*currentData += fragmentLength;
+
+		if (fragmentLength <= 0 || fragmentLength > host->maximumPacketSize || *currentData < host->receivedData || *currentData > &host->receivedData[host->receivedDataLength])
+			return -1;
+
+		channel = &peer->channels[command->header.channelID];
+		startSequenceNumber = ENET_NET_TO_HOST_16(command->sendFragment.startSequenceNumber);
+		startWindow = startSequenceNumber / ENET_PEER_RELIABLE_WINDOW_SIZE;
+		currentWindow = channel->incomingReliableSequenceNumber / ENET_PEER_RELIABLE_WINDOW_SIZE;
+
+		if (startSequenceNumber < channel->incomingReliableSequenceNumber)
+			startWindow += ENET_PEER_RELIABLE_WINDOWS;
+
+		if (startWindow < currentWindow || startWindow >= currentWindow + ENET_PEER_FREE_RELIABLE_WINDOWS - 1)
+			return 0;
+
+		fragmentNumber = ENET_NET_TO_HOST_32(command->sendFragment.fragmentNumber);
+		fragmentCount = ENET_NET_TO_HOST_32(command->sendFragment.fragmentCount);
+		fragmentOffset = ENET_NET_TO_HOST_32(command->sendFragment.fragmentOffset);
+		totalLength = ENET_NET_TO_HOST_32(command->sendFragment.totalLength);
+
+		if (fragmentCount > ENET_PROTOCOL_MAXIMUM_FRAGMENT_COUNT || fragmentNumber >= fragmentCount || totalLength > host->maximumPacketSize || totalLength < fragmentCount || fragmentOffset >= totalLength || fragmentLength > totalLength - fragmentOffset)
+			return -1;
+
+		if (startSequenceNumber != channel->incomingReliableSequenceNumber && (uint16_t)(startSequenceNumber - channel->incomingReliableSequenceNumber) <= channel->incomingReliableCapacity) {
+			ENetIncomingCommand* incomingCommand = channel->incomingReliableCommands[startSequenceNumber & (channel->incomingReliableCapacity - 1)];
+
+			if (incomingCommand != NULL && incomingCommand->reliableSequenceNumber == startSequenceNumber) {
+				if ((incomingCommand->command.header.command & ENET_PROTOCOL_COMMAND_MASK) != ENET_PROTOCOL_COMMAND_SEND_FRAGMENT || totalLength != incomingCommand->packet->dataLength || fragmentCount != incomingCommand->fragmentCount)
+					return -1;
+
+				startCommand = incomingCommand;
+			}
+		}
+
+		if (startCommand == NULL) {
+			ENetProtocol hostCommand = *command;
+			hostCommand.header.reliableSequenceNumber = startSequenceNumber;
+			startCommand = enet_peer_queue_incoming_command(peer, &hostCommand, NULL, totalLength, ENET_PACKET_FLAG_RELIABLE, fragmentCount);
+
+			if (startCommand == NULL)
+				return -1;
+		}
+
+		if ((startCommand->fragments[fragmentNumber / 32] & (1u << (fragmentNumber % 32))) == 0) {
+			--startCommand->fragmentsRemaining;
+			startCommand->fragments[fragmentNumber / 32] |= (1u << (fragmentNumber % 32));
+
+			if (fragmentOffset + fragmentLength > startCommand->packet->dataLength)
+				fragmentLength = startCommand->packet->dataLength - fragmentOffset;
+
+			memcpy(startCommand->packet->data + fragmentOffset, (uint8_t*)command + sizeof(ENetProtocolSendFragment), fragmentLength);
+
+			if (startCommand->fragmentsRemaining <= 0)
+				enet_peer_dispatch_incoming_reliable_commands(peer, channel, NULL);
+		}
+
+		return 0;
+	}
+
+	static int enet_protocol_handle_send_unreliable_fragment(ENetHost* host, ENetPeer* peer, const ENetProtocol* command, uint8_t** currentData) {
+		uint32_t fragmentNumber, fragmentCount, fragmentOffset, fragmentLength, reliableSequenceNumber, startSequenceNumber, totalLength;
+		uint16_t reliableWindow, currentWindow;
+		ENetChannel* channel;
+		ENetListIterator currentCommand;
+		ENetIncomingCommand* startCommand = NULL;
+
+		if (command->header.channelID >= peer->channelCount || (peer->state != ENET_PEER_STATE_CONNECTED && peer->state != ENET_PEER_STATE_DISCONNECT_LATER))
+			return -1;
+
+		fragmentLength = ENET_NET_TO_HOST_16(command->sendFragment.dataLength);
+		*currentData += fragmentLength;
+
+		if (fragmentLength > host->maximumPacketSize || *currentData < host->receivedData || *currentData > &host->receivedData[host->receivedDataLength])
+			return -1;
+
+		channel = &peer->channels[command->header.channelID];
+		reliableSequenceNumber = command->header.reliableSequenceNumber;
+		startSequenceNumber = ENET_NET_TO_HOST_16(command->sendFragment.startSequenceNumber);
+		reliableWindow = reliableSequenceNumber / ENET_PEER_RELIABLE_WINDOW_SIZE;
+		currentWindow = channel->incomingReliableSequenceNumber / ENET_PEER_RELIABLE_WINDOW_SIZE;
+
+		if (reliableSequenceNumber < channel->incomingReliableSequenceNumber)
+			reliableWindow += ENET_PEER_RELIABLE_WINDOWS;
+
+		if (reliableWindow < currentWindow || reliableWindow >= currentWindow + ENET_PEER_FREE_RELIABLE_WINDOWS - 1)
+			return 0;
+
+		if (reliableSequenceNumber == channel->incomingReliableSequenceNumber && startSequenceNumber <= channel->incomingUnreliableSequenceNumber)
+			return 0;
+
+		fragmentNumber = ENET_NET_TO_HOST_32(command->sendFragment.fragmentNumber);
+		fragmentCount = ENET_NET_TO_HOST_32(command->sendFragment.fragmentCount);
+		fragmentOffset = ENET_NET_TO_HOST_32(command->sendFragment.fragmentOffset);
+		totalLength = ENET_NET_TO_HOST_32(command->sendFragment.totalLength);
+
+		if (fragmentCount > ENET_PROTOCOL_MAXIMUM_FRAGMENT_COUNT || fragmentNumber >= fragmentCount || totalLength > host->maximumPacketSize || fragmentOffset >= totalLength || fragmentLength > totalLength - fragmentOffset)
+			return -1;
+
+			for (currentCommand = enet_list_previous(enet_list_end(&channel->incomingUnreliableCommands)); currentCommand != enet_list_end(&channel->incomingUnreliableCommands); currentCommand = enet_list_previous(currentCommand)) {
+				ENetIncomingCommand* incomingCommand = (ENetIncomingCommand*)currentCommand;
+
+				if (reliableSequenceNumber >= channel->incomingReliableSequenceNumber) {
+					if (incomingCommand->reliableSequenceNumber < channel->incomingReliableSequenceNumber)
+						continue;
+				} else if (incomingCommand->reliableSequenceNumber >= channel->incomingReliableSequenceNumber) {
+					break;
+				}
+
+				if (incomingCommand->reliableSequenceNumber < reliableSequenceNumber)
+					break;
+
+				if (incomingCommand->reliableSequenceNumber > reliableSequenceNumber)
+					continue;
+
+				if (incomingCommand->unreliableSequenceNumber <= startSequenceNumber) {
+					if (incomingCommand->unreliableSequenceNumber < startSequenceNumber)
+						break;
+
+					if ((incomingCommand->command.header.command & ENET_PROTOCOL_COMMAND_MASK) != ENET_PROTOCOL_COMMAND_SEND_UNRELIABLE_FRAGMENT || totalLength != incomingCommand->packet->dataLength || fragmentCount != incomingCommand->fragmentCount)
+						return -1;
+
+					startCommand = incomingCommand;
+
+					break;
+				}
+			}
+
+			if (startCommand == NULL) {
+				startCommand = enet_peer_queue_incoming_command(peer, command, NULL, totalLength, ENET_PACKET_FLAG_UNRELIABLE_FRAGMENTED, fragmentCount);
+
+				if (startCommand == NULL)
+					return -1;
+			}
+
+			if ((startCommand->fragments[fragmentNumber / 32] & (1u << (fragmentNumber % 32))) == 0) {
+				--startCommand->fragmentsRemaining;
+				startCommand->fragments[fragmentNumber / 32] |= (1u << (fragmentNumber % 32));
+
+			if (fragmentOffset + fragmentLength > startCommand->packet->dataLength)
+				fragmentLength = startCommand->packet->dataLength - fragmentOffset;
+
+			memcpy(startCommand->packet->data + fragmentOffset, (uint8_t*)command + sizeof(ENetProtocolSendFragment), fragmentLength);
+
+			if (startCommand->fragmentsRemaining <= 0)
+				enet_peer_dispatch_incoming_unreliable_commands(peer, channel, NULL);
+		}
+
+		return 0;
+	}
+
+	static int enet_protocol_handle_ping(ENetHost* host, ENetPeer* peer, const ENetProtocol* command) {
+		if (peer->state != ENET_PEER_STATE_CONNECTED && peer->state != ENET_PEER_STATE_DISCONNECT_LATER)
+			return -1;
+
+		return 0;
+	}
+
+	static int enet_protocol_handle_probe(ENetHost* host, ENetPeer* peer, const ENetProtocol* command, uint8_t** currentData) {
+		ENetProtocol reply;
+		uint16_t probeLength, receivedLength;
+
+		if (!(peer->capabilities & ENET_PROTOCOL_CAPABILITY_PATH_MTU) || (peer->state != ENET_PEER_STATE_CONNECTED && peer->state != ENET_PEER_STATE_DISCONNECT_LATER))
+			return -1;
+
+		probeLength = ENET_NET_TO_HOST_16(command->probe.probeLength);
+		receivedLength = ENET_NET_TO_HOST_16(command->probe.receivedLength);
+
+		if (receivedLength == 0) {
+			/* The padding fills the rest of the datagram, a probe only counts if it arrived at its full size */
+			if (host->receivedDataLength != probeLength)
+				return -1;
+
+			*currentData = &host->receivedData[host->receivedDataLength];
+
+			reply.header.command = ENET_PROTOCOL_COMMAND_PROBE;
+			reply.header.channelID = 0xFF;
+			reply.probe.probeSequenceNumber = command->probe.probeSequenceNumber;
+			reply.probe.probeLength = command->probe.probeLength;
+			reply.probe.receivedLength = command->probe.probeLength;
+
+			enet_peer_queue_outgoing_command(peer, &reply, NULL, 0, 0);
+
+			return 0;
+		}
+
+		if (peer->mtuProbeSize == 0 || ENET_NET_TO_HOST_16(command->probe.probeSequenceNumber) != peer->mtuProbeSequenceNumber || probeLength != peer->mtuProbeSize || receivedLength != probeLength)
+			return 0;
+
+		peer->mtuProbeLow = probeLength;
+		peer->mtuProbeSize = 0;
+		peer->mtuProbeCount = 0;
+		peer->mtuProbeTime = host->serviceTime;
+
+		if (probeLength > peer->mtu) {
+			peer->mtu = probeLength;
+
+			if (host->mtuCallback != NULL)
+				host->mtuCallback(peer, peer->mtu);
+		}
+
+		enet_peer_mark_pending(peer);
+
+		return 0;
+	}
+
+	/* Pieces are kept in units of the assembly mask, returns 1 once the command is complete and can be processed from the assembly */
+	static int enet_protocol_handle_piece(ENetHost* host, ENetPeer* peer, const ENetProtocol* command, uint8_t** currentData) {
+		const ENetProtocol* assembled;
+		size_t pieceOffset, pieceLength, totalLength, unitCount, dataLength;
+		uint64_t completeMask;
+
+		if (!(peer->capabilities & ENET_PROTOCOL_CAPABILITY_PATH_MTU) || (peer->state != ENET_PEER_STATE_CONNECTED && peer->state != ENET_PEER_STATE_DISCONNECT_LATER))
+			return -1;
+
+		pieceOffset = ENET_NET_TO_HOST_16(command->piece.pieceOffset);
+		pieceLength = ENET_NET_TO_HOST_16(command->piece.pieceLength);
+		totalLength = ENET_NET_TO_HOST_16(command->piece.totalLength);
+
+		if (totalLength < sizeof(ENetProtocolSendReliable) || totalLength > ENET_PROTOCOL_MAXIMUM_MTU || pieceLength == 0 || pieceOffset % ENET_PEER_PIECE_UNIT != 0 || pieceOffset + pieceLength > totalLength || (pieceLength % ENET_PEER_PIECE_UNIT != 0 && pieceOffset + pieceLength != totalLength) || *currentData + pieceLength > &host->receivedData[host->receivedDataLength])
+			return -1;
+
+		if (peer->pieceData == NULL) {
+			peer->pieceData = (uint8_t*)enet_malloc(ENET_PROTOCOL_MAXIMUM_MTU);
+
+			if (peer->pieceData == NULL)
+				return -1;
+		}
+
+		/* Only one command is cut into pieces at a time, the first piece of another one replaces the assembly */
+		if (peer->pieceMask == 0 || peer->pieceChannelID != command->header.channelID || peer->pieceSequenceNumber != command->header.reliableSequenceNumber || peer->pieceLength != totalLength) {
+			peer->pieceMask = 0;
+			peer->pieceChannelID = command->header.channelID;
+			peer->pieceSequenceNumber = command->header.reliableSequenceNumber;
+			peer->pieceLength = (uint16_t)totalLength;
+		}
+
+		memcpy(&peer->pieceData[pieceOffset], *currentData, pieceLength);
+
+		*currentData += pieceLength;
+		unitCount = (pieceLength + ENET_PEER_PIECE_UNIT - 1) / ENET_PEER_PIECE_UNIT;
+		peer->pieceMask |= (unitCount < 64 ? (((uint64_t)1 << unitCount) - 1) : ~(uint64_t)0) << (pieceOffset / ENET_PEER_PIECE_UNIT);
+		unitCount = (totalLength + ENET_PEER_PIECE_UNIT - 1) / ENET_PEER_PIECE_UNIT;
+		completeMask = unitCount < 64 ? (((uint64_t)1 << unitCount) - 1) : ~(uint64_t)0;
+
+		if (peer->pieceMask != completeMask)
+			return 0;
+
+		peer->pieceMask = 0;
+		assembled = (const ENetProtocol*)peer->pieceData;
+
+		if (assembled->header.channelID != command->header.channelID || ENET_NET_TO_HOST_16(assembled->header.reliableSequenceNumber) != command->header.reliableSequenceNumber)
+			return -1;
+
+		/* Only reliable data is cut into pieces, and the command has to account for every byte of the assembly */
+		switch (assembled->header.command) {
+			case ENET_PROTOCOL_COMMAND_SEND_RELIABLE | ENET_PROTOCOL_COMMAND_FLAG_ACKNOWLEDGE:
+				dataLength = sizeof(ENetProtocolSendReliable) + ENET_NET_TO_HOST_16(assembled->sendReliable.dataLength);
+
+				break;
+
+			case ENET_PROTOCOL_COMMAND_SEND_FRAGMENT | ENET_PROTOCOL_COMMAND_FLAG_ACKNOWLEDGE:
+				dataLength = totalLength >= sizeof(ENetProtocolSendFragment) ? sizeof(ENetProtocolSendFragment) + ENET_NET_TO_HOST_16(assembled->sendFragment.dataLength) : 0;
+
+				break;
+
+			default:
+				return -1;
+		}
+
+		return dataLength == totalLength ? 1 : -1;
+	}
+
+	static int enet_protocol_handle_bandwidth_limit(ENetHost* host, ENetPeer* peer, const ENetProtocol* command) {
+		if (peer->state != ENET_PEER_STATE_CONNECTED && peer->state != ENET_PEER_STATE_DISCONNECT_LATER)
+			return -1;
+
+		if (peer->incomingBandwidth != 0)
+			--host->bandwidthLimitedPeers;
+
+		peer->incomingBandwidth = ENET_NET_TO_HOST_32(command->bandwidthLimit.incomingBandwidth);
+		peer->outgoingBandwidth = ENET_NET_TO_HOST_32(command->bandwidthLimit.outgoingBandwidth);
+
+		if (peer->incomingBandwidth != 0)
+			++host->bandwidthLimitedPeers;
+
+		if (peer->incomingBandwidth == 0 && host->outgoingBandwidth == 0)
+			peer->windowSize = ENET_PROTOCOL_MAXIMUM_WINDOW_SIZE;
+		else if (peer->incomingBandwidth == 0 || host->outgoingBandwidth == 0)
+			peer->windowSize = (ENET_MAX(peer->incomingBandwidth, host->outgoingBandwidth) / ENET_PEER_WINDOW_SIZE_SCALE) * ENET_PROTOCOL_MINIMUM_WINDOW_SIZE;
+		else
+			peer->windowSize = (ENET_MIN(peer->incomingBandwidth, host->outgoingBandwidth) / ENET_PEER_WINDOW_SIZE_SCALE) * ENET_PROTOCOL_MINIMUM_WINDOW_SIZE;
+
+		if (peer->windowSize < ENET_PROTOCOL_MINIMUM_WINDOW_SIZE)
+			peer->windowSize = ENET_PROTOCOL_MINIMUM_WINDOW_SIZE;
+		else if (peer->windowSize > ENET_PROTOCOL_MAXIMUM_WINDOW_SIZE)
+			peer->windowSize = ENET_PROTOCOL_MAXIMUM_WINDOW_SIZE;
+
+		return 0;
+	}
+
+	static int enet_protocol_handle_throttle_configure(ENetHost* host, ENetPeer* peer, const ENetProtocol* command) {
+		if (peer->state != ENET_PEER_STATE_CONNECTED && peer->state != ENET_PEER_STATE_DISCONNECT_LATER)
+			return -1;
+
+		peer->packetThrottleInterval = ENET_NET_TO_HOST_32(command->throttleConfigure.packetThrottleInterval);
+		peer->packetThrottleAcceleration = ENET_NET_TO_HOST_32(command->throttleConfigure.packetThrottleAcceleration);
+		peer->packetThrottleDeceleration = ENET_NET_TO_HOST_32(command->throttleConfigure.packetThrottleDeceleration);
+
+		return 0;
+	}
+
+	static int enet_protocol_handle_disconnect(ENetHost* host, ENetPeer* peer, const ENetProtocol* command) {
+		if (peer->state == ENET_PEER_STATE_DISCONNECTED || peer->state == ENET_PEER_STATE_ZOMBIE || peer->state == ENET_PEER_STATE_ACKNOWLEDGING_DISCONNECT)
+			return 0;
+
+		enet_peer_reset_queues(peer);
+
+		if (peer->state == ENET_PEER_STATE_CONNECTION_SUCCEEDED || peer->state == ENET_PEER_STATE_DISCONNECTING || peer->state == ENET_PEER_STATE_CONNECTING) {
+			enet_protocol_dispatch_state(host, peer, ENET_PEER_STATE_ZOMBIE);
+		} else if (peer->state != ENET_PEER_STATE_CONNECTED && peer->state != ENET_PEER_STATE_DISCONNECT_LATER) {
+			if (peer->state == ENET_PEER_STATE_CONNECTION_PENDING)
+				host->recalculateBandwidthLimits = 1;
+
+			enet_peer_reset(peer);
+		} else if (command->header.command & ENET_PROTOCOL_COMMAND_FLAG_ACKNOWLEDGE) {
+			enet_protocol_change_state(host, peer, ENET_PEER_STATE_ACKNOWLEDGING_DISCONNECT);
+		} else {
+			enet_protocol_dispatch_state(host, peer, ENET_PEER_STATE_ZOMBIE);
+		}
+
+		if (peer->state != ENET_PEER_STATE_DISCONNECTED)
+			peer->eventData = ENET_NET_TO_HOST_32(command->disconnect.data);
+
+		return 0;
+	}
+
+	static uint32_t enet_protocol_measure_round_trip_time(ENetHost* host, uint16_t sentTime) {
+		uint32_t roundTripTime, receivedSentTime;
+		receivedSentTime = sentTime;
+		receivedSentTime |= host->serviceTime & 0xFFFF0000;
+
+		if ((receivedSentTime & 0x8000) > (host->serviceTime & 0x8000))
+			receivedSentTime -= 0x10000;
+
+		if (ENET_TIME_LESS(host->serviceTime, receivedSentTime))
+			return 0;
+
+		roundTripTime = ENET_TIME_DIFFERENCE(host->serviceTime, receivedSentTime);
+
+		return roundTripTime > 0 ? roundTripTime : 1;
+	}
+
+	static void enet_protocol_update_round_trip_time(ENetHost* host, ENetPeer* peer, uint32_t roundTripTime, uint32_t acknowledgedBytes) {
+		host->congestionControl->onAcknowledge(peer, roundTripTime, acknowledgedBytes);
+
+		if (peer->lastReceiveTime > 0) {
+			if (roundTripTime >= peer->roundTripTime) {
+				uint32_t diff = roundTripTime - peer->roundTripTime;
+				peer->roundTripTimeVariance -= peer->roundTripTimeVariance / 4;
+				peer->roundTripTimeVariance += diff / 4;
+				peer->roundTripTime += diff / 8;
+			} else {
+				uint32_t diff = peer->roundTripTime - roundTripTime;
+
+				if (diff <= peer->roundTripTimeVariance) {
+					peer->roundTripTimeVariance -= peer->roundTripTimeVariance / 4;
+					peer->roundTripTimeVariance += diff / 4;
+				} else {
+					peer->roundTripTimeVariance -= peer->roundTripTimeVariance / 32;
+					peer->roundTripTimeVariance += diff / 32;
+				}
+
+				peer->roundTripTime -= diff / 8;
+			}
+		} else {
+			peer->roundTripTime = roundTripTime;
+			peer->roundTripTimeVariance = roundTripTime / 2;
+		}
+
+		if (peer->roundTripTime < peer->lowestRoundTripTime)
+			peer->lowestRoundTripTime = peer->roundTripTime;
+
+		if (peer->roundTripTimeVariance > peer->highestRoundTripTimeVariance)
+			peer->highestRoundTripTimeVariance = peer->roundTripTimeVariance;
+
+		if (peer->packetThrottleEpoch == 0 || ENET_TIME_DIFFERENCE(host->serviceTime, peer->packetThrottleEpoch) >= peer->packetThrottleInterval) {
+			peer->lastRoundTripTime = peer->lowestRoundTripTime;
+			peer->lastRoundTripTimeVariance = peer->highestRoundTripTimeVariance;
+			peer->lowestRoundTripTime = peer->roundTripTime;
+			peer->highestRoundTripTimeVariance = peer->roundTripTimeVariance;
+			peer->packetThrottleEpoch = host->serviceTime;
+		}
+
+		peer->lastReceiveTime = ENET_MAX(host->serviceTime, 1);
+		peer->earliestTimeout = 0;
+	}
+
+	static void enet_protocol_fast_retransmit(ENetHost* host, ENetPeer* peer, uint32_t acknowledgedSendOrder, uint32_t acknowledgedCount) {
+		ENetOutgoingCommand* outgoingCommand;
+		ENetListIterator currentCommand, insertPosition, insertSendReliablePosition;
+		uint32_t lostBytes = 0;
+		currentCommand = enet_list_begin(&peer->sentReliableCommands);
+		insertPosition = enet_list_begin(&peer->outgoingCommands);
+		insertSendReliablePosition = enet_list_begin(&peer->outgoingSendReliableCommands);
+
+		while (currentCommand != enet_list_end(&peer->sentReliableCommands)) {
+			outgoingCommand = (ENetOutgoingCommand*)currentCommand;
+
+			/* Sent commands are kept in send order, so only the front was overtaken by the acknowledged command, even within one millisecond */
+			if ((int32_t)(outgoingCommand->sendOrder - acknowledgedSendOrder) >= 0)
+				break;
+
+			currentCommand = enet_list_next(currentCommand);
+
+			/* A selective acknowledgement stands for every command it acknowledges, otherwise merging them would hold fast retransmit back */
+			outgoingCommand->skippedAcknowledgements = (uint16_t)ENET_MIN((uint32_t)outgoingCommand->skippedAcknowledgements + acknowledgedCount, 0xFFFF);
+
+			if (outgoingCommand->skippedAcknowledgements < peer->fastRetransmit)
+				continue;
+
+			++peer->totalPacketsLost;
+			++peer->totalFastRetransmits;
+			outgoingCommand->inTransit = 0;
+
+			if (outgoingCommand->packet != NULL) {
+				peer->reliableDataInTransit -= outgoingCommand->fragmentLength;
+				lostBytes += outgoingCommand->fragmentLength;
+
+				enet_list_insert(insertSendReliablePosition, enet_list_remove(&outgoingCommand->outgoingCommandList));
+			} else {
+				enet_list_insert(insertPosition, enet_list_remove(&outgoingCommand->outgoingCommandList));
+			}
+		}
+
+		if (!enet_list_empty(&peer->sentReliableCommands)) {
+			outgoingCommand = (ENetOutgoingCommand*)enet_list_front(&peer->sentReliableCommands);
+			peer->nextTimeout = outgoingCommand->sentTime + outgoingCommand->roundTripTimeout;
+		}
+
+		if (lostBytes > 0 && host->congestionControl->onLoss != NULL)
+			host->congestionControl->onLoss(peer, lostBytes);
+	}
+
+	static int enet_protocol_handle_acknowledge(ENetHost* host, ENetEvent* event, ENetPeer* peer, const ENetProtocol* command) {
+		uint32_t roundTripTime, reliableDataInTransit, receivedReliableSequenceNumber, acknowledgedSendOrder = 0;
+		ENetProtocolCommand commandNumber;
+
+		if (peer->state == ENET_PEER_STATE_DISCONNECTED || peer->state == ENET_PEER_STATE_ZOMBIE)
+			return 0;
+
+		enet_peer_mark_pending(peer);
+
+		roundTripTime = enet_protocol_measure_round_trip_time(host, ENET_NET_TO_HOST_16(command->acknowledge.receivedSentTime));
+
+		if (roundTripTime == 0)
+			return 0;
+
+		reliableDataInTransit = peer->reliableDataInTransit;
+		receivedReliableSequenceNumber = ENET_NET_TO_HOST_16(command->acknowledge.receivedReliableSequenceNumber);
+		commandNumber = enet_protocol_remove_sent_reliable_command(peer, receivedReliableSequenceNumber, command->header.channelID, roundTripTime, &acknowledgedSendOrder);
+
+		enet_protocol_update_round_trip_time(host, peer, roundTripTime, reliableDataInTransit - peer->reliableDataInTransit);
+
+		if (peer->fastRetransmit > 0 && acknowledgedSendOrder != 0)
+			enet_protocol_fast_retransmit(host, peer, acknowledgedSendOrder, 1);
+
+		switch (peer->state) {
+			case ENET_PEER_STATE_ACKNOWLEDGING_CONNECT:
+				if (commandNumber != ENET_PROTOCOL_COMMAND_VERIFY_CONNECT)
+					return -1;
+
+				enet_protocol_notify_connect(host, peer, event);
+
+				break;
+
+			case ENET_PEER_STATE_DISCONNECTING:
+				if (commandNumber != ENET_PROTOCOL_COMMAND_DISCONNECT)
+					return -1;
+
+				enet_protocol_notify_disconnect(host, peer, event);
+
+				break;
+
+			case ENET_PEER_STATE_DISCONNECT_LATER:
+				if (!enet_peer_has_outgoing_commands(peer))
+					enet_peer_disconnect(peer, peer->eventData);
+
+				break;
+
+			default:
+				break;
+		}
+
+		return 0;
+	}
+
+	/* Every selective acknowledgement repeats what the receiver delivered in order, so one that gets lost leaves nothing to resend once the next arrives */
+	static uint32_t enet_protocol_remove_delivered_commands(ENetPeer* peer, uint8_t channelID, uint16_t deliveredSequenceNumber, uint32_t* sendOrder) {
+		ENetOutgoingCommand* outgoingCommand;
+		ENetListIterator currentCommand = enet_list_begin(&peer->sentReliableCommands);
+		uint32_t removed = 0;
+
+		while (currentCommand != enet_list_end(&peer->sentReliableCommands)) {
+			outgoingCommand = (ENetOutgoingCommand*)currentCommand;
+			currentCommand = enet_list_next(currentCommand);
+
+			if (outgoingCommand->command.header.channelID != channelID || (int16_t)(outgoingCommand->reliableSequenceNumber - deliveredSequenceNumber) > 0)
+				continue;
+
+			if (enet_protocol_remove_sent_reliable_command(peer, outgoingCommand->reliableSequenceNumber, channelID, 0, sendOrder) != ENET_PROTOCOL_COMMAND_NONE)
+				++removed;
+		}
+
+		return removed;
+	}
+
+	static int enet_protocol_handle_selective_acknowledge(ENetHost* host, ENetPeer* peer, const ENetProtocol* command) {
+		uint16_t reliableSequenceNumber;
+		uint32_t roundTripTime, reliableDataInTransit, receivedMask, acknowledgedSendOrder = 0, acknowledgedCount = 0;
+
+		if (peer->state == ENET_PEER_STATE_DISCONNECTED || peer->state == ENET_PEER_STATE_ZOMBIE)
+			return 0;
+
+		if (!(peer->capabilities & ENET_PROTOCOL_CAPABILITY_SELECTIVE_ACKNOWLEDGE) || command->header.channelID >= peer->channelCount)
+			return -1;
+
+		enet_peer_mark_pending(peer);
+
+		roundTripTime = enet_protocol_measure_round_trip_time(host, ENET_NET_TO_HOST_16(command->selectiveAcknowledge.receivedSentTime));
+
+		if (roundTripTime == 0)
+			return 0;
+
+		reliableDataInTransit = peer->reliableDataInTransit;
+		reliableSequenceNumber = ENET_NET_TO_HOST_16(command->selectiveAcknowledge.receivedReliableSequenceNumber);
+		receivedMask = ENET_NET_TO_HOST_32(command->selectiveAcknowledge.receivedMask);
+
+		if (enet_protocol_remove_sent_reliable_command(peer, reliableSequenceNumber, command->header.channelID, roundTripTime, &acknowledgedSendOrder) != ENET_PROTOCOL_COMMAND_NONE)
+			++acknowledgedCount;
+
+		for (; receivedMask != 0; receivedMask >>= 1) {
+			++reliableSequenceNumber;
+
+			if ((receivedMask & 1) && enet_protocol_remove_sent_reliable_command(peer, reliableSequenceNumber, command->header.channelID, 0, &acknowledgedSendOrder) != ENET_PROTOCOL_COMMAND_NONE)
+				++acknowledgedCount;
+		}
+
+		acknowledgedCount += enet_protocol_remove_delivered_commands(peer, command->header.channelID, command->header.reliableSequenceNumber, &acknowledgedSendOrder);
+
+		enet_protocol_update_round_trip_time(host, peer, roundTripTime, reliableDataInTransit - peer->reliableDataInTransit);
+
+		if (peer->fastRetransmit > 0 && acknowledgedSendOrder != 0)
+			enet_protocol_fast_retransmit(host, peer, acknowledgedSendOrder, acknowledgedCount);
+
+		switch (peer->state) {
+			case ENET_PEER_STATE_ACKNOWLEDGING_CONNECT:
+			case ENET_PEER_STATE_DISCONNECTING:
+				return -1;
+
+			case ENET_PEER_STATE_DISCONNECT_LATER:
+				if (!enet_peer_has_outgoing_commands(peer))
+					enet_peer_disconnect(peer, peer->eventData);
+
+				break;
+
+			default:
+				break;
+		}
+
+		return 0;
+	}
+
+	static int enet_protocol_handle_verify_connect(ENetHost* host, ENetEvent* event, ENetPeer* peer, const ENetProtocol* command, uint8_t** currentData) {
+		uint32_t mtu, windowSize, capabilities, checksumType;
+		size_t channelCount;
+		const uint8_t* remoteKey = NULL;
+
+		channelCount = ENET_NET_TO_HOST_32(command->verifyConnect.channelCount);
+		capabilities = (uint32_t)channelCount & ENET_PROTOCOL_CAPABILITY_MASK;
+		checksumType = (capabilities & ENET_PROTOCOL_CAPABILITY_CHECKSUM_MASK) >> ENET_PROTOCOL_CAPABILITY_CHECKSUM_SHIFT;
+		channelCount &= ~ENET_PROTOCOL_CAPABILITY_MASK;
+
+		/* The public key of the remote follows the command, retransmitted verifies carry it as well */
+		if (capabilities & ENET_PROTOCOL_CAPABILITY_ENCRYPTION) {
+			if (*currentData + ENET_PEER_CIPHER_KEY_SIZE > &host->receivedData[host->receivedDataLength])
+				return -1;
+
+			remoteKey = *currentData;
+			*currentData += ENET_PEER_CIPHER_KEY_SIZE;
+		}
+
+		/* Once the keys are derived retransmitted verifies only need their acknowledgement */
+		if (peer->state != ENET_PEER_STATE_CONNECTING || (peer->cipher != NULL && peer->cipher->keyed))
+			return 0;
+
+		if (channelCount < ENET_PROTOCOL_MINIMUM_CHANNEL_COUNT || channelCount > ENET_PROTOCOL_MAXIMUM_CHANNEL_COUNT || ENET_NET_TO_HOST_32(command->verifyConnect.packetThrottleInterval) != peer->packetThrottleInterval || ENET_NET_TO_HOST_32(command->verifyConnect.packetThrottleAcceleration) != peer->packetThrottleAcceleration || ENET_NET_TO_HOST_32(command->verifyConnect.packetThrottleDeceleration) != peer->packetThrottleDeceleration || command->verifyConnect.connectID != peer->connectID || (remoteKey != NULL) != (peer->cipher != NULL) || (remoteKey != NULL && enet_cipher_derive(peer, remoteKey, peer->connectID, 1) < 0)) {
+			peer->eventData = 0;
+
+			enet_protocol_dispatch_state(host, peer, ENET_PEER_STATE_ZOMBIE);
+
+			return -1;
+		}
+
+		enet_protocol_remove_sent_reliable_command(peer, 1, 0xFF, 0, NULL);
+
+		if (channelCount < peer->channelCount)
+			peer->channelCount = channelCount;
+
+		peer->capabilities = capabilities & host->capabilities;
+
+		if (host->checksum != ENET_CHECKSUM_NONE && checksumType < ENET_CHECKSUM_COUNT)
+			peer->checksum = (uint8_t)checksumType;
+
+		peer->outgoingPeerID = ENET_NET_TO_HOST_16(command->verifyConnect.outgoingPeerID);
+		peer->incomingSessionID = command->verifyConnect.incomingSessionID;
+		peer->outgoingSessionID = command->verifyConnect.outgoingSessionID;
+		mtu = ENET_NET_TO_HOST_32(command->verifyConnect.mtu);
+
+		if (mtu < ENET_PROTOCOL_MINIMUM_MTU)
+			mtu = ENET_PROTOCOL_MINIMUM_MTU;
+		else if (mtu > ENET_PROTOCOL_MAXIMUM_MTU)
+			mtu = ENET_PROTOCOL_MAXIMUM_MTU;
+
+		if (mtu < peer->mtu)
+			peer->mtu = mtu;
+
+		windowSize = ENET_NET_TO_HOST_32(command->verifyConnect.windowSize);
+
+		if (windowSize < ENET_PROTOCOL_MINIMUM_WINDOW_SIZE)
+			windowSize = ENET_PROTOCOL_MINIMUM_WINDOW_SIZE;
+
+		if (windowSize > ENET_PROTOCOL_MAXIMUM_WINDOW_SIZE)
+			windowSize = ENET_PROTOCOL_MAXIMUM_WINDOW_SIZE;
+
+		if (windowSize < peer->windowSize)
+			peer->windowSize = windowSize;
+
+		peer->incomingBandwidth = ENET_NET_TO_HOST_32(command->verifyConnect.incomingBandwidth);
+		peer->outgoingBandwidth = ENET_NET_TO_HOST_32(command->verifyConnect.outgoingBandwidth);
+
+		enet_peer_index(peer);
+
+		/* The verify came in the clear, an encrypting client connects on the first datagram of the server that opens under the derived keys, which the ping asks for */
+		if (peer->cipher != NULL) {
+			ENetProtocol ping;
+
+			ping.header.command = ENET_PROTOCOL_COMMAND_PING | ENET_PROTOCOL_COMMAND_FLAG_ACKNOWLEDGE;
+			ping.header.channelID = 0xFF;
+
+			enet_peer_queue_outgoing_command(peer, &ping, NULL, 0, 0);
+
+			return 0;
+		}
+
+		enet_protocol_notify_connect(host, peer, event);
+
+		return 0;
+	}
+
+	/* NONE stands for the host checksum callback, which keeps the legacy 64-bit layout */
+	static size_t enet_protocol_checksum_size(const ENetHost* host, ENetChecksumType type) {
+		switch (type) {
+			case ENET_CHECKSUM_CRC32C:
+				return sizeof(uint32_t);
+
+			case ENET_CHECKSUM_CRC64:
+			case ENET_CHECKSUM_XXHASH64:
+				return sizeof(uint64_t);
+
+			default:
+				return host->checksumCallback != NULL ? sizeof(enet_checksum) : 0;
+		}
+	}
+
+	static uint64_t enet_protocol_checksum(const ENetHost* host, ENetChecksumType type, const ENetBuffer* buffers, int bufferCount) {
+		switch (type) {
+			case ENET_CHECKSUM_CRC64:
+				return enet_crc64(buffers, bufferCount);
+
+			case ENET_CHECKSUM_CRC32C:
+				return enet_crc32c(buffers, bufferCount);
+
+			case ENET_CHECKSUM_XXHASH64:
+				return enet_xxhash64(buffers, bufferCount);
+
+			default:
+				return host->checksumCallback(buffers, bufferCount);
+		}
+	}
+
+	/* The field is seeded with the connect ID and the checksum covers the whole datagram, a 32-bit field takes the low half */
+	static void enet_protocol_write_checksum(uint8_t* field, size_t size, uint64_t value) {
+		if (size == sizeof(uint32_t)) {
+			uint32_t shortValue = (uint32_t)value;
+
+			memcpy(field, &shortValue, sizeof(uint32_t));
+		} else {
+			memcpy(field, &value, sizeof(uint64_t));
+		}
+	}
+
+	static int enet_protocol_verify_checksum(ENetHost* host, ENetPeer* peer, ENetChecksumType type, size_t headerSize) {
+		uint8_t* field = &host->receivedData[headerSize];
+		uint8_t desiredChecksum[sizeof(uint64_t)];
+		size_t size = enet_protocol_checksum_size(host, type);
+		ENetBuffer buffer;
+		int result;
+
+		if (host->receivedDataLength < headerSize + size)
+			return -1;
+
+		memcpy(desiredChecksum, field, size);
+		enet_protocol_write_checksum(field, size, peer != NULL ? peer->connectID : 0);
+
+		buffer.data = host->receivedData;
+		buffer.dataLength = host->receivedDataLength;
+
+		enet_protocol_write_checksum(field, size, enet_protocol_checksum(host, type, &buffer, 1));
+		result = memcmp(field, desiredChecksum, size) == 0 ? 0 : -1;
+
+		memcpy(field, desiredChecksum, size);
+
+		return result;
+	}
+
+	/* Only the low half of the counter is sent, the rest is inferred from the highest counter authenticated so far */
+	static uint64_t enet_protocol_cipher_counter(uint64_t highestCounter, uint32_t truncatedCounter) {
+		uint64_t expectedCounter = highestCounter + 1;
+		uint64_t counter = (expectedCounter & ~(uint64_t)0xFFFFFFFF) | truncatedCounter;
+
+		if (counter + 0x80000000 <= expectedCounter)
+			counter += (uint64_t)1 << 32;
+		else if (counter > expectedCounter + 0x80000000 && counter > 0xFFFFFFFF)
+			counter -= (uint64_t)1 << 32;
+
+		return counter;
+	}
+
+	/* The header and the counter are authenticated as additional data, the commands are decrypted in place once the tag matched */
+	static int enet_protocol_open_datagram(ENetHost* host, ENetPeer* peer, size_t headerSize) {
+		ENetCipher* cipher = peer->cipher;
+		uint8_t* counterField = &host->receivedData[headerSize];
+		uint8_t nonce[12] = { 0 };
+		uint64_t counter, distance;
+
+		if (!cipher->keyed || host->receivedDataLength < headerSize + ENET_PEER_CIPHER_OVERHEAD)
+			return -1;
+
+		counter = enet_protocol_cipher_counter(cipher->receiveCounter, enet_cipher_load32(counterField));
+
+		if (counter <= cipher->receiveCounter) {
+			distance = cipher->receiveCounter - counter;
+
+			if (distance >= ENET_PEER_CIPHER_REPLAY_WINDOW || (cipher->receiveWindow & ((uint64_t)1 << distance)))
+				return -1;
+		}
+
+		enet_cipher_store64(&nonce[4], counter);
+
+		if (enet_aead_open(cipher->receiveKey, nonce, host->receivedData, headerSize + ENET_PEER_CIPHER_COUNTER_SIZE, &host->receivedData[headerSize + ENET_PEER_CIPHER_OVERHEAD], host->receivedDataLength - headerSize - ENET_PEER_CIPHER_OVERHEAD, &counterField[ENET_PEER_CIPHER_COUNTER_SIZE]) < 0)
+			return -1;
+
+		if (counter > cipher->receiveCounter) {
+			distance = counter - cipher->receiveCounter;
+			cipher->receiveWindow = distance < ENET_PEER_CIPHER_REPLAY_WINDOW ? (cipher->receiveWindow << distance) | 1 : 1;
+			cipher->receiveCounter = counter;
+		} else {
+			cipher->receiveWindow |= (uint64_t)1 << (cipher->receiveCounter - counter);
+		}
+
+		return 0;
+	}
+
+	static int enet_protocol_handle_incoming_commands(ENetHost* host, ENetEvent* event) {
+		ENetProtocolHeader* header;
+		ENetProtocol* command;
+		ENetPeer* peer;
+		ENetChecksumType checksumType;
+		uint8_t* currentData;
+		uint8_t* resumeData = NULL;
+		uint8_t* datagramData = NULL;
+		size_t headerSize, datagramLength = 0;
+		uint16_t peerID, flags;
+		uint8_t sessionID;
+		int sealed;
+
+		if (host->receivedDataLength < (size_t)&((ENetProtocolHeader*)0)->sentTime)
+			return 0;
+
+		header = (ENetProtocolHeader*)host->receivedData;
+		peerID = ENET_NET_TO_HOST_16(header->peerID);
+		sessionID = (peerID & ENET_PROTOCOL_HEADER_SESSION_MASK) >> ENET_PROTOCOL_HEADER_SESSION_SHIFT;
+		flags = peerID & ENET_PROTOCOL_HEADER_FLAG_MASK;
+		peerID &= ~(ENET_PROTOCOL_HEADER_FLAG_MASK | ENET_PROTOCOL_HEADER_SESSION_MASK);
+		headerSize = (flags & ENET_PROTOCOL_HEADER_FLAG_SENT_TIME ? sizeof(ENetProtocolHeader) : (size_t)&((ENetProtocolHeader*)0)->sentTime);
+
+		if (peerID == ENET_PROTOCOL_MAXIMUM_PEER_ID) {
+			peer = NULL;
+		} else if (peerID >= host->peerCount) {
+			return 0;
+		} else {
+			peer = &host->peers[peerID];
+
+			if (peer->state == ENET_PEER_STATE_DISCONNECTED || peer->state == ENET_PEER_STATE_ZOMBIE || ((!enet_in6_equal(host->receivedAddress.ipv6, peer->address.ipv6) || host->receivedAddress.port != peer->address.port) && peer->address.ipv4.ip.s_addr != INADDR_BROADCAST) || (peer->outgoingPeerID < ENET_PROTOCOL_MAXIMUM_PEER_ID && sessionID != peer->incomingSessionID))
+				return 0;
+		}
+
+		sealed = peer != NULL && peer->cipher != NULL && enet_protocol_open_datagram(host, peer, headerSize) == 0;
+
+		if (sealed) {
+			headerSize += ENET_PEER_CIPHER_OVERHEAD;
+
+			if (peer->state == ENET_PEER_STATE_CONNECTING)
+				enet_protocol_notify_connect(host, peer, event);
+		} else {
+			/* Once the remote is known to seal its datagrams nothing in the clear is accepted anymore */
+			if (peer != NULL && peer->cipher != NULL && peer->cipher->receiveCounter != 0)
+				return 0;
+
+			checksumType = peer != NULL ? (ENetChecksumType)peer->checksum : ENET_CHECKSUM_NONE;
+
+			/* Datagrams the remote sent before it saw the handshake complete still carry the host checksum, the first one with the negotiated checksum ends that */
+			if (checksumType != ENET_CHECKSUM_NONE) {
+				if (enet_protocol_verify_checksum(host, peer, checksumType, headerSize) == 0) {
+					peer->checksumConfirmed = 1;
+				} else {
+					if (host->checksumCallback == NULL || peer->checksumConfirmed)
+						return 0;
+
+					checksumType = ENET_CHECKSUM_NONE;
+				}
+			}
+
+			if (checksumType == ENET_CHECKSUM_NONE && host->checksumCallback != NULL && enet_protocol_verify_checksum(host, peer, checksumType, headerSize) < 0)
+				return 0;
+
+			headerSize += enet_protocol_checksum_size(host, checksumType);
+		}
+
+		if (peer != NULL) {
+			peer->address.ipv6 = host->receivedAddress.ipv6;
+			peer->address.port = host->receivedAddress.port;
+			peer->incomingDataTotal += host->receivedDataLength;
+			peer->totalDataReceived += host->receivedDataLength;
+		}
+
+		/* The checksum covers the datagram as sent, the commands are expanded into the spare packet buffer after it was verified */
+		if (flags & ENET_PROTOCOL_HEADER_FLAG_COMPRESSED) {
+			size_t originalSize;
+
+			if (peer == NULL || host->compressor.context == NULL || host->receivedDataLength <= headerSize)
+				return 0;
+
+			originalSize = host->compressor.decompress(host->compressor.context, host->receivedData + headerSize, host->receivedDataLength - headerSize, host->packetData[1] + headerSize, sizeof(host->packetData[1]) - headerSize);
+
+			if (originalSize == 0 || originalSize > sizeof(host->packetData[1]) - headerSize)
+				return 0;
+
+			memcpy(host->packetData[1], host->receivedData, headerSize);
+
+			host->receivedData = host->packetData[1];
+			host->receivedDataLength = headerSize + originalSize;
+			header = (ENetProtocolHeader*)host->receivedData;
+		}
+
+		currentData = host->receivedData + headerSize;
+
+		for (;;) {
+			uint8_t commandNumber;
+			size_t commandSize;
+
+			/* A command assembled from pieces is processed from the assembly, then the datagram goes on after the last piece */
+			if (currentData >= &host->receivedData[host->receivedDataLength]) {
+				if (resumeData == NULL)
+					break;
+
+				host->receivedData = datagramData;
+				host->receivedDataLength = datagramLength;
+				currentData = resumeData;
+				resumeData = NULL;
+
+				continue;
+			}
+
+			command = (ENetProtocol*)currentData;
+
+			if (currentData + sizeof(ENetProtocolCommandHeader) > &host->receivedData[host->receivedDataLength])
+				break;
+
+			commandNumber = command->header.command & ENET_PROTOCOL_COMMAND_MASK;
+
+			if (commandNumber >= ENET_PROTOCOL_COMMAND_COUNT)
+				break;
+
+			commandSize = commandSizes[commandNumber];
+
+			if (commandSize == 0 || currentData + commandSize > &host->receivedData[host->receivedDataLength])
+				break;
+
+			currentData += commandSize;
+
+			/* A connect stands alone in its datagram, followed only by the public key of an encrypting client and the dictionary ID */
+			if (peer == NULL && (commandNumber != ENET_PROTOCOL_COMMAND_CONNECT || currentData + (ENET_NET_TO_HOST_32(command->connect.channelCount) & ENET_PROTOCOL_CAPABILITY_ENCRYPTION ? ENET_PEER_CIPHER_KEY_SIZE : 0) + (ENET_NET_TO_HOST_32(command->connect.channelCount) & ENET_PROTOCOL_CAPABILITY_DICTIONARY ? sizeof(uint32_t) : 0) != &host->receivedData[host->receivedDataLength]))
+				break;
+
+			/* The verify carrying the public key of the remote is the only command an encrypting peer takes in the clear */
+			if (peer != NULL && peer->cipher != NULL && !sealed && commandNumber != ENET_PROTOCOL_COMMAND_VERIFY_CONNECT)
+				break;
+
+			command->header.reliableSequenceNumber = ENET_NET_TO_HOST_16(command->header.reliableSequenceNumber);
+
+			switch (commandNumber) {
+				case ENET_PROTOCOL_COMMAND_ACKNOWLEDGE:
+					if (enet_protocol_handle_acknowledge(host, event, peer, command))
+						goto commandError;
+
+					break;
+
+				case ENET_PROTOCOL_COMMAND_SELECTIVE_ACKNOWLEDGE:
+					if (enet_protocol_handle_selective_acknowledge(host, peer, command))
+						goto commandError;
+
+					break;
+
+				case ENET_PROTOCOL_COMMAND_PROBE:
+					if (enet_protocol_handle_probe(host, peer, command, &currentData))
+						goto commandError;
+
+					break;
+
+				case ENET_PROTOCOL_COMMAND_PIECE: {
+					int result = enet_protocol_handle_piece(host, peer, command, &currentData);
+
+					if (result < 0)
+						goto commandError;
+
+					if (result > 0) {
+						resumeData = currentData;
+						datagramData = host->receivedData;
+						datagramLength = host->receivedDataLength;
+						host->receivedData = peer->pieceData;
+						host->receivedDataLength = peer->pieceLength;
+						currentData = peer->pieceData;
+					}
+
+					break;
+				}
+
+				case ENET_PROTOCOL_COMMAND_CONNECT:
+					if (peer != NULL)
+						goto commandError;
+
+					if (host->preventConnections == 0) {
+						peer = enet_protocol_handle_connect(host, header, command, &currentData);
+
+						if (peer == NULL)
+							goto commandError;
+					}
+
+					break;
+
+				case ENET_PROTOCOL_COMMAND_VERIFY_CONNECT:
+					if (enet_protocol_handle_verify_connect(host, event, peer, command, &currentData))
+						goto commandError;
+
+					break;
+
+				case ENET_PROTOCOL_COMMAND_DISCONNECT:
+					if (enet_protocol_handle_disconnect(host, peer, command))
+						goto commandError;
+
+					break;
+
+				case ENET_PROTOCOL_COMMAND_PING:
+					if (enet_protocol_handle_ping(host, peer, command))
+						goto commandError;
+
+					break;
+
+				case ENET_PROTOCOL_COMMAND_SEND_RELIABLE:
+					if (enet_protocol_handle_send_reliable(host, peer, command, &currentData))
+						goto commandError;
+
+					break;
+
+				case ENET_PROTOCOL_COMMAND_SEND_UNRELIABLE:
+					if (enet_protocol_handle_send_unreliable(host, peer, command, &currentData))
+						goto commandError;
+
+					break;
+
+				case ENET_PROTOCOL_COMMAND_SEND_UNSEQUENCED:
+					if (enet_protocol_handle_send_unsequenced(host, peer, command, &currentData))
+						goto commandError;
+
+					break;
+
+				case ENET_PROTOCOL_COMMAND_SEND_FRAGMENT:
+					if (enet_protocol_handle_send_fragment(host, peer, command, &currentData))
+						goto commandError;
+
+					break;
+
+				case ENET_PROTOCOL_COMMAND_BANDWIDTH_LIMIT:
+					if (enet_protocol_handle_bandwidth_limit(host, peer, command))
+						goto commandError;
+
+					break;
+
+				case ENET_PROTOCOL_COMMAND_THROTTLE_CONFIGURE:
+					if (enet_protocol_handle_throttle_configure(host, peer, command))
+						goto commandError;
+
+					break;
+
+				case ENET_PROTOCOL_COMMAND_SEND_UNRELIABLE_FRAGMENT:
+					if (enet_protocol_handle_send_unreliable_fragment(host, peer, command, &currentData))
+						goto commandError;
+
+					break;
+
+				default:
+					goto commandError;
+			}
+
+			if (peer != NULL && (command->header.command & ENET_PROTOCOL_COMMAND_FLAG_ACKNOWLEDGE) != 0) {
+				uint16_t sentTime;
+
+				if (!(flags & ENET_PROTOCOL_HEADER_FLAG_SENT_TIME))
+					break;
+
+				sentTime = ENET_NET_TO_HOST_16(header->sentTime);
+
+				switch (peer->state) {
+					case ENET_PEER_STATE_DISCONNECTING:
+					case ENET_PEER_STATE_ACKNOWLEDGING_CONNECT:
+					case ENET_PEER_STATE_DISCONNECTED:
+					case ENET_PEER_STATE_ZOMBIE:
+						break;
+
+					case ENET_PEER_STATE_ACKNOWLEDGING_DISCONNECT:
+						if ((command->header.command & ENET_PROTOCOL_COMMAND_MASK) == ENET_PROTOCOL_COMMAND_DISCONNECT)
+							enet_peer_queue_acknowledgement(peer, command, sentTime);
+
+						break;
+
+					default:
+						enet_peer_queue_acknowledgement(peer, command, sentTime);
+
+						break;
+				}
+			}
+		}
+
+		commandError:
+
+		if (resumeData != NULL) {
+			host->receivedData = datagramData;
+			host->receivedDataLength = datagramLength;
+		}
+
+		if (event != NULL && event->type != ENET_EVENT_TYPE_NONE)
+			return 1;
+
+		return 0;
+	}
+
+	static int enet_protocol_receive_incoming_commands(ENetHost* host, ENetEvent* event) {
+		/* Peers probing the path may send datagrams above the configured MTU */
+		int receiveLimit = (host->capabilities & ENET_PROTOCOL_CAPABILITY_PATH_MTU) ? ENET_PROTOCOL_MAXIMUM_MTU : (int)host->mtu;
+		int packets;
+
+		/* Datagrams left over from a batch that was interrupted by an event are handled before the socket is read again */
+		for (packets = 0; packets < 256 || host->receiveIndex < host->receiveCount; ++packets) {
+			int receivedLength;
+
+			if (host->receiveIndex >= host->receiveCount) {
+				size_t i;
+
+				/* The receive slots are allocated on the first socket read that needs them, io_uring hosts read from the kernel's buffers */
+				if (host->uring == NULL) {
+					if (!host->receiveCoalescing && host->receiveData == NULL) {
+						host->receiveData = (uint8_t*)enet_malloc(ENET_HOST_RECEIVE_BATCH * ENET_PROTOCOL_MAXIMUM_MTU);
+
+						if (host->receiveData == NULL)
+							return -1;
+					}
+
+					for (i = 0; i < ENET_HOST_RECEIVE_BATCH; ++i) {
+						#ifdef ENET_HAS_SEGMENT
+							if (host->receiveCoalescing) {
+								host->receiveBuffers[i].data = &host->receiveArena[i * ENET_SEGMENT_RECEIVE_SIZE];
+								host->receiveBuffers[i].dataLength = ENET_SEGMENT_RECEIVE_SIZE;
+
+								continue;
+							}
+						#endif
+
+						host->receiveBuffers[i].data = &host->receiveData[i * ENET_PROTOCOL_MAXIMUM_MTU];
+						host->receiveBuffers[i].dataLength = receiveLimit;
+					}
+				}
+
+				#ifdef ENET_HAS_URING
+					if (host->uring != NULL) {
+						memset(host->receiveSegmentSizes, 0, sizeof(host->receiveSegmentSizes));
+
+						receivedLength = enet_uring_receive_batch(host->uring, host->receiveAddresses, host->receiveBuffers, host->receiveLengths, ENET_HOST_RECEIVE_BATCH);
+					} else
+				#endif
+
+				receivedLength = enet_socket_receive_batch(host->socket, host->receiveAddresses, host->receiveBuffers, host->receiveLengths, host->receiveSegmentSizes, ENET_HOST_RECEIVE_BATCH);
+
+				if (receivedLength < 0)
+					return -1;
+
+				if (receivedLength == 0)
+					return 0;
+
+				host->receiveIndex = 0;
+				host->receiveCount = receivedLength;
+				host->receiveOffset = 0;
+			}
+
+			receivedLength = host->receiveLengths[host->receiveIndex];
+			host->receivedAddress = host->receiveAddresses[host->receiveIndex];
+			host->receivedData = (uint8_t*)host->receiveBuffers[host->receiveIndex].data + host->receiveOffset;
+
+			/* A coalesced read carries several datagrams of the same flow back to back, each of the segment size except possibly the last */
+			if (receivedLength > 0 && host->receiveSegmentSizes[host->receiveIndex] > 0 && receivedLength - (int)host->receiveOffset > host->receiveSegmentSizes[host->receiveIndex]) {
+				receivedLength = host->receiveSegmentSizes[host->receiveIndex];
+				host->receiveOffset += receivedLength;
+			} else {
+				if (receivedLength > 0)
+					receivedLength -= (int)host->receiveOffset;
+
+				host->receiveOffset = 0;
+				++host->receiveIndex;
+			}
+
+			if (receivedLength == -2 || receivedLength > receiveLimit)
+				continue;
+
+			host->receivedDataLength = receivedLength;
+			host->totalReceivedData += receivedLength;
+			host->totalReceivedPackets++;
+
+			if (host->interceptCallback != NULL) {
+				switch (host->interceptCallback(event, &host->receivedAddress, host->receivedData, host->receivedDataLength)) {
+					case 1:
+						if (event != NULL && event->type != ENET_EVENT_TYPE_NONE)
+							return 1;
+
+						continue;
+
+					case -1:
+						return -1;
+
+					default:
+						break;
+				}
+			}
+
+			switch (enet_protocol_handle_incoming_commands(host, event)) {
+				case 1:
+					return 1;
+
+				case -1:
+					return -1;
+
+				default:
+					break;
+			}
+		}
+
+		return 0;
+	}
+
+	static uint16_t enet_protocol_acknowledgement_sent_time(ENetHost* host, const ENetAcknowledgement* acknowledgement) {
+		/* The time an acknowledgement was held back is added to the echo, so the sender measures only the network round trip */
+		return (uint16_t)(acknowledgement->sentTime + ENET_TIME_DIFFERENCE(host->serviceTime, acknowledgement->queueTime));
+	}
+
+	/* The sender times out a command four round trip variances past the round trip, and the hold is hidden from its samples, so acknowledgements are held for half of that slack at most */
+	static uint32_t enet_protocol_acknowledgement_hold(const ENetPeer* peer) {
+		return ENET_MIN(peer->acknowledgementDelay, 2 * peer->roundTripTimeVariance);
+	}
+
+	static int enet_protocol_acknowledgements_due(ENetHost* host, ENetPeer* peer) {
+		ENetAcknowledgement* acknowledgement;
+
+		if (enet_list_empty(&peer->acknowledgements))
+			return 0;
+
+		if (peer->acknowledgementDelay == 0 || peer->state != ENET_PEER_STATE_CONNECTED || (peer->acknowledgementThreshold > 0 && peer->acknowledgementCount >= peer->acknowledgementThreshold))
+			return 1;
+
+		/* Held acknowledgements ride along with any data that is about to go out */
+		if (!enet_list_empty(&peer->outgoingCommands) || !enet_list_empty(&peer->outgoingSendReliableCommands))
+			return 1;
+
+		acknowledgement = (ENetAcknowledgement*)enet_list_front(&peer->acknowledgements);
+
+		return ENET_TIME_DIFFERENCE(host->serviceTime, acknowledgement->queueTime) >= enet_protocol_acknowledgement_hold(peer);
+	}
+
+	static void enet_protocol_merge_acknowledgements(ENetHost* host, ENetPeer* peer, ENetAcknowledgement* acknowledgement, ENetProtocol* command) {
+		ENetAcknowledgement* mergedAcknowledgement;
+		ENetListIterator currentAcknowledgement;
+		uint16_t reliableSequenceNumber, sentTime, distance;
+		uint32_t receivedMask = 0;
+		reliableSequenceNumber = acknowledgement->command.header.reliableSequenceNumber;
+		sentTime = enet_protocol_acknowledgement_sent_time(host, acknowledgement);
+		currentAcknowledgement = enet_list_next(&acknowledgement->acknowledgementList);
+
+		while (currentAcknowledgement != enet_list_end(&peer->acknowledgements)) {
+			mergedAcknowledgement = (ENetAcknowledgement*)currentAcknowledgement;
+			currentAcknowledgement = enet_list_next(currentAcknowledgement);
+			distance = mergedAcknowledgement->command.header.reliableSequenceNumber - reliableSequenceNumber;
+
+			if (mergedAcknowledgement->command.header.channelID != acknowledgement->command.header.channelID || distance > ENET_PEER_SELECTIVE_ACKNOWLEDGE_RANGE)
+				continue;
+
+			if (distance > 0)
+				receivedMask |= 1u << (distance - 1);
+
+			/* The newest send time gives the freshest round trip sample */
+			if ((int16_t)(enet_protocol_acknowledgement_sent_time(host, mergedAcknowledgement) - sentTime) > 0)
+				sentTime = enet_protocol_acknowledgement_sent_time(host, mergedAcknowledgement);
+
+			enet_list_remove(&mergedAcknowledgement->acknowledgementList);
+			enet_pool_free(&host->acknowledgementPool, mergedAcknowledgement);
+
+			--peer->acknowledgementCount;
+		}
+
+		command->header.command = ENET_PROTOCOL_COMMAND_SELECTIVE_ACKNOWLEDGE;
+		command->header.channelID = acknowledgement->command.header.channelID;
+		command->header.reliableSequenceNumber = ENET_HOST_TO_NET_16(peer->channels[acknowledgement->command.header.channelID].incomingReliableSequenceNumber);
+		command->selectiveAcknowledge.receivedReliableSequenceNumber = ENET_HOST_TO_NET_16(reliableSequenceNumber);
+		command->selectiveAcknowledge.receivedSentTime = ENET_HOST_TO_NET_16(sentTime);
+		command->selectiveAcknowledge.receivedMask = ENET_HOST_TO_NET_32(receivedMask);
+	}
+
+	static void enet_protocol_send_acknowledgements(ENetHost* host, ENetPeer* peer) {
+		ENetProtocol* command = &host->commands[host->commandCount];
+		ENetBuffer* buffer = &host->buffers[host->bufferCount];
+		ENetAcknowledgement* acknowledgement;
+		ENetListIterator currentAcknowledgement;
+		uint16_t reliableSequenceNumber;
+		size_t acknowledgementSize = (peer->capabilities & ENET_PROTOCOL_CAPABILITY_SELECTIVE_ACKNOWLEDGE) ? sizeof(ENetProtocolSelectiveAcknowledge) : sizeof(ENetProtocolAcknowledge);
+		currentAcknowledgement = enet_list_begin(&peer->acknowledgements);
+
+		while (currentAcknowledgement != enet_list_end(&peer->acknowledgements)) {
+			if (command >= &host->commands[ENET_PROTOCOL_MAXIMUM_PACKET_COMMANDS] || buffer >= &host->buffers[ENET_BUFFER_MAXIMUM] || peer->mtu - host->packetSize < acknowledgementSize) {
+				peer->continueSending = 1;
+
+				break;
+			}
+
+			acknowledgement = (ENetAcknowledgement*)currentAcknowledgement;
+			buffer->data = command;
+
+			if ((peer->capabilities & ENET_PROTOCOL_CAPABILITY_SELECTIVE_ACKNOWLEDGE) && acknowledgement->command.header.channelID != 0xFF) {
+				enet_protocol_merge_acknowledgements(host, peer, acknowledgement, command);
+
+				buffer->dataLength = sizeof(ENetProtocolSelectiveAcknowledge);
+			} else {
+				reliableSequenceNumber = ENET_HOST_TO_NET_16(acknowledgement->command.header.reliableSequenceNumber);
+				command->header.command = ENET_PROTOCOL_COMMAND_ACKNOWLEDGE;
+				command->header.channelID = acknowledgement->command.header.channelID;
+				command->header.reliableSequenceNumber = reliableSequenceNumber;
+				command->acknowledge.receivedReliableSequenceNumber = reliableSequenceNumber;
+				command->acknowledge.receivedSentTime = ENET_HOST_TO_NET_16(enet_protocol_acknowledgement_sent_time(host, acknowledgement));
+				buffer->dataLength = sizeof(ENetProtocolAcknowledge);
+			}
+
+			host->packetSize += buffer->dataLength;
+			currentAcknowledgement = enet_list_next(currentAcknowledgement);
+
+			if ((acknowledgement->command.header.command & ENET_PROTOCOL_COMMAND_MASK) == ENET_PROTOCOL_COMMAND_DISCONNECT)
+				enet_protocol_dispatch_state(host, peer, ENET_PEER_STATE_ZOMBIE);
+
+			enet_list_remove(&acknowledgement->acknowledgementList);
+			enet_pool_free(&host->acknowledgementPool, acknowledgement);
+
+			--peer->acknowledgementCount;
+
+			++command;
+			++buffer;
+		}
+
+		host->commandCount = command - host->commands;
+		host->bufferCount = buffer - host->buffers;
+	}
+
+	static int enet_protocol_check_timeouts(ENetHost* host, ENetPeer* peer, ENetEvent* event) {
+		ENetOutgoingCommand* outgoingCommand;
+		ENetListIterator currentCommand, insertPosition, insertSendReliablePosition;
+		uint32_t lostBytes = 0;
+		currentCommand = enet_list_begin(&peer->sentReliableCommands);
+		insertPosition = enet_list_begin(&peer->outgoingCommands);
+		insertSendReliablePosition = enet_list_begin(&peer->outgoingSendReliableCommands);
+
+		while (currentCommand != enet_list_end(&peer->sentReliableCommands)) {
+			outgoingCommand = (ENetOutgoingCommand*)currentCommand;
+			currentCommand = enet_list_next(currentCommand);
+
+			if (ENET_TIME_DIFFERENCE(host->serviceTime, outgoingCommand->sentTime) < outgoingCommand->roundTripTimeout)
+				continue;
+
+			if (peer->earliestTimeout == 0 || ENET_TIME_LESS(outgoingCommand->sentTime, peer->earliestTimeout))
+				peer->earliestTimeout = outgoingCommand->sentTime;
+
+			if (peer->earliestTimeout != 0 && (ENET_TIME_DIFFERENCE(host->serviceTime, peer->earliestTimeout) >= peer->timeoutMaximum || ((uint32_t)(1u << ((outgoingCommand->sendAttempts - 1) % 32)) >= peer->timeoutLimit && ENET_TIME_DIFFERENCE(host->serviceTime, peer->earliestTimeout) >= peer->timeoutMinimum))) {
+				enet_protocol_notify_disconnect_timeout(host, peer, event);
+
+				return 1;
+			}
+
+			++peer->totalPacketsLost;
+			outgoingCommand->roundTripTimeout = peer->roundTripTime + 4 * peer->roundTripTimeVariance + peer->remoteAcknowledgementHold;
+			outgoingCommand->inTransit = 0;
+
+			/* Large datagrams keep getting lost, the path may have shrunk or drop them without telling, so the MTU in use is probed again */
+			if (enet_protocol_above_mtu_minimum(peer, outgoingCommand) && ++peer->mtuLosses >= ENET_PEER_MTU_BLACK_HOLE_LIMIT && peer->mtuProbeSize == 0) {
+				peer->mtuLosses = 0;
+				peer->mtuProbeLow = ENET_PROTOCOL_MINIMUM_MTU;
+				peer->mtuProbeHigh = (uint16_t)peer->mtu;
+				peer->mtuProbeSize = (uint16_t)peer->mtu;
+				peer->mtuProbeCount = 0;
+				peer->mtuProbeTime = host->serviceTime;
+			}
+
+			if (outgoingCommand->packet != NULL) {
+				peer->reliableDataInTransit -= outgoingCommand->fragmentLength;
+				lostBytes += outgoingCommand->fragmentLength;
+
+				enet_list_insert(insertSendReliablePosition, enet_list_remove(&outgoingCommand->outgoingCommandList));
+	  		} else {
+				enet_list_insert(insertPosition, enet_list_remove(&outgoingCommand->outgoingCommandList));
+			}
+
+			/* Without encryption the payload is only the dictionary ID, which goes away with the capabilities */
+			if (host->legacyConnect && peer->state == ENET_PEER_STATE_CONNECTING && (outgoingCommand->command.header.command & ENET_PROTOCOL_COMMAND_MASK) == ENET_PROTOCOL_COMMAND_CONNECT && !(host->capabilities & ENET_PROTOCOL_CAPABILITY_ENCRYPTION) && ENET_TIME_DIFFERENCE(host->serviceTime, peer->earliestTimeout) >= ENET_PEER_LEGACY_CONNECT_DELAY) {
+				outgoingCommand->command.connect.channelCount = ENET_HOST_TO_NET_32(ENET_NET_TO_HOST_32(outgoingCommand->command.connect.channelCount) & ~ENET_PROTOCOL_CAPABILITY_MASK);
+				outgoingCommand->fragmentLength = 0;
+			}
+
+			if (currentCommand == enet_list_begin(&peer->sentReliableCommands) && !enet_list_empty(&peer->sentReliableCommands)) {
+				outgoingCommand = (ENetOutgoingCommand*)currentCommand;
+				peer->nextTimeout = outgoingCommand->sentTime + outgoingCommand->roundTripTimeout;
+			}
+		}
+
+		if (lostBytes > 0 && host->congestionControl->onLoss != NULL)
+			host->congestionControl->onLoss(peer, lostBytes);
+
+		return 0;
+	}
+
+	/* Commands are cut to the MTU when they are queued, a fallback of the MTU leaves the ones cut before it too large for any datagram */
+	static int enet_protocol_command_oversized(const ENetPeer* peer, size_t totalLength) {
+		size_t overhead = sizeof(ENetProtocolHeader) + sizeof(ENetProtocolAcknowledge) + (peer->cipher != NULL ? (size_t)ENET_PEER_CIPHER_OVERHEAD : enet_protocol_checksum_size(peer->host, (ENetChecksumType)peer->checksum));
+
+		return (peer->capabilities & ENET_PROTOCOL_CAPABILITY_PATH_MTU) && totalLength + overhead > peer->mtu;
+	}
+
+	/* A piece carries the next slice of the command as it would be sent whole, its header first and then its data */
+	static void enet_protocol_send_piece(ENetHost* host, ENetOutgoingCommand* outgoingCommand, ENetProtocol* command, ENetBuffer* buffer, size_t commandSize, size_t pieceLength) {
+		size_t pieceOffset = outgoingCommand->pieceOffset, dataOffset;
+
+		command->header.command = ENET_PROTOCOL_COMMAND_PIECE;
+		command->header.channelID = outgoingCommand->command.header.channelID;
+		command->header.reliableSequenceNumber = outgoingCommand->command.header.reliableSequenceNumber;
+		command->piece.pieceOffset = ENET_HOST_TO_NET_16((uint16_t)pieceOffset);
+		command->piece.pieceLength = ENET_HOST_TO_NET_16((uint16_t)pieceLength);
+		command->piece.totalLength = ENET_HOST_TO_NET_16((uint16_t)(commandSize + outgoingCommand->fragmentLength));
+		buffer->data = command;
+		buffer->dataLength = sizeof(ENetProtocolPiece);
+		host->packetSize += buffer->dataLength + pieceLength;
+		++buffer;
+
+		if (pieceOffset < commandSize) {
+			buffer->data = (uint8_t*)&outgoingCommand->command + pieceOffset;
+			buffer->dataLength = ENET_MIN(commandSize - pieceOffset, pieceLength);
+			++buffer;
+		}
+
+		if (pieceOffset + pieceLength > commandSize) {
+			dataOffset = ENET_MAX(pieceOffset, commandSize) - commandSize;
+			buffer->data = outgoingCommand->packet->data + outgoingCommand->fragmentOffset + dataOffset;
+			buffer->dataLength = pieceOffset + pieceLength - commandSize - dataOffset;
+			++buffer;
+		}
+
+		outgoingCommand->pieceOffset += (uint16_t)pieceLength;
+		host->bufferCount = buffer - host->buffers;
+		host->headerFlags |= ENET_PROTOCOL_HEADER_FLAG_SENT_TIME;
+	}
+
+	static int enet_protocol_check_outgoing_commands(ENetHost* host, ENetPeer* peer, ENetList* sentUnreliableCommands) {
+		ENetProtocol* command = &host->commands[host->commandCount];
+		ENetBuffer* buffer = &host->buffers[host->bufferCount];
+		ENetOutgoingCommand* outgoingCommand;
+		ENetListIterator currentCommand, currentSendReliableCommand;
+		ENetChannel* channel = NULL;
+		uint16_t reliableWindow = 0;
+		size_t commandSize = 0, totalLength = 0, pieceLength = 0;
+		int windowWrap = 0, canPing = 1, pieced = 0;
+
+		currentCommand = enet_list_begin(&peer->outgoingCommands);
+		currentSendReliableCommand = enet_list_begin(&peer->outgoingSendReliableCommands);
+
+		for (;;) {
+			if (currentCommand != enet_list_end(&peer->outgoingCommands)) {
+				outgoingCommand = (ENetOutgoingCommand*)currentCommand;
+
+				if (currentSendReliableCommand != enet_list_end(&peer->outgoingSendReliableCommands) && ENET_TIME_LESS(((ENetOutgoingCommand*)currentSendReliableCommand)->queueTime, outgoingCommand->queueTime))
+					goto useSendReliableCommand;
+
+					currentCommand = enet_list_next(currentCommand);
+				}
+				else if (currentSendReliableCommand != enet_list_end(&peer->outgoingSendReliableCommands)) {
+					useSendReliableCommand:
+
+					outgoingCommand = (ENetOutgoingCommand*)currentSendReliableCommand;
+					currentSendReliableCommand = enet_list_next(currentSendReliableCommand);
+				}
+				else {
+					break;
+				}
+
+			if (outgoingCommand->command.header.command & ENET_PROTOCOL_COMMAND_FLAG_ACKNOWLEDGE) {
+				channel = outgoingCommand->command.header.channelID < peer->channelCount ? &peer->channels[outgoingCommand->command.header.channelID] : NULL;
+				reliableWindow = outgoingCommand->reliableSequenceNumber / ENET_PEER_RELIABLE_WINDOW_SIZE;
+
+				if (channel != NULL) {
+					if (windowWrap) {
+			   			continue;
+					} else if (outgoingCommand->sendAttempts < 1 && outgoingCommand->pieceOffset == 0 && !(outgoingCommand->reliableSequenceNumber % ENET_PEER_RELIABLE_WINDOW_SIZE) && (channel->reliableWindows[(reliableWindow + ENET_PEER_RELIABLE_WINDOWS - 1) % ENET_PEER_RELIABLE_WINDOWS] >= ENET_PEER_RELIABLE_WINDOW_SIZE || channel->usedReliableWindows & ((((1u << (ENET_PEER_FREE_RELIABLE_WINDOWS + 2)) - 1) << reliableWindow) | (((1u << (ENET_PEER_FREE_RELIABLE_WINDOWS + 2)) - 1) >> (ENET_PEER_RELIABLE_WINDOWS - reliableWindow))))) {
+						windowWrap = 1;
+						currentSendReliableCommand = enet_list_end(&peer->outgoingSendReliableCommands);
+
+						continue;
+					}
+				}
+
+				if (outgoingCommand->packet != NULL && outgoingCommand->pieceOffset == 0) {
+					uint32_t windowSize = ENET_MIN(host->congestionControl->getWindow(peer), peer->windowSize);
+
+					if (peer->reliableDataInTransit + outgoingCommand->fragmentLength > ENET_MAX(windowSize, peer->mtu)) {
+						currentSendReliableCommand = enet_list_end(&peer->outgoingSendReliableCommands);
+
+						continue;
+					}
+				}
+
+				canPing = 0;
+			}
+
+			commandSize = commandSizes[outgoingCommand->command.header.command & ENET_PROTOCOL_COMMAND_MASK];
+			totalLength = commandSize + outgoingCommand->fragmentLength;
+			pieced = outgoingCommand->packet != NULL && (outgoingCommand->pieceOffset > 0 || enet_protocol_command_oversized(peer, totalLength));
+
+			/* Data cut before the MTU fell back no longer fits, reliable commands go out in pieces and unreliable ones are dropped like the network would */
+			if (pieced && !(outgoingCommand->command.header.command & ENET_PROTOCOL_COMMAND_FLAG_ACKNOWLEDGE)) {
+				--outgoingCommand->packet->referenceCount;
+
+				if (outgoingCommand->packet->referenceCount == 0)
+					enet_packet_destroy(outgoingCommand->packet);
+
+				enet_list_remove(&outgoingCommand->outgoingCommandList);
+				enet_pool_free(&host->outgoingCommandPool, outgoingCommand);
+
+				continue;
+			}
+
+			if (command >= &host->commands[ENET_PROTOCOL_MAXIMUM_PACKET_COMMANDS] || buffer + (pieced ? 3 : 1) >= &host->buffers[ENET_BUFFER_MAXIMUM] || peer->mtu - host->packetSize < commandSize || (pieced ? peer->mtu - host->packetSize < sizeof(ENetProtocolPiece) + ENET_MIN((size_t)ENET_PEER_PIECE_UNIT, totalLength - outgoingCommand->pieceOffset) : (outgoingCommand->packet != NULL && (uint16_t)(peer->mtu - host->packetSize) < (uint16_t)totalLength))) {
+				peer->continueSending = 1;
+
+				break;
+			}
+
+			if (outgoingCommand->command.header.command & ENET_PROTOCOL_COMMAND_FLAG_ACKNOWLEDGE) {
+				if (outgoingCommand->sendAttempts < 1 && outgoingCommand->pieceOffset == 0) {
+					if ((outgoingCommand->command.header.channelID == 0xFF || channel != NULL) && enet_protocol_index_sent_reliable_command(peer, outgoingCommand) < 0)
+						break;
+
+					if (channel != NULL) {
+						channel->usedReliableWindows |= 1u << reliableWindow;
+						++channel->reliableWindows[reliableWindow];
+					}
+				}
+
+				if (pieced) {
+					pieceLength = ENET_MIN(totalLength - outgoingCommand->pieceOffset, peer->mtu - host->packetSize - sizeof(ENetProtocolPiece));
+
+					if (outgoingCommand->pieceOffset + pieceLength < totalLength)
+						pieceLength -= pieceLength % ENET_PEER_PIECE_UNIT;
+
+					enet_protocol_send_piece(host, outgoingCommand, command, buffer, commandSize, pieceLength);
+
+					buffer = &host->buffers[host->bufferCount];
+					++command;
+
+					/* The command stays queued until its last piece is out, only then it counts as sent */
+					if (outgoingCommand->pieceOffset < totalLength) {
+						peer->continueSending = 1;
+
+						break;
+					}
+
+					outgoingCommand->pieceOffset = 0;
+				}
+
+				++outgoingCommand->sendAttempts;
+
+				if (outgoingCommand->roundTripTimeout == 0)
+					outgoingCommand->roundTripTimeout = peer->roundTripTime + 4 * peer->roundTripTimeVariance + peer->remoteAcknowledgementHold;
+
+				if (enet_list_empty(&peer->sentReliableCommands))
+					peer->nextTimeout = host->serviceTime + outgoingCommand->roundTripTimeout;
+
+				enet_list_insert(enet_list_end(&peer->sentReliableCommands),
+				enet_list_remove(&outgoingCommand->outgoingCommandList));
+
+				outgoingCommand->sentTime = host->serviceTime;
+				outgoingCommand->sendOrder = ++peer->sendOrder;
+				outgoingCommand->skippedAcknowledgements = 0;
+				outgoingCommand->inTransit = 1;
+				host->headerFlags |= ENET_PROTOCOL_HEADER_FLAG_SENT_TIME;
+				peer->reliableDataInTransit += outgoingCommand->fragmentLength;
+			} else {
+				if (outgoingCommand->packet != NULL && outgoingCommand->fragmentOffset == 0 && !(outgoingCommand->packet->flags & (ENET_PACKET_FLAG_UNTHROTTLED))) {
+					peer->packetThrottleCounter += ENET_PEER_PACKET_THROTTLE_COUNTER;
+					peer->packetThrottleCounter %= ENET_PEER_PACKET_THROTTLE_SCALE;
+
+					if (peer->packetThrottleCounter > peer->packetThrottle) {
+						uint16_t reliableSequenceNumber = outgoingCommand->reliableSequenceNumber,
+
+						unreliableSequenceNumber = outgoingCommand->unreliableSequenceNumber;
+
+						for (;;) {
+							--outgoingCommand->packet->referenceCount;
+
+							if (outgoingCommand->packet->referenceCount == 0)
+								enet_packet_destroy(outgoingCommand->packet);
+
+							enet_list_remove(&outgoingCommand->outgoingCommandList);
+							enet_pool_free(&host->outgoingCommandPool, outgoingCommand);
+
+							if (currentCommand == enet_list_end(&peer->outgoingCommands))
+								break;
+
+							outgoingCommand = (ENetOutgoingCommand*)currentCommand;
+
+							if (outgoingCommand->reliableSequenceNumber != reliableSequenceNumber || outgoingCommand->unreliableSequenceNumber != unreliableSequenceNumber)
+								break;
+
+							currentCommand = enet_list_next(currentCommand);
+						}
+
+						continue;
+					}
+				}
+
+				enet_list_remove(&outgoingCommand->outgoingCommandList);
+
+				if (outgoingCommand->packet != NULL)
+					enet_list_insert(enet_list_end(sentUnreliableCommands), outgoingCommand);
+			}
+
+			if (pieced) {
+				++peer->totalPacketsSent;
+
+				continue;
+			}
+
+			buffer->data = command;
+			buffer->dataLength = commandSize;
+			host->packetSize += buffer->dataLength;
+			*command = outgoingCommand->command;
+
+			if (outgoingCommand->packet != NULL) {
+				++buffer;
+				buffer->data = outgoingCommand->packet->data + outgoingCommand->fragmentOffset;
+				buffer->dataLength = outgoingCommand->fragmentLength;
+				host->packetSize += outgoingCommand->fragmentLength;
+			} else if (!(outgoingCommand->command.header.command & ENET_PROTOCOL_COMMAND_FLAG_ACKNOWLEDGE)) {
+				enet_pool_free(&host->outgoingCommandPool, outgoingCommand);
+			}
+
+			++peer->totalPacketsSent;
+			++command;
+			++buffer;
+		}
+
+		host->commandCount = command - host->commands;
+		host->bufferCount = buffer - host->buffers;
+
+		if (peer->state == ENET_PEER_STATE_DISCONNECT_LATER && !enet_peer_has_outgoing_commands(peer) && enet_list_empty(sentUnreliableCommands))
+			enet_peer_disconnect(peer, peer->eventData);
+
+		return canPing;
+	}
+
+	static int enet_protocol_send_datagrams(ENetHost* host) {
+		ENetAddress addresses[ENET_HOST_SEND_BATCH];
+		ENetBuffer* buffers[ENET_HOST_SEND_BATCH];
+		size_t bufferCounts[ENET_HOST_SEND_BATCH];
+		size_t segmentSizes[ENET_HOST_SEND_BATCH];
+		uint32_t delays[ENET_HOST_SEND_BATCH];
+		size_t slotCounts[ENET_HOST_SEND_BATCH];
+		int sentLengths[ENET_HOST_SEND_BATCH];
+		int slotLengths[ENET_HOST_SEND_BATCH];
+		size_t i, slot, batchCount, datagramCount = 0;
+		int result = 0, segmented = 0, retry = 0, unsupported = 0;
+
+		#ifdef ENET_HAS_SEGMENT
+			ENetBuffer segmentBuffers[ENET_SEGMENT_MAXIMUM_BUFFERS];
+			size_t segmentBufferCount = 0;
+		#endif
+
+		if (host->sendCount == 0)
+			return 0;
+
+		for (slot = 0; slot < host->sendCount; ++slot) {
+			slotLengths[slot] = 0;
+
+			for (i = 0; i < host->sendBufferCounts[slot]; ++i) {
+				slotLengths[slot] += (int)host->sendBuffers[slot][i].dataLength;
+			}
+		}
+
+		/* A probe is always the last datagram of its batch and goes out on its own */
+		batchCount = host->sendProbing ? host->sendCount - 1 : host->sendCount;
+
+		for (slot = 0; slot < batchCount; slot += slotCounts[datagramCount++]) {
+			addresses[datagramCount] = host->sendAddresses[slot];
+			buffers[datagramCount] = host->sendBuffers[slot];
+			bufferCounts[datagramCount] = host->sendBufferCounts[slot];
+			segmentSizes[datagramCount] = 0;
+			delays[datagramCount] = host->sendDelays[slot];
+			slotCounts[datagramCount] = 1;
+
+			#ifdef ENET_HAS_SEGMENT
+				/* Consecutive datagrams to the same peer are handed to the kernel as one buffer, every segment but the last must be of the same size */
+				if (host->segmentation) {
+					size_t last = slot + 1, totalLength = slotLengths[slot], totalBuffers = host->sendBufferCounts[slot];
+
+					while (last < batchCount && host->sendPeers[last] == host->sendPeers[slot] && host->sendDelays[last] == host->sendDelays[slot] && slotLengths[last - 1] == slotLengths[slot] && slotLengths[last] <= slotLengths[slot] && last - slot < ENET_SEGMENT_MAXIMUM_COUNT && totalLength + slotLengths[last] <= ENET_SEGMENT_MAXIMUM_SIZE && segmentBufferCount + totalBuffers + host->sendBufferCounts[last] <= ENET_SEGMENT_MAXIMUM_BUFFERS) {
+						totalLength += slotLengths[last];
+						totalBuffers += host->sendBufferCounts[last];
+						++last;
+					}
+
+					if (last - slot > 1) {
+						buffers[datagramCount] = &segmentBuffers[segmentBufferCount];
+						bufferCounts[datagramCount] = totalBuffers;
+						segmentSizes[datagramCount] = slotLengths[slot];
+						slotCounts[datagramCount] = last - slot;
+
+						for (i = slot; i < last; ++i) {
+							memcpy(&segmentBuffers[segmentBufferCount], host->sendBuffers[i], host->sendBufferCounts[i] * sizeof(ENetBuffer));
+							segmentBufferCount += host->sendBufferCounts[i];
+						}
+
+						segmented = 1;
+					}
+				}
+			#endif
+		}
+
+		#ifdef ENET_HAS_URING
+			if (host->uring != NULL && datagramCount > 0) {
+				result = enet_uring_send_batch(host->uring, addresses, buffers, bufferCounts, sentLengths, datagramCount, ENET_TIME_LESS(host->serviceTime, host->serviceDeadline) ? ENET_TIME_DIFFERENCE(host->serviceDeadline, host->serviceTime) : 0);
+
+				/* A ring the kernel stopped accepting is dropped for the poll backend, the datagrams it did not send are retried on the socket */
+				if (result < 0 && enet_uring_failed(host->uring)) {
+					enet_uring_destroy(host->uring);
+
+					host->uring = NULL;
+					host->receiveIndex = 0;
+					host->receiveCount = 0;
+					host->receiveOffset = 0;
+
+					retry = 1;
+					result = 0;
+				}
+			} else if (host->uring == NULL)
+		#endif
+
+		result = enet_socket_send_batch(host->socket, addresses, buffers, bufferCounts, segmentSizes, host->pacing == ENET_PACING_KERNEL ? delays : NULL, sentLengths, datagramCount);
+
+		/* The unsent datagrams of a failed segmented send are retried one by one, the offload is only turned off when the kernel refused it for the route */
+		if (result < 0 && segmented) {
+			#ifdef ENET_HAS_SEGMENT
+				unsupported = errno == EIO || errno == EINVAL || errno == EOPNOTSUPP || errno == ENOPROTOOPT;
+			#endif
+
+			retry = 1;
+			result = 0;
+		}
+
+		for (i = 0, slot = 0; i < datagramCount; slot += slotCounts[i++]) {
+			size_t segment;
+
+			/* A segmented datagram reports the length of all its segments, each segment keeps its own */
+			if (sentLengths[i] > 0) {
+				if (slotCounts[i] == 1)
+					slotLengths[slot] = sentLengths[i];
+
+				continue;
+			}
+
+			for (segment = slot; segment < slot + slotCounts[i]; ++segment) {
+				slotLengths[segment] = 0;
+
+				if (retry && result == 0) {
+					slotLengths[segment] = enet_socket_send(host->socket, &host->sendAddresses[segment], host->sendBuffers[segment], host->sendBufferCounts[segment]);
+
+					if (slotLengths[segment] < 0)
+						result = -1;
+				}
+			}
+		}
+
+		if (unsupported && result == 0)
+			host->segmentation = 0;
+
+		/* Only probes are sent with fragmentation forbidden, a probe the link refuses as too large is lost like one dropped on the way */
+		if (host->sendProbing) {
+			slot = host->sendCount - 1;
+
+			enet_socket_set_option(host->socket, ENET_SOCKOPT_DONTFRAGMENT, 1);
+
+			slotLengths[slot] = enet_socket_send(host->socket, &host->sendAddresses[slot], host->sendBuffers[slot], host->sendBufferCounts[slot]);
+
+			enet_socket_set_option(host->socket, ENET_SOCKOPT_DONTFRAGMENT, 0);
+
+			if (slotLengths[slot] < 0)
+				slotLengths[slot] = 0;
+
+			host->sendProbing = 0;
+		}
+
+		for (slot = 0; slot < host->sendCount; ++slot) {
+			ENetPeer* currentPeer = host->sendPeers[slot];
+
+			enet_protocol_remove_sent_unreliable_commands(currentPeer, &host->sendUnreliableCommands[slot]);
+
+			/* Datagrams a batch left behind on a full socket or a failed send were never on the wire */
+			if (slotLengths[slot] <= 0)
+				continue;
+
+			host->totalSentData += slotLengths[slot];
+			currentPeer->totalDataSent += slotLengths[slot];
+			host->totalSentPackets++;
+		}
+
+		host->sendCount = 0;
+
+		return result < 0 ? -1 : 0;
+	}
+
+	static void enet_protocol_cascade_timers(ENetHost* host, uint32_t level) {
+		ENetList* slot = &host->timerWheel[level][(host->timerTime >> (level * ENET_HOST_TIMER_SLOT_BITS)) & (ENET_HOST_TIMER_SLOTS - 1)];
+
+		while (!enet_list_empty(slot)) {
+			ENetListNode* node = enet_list_begin(slot);
+			ENetPeer* peer = (ENetPeer*)((uint8_t*)node - (size_t)&((ENetPeer*)0)->timerList);
+
+			enet_peer_schedule(peer, peer->timerDeadline);
+		}
+	}
+
+	static void enet_protocol_advance_timers(ENetHost* host) {
+		if (host->timerCount == 0) {
+			host->timerTime = host->serviceTime;
+
+			return;
+		}
+
+		while (ENET_TIME_LESS(host->timerTime, host->serviceTime)) {
+			ENetList* slot;
+			uint32_t level;
+
+			++host->timerTime;
+
+			for (level = ENET_HOST_TIMER_LEVELS - 1; level > 0; --level) {
+				if ((host->timerTime & ((1u << (level * ENET_HOST_TIMER_SLOT_BITS)) - 1)) == 0)
+					enet_protocol_cascade_timers(host, level);
+			}
+
+			slot = &host->timerWheel[0][host->timerTime & (ENET_HOST_TIMER_SLOTS - 1)];
+
+			while (!enet_list_empty(slot)) {
+				ENetListNode* node = enet_list_begin(slot);
+				ENetPeer* peer = (ENetPeer*)((uint8_t*)node - (size_t)&((ENetPeer*)0)->timerList);
+
+				enet_list_remove(node);
+
+				peer->timerList.next = NULL;
+				--host->timerCount;
+
+				enet_peer_mark_pending(peer);
+			}
+		}
+	}
+
+	static int enet_protocol_next_timer(ENetHost* host, uint32_t* deadline) {
+		uint32_t level, slot;
+
+		if (host->timerCount == 0)
+			return 0;
+
+		/* Lower levels always expire before higher ones and a level 0 slot holds a single deadline, so the first occupied slot bounds the wait */
+		for (level = 0; level < ENET_HOST_TIMER_LEVELS; ++level) {
+			uint32_t current = host->timerTime >> (level * ENET_HOST_TIMER_SLOT_BITS);
+
+			for (slot = 1; slot < ENET_HOST_TIMER_SLOTS; ++slot) {
+				ENetList* timers = &host->timerWheel[level][(current + slot) & (ENET_HOST_TIMER_SLOTS - 1)];
+				ENetListIterator currentTimer;
+
+				if (enet_list_empty(timers))
+					continue;
+
+				*deadline = ((ENetPeer*)((uint8_t*)enet_list_begin(timers) - (size_t)&((ENetPeer*)0)->timerList))->timerDeadline;
+
+				for (currentTimer = enet_list_begin(timers); currentTimer != enet_list_end(timers); currentTimer = enet_list_next(currentTimer)) {
+					ENetPeer* peer = (ENetPeer*)((uint8_t*)currentTimer - (size_t)&((ENetPeer*)0)->timerList);
+
+					if (ENET_TIME_LESS(peer->timerDeadline, *deadline))
+						*deadline = peer->timerDeadline;
+				}
+
+				return 1;
+			}
+		}
+
+		return 0;
+	}
+
+	/* Searches between the confirmed MTU and the smallest size that went unanswered, then settles until the next raise attempt */
+	static int enet_protocol_probe_due(ENetHost* host, ENetPeer* peer) {
+		if (!(peer->capabilities & ENET_PROTOCOL_CAPABILITY_PATH_MTU) || peer->state != ENET_PEER_STATE_CONNECTED)
+			return 0;
+
+		if (peer->mtuProbeHigh == 0) {
+			peer->mtuProbeLow = (uint16_t)peer->mtu;
+			peer->mtuProbeHigh = ENET_PROTOCOL_MAXIMUM_MTU;
+			peer->mtuProbeTime = host->serviceTime;
+		}
+
+		if (ENET_TIME_LESS(host->serviceTime, peer->mtuProbeTime))
+			return 0;
+
+		if (peer->mtuProbeSize != 0) {
+			if (++peer->mtuProbeCount < ENET_PEER_MTU_PROBE_COUNT)
+				return 1;
+
+			peer->mtuProbeHigh = peer->mtuProbeSize - 1;
+
+			/* The MTU in use failed its own probe, datagrams fall back to the minimum while the search goes on below it */
+			if (peer->mtuProbeSize <= peer->mtu) {
+				peer->mtu = peer->mtuProbeLow;
+
+				if (host->mtuCallback != NULL)
+					host->mtuCallback(peer, peer->mtu);
+			}
+
+			peer->mtuProbeSize = 0;
+		} else if (peer->mtuProbeLow >= peer->mtuProbeHigh) {
+			peer->mtuProbeHigh = ENET_PROTOCOL_MAXIMUM_MTU;
+		}
+
+		if (peer->mtuProbeHigh < peer->mtuProbeLow + ENET_PEER_MTU_PROBE_STEP) {
+			peer->mtuProbeHigh = peer->mtuProbeLow;
+			peer->mtuProbeTime = host->serviceTime + ENET_PEER_MTU_PROBE_INTERVAL;
+
+			return 0;
+		}
+
+		/* The largest size is tried first so that paths without a bottleneck settle in a single round trip */
+		if (peer->mtuProbeHigh == ENET_PROTOCOL_MAXIMUM_MTU)
+			peer->mtuProbeSize = ENET_PROTOCOL_MAXIMUM_MTU;
+		else
+			peer->mtuProbeSize = peer->mtuProbeLow + (peer->mtuProbeHigh - peer->mtuProbeLow + 1) / 2;
+		peer->mtuProbeCount = 0;
+
+		return 1;
+	}
+
+	static void enet_protocol_send_probe(ENetHost* host, ENetPeer* peer) {
+		static uint8_t padding[ENET_PROTOCOL_MAXIMUM_MTU];
+		ENetProtocol* command = &host->commands[host->commandCount];
+		ENetBuffer* buffer = &host->buffers[host->bufferCount];
+
+		if (command >= &host->commands[ENET_PROTOCOL_MAXIMUM_PACKET_COMMANDS] || buffer + 1 >= &host->buffers[ENET_BUFFER_MAXIMUM] || host->packetSize + sizeof(ENetProtocolProbe) > peer->mtuProbeSize)
+			return;
+
+		command->header.command = ENET_PROTOCOL_COMMAND_PROBE;
+		command->header.channelID = 0xFF;
+		command->header.reliableSequenceNumber = 0;
+		command->probe.probeSequenceNumber = ENET_HOST_TO_NET_16(++peer->mtuProbeSequenceNumber);
+		command->probe.probeLength = ENET_HOST_TO_NET_16(peer->mtuProbeSize);
+		command->probe.receivedLength = 0;
+		buffer->data = command;
+		buffer->dataLength = sizeof(ENetProtocolProbe);
+		host->packetSize += buffer->dataLength;
+		++buffer;
+		buffer->data = padding;
+		buffer->dataLength = peer->mtuProbeSize - host->packetSize;
+		host->packetSize += buffer->dataLength;
+		host->commandCount += 1;
+		host->bufferCount += 2;
+		host->headerFlags |= ENET_PROTOCOL_HEADER_FLAG_SENT_TIME;
+
+		peer->mtuProbeTime = host->serviceTime + ENET_MAX(peer->roundTripTime + 4 * peer->roundTripTimeVariance, ENET_PEER_MTU_PROBE_TIMEOUT);
+
+		if (!enet_list_empty(&peer->outgoingCommands) || !enet_list_empty(&peer->outgoingSendReliableCommands))
+			peer->continueSending = 1;
+	}
+
+	static uint32_t enet_protocol_pacing_rate(ENetPeer* peer) {
+		const ENetCongestionControl* congestionControl = peer->host->congestionControl;
+		uint32_t rate = 0, window;
+
+		if (congestionControl->getPacingRate != NULL)
+			rate = congestionControl->getPacingRate(peer);
+
+		/* Without a rate from the controller the window is spread over the smoothed round-trip time with some headroom */
+		if (rate == 0) {
+			window = ENET_MAX(ENET_MIN(congestionControl->getWindow(peer), peer->windowSize), peer->mtu);
+			rate = (uint32_t)ENET_MIN((uint64_t)window * 1250 / ENET_MAX(peer->roundTripTime, 1), 0xFFFFFFFF);
+		}
+
+		return ENET_MAX(rate, 1000);
+	}
+
+	static int enet_protocol_pace(ENetHost* host, ENetPeer* peer, uint32_t* releaseTime) {
+		uint32_t rate, limit, elapsed;
+		int64_t floor;
+
+		if (enet_list_empty(&peer->outgoingCommands) && enet_list_empty(&peer->outgoingSendReliableCommands))
+			return 0;
+
+		rate = enet_protocol_pacing_rate(peer);
+		limit = ENET_MAX(ENET_PEER_PACING_BURST * peer->mtu, rate / 1000 * ENET_PEER_PACING_QUANTUM);
+		elapsed = ENET_TIME_DIFFERENCE(host->serviceTime, peer->pacingTime);
+
+		if (elapsed > 0 || peer->pacingTime == 0) {
+			peer->pacingCredit = (int32_t)ENET_MIN((int64_t)peer->pacingCredit + (int64_t)rate * elapsed / 1000, (int64_t)limit);
+			peer->pacingTime = ENET_MAX(host->serviceTime, 1);
+		}
+
+		/* With kernel pacing the datagrams are stamped with a departure time and may run ahead up to the horizon */
+		floor = host->pacing == ENET_PACING_KERNEL ? -(int64_t)rate * ENET_PEER_PACING_HORIZON / 1000 : 0;
+
+		if (peer->pacingCredit > floor)
+			return 0;
+
+		*releaseTime = host->serviceTime + (uint32_t)ENET_MAX((floor - peer->pacingCredit) * 1000 / rate, 1);
+
+		return 1;
+	}
+
+	/* Peers whose datagrams stop shrinking are skipped for a doubling number of datagrams, so incompressible traffic costs next to nothing */
+	static void enet_protocol_compress_datagram(ENetHost* host, ENetPeer* peer) {
+		uint8_t* compressedData = &host->stagingData[host->sendCount * ENET_PROTOCOL_MAXIMUM_MTU];
+		size_t inLimit = 0, compressedSize, i;
+
+		for (i = 1; i < host->bufferCount; ++i) {
+			inLimit += host->buffers[i].dataLength;
+		}
+
+		if (inLimit < ENET_PEER_COMPRESSION_MINIMUM)
+			return;
+
+		if (peer->compressionBypass > 0) {
+			--peer->compressionBypass;
+
+			return;
+		}
+
+		compressedSize = host->compressor.compress(host->compressor.context, &host->buffers[1], host->bufferCount - 1, inLimit, compressedData, inLimit);
+
+		if (compressedSize == 0 || compressedSize >= inLimit) {
+			if (peer->compressionFailures < ENET_PEER_COMPRESSION_BYPASS_LIMIT)
+				++peer->compressionFailures;
+
+			peer->compressionBypass = (uint8_t)((1 << peer->compressionFailures) - 1);
+
+			return;
+		}
+
+		peer->compressionFailures = 0;
+		host->headerFlags |= ENET_PROTOCOL_HEADER_FLAG_COMPRESSED;
+		host->buffers[1].data = compressedData;
+		host->buffers[1].dataLength = compressedSize;
+		host->bufferCount = 2;
+		host->packetSize -= inLimit - compressedSize;
+	}
+
+	/* The commands are gathered into the staging buffer while they are encrypted, a compressed datagram is encrypted where it already is */
+	static void enet_protocol_seal_datagram(ENetHost* host, ENetPeer* peer, uint8_t* headerData) {
+		uint8_t* sealedData = &host->stagingData[host->sendCount * ENET_PROTOCOL_MAXIMUM_MTU];
+		size_t headerLength = host->buffers->dataLength;
+		uint8_t nonce[12] = { 0 };
+		uint64_t counter = ++peer->cipher->sendCounter;
+
+		enet_cipher_store32(&headerData[headerLength], (uint32_t)counter);
+		enet_cipher_store64(&nonce[4], counter);
+
+		host->buffers[1].dataLength = enet_aead_seal(peer->cipher->sendKey, nonce, headerData, headerLength + ENET_PEER_CIPHER_COUNTER_SIZE, &host->buffers[1], host->bufferCount - 1, sealedData, &headerData[headerLength + ENET_PEER_CIPHER_COUNTER_SIZE]);
+		host->buffers[1].data = sealedData;
+		host->buffers->dataLength += ENET_PEER_CIPHER_OVERHEAD;
+		host->bufferCount = 2;
+	}
+
+	/* Packets copied into aggregates stay referenced until the next flush, so a caller can hand the same packet to several peers in between */
+	static void enet_protocol_release_aggregated_packets(ENetHost* host) {
+		while (host->aggregatedPacketCount > 0) {
+			ENetPacket* packet = host->aggregatedPackets[--host->aggregatedPacketCount];
+
+			--packet->referenceCount;
+
+			if (packet->referenceCount == 0) {
+				packet->flags |= ENET_PACKET_FLAG_SENT;
+
+				enet_packet_destroy(packet);
+			}
+		}
+	}
+
+	static int enet_protocol_send_outgoing_commands(ENetHost* host, ENetEvent* event, int checkForTimeouts) {
+		uint8_t* headerData;
+		ENetProtocolHeader* header;
+		ENetList* sentUnreliableCommands;
+		ENetChecksumType checksumType;
+		size_t checksumSize;
+		uint32_t releaseTime = 0;
+		int paced, probing, sealed;
+
+		enet_protocol_release_aggregated_packets(host);
+
+		/* Only peers with queued work or an expired timer are visited, idle peers wait in the timer wheel */
+		enet_protocol_advance_timers(host);
+
+		for (int sendPass = 0, continueSending = 0; sendPass <= continueSending; ++sendPass) {
+			ENetListIterator currentNode, nextNode;
+
+			for (currentNode = enet_list_begin(&host->pendingPeers); currentNode != enet_list_end(&host->pendingPeers); currentNode = nextNode) {
+				ENetPeer* currentPeer = (ENetPeer*)((uint8_t*)currentNode - (size_t)&((ENetPeer*)0)->pendingList);
+
+				nextNode = enet_list_next(currentNode);
+
+				if (currentPeer->state == ENET_PEER_STATE_ZOMBIE) {
+					enet_peer_unschedule(currentPeer);
+
+					continue;
+				}
+
+				if (sendPass > 0 && !currentPeer->continueSending)
+					continue;
+
+				nextDatagram:
+
+				currentPeer->continueSending = 0;
+				paced = 0;
+				probing = 0;
+
+				headerData = host->sendHeaderData[host->sendCount];
+				header = (ENetProtocolHeader*)headerData;
+				sentUnreliableCommands = &host->sendUnreliableCommands[host->sendCount];
+
+				host->headerFlags = 0;
+				host->commands = host->sendCommands[host->sendCount];
+				host->commandCount = 0;
+				host->buffers = host->sendBuffers[host->sendCount];
+				host->bufferCount = 1;
+				host->packetSize = sizeof(ENetProtocolHeader);
+
+				/* Until the verify is acknowledged the remote cannot know the negotiated checksum or its keys yet, sealed datagrams carry a tag instead of a checksum */
+				checksumType = currentPeer->state != ENET_PEER_STATE_ACKNOWLEDGING_CONNECT ? (ENetChecksumType)currentPeer->checksum : ENET_CHECKSUM_NONE;
+				sealed = currentPeer->cipher != NULL && currentPeer->cipher->keyed && currentPeer->state != ENET_PEER_STATE_ACKNOWLEDGING_CONNECT;
+				checksumSize = sealed ? 0 : enet_protocol_checksum_size(host, checksumType);
+				host->packetSize += sealed ? ENET_PEER_CIPHER_OVERHEAD : checksumSize;
+
+				if (enet_protocol_acknowledgements_due(host, currentPeer))
+					enet_protocol_send_acknowledgements(host, currentPeer);
+
+				if (checkForTimeouts != 0 && !enet_list_empty(&currentPeer->sentReliableCommands) && ENET_TIME_GREATER_EQUAL(host->serviceTime, currentPeer->nextTimeout) && enet_protocol_check_timeouts(host, currentPeer, event) == 1) {
+					if (event != NULL && event->type != ENET_EVENT_TYPE_NONE)
+						return enet_protocol_send_datagrams(host) < 0 ? -1 : 1;
+					else
+						goto nextPeer;
+				}
+
+				paced = host->pacing != ENET_PACING_NONE && enet_protocol_pace(host, currentPeer, &releaseTime);
+
+				if (!paced && enet_protocol_probe_due(host, currentPeer)) {
+					enet_protocol_send_probe(host, currentPeer);
+
+					probing = 1;
+				} else if (!paced && ((enet_list_empty(&currentPeer->outgoingCommands) && enet_list_empty(&currentPeer->outgoingSendReliableCommands)) || enet_protocol_check_outgoing_commands(host, currentPeer, sentUnreliableCommands)) && enet_list_empty(&currentPeer->sentReliableCommands) && ENET_TIME_DIFFERENCE(host->serviceTime, currentPeer->lastReceiveTime) >= currentPeer->pingInterval && currentPeer->mtu - host->packetSize >= sizeof(ENetProtocolPing)) {
+					enet_peer_ping(currentPeer);
+					enet_protocol_check_outgoing_commands(host, currentPeer, sentUnreliableCommands);
+				}
+
+				if (host->commandCount == 0)
+					goto nextPeer;
+
+				/* Probes are padded to the size under test and must reach the wire as they are */
+				if (!probing && host->compressor.context != NULL && (currentPeer->capabilities & ENET_PROTOCOL_CAPABILITY_COMPRESSION))
+					enet_protocol_compress_datagram(host, currentPeer);
+
+				host->buffers->data = headerData;
+
+				if (host->headerFlags & ENET_PROTOCOL_HEADER_FLAG_SENT_TIME) {
+					header->sentTime = ENET_HOST_TO_NET_16(host->serviceTime & 0xFFFF);
+					host->buffers->dataLength = sizeof(ENetProtocolHeader);
+				} else {
+					host->buffers->dataLength = (size_t)&((ENetProtocolHeader*)0)->sentTime;
+				}
+
+				if (currentPeer->outgoingPeerID < ENET_PROTOCOL_MAXIMUM_PEER_ID)
+					host->headerFlags |= currentPeer->outgoingSessionID << ENET_PROTOCOL_HEADER_SESSION_SHIFT;
+
+				header->peerID = ENET_HOST_TO_NET_16(currentPeer->outgoingPeerID | host->headerFlags);
+
+				if (sealed) {
+					enet_protocol_seal_datagram(host, currentPeer, headerData);
+				} else if (checksumSize != 0) {
+					uint8_t* checksum = &headerData[host->buffers->dataLength];
+
+					enet_protocol_write_checksum(checksum, checksumSize, currentPeer->outgoingPeerID < ENET_PROTOCOL_MAXIMUM_PEER_ID ? currentPeer->connectID : 0);
+
+					host->buffers->dataLength += checksumSize;
+
+					enet_protocol_write_checksum(checksum, checksumSize, enet_protocol_checksum(host, checksumType, host->buffers, (int)host->bufferCount));
+				}
+
+				currentPeer->lastSendTime = host->serviceTime;
+
+				if (host->congestionControl->onSend != NULL)
+					host->congestionControl->onSend(currentPeer, (uint32_t)host->packetSize);
+
+				host->sendDelays[host->sendCount] = 0;
+
+				if (host->pacing != ENET_PACING_NONE) {
+					if (host->pacing == ENET_PACING_KERNEL && currentPeer->pacingCredit < 0)
+						host->sendDelays[host->sendCount] = (uint32_t)((int64_t)-currentPeer->pacingCredit * 1000000 / enet_protocol_pacing_rate(currentPeer));
+
+					currentPeer->pacingCredit -= (int32_t)host->packetSize;
+				}
+
+				/* The datagram is staged and goes out with the rest of the batch, its unreliable commands are released once it has been handed to the socket */
+				host->sendAddresses[host->sendCount] = currentPeer->address;
+				host->sendPeers[host->sendCount] = currentPeer;
+				host->sendBufferCounts[host->sendCount] = host->bufferCount;
+
+				host->sendProbing = probing;
+
+				if ((++host->sendCount >= ENET_HOST_SEND_BATCH || probing) && enet_protocol_send_datagrams(host) < 0)
+					return -1;
+
+				/* With segmentation offload the rest of the peer's datagrams are staged back to back, so the flush can coalesce them into a single send */
+				if (host->segmentation && currentPeer->continueSending)
+					goto nextDatagram;
+
+				nextPeer:
+
+				if (currentPeer->continueSending) {
+					continueSending = sendPass + 1;
+				} else if (paced && currentPeer->state != ENET_PEER_STATE_DISCONNECTED && currentPeer->state != ENET_PEER_STATE_ZOMBIE) {
+					enet_list_remove(&currentPeer->pendingList);
+
+					currentPeer->pendingList.next = NULL;
+
+					enet_peer_schedule(currentPeer, releaseTime);
+				} else if (currentPeer->state != ENET_PEER_STATE_DISCONNECTED && currentPeer->state != ENET_PEER_STATE_ZOMBIE && !enet_protocol_acknowledgements_due(host, currentPeer) && enet_list_empty(&currentPeer->outgoingCommands) && enet_list_empty(&currentPeer->outgoingSendReliableCommands)) {
+					uint32_t deadline;
+
+					enet_list_remove(&currentPeer->pendingList);
+
+					currentPeer->pendingList.next = NULL;
+
+					if (!enet_list_empty(&currentPeer->sentReliableCommands))
+						deadline = currentPeer->nextTimeout;
+					else
+						deadline = currentPeer->lastReceiveTime + currentPeer->pingInterval;
+
+					if (!enet_list_empty(&currentPeer->acknowledgements)) {
+						ENetAcknowledgement* acknowledgement = (ENetAcknowledgement*)enet_list_front(&currentPeer->acknowledgements);
+
+						if (ENET_TIME_LESS(acknowledgement->queueTime + enet_protocol_acknowledgement_hold(currentPeer), deadline))
+							deadline = acknowledgement->queueTime + enet_protocol_acknowledgement_hold(currentPeer);
+					}
+
+					if ((currentPeer->capabilities & ENET_PROTOCOL_CAPABILITY_PATH_MTU) && currentPeer->mtuProbeHigh != 0 && ENET_TIME_LESS(currentPeer->mtuProbeTime, deadline))
+						deadline = currentPeer->mtuProbeTime;
+
+					enet_peer_schedule(currentPeer, deadline);
+				}
+			}
+
+			if (enet_protocol_send_datagrams(host) < 0)
+				return -1;
+		}
+
+		return 0;
+	}
+
+	static void enet_protocol_deliver_posted_packets(ENetHost* host) {
+		ENetHostMessage* messages = (ENetHostMessage*)ENET_ATOMIC_READ(&host->postedMessages);
+		ENetHostMessage* ordered = NULL;
+
+		if (messages == NULL)
+			return;
+
+		while (ENET_ATOMIC_CAS(&host->postedMessages, messages, NULL) != messages) {
+			messages = (ENetHostMessage*)ENET_ATOMIC_READ(&host->postedMessages);
+		}
+
+		/* Posting pushes onto a stack, reverse it so packets go out in the order they were posted */
+		while (messages != NULL) {
+			ENetHostMessage* next = messages->next;
+
+			messages->next = ordered;
+			ordered = messages;
+			messages = next;
+		}
+
+		while (ordered != NULL) {
+			ENetHostMessage* message = ordered;
+			ENetPacket* packet = message->packet;
+
+			ordered = message->next;
+
+			if (message->peer == NULL) {
+				enet_host_broadcast(host, message->channelID, packet);
+			} else if (message->peer < host->peers || message->peer >= &host->peers[host->peerCount] || enet_peer_send(message->peer, message->channelID, packet) < 0) {
+				if (packet->referenceCount == 0)
+					enet_packet_destroy(packet);
+			}
+
+			enet_free(message);
+		}
+	}
+
+	void enet_host_flush(ENetHost* host) {
+		enet_protocol_deliver_posted_packets(host);
+
+		host->serviceTime = enet_time_get();
+		host->serviceDeadline = host->serviceTime;
+
+		enet_protocol_send_outgoing_commands(host, NULL, 0);
+	}
+
+	int enet_host_check_events(ENetHost* host, ENetEvent* event) {
+		if (event == NULL)
+			return -1;
+
+		event->type = ENET_EVENT_TYPE_NONE;
+		event->peer = NULL;
+		event->packet = NULL;
+
+		return enet_protocol_dispatch_incoming_commands(host, event);
+	}
+
+	int enet_host_service(ENetHost* host, ENetEvent* event, uint32_t timeout) {
+		uint32_t waitCondition;
+
+		if (host->packetPoolPrewarm > 0) {
+			enet_packet_pool_prewarm(host->packetPoolPrewarm);
+
+			host->packetPoolPrewarm = 0;
+		}
+
+		enet_protocol_deliver_posted_packets(host);
+
+		if (event != NULL) {
+			event->type = ENET_EVENT_TYPE_NONE;
+			event->peer = NULL;
+			event->packet = NULL;
+
+			switch (enet_protocol_dispatch_incoming_commands(host, event)) {
+				case 1:
+					return 1;
+
+				case -1:
+					#ifdef ENET_DEBUG
+						perror("Error dispatching incoming packets");
+					#endif
+
+					return -1;
+
+				default:
+					break;
+			}
+		}
+
+		host->serviceTime = enet_time_get();
+		timeout += host->serviceTime;
+		host->serviceDeadline = timeout;
+
+		do {
+			if (ENET_TIME_DIFFERENCE(host->serviceTime, host->bandwidthThrottleEpoch) >= ENET_HOST_BANDWIDTH_THROTTLE_INTERVAL)
+				enet_host_bandwidth_throttle(host);
+
+			switch (enet_protocol_send_outgoing_commands(host, event, 1)) {
+				case 1:
+					return 1;
+
+				case -1:
+					#ifdef ENET_DEBUG
+						perror("Error sending outgoing packets");
+					#endif
+
+					return -1;
+
+				default:
+					break;
+			}
+
+			switch (enet_protocol_receive_incoming_commands(host, event)) {
+				case 1:
+					return 1;
+
+				case -1:
+					#ifdef ENET_DEBUG
+						perror("Error receiving incoming packets");
+					#endif
+
+					return -1;
+
+				default:
+					break;
+			}
+
+			switch (enet_protocol_send_outgoing_commands(host, event, 1)) {
+				case 1:
+					return 1;
+
+				case -1:
+					#ifdef ENET_DEBUG
+						perror("Error sending outgoing packets");
+					#endif
+
+					return -1;
+
+				default:
+					break;
+			}
+
+			if (event != NULL) {
+				switch (enet_protocol_dispatch_incoming_commands(host, event)) {
+					case 1:
+						return 1;
+
+					case -1:
+						#ifdef ENET_DEBUG
+							perror("Error dispatching incoming packets");
+						#endif
+
+						return -1;
+
+					default:
+						break;
+				}
+			}
+
+			if (ENET_TIME_GREATER_EQUAL(host->serviceTime, timeout))
+				return 0;
+
+			do {
+				uint32_t wakeTime = timeout, nextTimer;
+
+				host->serviceTime = enet_time_get();
+
+				if (ENET_TIME_GREATER_EQUAL(host->serviceTime, timeout))
+					return 0;
+
+				/* Sleep only until the earliest retransmission or ping is due rather than for the whole timeout */
+				if (enet_protocol_next_timer(host, &nextTimer) && ENET_TIME_LESS(nextTimer, wakeTime))
+					wakeTime = ENET_TIME_LESS(nextTimer, host->serviceTime) ? host->serviceTime : nextTimer;
+
+				waitCondition = ENET_SOCKET_WAIT_RECEIVE | ENET_SOCKET_WAIT_INTERRUPT;
+
+				#ifdef ENET_HAS_URING
+					if (host->uring != NULL) {
+						if (enet_uring_wait(host->uring, &waitCondition, ENET_TIME_DIFFERENCE(wakeTime, host->serviceTime)) != 0)
+							return -1;
+					} else
+				#endif
+
+				if (enet_socket_wait(host->socket, &waitCondition, ENET_TIME_DIFFERENCE(wakeTime, host->serviceTime)) != 0)
+					return -1;
+			}
+
+			while (waitCondition & ENET_SOCKET_WAIT_INTERRUPT);
+
+			host->serviceTime = enet_time_get();
+		}
+
+		while ((waitCondition & ENET_SOCKET_WAIT_RECEIVE) || ENET_TIME_LESS(host->serviceTime, timeout));
+
+		return 0;
+	}
+
+/*
+=======================================================================
+
+	Peer
+
+=======================================================================
+*/
+
+	void enet_peer_throttle_configure(ENetPeer* peer, uint32_t interval, uint32_t acceleration, uint32_t deceleration, uint32_t threshold) {
+		ENetProtocol command;
+		peer->packetThrottleThreshold = threshold;
+		peer->packetThrottleInterval = interval;
+		peer->packetThrottleAcceleration = acceleration;
+		peer->packetThrottleDeceleration = deceleration;
+		command.header.command = ENET_PROTOCOL_COMMAND_THROTTLE_CONFIGURE | ENET_PROTOCOL_COMMAND_FLAG_ACKNOWLEDGE;
+		command.header.channelID = 0xFF;
+		command.throttleConfigure.packetThrottleInterval = ENET_HOST_TO_NET_32(interval);
+		command.throttleConfigure.packetThrottleAcceleration = ENET_HOST_TO_NET_32(acceleration);
+		command.throttleConfigure.packetThrottleDeceleration = ENET_HOST_TO_NET_32(deceleration);
+
+		enet_peer_queue_outgoing_command(peer, &command, NULL, 0, 0);
+	}
+
+	int enet_peer_throttle(ENetPeer* peer, uint32_t rtt) {
+		if (peer->lastRoundTripTime <= peer->lastRoundTripTimeVariance) {
+			peer->packetThrottle = peer->packetThrottleLimit;
+		} else if (rtt < peer->lastRoundTripTime + (peer->lastRoundTripTimeVariance + 1) / 2) {
+			peer->packetThrottle += peer->packetThrottleAcceleration;
+
+			if (peer->packetThrottle > peer->packetThrottleLimit)
+				peer->packetThrottle = peer->packetThrottleLimit;
+
+			return 1;
+		} else if (rtt > peer->lastRoundTripTime + peer->packetThrottleThreshold + 2 * peer->lastRoundTripTimeVariance) {
+			if (peer->packetThrottle > peer->packetThrottleDeceleration)
+				peer->packetThrottle -= peer->packetThrottleDeceleration;
+			else
+				peer->packetThrottle = 0;
+
+			return -1;
+		}
+
+		return 0;
+	}
+
+	/* Controllers only size the reliable window, each of them still feeds the packet throttle that drops unreliable traffic */
+	static uint32_t enet_congestion_initial_window(ENetPeer* peer) {
+		ENetCongestionState* state = &peer->congestion;
+
+		if (state->window == 0) {
+			state->window = ENET_PEER_CONGESTION_INITIAL_WINDOW * peer->mtu;
+			state->threshold = ~0u;
+		}
+
+		return state->window;
+	}
+
+	static void enet_congestion_clamp_window(ENetPeer* peer) {
+		ENetCongestionState* state = &peer->congestion;
+
+		if (state->window < ENET_PEER_CONGESTION_MINIMUM_WINDOW * peer->mtu)
+			state->window = ENET_PEER_CONGESTION_MINIMUM_WINDOW * peer->mtu;
+		else if (state->window > peer->windowSize)
+			state->window = peer->windowSize;
+	}
+
+	static void enet_congestion_update_minimum_round_trip_time(ENetPeer* peer, uint32_t roundTripTime) {
+		ENetCongestionState* state = &peer->congestion;
+		uint32_t serviceTime = peer->host->serviceTime;
+
+		if (state->minimumRoundTripTime == 0 || roundTripTime <= state->minimumRoundTripTime || ENET_TIME_DIFFERENCE(serviceTime, state->minimumRoundTripTimeEpoch) >= ENET_PEER_CONGESTION_RTT_WINDOW) {
+			state->minimumRoundTripTime = roundTripTime;
+			state->minimumRoundTripTimeEpoch = serviceTime;
+		}
+	}
+
+	static void ENET_CALLBACK enet_congestion_legacy_acknowledge(ENetPeer* peer, uint32_t roundTripTime, uint32_t acknowledgedBytes) {
+		(void)acknowledgedBytes;
+
+		enet_peer_throttle(peer, roundTripTime);
+	}
+
+	static uint32_t ENET_CALLBACK enet_congestion_legacy_window(ENetPeer* peer) {
+		return (peer->packetThrottle * peer->windowSize) / ENET_PEER_PACKET_THROTTLE_SCALE;
+	}
+
+	/* Delay-based controller, grows the window while the queueing delay above the lowest round-trip time stays under the target */
+	static void ENET_CALLBACK enet_congestion_delay_acknowledge(ENetPeer* peer, uint32_t roundTripTime, uint32_t acknowledgedBytes) {
+		ENetCongestionState* state = &peer->congestion;
+		uint32_t window, queueingDelay;
+		int64_t change;
+
+		enet_peer_throttle(peer, roundTripTime);
+
+		window = enet_congestion_initial_window(peer);
+
+		enet_congestion_update_minimum_round_trip_time(peer, roundTripTime);
+
+		if (acknowledgedBytes == 0)
+			return;
+
+		queueingDelay = roundTripTime - state->minimumRoundTripTime;
+
+		if (window < state->threshold) {
+			if (queueingDelay < ENET_PEER_CONGESTION_DELAY_TARGET / 2) {
+				state->window += acknowledgedBytes;
+				enet_congestion_clamp_window(peer);
+
+				return;
+			}
+
+			state->threshold = window;
+		}
+
+		change = ((int64_t)ENET_PEER_CONGESTION_DELAY_TARGET - (int64_t)queueingDelay) * acknowledgedBytes * peer->mtu / ((int64_t)ENET_PEER_CONGESTION_DELAY_TARGET * window);
+
+		if (change < -(int64_t)(window / 2))
+			change = -(int64_t)(window / 2);
+
+		state->window = (uint32_t)((int64_t)window + change);
+
+		enet_congestion_clamp_window(peer);
+	}
+
+	static void ENET_CALLBACK enet_congestion_delay_loss(ENetPeer* peer, uint32_t lostBytes) {
+		ENetCongestionState* state = &peer->congestion;
+		uint32_t serviceTime = peer->host->serviceTime;
+		uint32_t window = enet_congestion_initial_window(peer);
+
+		(void)lostBytes;
+
+		/* Losses while the round trip stays within the delay target come from the link rather than a queue filling up */
+		if (state->minimumRoundTripTime != 0 && peer->roundTripTime < state->minimumRoundTripTime + ENET_PEER_CONGESTION_DELAY_TARGET)
+			return;
+
+		/* A burst of losses within one round trip counts as a single congestion event */
+		if (state->lossEpoch != 0 && ENET_TIME_DIFFERENCE(serviceTime, state->lossEpoch) < peer->roundTripTime)
+			return;
+
+		state->window = window - window / 4;
+		state->threshold = state->window;
+		state->lossEpoch = ENET_MAX(serviceTime, 1);
+
+		enet_congestion_clamp_window(peer);
+	}
+
+	static uint32_t ENET_CALLBACK enet_congestion_delay_window(ENetPeer* peer) {
+		return enet_congestion_initial_window(peer);
+	}
+
+	/* Model-based controller, sizes the window to twice the product of the peak delivery rate and the lowest round-trip time */
+	static void ENET_CALLBACK enet_congestion_bbr_acknowledge(ENetPeer* peer, uint32_t roundTripTime, uint32_t acknowledgedBytes) {
+		static const uint32_t gains[ENET_PEER_CONGESTION_PROBE_PHASES + 1] = { 289, 125, 75, 100, 100, 100, 100, 100, 100 };
+		ENetCongestionState* state = &peer->congestion;
+		uint32_t serviceTime = peer->host->serviceTime;
+		uint32_t elapsed, sample, window;
+
+		enet_peer_throttle(peer, roundTripTime);
+		enet_congestion_initial_window(peer);
+		enet_congestion_update_minimum_round_trip_time(peer, roundTripTime);
+
+		if (state->deliveredTime == 0)
+			state->deliveredTime = ENET_MAX(serviceTime, 1);
+
+		state->delivered += acknowledgedBytes;
+		elapsed = ENET_TIME_DIFFERENCE(serviceTime, state->deliveredTime);
+
+		if (elapsed < state->minimumRoundTripTime || elapsed == 0)
+			return;
+
+		sample = (uint32_t)ENET_MIN((uint64_t)state->delivered * 1000 / elapsed, 0xFFFFFFFF);
+		state->delivered = 0;
+		state->deliveredTime = ENET_MAX(serviceTime, 1);
+
+		if (sample >= state->bandwidth || state->round - state->bandwidthRound >= ENET_PEER_CONGESTION_BANDWIDTH_ROUNDS) {
+			state->bandwidth = sample;
+			state->bandwidthRound = state->round;
+		}
+
+		++state->round;
+
+		if (state->phase == 0) {
+			if (state->bandwidth >= state->fullBandwidth + state->fullBandwidth / 4) {
+				state->fullBandwidth = state->bandwidth;
+				state->fullBandwidthCount = 0;
+			} else if (++state->fullBandwidthCount >= ENET_PEER_CONGESTION_STARTUP_ROUNDS) {
+				state->phase = 1;
+			}
+		} else {
+			state->phase = state->phase % ENET_PEER_CONGESTION_PROBE_PHASES + 1;
+		}
+
+		state->pacingRate = (uint32_t)ENET_MIN((uint64_t)state->bandwidth * gains[state->phase] / 100, 0xFFFFFFFF);
+		window = (uint32_t)ENET_MIN((uint64_t)state->bandwidth * state->minimumRoundTripTime * 2 / 1000, 0xFFFFFFFF);
+
+		if (state->phase == 0)
+			state->window = ENET_MAX(state->window * 2, window);
+		else
+			state->window = window;
+
+		enet_congestion_clamp_window(peer);
+	}
+
+	static uint32_t ENET_CALLBACK enet_congestion_bbr_window(ENetPeer* peer) {
+		return enet_congestion_initial_window(peer);
+	}
+
+	static uint32_t ENET_CALLBACK enet_congestion_bbr_pacing_rate(ENetPeer* peer) {
+		return peer->congestion.pacingRate;
+	}
+
+	static const ENetCongestionControl enet_congestion_controls[] = {
+		{ NULL, enet_congestion_legacy_acknowledge, NULL, NULL, enet_congestion_legacy_window, NULL },
+		{ NULL, enet_congestion_delay_acknowledge, enet_congestion_delay_loss, NULL, enet_congestion_delay_window, NULL },
+		{ NULL, enet_congestion_bbr_acknowledge, NULL, NULL, enet_congestion_bbr_window, enet_congestion_bbr_pacing_rate }
+	};
+
+	const ENetCongestionControl* enet_congestion_control_get(ENetCongestionControlType type) {
+		if ((size_t)type >= sizeof(enet_congestion_controls) / sizeof(enet_congestion_controls[0]))
+			return NULL;
+
+		return &enet_congestion_controls[type];
+	}
+
+	static void enet_peer_reset_congestion(ENetPeer* peer) {
+		memset(&peer->congestion, 0, sizeof(ENetCongestionState));
+
+		if (peer->host->congestionControl->initialize != NULL)
+			peer->host->congestionControl->initialize(peer);
+	}
+
+	static int enet_peer_hold_aggregated_packet(ENetHost* host, ENetPacket* packet) {
+		if (host->aggregatedPacketCount == host->aggregatedPacketCapacity) {
+			size_t capacity = host->aggregatedPacketCapacity > 0 ? host->aggregatedPacketCapacity * 2 : 64;
+			ENetPacket** packets = (ENetPacket**)enet_malloc(capacity * sizeof(ENetPacket*));
+
+			if (packets == NULL)
+				return -1;
+
+			if (host->aggregatedPackets != NULL) {
+				memcpy(packets, host->aggregatedPackets, host->aggregatedPacketCount * sizeof(ENetPacket*));
+				enet_free(host->aggregatedPackets);
+			}
+
+			host->aggregatedPackets = packets;
+			host->aggregatedPacketCapacity = capacity;
+		}
+
+		++packet->referenceCount;
+
+		host->aggregatedPackets[host->aggregatedPacketCount++] = packet;
+
+		return 0;
+	}
+
+	static int enet_peer_aggregate(ENetPeer* peer, ENetProtocol* command, ENetPacket* packet, size_t capacity) {
+		ENetList* queue = (command->header.command & ENET_PROTOCOL_COMMAND_FLAG_ACKNOWLEDGE) ? &peer->outgoingSendReliableCommands : &peer->outgoingCommands;
+		ENetOutgoingCommand* outgoingCommand = NULL;
+		ENetListIterator currentCommand;
+		ENetPacket* aggregate;
+		size_t headerLength, length;
+		uint8_t header[2];
+
+		/* The message is copied, the packet is held until the next flush like one queued on its own */
+		if (enet_peer_hold_aggregated_packet(peer->host, packet) < 0)
+			return -1;
+
+		headerLength = enet_packet_write_aggregate(header, packet->dataLength);
+		length = headerLength + packet->dataLength;
+
+		/* Only the newest command of the channel can take more messages, anything earlier would reorder them */
+		for (currentCommand = enet_list_previous(enet_list_end(queue)); currentCommand != enet_list_end(queue); currentCommand = enet_list_previous(currentCommand)) {
+			if (((ENetOutgoingCommand*)currentCommand)->command.header.channelID == command->header.channelID) {
+				outgoingCommand = (ENetOutgoingCommand*)currentCommand;
+
+				break;
+			}
+		}
+
+		if (outgoingCommand != NULL && outgoingCommand->command.header.command == command->header.command && outgoingCommand->sendAttempts == 0 && outgoingCommand->pieceOffset == 0 && (outgoingCommand->packet->flags & ENET_PACKET_FLAG_UNTHROTTLED) == (packet->flags & ENET_PACKET_FLAG_UNTHROTTLED) && outgoingCommand->fragmentLength + length <= capacity) {
+			aggregate = outgoingCommand->packet;
+
+			memcpy(&aggregate->data[aggregate->dataLength], header, headerLength);
+			memcpy(&aggregate->data[aggregate->dataLength + headerLength], packet->data, packet->dataLength);
+
+			aggregate->dataLength += length;
+			outgoingCommand->fragmentLength += length;
+			peer->outgoingDataTotal += length;
+
+			switch (command->header.command & ENET_PROTOCOL_COMMAND_MASK) {
+				case ENET_PROTOCOL_COMMAND_SEND_RELIABLE:
+					outgoingCommand->command.sendReliable.dataLength = ENET_HOST_TO_NET_16(aggregate->dataLength);
+
+					break;
+
+				case ENET_PROTOCOL_COMMAND_SEND_UNSEQUENCED:
+					outgoingCommand->command.sendUnsequenced.dataLength = ENET_HOST_TO_NET_16(aggregate->dataLength);
+
+					break;
+
+				default:
+					outgoingCommand->command.sendUnreliable.dataLength = ENET_HOST_TO_NET_16(aggregate->dataLength);
+
+					break;
+			}
+
+			return 0;
+		}
+
+		aggregate = enet_packet_create(NULL, capacity, packet->flags & (ENET_PACKET_FLAG_RELIABLE | ENET_PACKET_FLAG_UNSEQUENCED | ENET_PACKET_FLAG_UNTHROTTLED));
+
+		if (aggregate == NULL)
+			return -1;
+
+		memcpy(aggregate->data, header, headerLength);
+		memcpy(&aggregate->data[headerLength], packet->data, packet->dataLength);
+
+		aggregate->dataLength = length;
+
+		switch (command->header.command & ENET_PROTOCOL_COMMAND_MASK) {
+			case ENET_PROTOCOL_COMMAND_SEND_RELIABLE:
+				command->sendReliable.dataLength = ENET_HOST_TO_NET_16(length);
+
+				break;
+
+			case ENET_PROTOCOL_COMMAND_SEND_UNSEQUENCED:
+				command->sendUnsequenced.dataLength = ENET_HOST_TO_NET_16(length);
+
+				break;
+
+			default:
+				command->sendUnreliable.dataLength = ENET_HOST_TO_NET_16(length);
+
+				break;
+		}
+
+		if (enet_peer_queue_outgoing_command(peer, command, aggregate, 0, length) == NULL) {
+			enet_packet_destroy(aggregate);
+
+			--packet->referenceCount;
+			--peer->host->aggregatedPacketCount;
+
+			return -1;
+		}
+
+		return 0;
+	}
+
+	int enet_peer_send(ENetPeer* peer, uint8_t channelID, ENetPacket* packet) {
+		ENetChannel* channel;
+		ENetProtocol command;
+		size_t fragmentLength;
+
+		if (peer->state != ENET_PEER_STATE_CONNECTED || channelID >= peer->channelCount || packet->dataLength > peer->host->maximumPacketSize)
+			return -1;
+
+ 		channel = &peer->channels[channelID];
+		fragmentLength = peer->mtu - sizeof(ENetProtocolHeader) - sizeof(ENetProtocolSendFragment) - sizeof(ENetProtocolAcknowledge);
+
+		fragmentLength -= peer->cipher != NULL ? ENET_PEER_CIPHER_OVERHEAD : enet_protocol_checksum_size(peer->host, (ENetChecksumType)peer->checksum);
+
+		if (packet->dataLength > fragmentLength) {
+			uint32_t fragmentCount = (packet->dataLength + fragmentLength - 1) / fragmentLength, fragmentNumber, fragmentOffset;
+			uint8_t commandNumber;
+			uint16_t startSequenceNumber;
+			ENetList fragments;
+			ENetOutgoingCommand* fragment;
+
+			if (fragmentCount > ENET_PROTOCOL_MAXIMUM_FRAGMENT_COUNT)
+				return -1;
+
+			if ((packet->flags & (ENET_PACKET_FLAG_RELIABLE | ENET_PACKET_FLAG_UNRELIABLE_FRAGMENTED)) == ENET_PACKET_FLAG_UNRELIABLE_FRAGMENTED && channel->outgoingUnreliableSequenceNumber < 0xFFFF) {
+				commandNumber = ENET_PROTOCOL_COMMAND_SEND_UNRELIABLE_FRAGMENT;
+				startSequenceNumber = ENET_HOST_TO_NET_16(channel->outgoingUnreliableSequenceNumber + 1);
+			} else {
+				commandNumber = ENET_PROTOCOL_COMMAND_SEND_FRAGMENT | ENET_PROTOCOL_COMMAND_FLAG_ACKNOWLEDGE;
+				startSequenceNumber = ENET_HOST_TO_NET_16(channel->outgoingReliableSequenceNumber + 1);
+			}
+
+			enet_list_clear(&fragments);
+
+			for (fragmentNumber = 0, fragmentOffset = 0; fragmentOffset < packet->dataLength; ++fragmentNumber, fragmentOffset += fragmentLength) {
+				if (packet->dataLength - fragmentOffset < fragmentLength)
+					fragmentLength = packet->dataLength - fragmentOffset;
+
+				fragment = (ENetOutgoingCommand*)enet_pool_allocate(&peer->host->outgoingCommandPool);
+
+				if (fragment == NULL) {
+					while (!enet_list_empty(&fragments)) {
+						fragment = (ENetOutgoingCommand*)enet_list_remove(enet_list_begin(&fragments));
+
+						enet_pool_free(&peer->host->outgoingCommandPool, fragment);
+					}
+
+					return -1;
+				}
+
+				fragment->fragmentOffset = fragmentOffset;
+				fragment->fragmentLength = fragmentLength;
+				fragment->packet = packet;
+				fragment->command.header.command = commandNumber;
+				fragment->command.header.channelID = channelID;
+				fragment->command.sendFragment.startSequenceNumber = startSequenceNumber;
+				fragment->command.sendFragment.dataLength = ENET_HOST_TO_NET_16(fragmentLength);
+				fragment->command.sendFragment.fragmentCount = ENET_HOST_TO_NET_32(fragmentCount);
+				fragment->command.sendFragment.fragmentNumber = ENET_HOST_TO_NET_32(fragmentNumber);
+				fragment->command.sendFragment.totalLength = ENET_HOST_TO_NET_32(packet->dataLength);
+				fragment->command.sendFragment.fragmentOffset = ENET_NET_TO_HOST_32(fragmentOffset);
+
+				enet_list_insert(enet_list_end(&fragments), fragment);
+			}
+
+			packet->referenceCount += fragmentNumber;
+
+			while (!enet_list_empty(&fragments)) {
+				fragment = (ENetOutgoingCommand*)enet_list_remove(enet_list_begin(&fragments));
+
+				enet_peer_setup_outgoing_command(peer, fragment);
+			}
+
+			return 0;
+		}
+
+		command.header.channelID = channelID;
+
+		if ((packet->flags & (ENET_PACKET_FLAG_RELIABLE | ENET_PACKET_FLAG_UNSEQUENCED)) == ENET_PACKET_FLAG_UNSEQUENCED) {
+			command.header.command = ENET_PROTOCOL_COMMAND_SEND_UNSEQUENCED | ENET_PROTOCOL_COMMAND_FLAG_UNSEQUENCED;
+			command.sendUnsequenced.dataLength = ENET_HOST_TO_NET_16(packet->dataLength);
+		} else if (packet->flags & ENET_PACKET_FLAG_RELIABLE || channel->outgoingUnreliableSequenceNumber >= 0xFFFF) {
+			command.header.command = ENET_PROTOCOL_COMMAND_SEND_RELIABLE | ENET_PROTOCOL_COMMAND_FLAG_ACKNOWLEDGE;
+			command.sendReliable.dataLength = ENET_HOST_TO_NET_16(packet->dataLength);
+		} else {
+			command.header.command = ENET_PROTOCOL_COMMAND_SEND_UNRELIABLE;
+			command.sendUnreliable.dataLength = ENET_HOST_TO_NET_16(packet->dataLength);
+		}
+
+		if (channel->aggregation && (peer->capabilities & ENET_PROTOCOL_CAPABILITY_AGGREGATION) && packet->dataLength + 2 <= fragmentLength) {
+			command.header.command |= ENET_PROTOCOL_COMMAND_FLAG_AGGREGATED;
+
+			if (enet_peer_aggregate(peer, &command, packet, fragmentLength) < 0)
+				return -1;
+		} else if (enet_peer_queue_outgoing_command(peer, &command, packet, 0, packet->dataLength) == NULL) {
+			return -1;
+		}
+
+		if (packet->flags & ENET_PACKET_FLAG_INSTANT)
+			enet_host_flush(peer->host);
+
+		return 0;
+	}
+
+	ENetPacket* enet_peer_receive(ENetPeer* peer, uint8_t* channelID) {
+		ENetIncomingCommand* incomingCommand;
+		ENetPacket* packet;
+
+		if (enet_list_empty(&peer->dispatchedCommands))
+			return NULL;
+
+		incomingCommand = (ENetIncomingCommand*)enet_list_front(&peer->dispatchedCommands);
+
+		if (channelID != NULL)
+			*channelID = incomingCommand->command.header.channelID;
+
+		if (incomingCommand->command.header.command & ENET_PROTOCOL_COMMAND_FLAG_AGGREGATED) {
+			ENetPacket* aggregate = incomingCommand->packet;
+			size_t headerLength, messageLength;
+			headerLength = enet_packet_read_aggregate(&aggregate->data[incomingCommand->aggregateOffset], aggregate->dataLength - incomingCommand->aggregateOffset, &messageLength);
+			packet = enet_packet_create(&aggregate->data[incomingCommand->aggregateOffset + headerLength], messageLength, aggregate->flags);
+
+			if (packet == NULL)
+				return NULL;
+
+			incomingCommand->aggregateOffset += headerLength + messageLength;
+
+			if (incomingCommand->aggregateOffset < aggregate->dataLength)
+				return packet;
+
+			enet_list_remove(&incomingCommand->incomingCommandList);
+			enet_pool_free(&peer->host->incomingCommandPool, incomingCommand);
+
+			peer->totalWaitingData -= aggregate->dataLength;
+
+			if (--aggregate->referenceCount == 0)
+				enet_packet_destroy(aggregate);
+
+			return packet;
+		}
+
+		enet_list_remove(&incomingCommand->incomingCommandList);
+
+		packet = incomingCommand->packet;
+		--packet->referenceCount;
+
+		if (incomingCommand->fragments != NULL)
+			enet_free(incomingCommand->fragments);
+
+		enet_pool_free(&peer->host->incomingCommandPool, incomingCommand);
+
+		peer->totalWaitingData -= packet->dataLength;
+
+		return packet;
+	}
+
+	static void enet_peer_reset_outgoing_commands(ENetPeer* peer, ENetList* queue) {
+		ENetOutgoingCommand* outgoingCommand;
+
+		while (!enet_list_empty(queue)) {
+			outgoingCommand = (ENetOutgoingCommand*)enet_list_remove(enet_list_begin(queue));
+
+			if (outgoingCommand->packet != NULL) {
+				--outgoingCommand->packet->referenceCount;
+
+				if (outgoingCommand->packet->referenceCount == 0)
+					enet_packet_destroy(outgoingCommand->packet);
+			}
+
+			enet_pool_free(&peer->host->outgoingCommandPool, outgoingCommand);
+		}
+	}
+
+	static void enet_peer_remove_incoming_commands(ENetPeer* peer, ENetList* queue, ENetListIterator startCommand, ENetListIterator endCommand, ENetIncomingCommand* excludeCommand) {
+		ENetListIterator currentCommand;
+
+		for (currentCommand = startCommand; currentCommand != endCommand;) {
+			ENetIncomingCommand* incomingCommand = (ENetIncomingCommand*)currentCommand;
+			currentCommand = enet_list_next(currentCommand);
+
+			if (incomingCommand == excludeCommand)
+				continue;
+
+			enet_list_remove(&incomingCommand->incomingCommandList);
+
+			if (incomingCommand->packet != NULL) {
+				--incomingCommand->packet->referenceCount;
+
+				if (incomingCommand->packet->referenceCount == 0)
+					enet_packet_destroy(incomingCommand->packet);
+			}
+
+			if (incomingCommand->fragments != NULL)
+				enet_free(incomingCommand->fragments);
+
+			enet_pool_free(&peer->host->incomingCommandPool, incomingCommand);
+		}
+	}
+
+	static void enet_peer_reset_incoming_commands(ENetPeer* peer, ENetList* queue) {
+		enet_peer_remove_incoming_commands(peer, queue, enet_list_begin(queue), enet_list_end(queue), NULL);
+	}
+
+	void enet_peer_reset_queues(ENetPeer* peer) {
+		ENetChannel* channel;
 
 		if (peer->needsDispatch) {
 			enet_list_remove(&peer->dispatchList);
 
-			peer->needsDispatch = 0;
+			peer->needsDispatch = 0;
+		}
+
+		while (!enet_list_empty(&peer->acknowledgements)) {
+			enet_pool_free(&peer->host->acknowledgementPool, enet_list_remove(enet_list_begin(&peer->acknowledgements)));
+		}
+
+		peer->acknowledgementCount = 0;
+
+		enet_peer_reset_outgoing_commands(peer, &peer->sentReliableCommands);
+		enet_peer_reset_outgoing_commands(peer, &peer->outgoingCommands);
+		enet_peer_reset_outgoing_commands(peer, &peer->outgoingSendReliableCommands);
+		enet_peer_reset_incoming_commands(peer, &peer->dispatchedCommands);
+
+		if (peer->sentControlCommands != NULL) {
+			enet_free(peer->sentControlCommands);
+
+			peer->sentControlCommands = NULL;
+			peer->sentControlCapacity = 0;
+		}
+
+		if (peer->pieceData != NULL) {
+			enet_free(peer->pieceData);
+
+			peer->pieceData = NULL;
+			peer->pieceMask = 0;
+		}
+
+		if (peer->channels != NULL && peer->channelCount > 0) {
+			for (channel = peer->channels; channel < &peer->channels[peer->channelCount]; ++channel) {
+				if (channel->incomingReliableCommands != NULL) {
+					ENetList incomingReliableCommands;
+					uint32_t i;
+
+					enet_list_clear(&incomingReliableCommands);
+
+					for (i = 0; i < channel->incomingReliableCapacity; ++i) {
+						if (channel->incomingReliableCommands[i] != NULL)
+							enet_list_insert(enet_list_end(&incomingReliableCommands), channel->incomingReliableCommands[i]);
+					}
+
+					enet_peer_reset_incoming_commands(peer, &incomingReliableCommands);
+					enet_free(channel->incomingReliableCommands);
+				}
+
+				if (channel->sentReliableCommands != NULL)
+					enet_free(channel->sentReliableCommands);
+
+				enet_peer_reset_incoming_commands(peer, &channel->incomingUnreliableCommands);
+			}
+
+			enet_free(peer->channels);
+		}
+
+		peer->channels = NULL;
+		peer->channelCount = 0;
+	}
+
+	int enet_peer_has_outgoing_commands(ENetPeer* peer) {
+		if (enet_list_empty(&peer->outgoingCommands) && enet_list_empty(&peer->outgoingSendReliableCommands) && enet_list_empty(&peer->sentReliableCommands))
+			return 0;
+
+		return 1;
+	}
+
+	void enet_peer_on_connect(ENetPeer* peer) {
+		if (peer->state != ENET_PEER_STATE_CONNECTED && peer->state != ENET_PEER_STATE_DISCONNECT_LATER) {
+			if (peer->incomingBandwidth != 0)
+				++peer->host->bandwidthLimitedPeers;
+
+			++peer->host->connectedPeers;
+		}
+	}
+
+	void enet_peer_on_disconnect(ENetPeer* peer) {
+		if (peer->state == ENET_PEER_STATE_CONNECTED || peer->state == ENET_PEER_STATE_DISCONNECT_LATER) {
+			if (peer->incomingBandwidth != 0)
+				--peer->host->bandwidthLimitedPeers;
+
+			--peer->host->connectedPeers;
+		}
+	}
+
+	void enet_peer_activate(ENetPeer* peer) {
+		ENetHost* host = peer->host;
+
+		host->freePeerHead = (host->freePeerHead + 1) % host->peerCount;
+		--host->freePeerCount;
+
+		peer->activeIndex = host->activePeerCount;
+		host->activePeers[host->activePeerCount++] = peer;
+	}
+
+	void enet_peer_deactivate(ENetPeer* peer) {
+		ENetHost* host = peer->host;
+		ENetPeer* lastPeer = host->activePeers[--host->activePeerCount];
+
+		lastPeer->activeIndex = peer->activeIndex;
+		host->activePeers[peer->activeIndex] = lastPeer;
+		host->freePeers[(host->freePeerHead + host->freePeerCount++) % host->peerCount] = peer;
+	}
+
+	void enet_peer_mark_pending(ENetPeer* peer) {
+		if (peer->state == ENET_PEER_STATE_DISCONNECTED || peer->pendingList.next != NULL)
+			return;
+
+		enet_list_insert(enet_list_end(&peer->host->pendingPeers), &peer->pendingList);
+	}
+
+	void enet_peer_schedule(ENetPeer* peer, uint32_t deadline) {
+		ENetHost* host = peer->host;
+		uint32_t level = 0;
+
+		if (peer->timerList.next != NULL) {
+			enet_list_remove(&peer->timerList);
+
+			--host->timerCount;
+		}
+
+		/* Work that is already due goes into the next tick, the current slot has been processed */
+		if (ENET_TIME_LESS_EQUAL(deadline, host->timerTime))
+			deadline = host->timerTime + 1;
+
+		/* A deadline sits on the level of the highest bits that differ from the wheel time, so every slot is reached before anything in it expires */
+		while (level < ENET_HOST_TIMER_LEVELS - 1 && (deadline ^ host->timerTime) >> ((level + 1) * ENET_HOST_TIMER_SLOT_BITS) != 0) {
+			++level;
+		}
+
+		peer->timerDeadline = deadline;
+
+		enet_list_insert(enet_list_end(&host->timerWheel[level][(deadline >> (level * ENET_HOST_TIMER_SLOT_BITS)) & (ENET_HOST_TIMER_SLOTS - 1)]), &peer->timerList);
+
+		++host->timerCount;
+	}
+
+	void enet_peer_unschedule(ENetPeer* peer) {
+		if (peer->pendingList.next != NULL) {
+			enet_list_remove(&peer->pendingList);
+
+			peer->pendingList.next = NULL;
+		}
+
+		if (peer->timerList.next != NULL) {
+			enet_list_remove(&peer->timerList);
+
+			peer->timerList.next = NULL;
+			--peer->host->timerCount;
+		}
+	}
+
+	static uint32_t enet_peer_hash_address(const ENetHost* host, const struct in6_addr* address) {
+		uint32_t words[4], hash = host->indexSeed;
+		int i;
+
+		memcpy(words, address, sizeof(words));
+
+		for (i = 0; i < 4; ++i) {
+			hash = (hash ^ words[i]) * 0x9E3779B1;
+			hash ^= hash >> 15;
+		}
+
+		return hash;
+	}
+
+	static uint32_t enet_peer_hash_connection(const ENetHost* host, const ENetAddress* address, uint32_t connectID) {
+		uint32_t hash = enet_peer_hash_address(host, &address->ipv6);
+
+		hash = (hash ^ address->port) * 0x85EBCA77;
+		hash ^= hash >> 13;
+		hash = (hash ^ connectID) * 0xC2B2AE3D;
+		hash ^= hash >> 16;
+
+		return hash;
+	}
+
+	ENetPeer* enet_host_find_connection(ENetHost* host, const ENetAddress* address, uint32_t connectID) {
+		size_t slot = enet_peer_hash_connection(host, address, connectID) & host->indexMask;
+
+		while (host->connectionIndex[slot] != NULL) {
+			ENetPeer* peer = host->connectionIndex[slot];
+
+			if (peer->connectID == connectID && peer->address.port == address->port && enet_in6_equal(peer->address.ipv6, address->ipv6))
+				return peer;
+
+			slot = (slot + 1) & host->indexMask;
+		}
+
+		return NULL;
+	}
+
+	uint32_t enet_host_count_address(ENetHost* host, const struct in6_addr* address) {
+		size_t slot = enet_peer_hash_address(host, address) & host->indexMask;
+
+		while (host->addressCounts[slot].count != 0) {
+			if (enet_in6_equal(host->addressCounts[slot].address, *address))
+				return host->addressCounts[slot].count;
+
+			slot = (slot + 1) & host->indexMask;
+		}
+
+		return 0;
+	}
+
+	/* Both tables use linear probing and are never more than half full, removal shifts later entries back instead of leaving tombstones */
+	void enet_peer_index(ENetPeer* peer) {
+		ENetHost* host = peer->host;
+		uint32_t hash;
+		size_t slot;
+
+		if (peer->indexed)
+			return;
+
+		peer->indexed = 1;
+		peer->indexHash = enet_peer_hash_connection(host, &peer->address, peer->connectID);
+
+		for (slot = peer->indexHash & host->indexMask; host->connectionIndex[slot] != NULL; slot = (slot + 1) & host->indexMask) {
+			continue;
+		}
+
+		host->connectionIndex[slot] = peer;
+		hash = enet_peer_hash_address(host, &peer->address.ipv6);
+
+		for (slot = hash & host->indexMask; host->addressCounts[slot].count != 0; slot = (slot + 1) & host->indexMask) {
+			if (enet_in6_equal(host->addressCounts[slot].address, peer->address.ipv6))
+				break;
+		}
+
+		if (host->addressCounts[slot].count++ == 0) {
+			host->addressCounts[slot].address = peer->address.ipv6;
+			host->addressCounts[slot].hash = hash;
+		}
+	}
+
+	void enet_peer_unindex(ENetPeer* peer) {
+		ENetHost* host = peer->host;
+		size_t slot, next;
+
+		if (!peer->indexed)
+			return;
+
+		peer->indexed = 0;
+
+		for (slot = peer->indexHash & host->indexMask; host->connectionIndex[slot] != peer; slot = (slot + 1) & host->indexMask) {
+			continue;
+		}
+
+		for (next = (slot + 1) & host->indexMask; host->connectionIndex[next] != NULL; next = (next + 1) & host->indexMask) {
+			size_t home = host->connectionIndex[next]->indexHash & host->indexMask;
+
+			if (((next - home) & host->indexMask) >= ((next - slot) & host->indexMask)) {
+				host->connectionIndex[slot] = host->connectionIndex[next];
+				slot = next;
+			}
+		}
+
+		host->connectionIndex[slot] = NULL;
+
+		for (slot = enet_peer_hash_address(host, &peer->address.ipv6) & host->indexMask; !enet_in6_equal(host->addressCounts[slot].address, peer->address.ipv6) || host->addressCounts[slot].count == 0; slot = (slot + 1) & host->indexMask) {
+			continue;
+		}
+
+		if (--host->addressCounts[slot].count != 0)
+			return;
+
+		for (next = (slot + 1) & host->indexMask; host->addressCounts[next].count != 0; next = (next + 1) & host->indexMask) {
+			size_t home = host->addressCounts[next].hash & host->indexMask;
+
+			if (((next - home) & host->indexMask) >= ((next - slot) & host->indexMask)) {
+				host->addressCounts[slot] = host->addressCounts[next];
+				slot = next;
+			}
+		}
+
+		host->addressCounts[slot].count = 0;
+	}
+
+	void enet_peer_reset(ENetPeer* peer) {
+		enet_peer_on_disconnect(peer);
+		enet_peer_unschedule(peer);
+		enet_peer_unindex(peer);
+
+		if (peer->state != ENET_PEER_STATE_DISCONNECTED)
+			enet_peer_deactivate(peer);
+
+		peer->outgoingPeerID = ENET_PROTOCOL_MAXIMUM_PEER_ID;
+		peer->state = ENET_PEER_STATE_DISCONNECTED;
+		peer->capabilities = 0;
+		peer->checksum = ENET_CHECKSUM_NONE;
+		peer->checksumConfirmed = 0;
+		peer->compressionBypass = 0;
+		peer->compressionFailures = 0;
+		peer->incomingBandwidth = 0;
+		peer->outgoingBandwidth = 0;
+		peer->incomingBandwidthThrottleEpoch = 0;
+		peer->outgoingBandwidthThrottleEpoch = 0;
+		peer->incomingDataTotal = 0;
+		peer->totalDataReceived = 0;
+		peer->outgoingDataTotal = 0;
+		peer->totalDataSent = 0;
+		peer->lastSendTime = 0;
+		peer->lastReceiveTime = 0;
+		peer->nextTimeout = 0;
+		peer->earliestTimeout = 0;
+		peer->totalPacketsSent = 0;
+		peer->totalPacketsLost = 0;
+		peer->totalFastRetransmits = 0;
+		peer->packetThrottle = ENET_PEER_DEFAULT_PACKET_THROTTLE;
+		peer->packetThrottleThreshold = ENET_PEER_PACKET_THROTTLE_THRESHOLD;
+		peer->packetThrottleLimit = ENET_PEER_PACKET_THROTTLE_SCALE;
+		peer->packetThrottleCounter = 0;
+		peer->packetThrottleEpoch = 0;
+		peer->packetThrottleAcceleration = ENET_PEER_PACKET_THROTTLE_ACCELERATION;
+		peer->packetThrottleDeceleration = ENET_PEER_PACKET_THROTTLE_DECELERATION;
+		peer->packetThrottleInterval = ENET_PEER_PACKET_THROTTLE_INTERVAL;
+		peer->pingInterval = ENET_PEER_PING_INTERVAL;
+		peer->fastRetransmit = 0;
+		peer->sendOrder = 0;
+		peer->acknowledgementDelay = 0;
+		peer->acknowledgementThreshold = 0;
+		peer->remoteAcknowledgementHold = 0;
+		peer->timeoutLimit = ENET_PEER_TIMEOUT_LIMIT;
+		peer->timeoutMinimum = ENET_PEER_TIMEOUT_MINIMUM;
+		peer->timeoutMaximum = ENET_PEER_TIMEOUT_MAXIMUM;
+		peer->lastRoundTripTime = ENET_PEER_DEFAULT_ROUND_TRIP_TIME;
+		peer->lowestRoundTripTime = ENET_PEER_DEFAULT_ROUND_TRIP_TIME;
+		peer->lastRoundTripTimeVariance = 0;
+		peer->highestRoundTripTimeVariance = 0;
+		peer->roundTripTime = 1;
+		peer->roundTripTimeVariance = 0;
+		peer->mtu = peer->host->mtu;
+		peer->reliableDataInTransit = 0;
+		peer->outgoingReliableSequenceNumber = 0;
+		peer->windowSize = ENET_PROTOCOL_MAXIMUM_WINDOW_SIZE;
+		peer->incomingUnsequencedGroup = 0;
+		peer->outgoingUnsequencedGroup = 0;
+		peer->eventData = 0;
+		peer->totalWaitingData = 0;
+		peer->pacingCredit = 0;
+		peer->pacingTime = 0;
+		peer->mtuProbeSize = 0;
+		peer->mtuProbeLow = 0;
+		peer->mtuProbeHigh = 0;
+		peer->mtuProbeSequenceNumber = 0;
+		peer->mtuProbeCount = 0;
+		peer->mtuProbeTime = 0;
+		peer->mtuLosses = 0;
+
+		memset(peer->unsequencedWindow, 0, sizeof(peer->unsequencedWindow));
+
+		enet_cipher_destroy(peer);
+		enet_peer_reset_congestion(peer);
+		enet_peer_reset_queues(peer);
+	}
+
+	void enet_peer_ping(ENetPeer* peer) {
+		ENetProtocol command;
+
+		if (peer->state != ENET_PEER_STATE_CONNECTED)
+			return;
+
+		command.header.command = ENET_PROTOCOL_COMMAND_PING | ENET_PROTOCOL_COMMAND_FLAG_ACKNOWLEDGE;
+		command.header.channelID = 0xFF;
+
+		enet_peer_queue_outgoing_command(peer, &command, NULL, 0, 0);
+	}
+
+	void enet_peer_ping_interval(ENetPeer* peer, uint32_t pingInterval) {
+		peer->pingInterval = pingInterval ? pingInterval : ENET_PEER_PING_INTERVAL;
+
+		enet_peer_mark_pending(peer);
+	}
+
+	void enet_peer_fast_retransmit(ENetPeer* peer, uint32_t threshold) {
+		peer->fastRetransmit = threshold;
+	}
+
+	void enet_peer_acknowledgement_delay(ENetPeer* peer, uint32_t delay, uint32_t threshold) {
+		peer->acknowledgementDelay = delay;
+		peer->acknowledgementThreshold = threshold;
+
+		enet_peer_mark_pending(peer);
+	}
+
+	int enet_peer_channel_aggregation(ENetPeer* peer, uint8_t channelID, int enabled) {
+		if (channelID >= peer->channelCount)
+			return -1;
+
+		peer->channels[channelID].aggregation = enabled ? 1 : 0;
+
+		return 0;
+	}
+
+	void enet_peer_timeout(ENetPeer* peer, uint32_t timeoutLimit, uint32_t timeoutMinimum, uint32_t timeoutMaximum) {
+		peer->timeoutLimit = timeoutLimit ? timeoutLimit : ENET_PEER_TIMEOUT_LIMIT;
+		peer->timeoutMinimum = timeoutMinimum ? timeoutMinimum : ENET_PEER_TIMEOUT_MINIMUM;
+		peer->timeoutMaximum = timeoutMaximum ? timeoutMaximum : ENET_PEER_TIMEOUT_MAXIMUM;
+	}
+
+	void enet_peer_disconnect_now(ENetPeer* peer, uint32_t data) {
+		ENetProtocol command;
+
+		if (peer->state == ENET_PEER_STATE_DISCONNECTED)
+			return;
+
+		if (peer->state != ENET_PEER_STATE_ZOMBIE && peer->state != ENET_PEER_STATE_DISCONNECTING) {
+			enet_peer_reset_queues(peer);
+
+			command.header.command = ENET_PROTOCOL_COMMAND_DISCONNECT | ENET_PROTOCOL_COMMAND_FLAG_UNSEQUENCED;
+			command.header.channelID = 0xFF;
+			command.disconnect.data = ENET_HOST_TO_NET_32(data);
+
+			enet_peer_queue_outgoing_command(peer, &command, NULL, 0, 0);
+			enet_host_flush(peer->host);
+		}
+
+		enet_peer_reset(peer);
+	}
+
+	void enet_peer_disconnect(ENetPeer* peer, uint32_t data) {
+		ENetProtocol command;
+
+		if (peer->state == ENET_PEER_STATE_DISCONNECTING || peer->state == ENET_PEER_STATE_DISCONNECTED || peer->state == ENET_PEER_STATE_ACKNOWLEDGING_DISCONNECT || peer->state == ENET_PEER_STATE_ZOMBIE)
+			return;
+
+		enet_peer_reset_queues(peer);
+
+		command.header.command = ENET_PROTOCOL_COMMAND_DISCONNECT;
+		command.header.channelID = 0xFF;
+		command.disconnect.data = ENET_HOST_TO_NET_32(data);
+
+		if (peer->state == ENET_PEER_STATE_CONNECTED || peer->state == ENET_PEER_STATE_DISCONNECT_LATER)
+			command.header.command |= ENET_PROTOCOL_COMMAND_FLAG_ACKNOWLEDGE;
+		else
+			command.header.command |= ENET_PROTOCOL_COMMAND_FLAG_UNSEQUENCED;
+
+		enet_peer_queue_outgoing_command(peer, &command, NULL, 0, 0);
+
+		if (peer->state == ENET_PEER_STATE_CONNECTED || peer->state == ENET_PEER_STATE_DISCONNECT_LATER) {
+			enet_peer_on_disconnect(peer);
+
+			peer->state = ENET_PEER_STATE_DISCONNECTING;
+		} else {
+			enet_host_flush(peer->host);
+			enet_peer_reset(peer);
+		}
+	}
+
+	void enet_peer_disconnect_later(ENetPeer* peer, uint32_t data) {
+		if ((peer->state == ENET_PEER_STATE_CONNECTED || peer->state == ENET_PEER_STATE_DISCONNECT_LATER) && enet_peer_has_outgoing_commands(peer)) {
+			peer->state = ENET_PEER_STATE_DISCONNECT_LATER;
+			peer->eventData = data;
+		} else {
+			enet_peer_disconnect(peer, data);
+		}
+	}
+
+	ENetAcknowledgement* enet_peer_queue_acknowledgement(ENetPeer* peer, const ENetProtocol* command, uint16_t sentTime) {
+		ENetAcknowledgement* acknowledgement;
+
+		if (command->header.channelID < peer->channelCount) {
+			ENetChannel* channel = &peer->channels[command->header.channelID];
+			uint16_t reliableWindow = command->header.reliableSequenceNumber / ENET_PEER_RELIABLE_WINDOW_SIZE;
+			uint16_t currentWindow = channel->incomingReliableSequenceNumber / ENET_PEER_RELIABLE_WINDOW_SIZE;
+
+			if (command->header.reliableSequenceNumber < channel->incomingReliableSequenceNumber)
+				reliableWindow += ENET_PEER_RELIABLE_WINDOWS;
+
+			if (reliableWindow >= currentWindow + ENET_PEER_FREE_RELIABLE_WINDOWS - 1 && reliableWindow <= currentWindow + ENET_PEER_FREE_RELIABLE_WINDOWS)
+				return NULL;
+		}
+
+		acknowledgement = (ENetAcknowledgement*)enet_pool_allocate(&peer->host->acknowledgementPool);
+
+		if (acknowledgement == NULL)
+			return NULL;
+
+		peer->outgoingDataTotal += sizeof(ENetProtocolAcknowledge);
+		acknowledgement->sentTime = sentTime;
+		acknowledgement->queueTime = peer->host->serviceTime;
+		acknowledgement->command = *command;
+		++peer->acknowledgementCount;
+
+		enet_list_insert(enet_list_end(&peer->acknowledgements), acknowledgement);
+		enet_peer_mark_pending(peer);
+
+		return acknowledgement;
+	}
+
+	void enet_peer_setup_outgoing_command(ENetPeer* peer, ENetOutgoingCommand* outgoingCommand) {
+		ENetChannel *channel = NULL;
+
+		if (outgoingCommand->command.header.channelID < peer->channelCount)
+		{
+			channel = &peer->channels[outgoingCommand->command.header.channelID];
+		}
+
+		peer->outgoingDataTotal += enet_protocol_command_size(outgoingCommand->command.header.command) + outgoingCommand->fragmentLength;
+
+		if (outgoingCommand->command.header.channelID == 0xFF) {
+			++peer->outgoingReliableSequenceNumber;
+			outgoingCommand->reliableSequenceNumber = peer->outgoingReliableSequenceNumber;
+			outgoingCommand->unreliableSequenceNumber = 0;
+		} else if (outgoingCommand->command.header.command & ENET_PROTOCOL_COMMAND_FLAG_ACKNOWLEDGE) {
+			++channel->outgoingReliableSequenceNumber;
+			channel->outgoingUnreliableSequenceNumber = 0;
+			outgoingCommand->reliableSequenceNumber = channel->outgoingReliableSequenceNumber;
+			outgoingCommand->unreliableSequenceNumber = 0;
+		} else if (outgoingCommand->command.header.command & ENET_PROTOCOL_COMMAND_FLAG_UNSEQUENCED) {
+			++peer->outgoingUnsequencedGroup;
+			outgoingCommand->reliableSequenceNumber = 0;
+			outgoingCommand->unreliableSequenceNumber = 0;
+		} else {
+			if (outgoingCommand->fragmentOffset == 0)
+				++channel->outgoingUnreliableSequenceNumber;
+
+			outgoingCommand->reliableSequenceNumber = channel->outgoingReliableSequenceNumber;
+			outgoingCommand->unreliableSequenceNumber = channel->outgoingUnreliableSequenceNumber;
+		}
+
+		outgoingCommand->sendAttempts = 0;
+		outgoingCommand->skippedAcknowledgements = 0;
+		outgoingCommand->pieceOffset = 0;
+		outgoingCommand->inTransit = 0;
+		outgoingCommand->sentTime = 0;
+		outgoingCommand->sendOrder = 0;
+		outgoingCommand->roundTripTimeout = 0;
+		outgoingCommand->command.header.reliableSequenceNumber = ENET_HOST_TO_NET_16(outgoingCommand->reliableSequenceNumber);
+		outgoingCommand->queueTime = ++peer->host->totalQueued;
+
+		switch (outgoingCommand->command.header.command & ENET_PROTOCOL_COMMAND_MASK) {
+			case ENET_PROTOCOL_COMMAND_SEND_UNRELIABLE:
+				outgoingCommand->command.sendUnreliable.unreliableSequenceNumber = ENET_HOST_TO_NET_16(outgoingCommand->unreliableSequenceNumber);
+
+				break;
+
+			case ENET_PROTOCOL_COMMAND_SEND_UNSEQUENCED:
+				outgoingCommand->command.sendUnsequenced.unsequencedGroup = ENET_HOST_TO_NET_16(peer->outgoingUnsequencedGroup);
+
+				break;
+
+			default:
+				break;
+		}
+
+		if ((outgoingCommand->command.header.command & ENET_PROTOCOL_COMMAND_FLAG_ACKNOWLEDGE) != 0 && outgoingCommand->packet != NULL)
+			enet_list_insert(enet_list_end(&peer->outgoingSendReliableCommands), outgoingCommand);
+		else
+			enet_list_insert(enet_list_end(&peer->outgoingCommands), outgoingCommand);
+
+		enet_peer_mark_pending(peer);
+	}
+
+	ENetOutgoingCommand* enet_peer_queue_outgoing_command(ENetPeer* peer, const ENetProtocol* command, ENetPacket* packet, uint32_t offset, uint16_t length) {
+		ENetOutgoingCommand* outgoingCommand = (ENetOutgoingCommand*)enet_pool_allocate(&peer->host->outgoingCommandPool);
+
+		if (outgoingCommand == NULL)
+			return NULL;
+
+		outgoingCommand->command = *command;
+		outgoingCommand->fragmentOffset = offset;
+		outgoingCommand->fragmentLength = length;
+		outgoingCommand->packet = packet;
+
+		if (packet != NULL)
+			++packet->referenceCount;
+
+		enet_peer_setup_outgoing_command(peer, outgoingCommand);
+
+		return outgoingCommand;
+	}
+
+	void enet_peer_dispatch_incoming_unreliable_commands(ENetPeer* peer, ENetChannel* channel, ENetIncomingCommand* queuedCommand) {
+		ENetListIterator droppedCommand, startCommand, currentCommand;
+
+		for (droppedCommand = startCommand = currentCommand = enet_list_begin(&channel->incomingUnreliableCommands); currentCommand != enet_list_end(&channel->incomingUnreliableCommands); currentCommand = enet_list_next(currentCommand)) {
+			ENetIncomingCommand* incomingCommand = (ENetIncomingCommand*)currentCommand;
+
+			if ((incomingCommand->command.header.command & ENET_PROTOCOL_COMMAND_MASK) == ENET_PROTOCOL_COMMAND_SEND_UNSEQUENCED)
+				continue;
+
+			if (incomingCommand->reliableSequenceNumber == channel->incomingReliableSequenceNumber) {
+				if (incomingCommand->fragmentsRemaining <= 0) {
+					channel->incomingUnreliableSequenceNumber = incomingCommand->unreliableSequenceNumber;
+
+					continue;
+				}
+
+				if (startCommand != currentCommand) {
+					enet_list_move(enet_list_end(&peer->dispatchedCommands), startCommand, enet_list_previous(currentCommand));
+
+					if (!peer->needsDispatch) {
+						enet_list_insert(enet_list_end(&peer->host->dispatchQueue), &peer->dispatchList);
+
+						peer->needsDispatch = 1;
+					}
+
+					droppedCommand = currentCommand;
+				} else if (droppedCommand != currentCommand) {
+					droppedCommand = enet_list_previous(currentCommand);
+				}
+			} else {
+				uint16_t reliableWindow = incomingCommand->reliableSequenceNumber / ENET_PEER_RELIABLE_WINDOW_SIZE;
+				uint16_t currentWindow = channel->incomingReliableSequenceNumber / ENET_PEER_RELIABLE_WINDOW_SIZE;
+
+				if (incomingCommand->reliableSequenceNumber < channel->incomingReliableSequenceNumber)
+					reliableWindow += ENET_PEER_RELIABLE_WINDOWS;
+
+				if (reliableWindow >= currentWindow && reliableWindow < currentWindow + ENET_PEER_FREE_RELIABLE_WINDOWS - 1)
+					break;
+
+				droppedCommand = enet_list_next(currentCommand);
+
+				if (startCommand != currentCommand) {
+					enet_list_move(enet_list_end(&peer->dispatchedCommands), startCommand, enet_list_previous(currentCommand));
+
+					if (!peer->needsDispatch) {
+						enet_list_insert(enet_list_end(&peer->host->dispatchQueue), &peer->dispatchList);
+
+						peer->needsDispatch = 1;
+					}
+				}
+			}
+
+			startCommand = enet_list_next(currentCommand);
+		}
+
+		if (startCommand != currentCommand) {
+			enet_list_move(enet_list_end(&peer->dispatchedCommands), startCommand, enet_list_previous(currentCommand));
+
+			if (!peer->needsDispatch) {
+				enet_list_insert(enet_list_end(&peer->host->dispatchQueue), &peer->dispatchList);
+
+				peer->needsDispatch = 1;
+			}
+
+			droppedCommand = currentCommand;
+		}
+
+		enet_peer_remove_incoming_commands(peer, &channel->incomingUnreliableCommands, enet_list_begin(&channel->incomingUnreliableCommands), droppedCommand, queuedCommand);
+	}
+
+	void enet_peer_dispatch_incoming_reliable_commands(ENetPeer* peer, ENetChannel* channel, ENetIncomingCommand* queuedCommand) {
+		uint16_t startSequenceNumber = channel->incomingReliableSequenceNumber;
+
+		if (channel->incomingReliableCommands == NULL)
+			return;
+
+		for (;;) {
+			uint16_t reliableSequenceNumber = channel->incomingReliableSequenceNumber + 1;
+			ENetIncomingCommand** slot = &channel->incomingReliableCommands[reliableSequenceNumber & (channel->incomingReliableCapacity - 1)];
+			ENetIncomingCommand* incomingCommand = *slot;
+
+			if (incomingCommand == NULL || incomingCommand->reliableSequenceNumber != reliableSequenceNumber || incomingCommand->fragmentsRemaining > 0)
+				break;
+
+			*slot = NULL;
+			channel->incomingReliableSequenceNumber = reliableSequenceNumber;
+
+			if (incomingCommand->fragmentCount > 0)
+				channel->incomingReliableSequenceNumber += incomingCommand->fragmentCount - 1;
+
+			enet_list_insert(enet_list_end(&peer->dispatchedCommands), incomingCommand);
+		}
+
+		if (channel->incomingReliableSequenceNumber == startSequenceNumber)
+			return;
+
+		channel->incomingUnreliableSequenceNumber = 0;
+
+		if (!peer->needsDispatch) {
+			enet_list_insert(enet_list_end(&peer->host->dispatchQueue), &peer->dispatchList);
+
+			peer->needsDispatch = 1;
+		}
+
+		if (!enet_list_empty(&channel->incomingUnreliableCommands))
+			enet_peer_dispatch_incoming_unreliable_commands(peer, channel, queuedCommand);
+	}
+
+	/* Reliable commands waiting for delivery sit in a ring indexed by sequence number, it grows on demand until it spans the free reliable windows */
+	static int enet_peer_grow_reliable_commands(ENetChannel* channel, uint16_t distance) {
+		ENetIncomingCommand** incomingReliableCommands;
+		uint32_t capacity = channel->incomingReliableCapacity > 0 ? channel->incomingReliableCapacity : ENET_PEER_RELIABLE_RING_MINIMUM;
+		uint32_t i;
+
+		if (distance > ENET_PEER_RELIABLE_RING_MAXIMUM)
+			return -1;
+
+		while (capacity < distance) {
+			capacity <<= 1;
+		}
+
+		incomingReliableCommands = (ENetIncomingCommand**)enet_malloc(capacity * sizeof(ENetIncomingCommand*));
+
+		if (incomingReliableCommands == NULL)
+			return -1;
+
+		memset(incomingReliableCommands, 0, capacity * sizeof(ENetIncomingCommand*));
+
+		for (i = 0; i < channel->incomingReliableCapacity; ++i) {
+			ENetIncomingCommand* incomingCommand = channel->incomingReliableCommands[i];
+
+			if (incomingCommand != NULL)
+				incomingReliableCommands[incomingCommand->reliableSequenceNumber & (capacity - 1)] = incomingCommand;
+		}
+
+		if (channel->incomingReliableCommands != NULL)
+			enet_free(channel->incomingReliableCommands);
+
+		channel->incomingReliableCommands = incomingReliableCommands;
+		channel->incomingReliableCapacity = capacity;
+
+		return 0;
+	}
+
+	ENetIncomingCommand* enet_peer_queue_incoming_command(ENetPeer* peer, const ENetProtocol* command, const void* data, size_t dataLength, uint32_t flags, uint32_t fragmentCount) {
+		static ENetIncomingCommand dummyCommand;
+
+		ENetChannel* channel = &peer->channels[command->header.channelID];
+		uint32_t unreliableSequenceNumber = 0, reliableSequenceNumber = 0;
+		uint16_t reliableWindow, currentWindow;
+		ENetIncomingCommand* incomingCommand;
+		ENetListIterator currentCommand;
+		ENetPacket* packet = NULL;
+
+		if (peer->state == ENET_PEER_STATE_DISCONNECT_LATER)
+			goto discardCommand;
+
+		if ((command->header.command & ENET_PROTOCOL_COMMAND_MASK) != ENET_PROTOCOL_COMMAND_SEND_UNSEQUENCED) {
+			reliableSequenceNumber = command->header.reliableSequenceNumber;
+			reliableWindow = reliableSequenceNumber / ENET_PEER_RELIABLE_WINDOW_SIZE;
+			currentWindow = channel->incomingReliableSequenceNumber / ENET_PEER_RELIABLE_WINDOW_SIZE;
+
+			if (reliableSequenceNumber < channel->incomingReliableSequenceNumber)
+				reliableWindow += ENET_PEER_RELIABLE_WINDOWS;
+
+			if (reliableWindow < currentWindow || reliableWindow >= currentWindow + ENET_PEER_FREE_RELIABLE_WINDOWS - 1)
+				goto discardCommand;
+		}
+
+		switch (command->header.command & ENET_PROTOCOL_COMMAND_MASK) {
+			case ENET_PROTOCOL_COMMAND_SEND_FRAGMENT:
+			case ENET_PROTOCOL_COMMAND_SEND_RELIABLE:
+				if (reliableSequenceNumber == channel->incomingReliableSequenceNumber)
+					goto discardCommand;
+
+				if ((uint16_t)(reliableSequenceNumber - channel->incomingReliableSequenceNumber) > channel->incomingReliableCapacity && enet_peer_grow_reliable_commands(channel, (uint16_t)(reliableSequenceNumber - channel->incomingReliableSequenceNumber)) < 0)
+					goto notifyError;
+
+				if (channel->incomingReliableCommands[reliableSequenceNumber & (channel->incomingReliableCapacity - 1)] != NULL)
+					goto discardCommand;
+
+				break;
+
+			case ENET_PROTOCOL_COMMAND_SEND_UNRELIABLE:
+			case ENET_PROTOCOL_COMMAND_SEND_UNRELIABLE_FRAGMENT:
+				unreliableSequenceNumber = ENET_NET_TO_HOST_16(command->sendUnreliable.unreliableSequenceNumber);
+
+				if (reliableSequenceNumber == channel->incomingReliableSequenceNumber && unreliableSequenceNumber <= channel->incomingUnreliableSequenceNumber)
+					goto discardCommand;
+
+				for (currentCommand = enet_list_previous(enet_list_end(&channel->incomingUnreliableCommands)); currentCommand != enet_list_end(&channel->incomingUnreliableCommands); currentCommand = enet_list_previous(currentCommand)) {
+					incomingCommand = (ENetIncomingCommand*)currentCommand;
+
+					if ((command->header.command & ENET_PROTOCOL_COMMAND_MASK) == ENET_PROTOCOL_COMMAND_SEND_UNSEQUENCED)
+						continue;
+
+					if (reliableSequenceNumber >= channel->incomingReliableSequenceNumber) {
+						if (incomingCommand->reliableSequenceNumber < channel->incomingReliableSequenceNumber)
+							continue;
+					} else if (incomingCommand->reliableSequenceNumber >= channel->incomingReliableSequenceNumber) {
+						break;
+					}
+
+					if (incomingCommand->reliableSequenceNumber < reliableSequenceNumber)
+						break;
+
+					if (incomingCommand->reliableSequenceNumber > reliableSequenceNumber)
+						continue;
+
+					if (incomingCommand->unreliableSequenceNumber <= unreliableSequenceNumber) {
+						if (incomingCommand->unreliableSequenceNumber < unreliableSequenceNumber)
+							break;
+
+						goto discardCommand;
+					}
+				}
+
+				break;
+
+			case ENET_PROTOCOL_COMMAND_SEND_UNSEQUENCED:
+				currentCommand = enet_list_end(&channel->incomingUnreliableCommands);
+
+				break;
+
+			default:
+				goto discardCommand;
+		}
+
+		if (peer->totalWaitingData >= peer->host->maximumWaitingData)
+			goto notifyError;
+
+		packet = enet_packet_create(data, dataLength, flags);
+
+		if (packet == NULL)
+			goto notifyError;
+
+		incomingCommand = (ENetIncomingCommand*)enet_pool_allocate(&peer->host->incomingCommandPool);
+
+		if (incomingCommand == NULL)
+			goto notifyError;
+
+		incomingCommand->reliableSequenceNumber = command->header.reliableSequenceNumber;
+		incomingCommand->unreliableSequenceNumber = unreliableSequenceNumber & 0xFFFF;
+		incomingCommand->command = *command;
+		incomingCommand->fragmentCount = fragmentCount;
+		incomingCommand->fragmentsRemaining = fragmentCount;
+		incomingCommand->aggregateOffset = 0;
+		incomingCommand->packet = packet;
+		incomingCommand->fragments = NULL;
+
+		if (fragmentCount > 0) {
+			if (fragmentCount <= ENET_PROTOCOL_MAXIMUM_FRAGMENT_COUNT)
+				incomingCommand->fragments = (uint32_t*)enet_malloc((fragmentCount + 31) / 32 * sizeof(uint32_t));
+
+			if (incomingCommand->fragments == NULL) {
+				enet_pool_free(&peer->host->incomingCommandPool, incomingCommand);
+
+				goto notifyError;
+			}
+
+			memset(incomingCommand->fragments, 0, (fragmentCount + 31) / 32 * sizeof(uint32_t));
+		}
+
+		if (packet != NULL) {
+			++packet->referenceCount;
+			peer->totalWaitingData += packet->dataLength;
+		}
+
+		switch (command->header.command & ENET_PROTOCOL_COMMAND_MASK) {
+			case ENET_PROTOCOL_COMMAND_SEND_FRAGMENT:
+			case ENET_PROTOCOL_COMMAND_SEND_RELIABLE:
+				channel->incomingReliableCommands[reliableSequenceNumber & (channel->incomingReliableCapacity - 1)] = incomingCommand;
+
+				enet_peer_dispatch_incoming_reliable_commands(peer, channel, incomingCommand);
+
+				break;
+
+			default:
+				enet_list_insert(enet_list_next(currentCommand), incomingCommand);
+				enet_peer_dispatch_incoming_unreliable_commands(peer, channel, incomingCommand);
+
+				break;
+		}
+
+		return incomingCommand;
+
+		discardCommand:
+
+		if (fragmentCount > 0)
+			goto notifyError;
+
+		if (packet != NULL && packet->referenceCount == 0)
+			enet_packet_destroy(packet);
+
+		return &dummyCommand;
+
+		notifyError:
+
+		if (packet != NULL && packet->referenceCount == 0)
+			enet_packet_destroy(packet);
+
+		return NULL;
+	}
+
+/*
+=======================================================================
+
+	Host
+
+=======================================================================
+*/
+
+	ENetHost* enet_host_create(const ENetAddress* address, size_t peerCount, size_t channelLimit, uint32_t incomingBandwidth, uint32_t outgoingBandwidth, int bufferSize) {
+		return enet_host_create_with_options(address, peerCount, channelLimit, incomingBandwidth, outgoingBandwidth, bufferSize, NULL);
+	}
+
+	ENetHost* enet_host_create_with_options(const ENetAddress* address, size_t peerCount, size_t channelLimit, uint32_t incomingBandwidth, uint32_t outgoingBandwidth, int bufferSize, const ENetHostOptions* options) {
+		ENetHost* host;
+		ENetPeer* currentPeer;
+		size_t i, poolHighWaterMark;
+
+		if (peerCount > ENET_PROTOCOL_MAXIMUM_PEER_ID)
+			return NULL;
+
+		host = (ENetHost*)enet_malloc(sizeof(ENetHost));
+
+		if (host == NULL)
+			return NULL;
+
+		memset(host, 0, sizeof(ENetHost));
+
+		host->peers = (ENetPeer*)enet_malloc(peerCount * sizeof(ENetPeer));
+
+		if (host->peers == NULL) {
+			enet_free(host);
+
+			return NULL;
+		}
+
+		memset(host->peers, 0, peerCount * sizeof(ENetPeer));
+
+		for (i = 2; i < peerCount * 2; i <<= 1) {
+			continue;
+		}
+
+		host->indexMask = i - 1;
+
+		/* The active and free peer arrays share one allocation with the connection and address index tables */
+		host->activePeers = (ENetPeer**)enet_malloc((peerCount * 2 + i) * sizeof(ENetPeer*) + i * sizeof(ENetAddressCount));
+
+		if (host->activePeers == NULL) {
+			enet_free(host->peers);
+			enet_free(host);
+
+			return NULL;
+		}
+
+		host->freePeers = &host->activePeers[peerCount];
+		host->connectionIndex = &host->activePeers[peerCount * 2];
+		host->addressCounts = (ENetAddressCount*)&host->connectionIndex[i];
+
+		memset(host->connectionIndex, 0, i * (sizeof(ENetPeer*) + sizeof(ENetAddressCount)));
+
+		host->socket = enet_socket_create(ENET_SOCKET_TYPE_DATAGRAM);
+
+		if (host->socket != ENET_SOCKET_NULL)
+			enet_socket_set_option(host->socket, ENET_SOCKOPT_IPV6_V6ONLY, 0);
+
+		if (host->socket == ENET_SOCKET_NULL || (options != NULL && options->reusePort && enet_socket_set_option(host->socket, ENET_SOCKOPT_REUSEPORT, 1) < 0) || (address != NULL && enet_socket_bind(host->socket, address) < 0)) {
+			if (host->socket != ENET_SOCKET_NULL)
+				enet_socket_destroy(host->socket);
+
+			enet_free(host->activePeers);
+			enet_free(host->peers);
+			enet_free(host);
+
+			return NULL;
+		}
+
+		if (bufferSize > ENET_HOST_BUFFER_SIZE_MAX)
+			bufferSize = ENET_HOST_BUFFER_SIZE_MAX;
+		else if (bufferSize < ENET_HOST_BUFFER_SIZE_MIN)
+			bufferSize = ENET_HOST_BUFFER_SIZE_MIN;
+
+		enet_socket_set_option(host->socket, ENET_SOCKOPT_NONBLOCK, 1);
+		enet_socket_set_option(host->socket, ENET_SOCKOPT_BROADCAST, 1);
+		enet_socket_set_option(host->socket, ENET_SOCKOPT_RCVBUF, bufferSize);
+		enet_socket_set_option(host->socket, ENET_SOCKOPT_SNDBUF, bufferSize);
+
+		if (address != NULL && enet_socket_get_address(host->socket, &host->address) < 0)
+			host->address = *address;
+
+		if (!channelLimit || channelLimit > ENET_PROTOCOL_MAXIMUM_CHANNEL_COUNT)
+			channelLimit = ENET_PROTOCOL_MAXIMUM_CHANNEL_COUNT;
+		else if (channelLimit < ENET_PROTOCOL_MINIMUM_CHANNEL_COUNT)
+			channelLimit = ENET_PROTOCOL_MINIMUM_CHANNEL_COUNT;
+
+		host->randomSeed = (uint32_t)(size_t)host;
+		host->randomSeed += enet_host_random_seed();
+		host->randomSeed = (host->randomSeed << 16) | (host->randomSeed >> 16);
+		host->indexSeed = host->randomSeed ^ enet_host_random_seed();
+		host->channelLimit = channelLimit;
+		host->incomingBandwidth = incomingBandwidth;
+		host->outgoingBandwidth = outgoingBandwidth;
+		host->bandwidthThrottleEpoch = 0;
+		host->recalculateBandwidthLimits = 0;
+		host->preventConnections = 0;
+		host->legacyConnect = 0;
+		host->capabilities = 0;
+		host->mtu = ENET_HOST_DEFAULT_MTU;
+		host->peerCount = peerCount;
+		host->sendProbing = 0;
+		host->segmentation = 0;
+		host->pacing = ENET_PACING_NONE;
+		host->commands = host->sendCommands[0];
+		host->commandCount = 0;
+		host->buffers = host->sendBuffers[0];
+		host->bufferCount = 0;
+		host->sendCount = 0;
+		host->checksum = ENET_CHECKSUM_NONE;
+		host->checksumCallback = NULL;
+		host->compressor.context = NULL;
+		host->compressor.compress = NULL;
+		host->compressor.decompress = NULL;
+		host->compressor.destroy = NULL;
+		host->compressionDictionary = 0;
+		host->stagingData = NULL;
+		host->congestionControl = enet_congestion_control_get(ENET_CONGESTION_CONTROL_LEGACY);
+		host->receivedAddress.ipv6 = ENET_HOST_ANY;
+		host->receivedAddress.port = 0;
+		host->receivedData = NULL;
+		host->receiveData = NULL;
+		host->receiveArena = NULL;
+		host->receiveOffset = 0;
+		host->receiveCoalescing = 0;
+		host->uring = NULL;
+		host->postedMessages = NULL;
+		host->aggregatedPackets = NULL;
+		host->aggregatedPacketCount = 0;
+		host->aggregatedPacketCapacity = 0;
+		host->receivedDataLength = 0;
+		host->receiveIndex = 0;
+		host->receiveCount = 0;
+		host->totalSentData = 0;
+		host->totalSentPackets = 0;
+		host->totalReceivedData = 0;
+		host->totalReceivedPackets = 0;
+		host->totalQueued = 0;
+		host->connectedPeers = 0;
+		host->bandwidthLimitedPeers = 0;
+		host->duplicatePeers = ENET_PROTOCOL_MAXIMUM_PEER_ID;
+		host->maximumPacketSize = ENET_HOST_DEFAULT_MAXIMUM_PACKET_SIZE;
+		host->maximumWaitingData = ENET_HOST_DEFAULT_MAXIMUM_WAITING_DATA;
+		host->interceptCallback = NULL;
+		host->mtuCallback = NULL;
+
+		poolHighWaterMark = options != NULL && options->poolHighWaterMark > 0 ? options->poolHighWaterMark : ENET_HOST_DEFAULT_POOL_HIGH_WATER_MARK;
+
+		enet_pool_initialize(&host->outgoingCommandPool, sizeof(ENetOutgoingCommand), poolHighWaterMark);
+		enet_pool_initialize(&host->incomingCommandPool, sizeof(ENetIncomingCommand), poolHighWaterMark);
+		enet_pool_initialize(&host->acknowledgementPool, sizeof(ENetAcknowledgement), poolHighWaterMark);
+
+		/* Packet size classes belong to a thread, so they are filled by the first service call on the thread that runs the host rather than here */
+		host->packetPoolPrewarm = options != NULL ? options->packetPoolPrewarm : 0;
+
+		/* A backend the kernel does not support leaves the host on the regular socket calls */
+		#ifdef ENET_HAS_URING
+			if (options != NULL && options->backend == ENET_HOST_BACKEND_URING)
+				host->uring = enet_uring_create(host->socket);
+		#endif
+
+		enet_list_clear(&host->dispatchQueue);
+		enet_list_clear(&host->pendingPeers);
+
+		for (i = 0; i < ENET_HOST_TIMER_LEVELS * ENET_HOST_TIMER_SLOTS; ++i) {
+			enet_list_clear(&host->timerWheel[i / ENET_HOST_TIMER_SLOTS][i % ENET_HOST_TIMER_SLOTS]);
+		}
+
+		host->timerTime = enet_time_get();
+		host->timerCount = 0;
+
+		for (i = 0; i < ENET_HOST_SEND_BATCH; ++i) {
+			enet_list_clear(&host->sendUnreliableCommands[i]);
+		}
+
+		for (currentPeer = host->peers; currentPeer < &host->peers[host->peerCount]; ++currentPeer) {
+			currentPeer->host = host;
+			currentPeer->incomingPeerID = currentPeer - host->peers;
+			currentPeer->outgoingSessionID = currentPeer->incomingSessionID = 0xFF;
+			currentPeer->data = NULL;
+
+			enet_list_clear(&currentPeer->acknowledgements);
+			enet_list_clear(&currentPeer->sentReliableCommands);
+			enet_list_clear(&currentPeer->outgoingCommands);
+			enet_list_clear(&currentPeer->outgoingSendReliableCommands);
+			enet_list_clear(&currentPeer->dispatchedCommands);
+			enet_peer_reset(currentPeer);
+		}
+
+		/* Released slots queue up behind the others so that a peer ID is not reused while stale datagrams for it may still be in flight */
+		for (i = 0; i < peerCount; ++i) {
+			host->freePeers[host->freePeerCount++] = &host->peers[i];
+		}
+
+		return host;
+	}
+
+	void enet_host_destroy(ENetHost* host) {
+		ENetPeer* currentPeer;
+
+		if (host == NULL)
+			return;
+
+		#ifdef ENET_HAS_URING
+			if (host->uring != NULL)
+				enet_uring_destroy(host->uring);
+		#endif
+
+		enet_socket_destroy(host->socket);
+
+		while (host->postedMessages != NULL) {
+			ENetHostMessage* message = host->postedMessages;
+
+			host->postedMessages = message->next;
+
+			if (message->packet->referenceCount == 0)
+				enet_packet_destroy(message->packet);
+
+			enet_free(message);
+		}
+
+		for (currentPeer = host->peers; currentPeer < &host->peers[host->peerCount]; ++currentPeer) {
+			enet_peer_reset(currentPeer);
+		}
+
+		enet_protocol_release_aggregated_packets(host);
+
+		if (host->aggregatedPackets != NULL)
+			enet_free(host->aggregatedPackets);
+
+		if (host->receiveData != NULL)
+			enet_free(host->receiveData);
+
+		if (host->receiveArena != NULL)
+			enet_free(host->receiveArena);
+
+		enet_host_compress(host, NULL);
+
+		if (host->stagingData != NULL)
+			enet_free(host->stagingData);
+
+		enet_cipher_wipe(host->presharedKey, sizeof(host->presharedKey));
+
+		enet_pool_destroy(&host->outgoingCommandPool);
+		enet_pool_destroy(&host->incomingCommandPool);
+		enet_pool_destroy(&host->acknowledgementPool);
+
+		enet_free(host->activePeers);
+		enet_free(host->peers);
+		enet_free(host);
+	}
+
+	void enet_host_prevent_connections(ENetHost* host, uint8_t state) {
+		if (host == NULL)
+			return;
+
+		host->preventConnections = state;
+	}
+
+	ENetPeer* enet_host_connect(ENetHost* host, const ENetAddress* address, size_t channelCount, uint32_t data) {
+		ENetPeer* currentPeer;
+		ENetChannel* channel;
+		ENetPacket* payloadPacket = NULL;
+		ENetProtocol command;
+		uint8_t payload[ENET_PEER_CIPHER_KEY_SIZE + sizeof(uint32_t)];
+		size_t payloadLength = 0;
+		uint32_t dictionary;
+
+		if (channelCount < ENET_PROTOCOL_MINIMUM_CHANNEL_COUNT)
+			channelCount = ENET_PROTOCOL_MINIMUM_CHANNEL_COUNT;
+		else if (channelCount > ENET_PROTOCOL_MAXIMUM_CHANNEL_COUNT)
+			channelCount = ENET_PROTOCOL_MAXIMUM_CHANNEL_COUNT;
+
+		if (host->freePeerCount == 0)
+			return NULL;
+
+		currentPeer = host->freePeers[host->freePeerHead];
+
+		/* The public key and the dictionary ID travel as the payload of the connect */
+		if (host->capabilities & ENET_PROTOCOL_CAPABILITY_ENCRYPTION) {
+			if (enet_cipher_create(currentPeer) < 0)
+				return NULL;
+
+			memcpy(payload, currentPeer->cipher->publicKey, ENET_PEER_CIPHER_KEY_SIZE);
+
+			payloadLength = ENET_PEER_CIPHER_KEY_SIZE;
 		}
 
-		while (!enet_list_empty(&peer->acknowledgements)) {
-			enet_free(enet_list_remove(enet_list_begin(&peer->acknowledgements)));
+		if (host->compressionDictionary != 0) {
+			dictionary = ENET_HOST_TO_NET_32(host->compressionDictionary);
+
+			memcpy(&payload[payloadLength], &dictionary, sizeof(uint32_t));
+
+			payloadLength += sizeof(uint32_t);
 		}
 
-		enet_peer_reset_outgoing_commands(&peer->sentReliableCommands);
-		enet_peer_reset_outgoing_commands(&peer->outgoingCommands);
-		enet_peer_reset_outgoing_commands(&peer->outgoingSendReliableCommands);
-		enet_peer_reset_incoming_commands(&peer->dispatchedCommands);
+		if (payloadLength > 0) {
+			payloadPacket = enet_packet_create(payload, payloadLength, ENET_PACKET_FLAG_RELIABLE);
 
-		if (peer->channels != NULL && peer->channelCount > 0) {
-			for (channel = peer->channels; channel < &peer->channels[peer->channelCount]; ++channel) {
-				enet_peer_reset_incoming_commands(&channel->incomingReliableCommands);
-				enet_peer_reset_incoming_commands(&channel->incomingUnreliableCommands);
+			if (payloadPacket == NULL) {
+				enet_cipher_destroy(currentPeer);
+
+				return NULL;
 			}
+		}
 
-			enet_free(peer->channels);
+		currentPeer->channels = (ENetChannel*)enet_malloc(channelCount * sizeof(ENetChannel));
+
+		if (currentPeer->channels == NULL) {
+			if (payloadPacket != NULL) {
+				enet_packet_destroy(payloadPacket);
+				enet_cipher_destroy(currentPeer);
+			}
+
+			return NULL;
 		}
 
-		peer->channels = NULL;
-		peer->channelCount = 0;
+		enet_peer_activate(currentPeer);
+
+		currentPeer->channelCount = channelCount;
+		currentPeer->state = ENET_PEER_STATE_CONNECTING;
+		currentPeer->address = *address;
+		currentPeer->connectID = ++host->randomSeed;
+
+		if (host->outgoingBandwidth == 0)
+			currentPeer->windowSize = ENET_PROTOCOL_MAXIMUM_WINDOW_SIZE;
+		else
+			currentPeer->windowSize = (host->outgoingBandwidth / ENET_PEER_WINDOW_SIZE_SCALE) * ENET_PROTOCOL_MINIMUM_WINDOW_SIZE;
+
+		if (currentPeer->windowSize < ENET_PROTOCOL_MINIMUM_WINDOW_SIZE)
+			currentPeer->windowSize = ENET_PROTOCOL_MINIMUM_WINDOW_SIZE;
+		else if (currentPeer->windowSize > ENET_PROTOCOL_MAXIMUM_WINDOW_SIZE)
+			currentPeer->windowSize = ENET_PROTOCOL_MAXIMUM_WINDOW_SIZE;
+
+		for (channel = currentPeer->channels; channel < &currentPeer->channels[channelCount]; ++channel) {
+			channel->outgoingReliableSequenceNumber = 0;
+			channel->outgoingUnreliableSequenceNumber = 0;
+			channel->incomingReliableSequenceNumber = 0;
+			channel->incomingUnreliableSequenceNumber = 0;
+
+			enet_list_clear(&channel->incomingUnreliableCommands);
+
+			channel->incomingReliableCommands = NULL;
+			channel->incomingReliableCapacity = 0;
+			channel->sentReliableCommands = NULL;
+			channel->sentReliableCapacity = 0;
+
+			channel->usedReliableWindows = 0;
+			channel->aggregation = 0;
+
+			memset(channel->reliableWindows, 0, sizeof(channel->reliableWindows));
+		}
+
+		command.header.command = ENET_PROTOCOL_COMMAND_CONNECT | ENET_PROTOCOL_COMMAND_FLAG_ACKNOWLEDGE;
+		command.header.channelID = 0xFF;
+		command.connect.outgoingPeerID = ENET_HOST_TO_NET_16(currentPeer->incomingPeerID);
+		command.connect.incomingSessionID = currentPeer->incomingSessionID;
+		command.connect.outgoingSessionID = currentPeer->outgoingSessionID;
+		command.connect.mtu = ENET_HOST_TO_NET_32(currentPeer->mtu);
+		command.connect.windowSize = ENET_HOST_TO_NET_32(currentPeer->windowSize);
+		command.connect.channelCount = ENET_HOST_TO_NET_32(channelCount | host->capabilities | ((uint32_t)host->checksum << ENET_PROTOCOL_CAPABILITY_CHECKSUM_SHIFT) | (host->compressionDictionary != 0 ? ENET_PROTOCOL_CAPABILITY_DICTIONARY : 0));
+		command.connect.incomingBandwidth = ENET_HOST_TO_NET_32(host->incomingBandwidth);
+		command.connect.outgoingBandwidth = ENET_HOST_TO_NET_32(host->outgoingBandwidth);
+		command.connect.packetThrottleInterval = ENET_HOST_TO_NET_32(currentPeer->packetThrottleInterval);
+		command.connect.packetThrottleAcceleration = ENET_HOST_TO_NET_32(currentPeer->packetThrottleAcceleration);
+		command.connect.packetThrottleDeceleration = ENET_HOST_TO_NET_32(currentPeer->packetThrottleDeceleration);
+		command.connect.connectID = currentPeer->connectID;
+		command.connect.data = ENET_HOST_TO_NET_32(data);
+
+		if (enet_peer_queue_outgoing_command(currentPeer, &command, payloadPacket, 0, (uint16_t)payloadLength) == NULL && payloadPacket != NULL)
+			enet_packet_destroy(payloadPacket);
+
+		return currentPeer;
 	}
 
-	int enet_peer_has_outgoing_commands(ENetPeer* peer) {
-		if (enet_list_empty(&peer->outgoingCommands) && enet_list_empty(&peer->outgoingSendReliableCommands) && enet_list_empty(&peer->sentReliableCommands))
-			return 0;
+	void enet_host_broadcast(ENetHost* host, uint8_t channelID, ENetPacket* packet) {
+		ENetPeer* currentPeer;
 
-		return 1;
+		if (packet->flags & ENET_PACKET_FLAG_INSTANT)
+			++packet->referenceCount;
+
+		for (size_t i = 0; i < host->activePeerCount; ++i) {
+			currentPeer = host->activePeers[i];
+
+			if (currentPeer->state != ENET_PEER_STATE_CONNECTED)
+				continue;
+
+			enet_peer_send(currentPeer, channelID, packet);
+		}
+
+		if (packet->flags & ENET_PACKET_FLAG_INSTANT)
+			--packet->referenceCount;
+
+		if (packet->referenceCount == 0)
+			enet_packet_destroy(packet);
 	}
 
-	void enet_peer_on_connect(ENetPeer* peer) {
-		if (peer->state != ENET_PEER_STATE_CONNECTED && peer->state != ENET_PEER_STATE_DISCONNECT_LATER) {
-			if (peer->incomingBandwidth != 0)
-				++peer->host->bandwidthLimitedPeers;
+	void enet_host_broadcast_exclude(ENetHost* host, uint8_t channelID, ENetPacket* packet, ENetPeer* excludedPeer) {
+		ENetPeer* currentPeer;
 
-			++peer->host->connectedPeers;
+		if (packet->flags & ENET_PACKET_FLAG_INSTANT)
+			++packet->referenceCount;
+
+		for (size_t i = 0; i < host->activePeerCount; ++i) {
+			currentPeer = host->activePeers[i];
+
+			if (currentPeer->state != ENET_PEER_STATE_CONNECTED || currentPeer == excludedPeer)
+				continue;
+
+			enet_peer_send(currentPeer, channelID, packet);
 		}
+
+		if (packet->flags & ENET_PACKET_FLAG_INSTANT)
+			--packet->referenceCount;
+
+		if (packet->referenceCount == 0)
+			enet_packet_destroy(packet);
 	}
 
-	void enet_peer_on_disconnect(ENetPeer* peer) {
-		if (peer->state == ENET_PEER_STATE_CONNECTED || peer->state == ENET_PEER_STATE_DISCONNECT_LATER) {
-			if (peer->incomingBandwidth != 0)
-				--peer->host->bandwidthLimitedPeers;
+	void enet_host_broadcast_selective(ENetHost* host, uint8_t channelID, ENetPacket* packet, ENetPeer** peers, size_t length) {
+		ENetPeer* currentPeer;
+		size_t i;
 
-			--peer->host->connectedPeers;
+		if (host == NULL)
+			return;
+
+		if (packet->flags & ENET_PACKET_FLAG_INSTANT)
+			++packet->referenceCount;
+
+		for (i = 0; i < length; i++) {
+			currentPeer = peers[i];
+
+			if (currentPeer == NULL || currentPeer->state != ENET_PEER_STATE_CONNECTED)
+				continue;
+
+			enet_peer_send(currentPeer, channelID, packet);
 		}
+
+		if (packet->flags & ENET_PACKET_FLAG_INSTANT)
+			--packet->referenceCount;
+
+		if (packet->referenceCount == 0)
+			enet_packet_destroy(packet);
 	}
 
-	void enet_peer_reset(ENetPeer* peer) {
-		enet_peer_on_disconnect(peer);
+	void enet_host_channel_limit(ENetHost* host, size_t channelLimit) {
+		if (!channelLimit || channelLimit > ENET_PROTOCOL_MAXIMUM_CHANNEL_COUNT)
+			channelLimit = ENET_PROTOCOL_MAXIMUM_CHANNEL_COUNT;
+		else if (channelLimit < ENET_PROTOCOL_MINIMUM_CHANNEL_COUNT)
+			channelLimit = ENET_PROTOCOL_MINIMUM_CHANNEL_COUNT;
 
-		peer->outgoingPeerID = ENET_PROTOCOL_MAXIMUM_PEER_ID;
-		peer->state = ENET_PEER_STATE_DISCONNECTED;
-		peer->incomingBandwidth = 0;
-		peer->outgoingBandwidth = 0;
-		peer->incomingBandwidthThrottleEpoch = 0;
-		peer->outgoingBandwidthThrottleEpoch = 0;
-		peer->incomingDataTotal = 0;
-		peer->totalDataReceived = 0;
-		peer->outgoingDataTotal = 0;
-		peer->totalDataSent = 0;
-		peer->lastSendTime = 0;
-		peer->lastReceiveTime = 0;
-		peer->nextTimeout = 0;
-		peer->earliestTimeout = 0;
-		peer->totalPacketsSent = 0;
-		peer->totalPacketsLost = 0;
-		peer->packetThrottle = ENET_PEER_DEFAULT_PACKET_THROTTLE;
-		peer->packetThrottleThreshold = ENET_PEER_PACKET_THROTTLE_THRESHOLD;
-		peer->packetThrottleLimit = ENET_PEER_PACKET_THROTTLE_SCALE;
-		peer->packetThrottleCounter = 0;
-		peer->packetThrottleEpoch = 0;
-		peer->packetThrottleAcceleration = ENET_PEER_PACKET_THROTTLE_ACCELERATION;
-		peer->packetThrottleDeceleration = ENET_PEER_PACKET_THROTTLE_DECELERATION;
-		peer->packetThrottleInterval = ENET_PEER_PACKET_THROTTLE_INTERVAL;
-		peer->pingInterval = ENET_PEER_PING_INTERVAL;
-		peer->timeoutLimit = ENET_PEER_TIMEOUT_LIMIT;
-		peer->timeoutMinimum = ENET_PEER_TIMEOUT_MINIMUM;
-		peer->timeoutMaximum = ENET_PEER_TIMEOUT_MAXIMUM;
-		peer->lastRoundTripTime = ENET_PEER_DEFAULT_ROUND_TRIP_TIME;
-		peer->lowestRoundTripTime = ENET_PEER_DEFAULT_ROUND_TRIP_TIME;
-		peer->lastRoundTripTimeVariance = 0;
-		peer->highestRoundTripTimeVariance = 0;
-		peer->roundTripTime = 1;
-		peer->roundTripTimeVariance = 0;
-		peer->mtu = peer->host->mtu;
-		peer->reliableDataInTransit = 0;
-		peer->outgoingReliableSequenceNumber = 0;
-		peer->windowSize = ENET_PROTOCOL_MAXIMUM_WINDOW_SIZE;
-		peer->incomingUnsequencedGroup = 0;
-		peer->outgoingUnsequencedGroup = 0;
-		peer->eventData = 0;
-		peer->totalWaitingData = 0;
+		host->channelLimit = channelLimit;
+	}
+
+	void enet_host_bandwidth_limit(ENetHost* host, uint32_t incomingBandwidth, uint32_t outgoingBandwidth) {
+		host->incomingBandwidth = incomingBandwidth;
+		host->outgoingBandwidth = outgoingBandwidth;
+		host->recalculateBandwidthLimits = 1;
+	}
+
+	/* Safe to call from any thread, the packet is handed over to the thread servicing the host on its next service or flush, a NULL peer broadcasts */
+	int enet_host_post(ENetHost* host, ENetPeer* peer, uint8_t channelID, ENetPacket* packet) {
+		ENetHostMessage* message = (ENetHostMessage*)enet_malloc(sizeof(ENetHostMessage));
+		ENetHostMessage* head;
+
+		if (message == NULL)
+			return -1;
+
+		message->peer = peer;
+		message->packet = packet;
+		message->channelID = channelID;
+
+		do {
+			head = (ENetHostMessage*)ENET_ATOMIC_READ(&host->postedMessages);
+			message->next = head;
+		}
+
+		while (ENET_ATOMIC_CAS(&host->postedMessages, head, message) != head);
+
+		return 0;
+	}
+
+	ENetHostGroup* enet_host_group_create(const ENetAddress* address, size_t hostCount, size_t peerCount, size_t channelLimit, uint32_t incomingBandwidth, uint32_t outgoingBandwidth, int bufferSize, const ENetHostOptions* options) {
+		ENetHostGroup* group;
+		ENetHostOptions groupOptions;
+		ENetAddress groupAddress;
+
+		if (address == NULL || hostCount < 1)
+			return NULL;
+
+		group = (ENetHostGroup*)enet_malloc(sizeof(ENetHostGroup));
+
+		if (group == NULL)
+			return NULL;
+
+		group->hosts = (ENetHost**)enet_malloc(hostCount * sizeof(ENetHost*));
+
+		if (group->hosts == NULL) {
+			enet_free(group);
+
+			return NULL;
+		}
+
+		if (options != NULL)
+			groupOptions = *options;
+		else
+			memset(&groupOptions, 0, sizeof(ENetHostOptions));
+
+		groupOptions.reusePort = 1;
+		groupAddress = *address;
+
+		/* Every host binds the same port, the kernel spreads clients over the sockets by their address and keeps each one on the same host */
+		for (group->hostCount = 0; group->hostCount < hostCount; ++group->hostCount) {
+			ENetHost* host = enet_host_create_with_options(&groupAddress, peerCount, channelLimit, incomingBandwidth, outgoingBandwidth, bufferSize, &groupOptions);
+
+			if (host == NULL) {
+				enet_host_group_destroy(group);
+
+				return NULL;
+			}
 
-		memset(peer->unsequencedWindow, 0, sizeof(peer->unsequencedWindow));
+			group->hosts[group->hostCount] = host;
+			groupAddress.port = host->address.port;
+		}
 
-		enet_peer_reset_queues(peer);
+		return group;
 	}
 
-	void enet_peer_ping(ENetPeer* peer) {
-		ENetProtocol command;
+	void enet_host_group_destroy(ENetHostGroup* group) {
+		size_t i;
 
-		if (peer->state != ENET_PEER_STATE_CONNECTED)
+		if (group == NULL)
 			return;
 
-		command.header.command = ENET_PROTOCOL_COMMAND_PING | ENET_PROTOCOL_COMMAND_FLAG_ACKNOWLEDGE;
-		command.header.channelID = 0xFF;
-
-		enet_peer_queue_outgoing_command(peer, &command, NULL, 0, 0);
-	}
+		for (i = 0; i < group->hostCount; ++i) {
+			enet_host_destroy(group->hosts[i]);
+		}
 
-	void enet_peer_ping_interval(ENetPeer* peer, uint32_t pingInterval) {
-		peer->pingInterval = pingInterval ? pingInterval : ENET_PEER_PING_INTERVAL;
+		enet_free(group->hosts);
+		enet_free(group);
 	}
 
-	void enet_peer_timeout(ENetPeer* peer, uint32_t timeoutLimit, uint32_t timeoutMinimum, uint32_t timeoutMaximum) {
-		peer->timeoutLimit = timeoutLimit ? timeoutLimit : ENET_PEER_TIMEOUT_LIMIT;
-		peer->timeoutMinimum = timeoutMinimum ? timeoutMinimum : ENET_PEER_TIMEOUT_MINIMUM;
-		peer->timeoutMaximum = timeoutMaximum ? timeoutMaximum : ENET_PEER_TIMEOUT_MAXIMUM;
-	}
+	/* Broadcasts directly on the calling thread's own host and posts a copy of the packet to every other host, origin may be NULL when the caller services none of them */
+	int enet_host_group_broadcast(ENetHostGroup* group, ENetHost* origin, uint8_t channelID, ENetPacket* packet) {
+		int result = 0;
+		size_t i;
 
-	void enet_peer_disconnect_now(ENetPeer* peer, uint32_t data) {
-		ENetProtocol command;
+		for (i = 0; i < group->hostCount; ++i) {
+			ENetPacket* copy;
 
-		if (peer->state == ENET_PEER_STATE_DISCONNECTED)
-			return;
+			if (group->hosts[i] == origin)
+				continue;
 
-		if (peer->state != ENET_PEER_STATE_ZOMBIE && peer->state != ENET_PEER_STATE_DISCONNECTING) {
-			enet_peer_reset_queues(peer);
+			copy = enet_packet_create(packet->data, packet->dataLength, packet->flags & ~ENET_PACKET_FLAG_NO_ALLOCATE);
 
-			command.header.command = ENET_PROTOCOL_COMMAND_DISCONNECT | ENET_PROTOCOL_COMMAND_FLAG_UNSEQUENCED;
-			command.header.channelID = 0xFF;
-			command.disconnect.data = ENET_HOST_TO_NET_32(data);
+			if (copy == NULL || enet_host_post(group->hosts[i], NULL, channelID, copy) < 0) {
+				if (copy != NULL)
+					enet_packet_destroy(copy);
 
-			enet_peer_queue_outgoing_command(peer, &command, NULL, 0, 0);
-			enet_host_flush(peer->host);
+				result = -1;
+			}
 		}
 
-		enet_peer_reset(peer);
+		if (origin != NULL)
+			enet_host_broadcast(origin, channelID, packet);
+		else if (packet->referenceCount == 0)
+			enet_packet_destroy(packet);
+
+		return result;
 	}
 
-	void enet_peer_disconnect(ENetPeer* peer, uint32_t data) {
+	void enet_host_bandwidth_throttle(ENetHost* host) {
+		uint32_t timeCurrent = enet_time_get();
+		uint32_t elapsedTime = timeCurrent - host->bandwidthThrottleEpoch;
+		uint32_t peersRemaining = (uint32_t)host->connectedPeers;
+		uint32_t dataTotal = ~0;
+		uint32_t bandwidth = ~0;
+		uint32_t throttle = 0;
+		uint32_t bandwidthLimit = 0;
+
+		int needsAdjustment = host->bandwidthLimitedPeers > 0 ? 1 : 0;
+		ENetPeer* peer, **activePeer;
 		ENetProtocol command;
 
-		if (peer->state == ENET_PEER_STATE_DISCONNECTING || peer->state == ENET_PEER_STATE_DISCONNECTED || peer->state == ENET_PEER_STATE_ACKNOWLEDGING_DISCONNECT || peer->state == ENET_PEER_STATE_ZOMBIE)
+		if (elapsedTime < ENET_HOST_BANDWIDTH_THROTTLE_INTERVAL)
 			return;
 
-		enet_peer_reset_queues(peer);
+		if (host->outgoingBandwidth == 0 && host->incomingBandwidth == 0)
+			return;
 
-		command.header.command = ENET_PROTOCOL_COMMAND_DISCONNECT;
-		command.header.channelID = 0xFF;
-		command.disconnect.data = ENET_HOST_TO_NET_32(data);
+		host->bandwidthThrottleEpoch = timeCurrent;
 
-		if (peer->state == ENET_PEER_STATE_CONNECTED || peer->state == ENET_PEER_STATE_DISCONNECT_LATER)
-			command.header.command |= ENET_PROTOCOL_COMMAND_FLAG_ACKNOWLEDGE;
-		else
-			command.header.command |= ENET_PROTOCOL_COMMAND_FLAG_UNSEQUENCED;
+		if (peersRemaining == 0)
+			return;
 
-		enet_peer_queue_outgoing_command(peer, &command, NULL, 0, 0);
+		if (host->outgoingBandwidth != 0) {
+			dataTotal = 0;
+			bandwidth = (host->outgoingBandwidth * elapsedTime) / 1000;
 
-		if (peer->state == ENET_PEER_STATE_CONNECTED || peer->state == ENET_PEER_STATE_DISCONNECT_LATER) {
-			enet_peer_on_disconnect(peer);
+			for (activePeer = host->activePeers; activePeer < &host->activePeers[host->activePeerCount]; ++activePeer) {
+				peer = *activePeer;
 
-			peer->state = ENET_PEER_STATE_DISCONNECTING;
-		} else {
-			enet_host_flush(peer->host);
-			enet_peer_reset(peer);
-		}
-	}
+				if (peer->state != ENET_PEER_STATE_CONNECTED && peer->state != ENET_PEER_STATE_DISCONNECT_LATER)
+					continue;
 
-	void enet_peer_disconnect_later(ENetPeer* peer, uint32_t data) {
-		if ((peer->state == ENET_PEER_STATE_CONNECTED || peer->state == ENET_PEER_STATE_DISCONNECT_LATER) && enet_peer_has_outgoing_commands(peer)) {
-			peer->state = ENET_PEER_STATE_DISCONNECT_LATER;
-			peer->eventData = data;
-		} else {
-			enet_peer_disconnect(peer, data);
+				dataTotal += peer->outgoingDataTotal;
+			}
 		}
-	}
 
-	ENetAcknowledgement* enet_peer_queue_acknowledgement(ENetPeer* peer, const ENetProtocol* command, uint16_t sentTime) {
-		ENetAcknowledgement* acknowledgement;
+		while (peersRemaining > 0 && needsAdjustment != 0) {
+			needsAdjustment = 0;
 
-		if (command->header.channelID < peer->channelCount) {
-			ENetChannel* channel = &peer->channels[command->header.channelID];
-			uint16_t reliableWindow = command->header.reliableSequenceNumber / ENET_PEER_RELIABLE_WINDOW_SIZE;
-			uint16_t currentWindow = channel->incomingReliableSequenceNumber / ENET_PEER_RELIABLE_WINDOW_SIZE;
+			if (dataTotal <= bandwidth)
+				throttle = ENET_PEER_PACKET_THROTTLE_SCALE;
+			else
+				throttle = (bandwidth * ENET_PEER_PACKET_THROTTLE_SCALE) / dataTotal;
 
-			if (command->header.reliableSequenceNumber < channel->incomingReliableSequenceNumber)
-				reliableWindow += ENET_PEER_RELIABLE_WINDOWS;
+			for (activePeer = host->activePeers; activePeer < &host->activePeers[host->activePeerCount]; ++activePeer) {
+				uint32_t peerBandwidth;
 
-			if (reliableWindow >= currentWindow + ENET_PEER_FREE_RELIABLE_WINDOWS - 1 && reliableWindow <= currentWindow + ENET_PEER_FREE_RELIABLE_WINDOWS)
-				return NULL;
-		}
+				peer = *activePeer;
 
-		acknowledgement = (ENetAcknowledgement*)enet_malloc(sizeof(ENetAcknowledgement));
+				if ((peer->state != ENET_PEER_STATE_CONNECTED && peer->state != ENET_PEER_STATE_DISCONNECT_LATER) || peer->incomingBandwidth == 0 || peer->outgoingBandwidthThrottleEpoch == timeCurrent)
+					continue;
 
-		if (acknowledgement == NULL)
-			return NULL;
+				peerBandwidth = (peer->incomingBandwidth * elapsedTime) / 1000;
 
-		peer->outgoingDataTotal += sizeof(ENetProtocolAcknowledge);
-		acknowledgement->sentTime = sentTime;
-		acknowledgement->command = *command;
+				if ((throttle * peer->outgoingDataTotal) / ENET_PEER_PACKET_THROTTLE_SCALE <= peerBandwidth)
+					continue;
 
-		enet_list_insert(enet_list_end(&peer->acknowledgements), acknowledgement);
+				peer->packetThrottleLimit = (peerBandwidth * ENET_PEER_PACKET_THROTTLE_SCALE) / peer->outgoingDataTotal;
 
-		return acknowledgement;
-	}
+				if (peer->packetThrottleLimit == 0)
+					peer->packetThrottleLimit = 1;
 
-	void enet_peer_setup_outgoing_command(ENetPeer* peer, ENetOutgoingCommand* outgoingCommand) {
-		ENetChannel *channel = NULL;
+				if (peer->packetThrottle > peer->packetThrottleLimit)
+					peer->packetThrottle = peer->packetThrottleLimit;
 
-		if (outgoingCommand->command.header.channelID < peer->channelCount)
-		{
-			channel = &peer->channels[outgoingCommand->command.header.channelID];
+				peer->outgoingBandwidthThrottleEpoch = timeCurrent;
+				peer->incomingDataTotal = 0;
+				peer->outgoingDataTotal = 0;
+				needsAdjustment = 1;
+				--peersRemaining;
+				bandwidth -= peerBandwidth;
+				dataTotal -= peerBandwidth;
+			}
 		}
 
-		peer->outgoingDataTotal += enet_protocol_command_size(outgoingCommand->command.header.command) + outgoingCommand->fragmentLength;
+		if (peersRemaining > 0) {
+			if (dataTotal <= bandwidth)
+				throttle = ENET_PEER_PACKET_THROTTLE_SCALE;
+			else
+				throttle = (bandwidth * ENET_PEER_PACKET_THROTTLE_SCALE) / dataTotal;
 
-		if (outgoingCommand->command.header.channelID == 0xFF) {
-			++peer->outgoingReliableSequenceNumber;
-			outgoingCommand->reliableSequenceNumber = peer->outgoingReliableSequenceNumber;
-			outgoingCommand->unreliableSequenceNumber = 0;
-		} else if (outgoingCommand->command.header.command & ENET_PROTOCOL_COMMAND_FLAG_ACKNOWLEDGE) {
-			++channel->outgoingReliableSequenceNumber;
-			channel->outgoingUnreliableSequenceNumber = 0;
-			outgoingCommand->reliableSequenceNumber = channel->outgoingReliableSequenceNumber;
-			outgoingCommand->unreliableSequenceNumber = 0;
-		} else if (outgoingCommand->command.header.command & ENET_PROTOCOL_COMMAND_FLAG_UNSEQUENCED) {
-			++peer->outgoingUnsequencedGroup;
-			outgoingCommand->reliableSequenceNumber = 0;
-			outgoingCommand->unreliableSequenceNumber = 0;
-		} else {
-			if (outgoingCommand->fragmentOffset == 0)
-				++channel->outgoingUnreliableSequenceNumber;
+			for (activePeer = host->activePeers; activePeer < &host->activePeers[host->activePeerCount]; ++activePeer) {
+				peer = *activePeer;
 
-			outgoingCommand->reliableSequenceNumber = channel->outgoingReliableSequenceNumber;
-			outgoingCommand->unreliableSequenceNumber = channel->outgoingUnreliableSequenceNumber;
+				if ((peer->state != ENET_PEER_STATE_CONNECTED && peer->state != ENET_PEER_STATE_DISCONNECT_LATER) || peer->outgoingBandwidthThrottleEpoch == timeCurrent)
+					continue;
+
+				peer->packetThrottleLimit = throttle;
+
+				if (peer->packetThrottle > peer->packetThrottleLimit)
+					peer->packetThrottle = peer->packetThrottleLimit;
+
+				peer->incomingDataTotal = 0;
+				peer->outgoingDataTotal = 0;
+			}
 		}
 
-		outgoingCommand->sendAttempts = 0;
-		outgoingCommand->sentTime = 0;
-		outgoingCommand->roundTripTimeout = 0;
-		outgoingCommand->command.header.reliableSequenceNumber = ENET_HOST_TO_NET_16(outgoingCommand->reliableSequenceNumber);
-		outgoingCommand->queueTime = ++peer->host->totalQueued;
+		if (host->recalculateBandwidthLimits) {
+			host->recalculateBandwidthLimits = 0;
+			peersRemaining = (uint32_t)host->connectedPeers;
+			bandwidth = host->incomingBandwidth;
+			needsAdjustment = 1;
 
-		switch (outgoingCommand->command.header.command & ENET_PROTOCOL_COMMAND_MASK) {
-			case ENET_PROTOCOL_COMMAND_SEND_UNRELIABLE:
-				outgoingCommand->command.sendUnreliable.unreliableSequenceNumber = ENET_HOST_TO_NET_16(outgoingCommand->unreliableSequenceNumber);
+			if (bandwidth == 0) {
+				bandwidthLimit = 0;
+			} else {
+				while (peersRemaining > 0 && needsAdjustment != 0) {
+					needsAdjustment = 0;
+					bandwidthLimit = bandwidth / peersRemaining;
 
-				break;
+					for (activePeer = host->activePeers; activePeer < &host->activePeers[host->activePeerCount]; ++activePeer) {
+						peer = *activePeer;
 
-			case ENET_PROTOCOL_COMMAND_SEND_UNSEQUENCED:
-				outgoingCommand->command.sendUnsequenced.unsequencedGroup = ENET_HOST_TO_NET_16(peer->outgoingUnsequencedGroup);
+						if ((peer->state != ENET_PEER_STATE_CONNECTED && peer->state != ENET_PEER_STATE_DISCONNECT_LATER) || peer->incomingBandwidthThrottleEpoch == timeCurrent)
+							continue;
 
-				break;
+						if (peer->outgoingBandwidth > 0 && peer->outgoingBandwidth >= bandwidthLimit)
+							continue;
 
-			default:
-				break;
-		}
+						peer->incomingBandwidthThrottleEpoch = timeCurrent;
+						needsAdjustment = 1;
+						--peersRemaining;
+						bandwidth -= peer->outgoingBandwidth;
+					}
+				}
+			}
 
-		if ((outgoingCommand->command.header.command & ENET_PROTOCOL_COMMAND_FLAG_ACKNOWLEDGE) != 0 && outgoingCommand->packet != NULL)
-			enet_list_insert(enet_list_end(&peer->outgoingSendReliableCommands), outgoingCommand);
-		else
-			enet_list_insert(enet_list_end(&peer->outgoingCommands), outgoingCommand);
+			for (activePeer = host->activePeers; activePeer < &host->activePeers[host->activePeerCount]; ++activePeer) {
+				peer = *activePeer;
+
+				if (peer->state != ENET_PEER_STATE_CONNECTED && peer->state != ENET_PEER_STATE_DISCONNECT_LATER)
+					continue;
+
+				command.header.command = ENET_PROTOCOL_COMMAND_BANDWIDTH_LIMIT | ENET_PROTOCOL_COMMAND_FLAG_ACKNOWLEDGE;
+				command.header.channelID = 0xFF;
+				command.bandwidthLimit.outgoingBandwidth = ENET_HOST_TO_NET_32(host->outgoingBandwidth);
+
+				if (peer->incomingBandwidthThrottleEpoch == timeCurrent)
+					command.bandwidthLimit.incomingBandwidth = ENET_HOST_TO_NET_32(peer->outgoingBandwidth);
+				else
+					command.bandwidthLimit.incomingBandwidth = ENET_HOST_TO_NET_32(bandwidthLimit);
+
+				enet_peer_queue_outgoing_command(peer, &command, NULL, 0, 0);
+			}
+		}
 	}
 
-	ENetOutgoingCommand* enet_peer_queue_outgoing_command(ENetPeer* peer, const ENetProtocol* command, ENetPacket* packet, uint32_t offset, uint16_t length) {
-		ENetOutgoingCommand* outgoingCommand = (ENetOutgoingCommand*)enet_malloc(sizeof(ENetOutgoingCommand));
+/*
+=======================================================================
 
-		if (outgoingCommand == NULL)
-			return NULL;
+	Address
 
-		outgoingCommand->command = *command;
-		outgoingCommand->fragmentOffset = offset;
-		outgoingCommand->fragmentLength = length;
-		outgoingCommand->packet = packet;
+=======================================================================
+*/
 
-		if (packet != NULL)
-			++packet->referenceCount;
+	int enet_address_set_ip(ENetAddress* address, const char* ip) {
+		int type = AF_INET6;
+		void* destination = &address->ipv6;
 
-		enet_peer_setup_outgoing_command(peer, outgoingCommand);
+		if (strchr(ip, ':') == NULL) {
+			type = AF_INET;
 
-		return outgoingCommand;
-	}
+			memset(address, 0, sizeof(address->ipv4.zeros));
 
-	void enet_peer_dispatch_incoming_unreliable_commands(ENetPeer* peer, ENetChannel* channel, ENetIncomingCommand* queuedCommand) {
-		ENetListIterator droppedCommand, startCommand, currentCommand;
+			address->ipv4.ffff = 0xFFFF;
+			destination = &address->ipv4.ip;
+		}
 
-		for (droppedCommand = startCommand = currentCommand = enet_list_begin(&channel->incomingUnreliableCommands); currentCommand != enet_list_end(&channel->incomingUnreliableCommands); currentCommand = enet_list_next(currentCommand)) {
-			ENetIncomingCommand* incomingCommand = (ENetIncomingCommand*)currentCommand;
+		if (!inet_pton(type, ip, destination))
+			return -1;
 
-			if ((incomingCommand->command.header.command & ENET_PROTOCOL_COMMAND_MASK) == ENET_PROTOCOL_COMMAND_SEND_UNSEQUENCED)
-				continue;
+		return 0;
+	}
 
-			if (incomingCommand->reliableSequenceNumber == channel->incomingReliableSequenceNumber) {
-				if (incomingCommand->fragmentsRemaining <= 0) {
-					channel->incomingUnreliableSequenceNumber = incomingCommand->unreliableSequenceNumber;
+	int enet_address_set_hostname(ENetAddress* address, const char* name) {
+		struct addrinfo hints, *resultList = NULL, *result = NULL;
 
-					continue;
-				}
+		memset(&hints, 0, sizeof(hints));
 
-				if (startCommand != currentCommand) {
-					enet_list_move(enet_list_end(&peer->dispatchedCommands), startCommand, enet_list_previous(currentCommand));
+		hints.ai_family = AF_UNSPEC;
 
-					if (!peer->needsDispatch) {
-						enet_list_insert(enet_list_end(&peer->host->dispatchQueue), &peer->dispatchList);
+		if (getaddrinfo(name, NULL, &hints, &resultList) != 0)
+			return -1;
 
-						peer->needsDispatch = 1;
-					}
+		for (result = resultList; result != NULL; result = result->ai_next) {
+			if (result->ai_addr != NULL && result->ai_addrlen >= sizeof(struct sockaddr_in)) {
+				if (result->ai_family == AF_INET) {
+					struct sockaddr_in* sin = (struct sockaddr_in*)result->ai_addr;
 
-					droppedCommand = currentCommand;
-				} else if (droppedCommand != currentCommand) {
-					droppedCommand = enet_list_previous(currentCommand);
-				}
-			} else {
-				uint16_t reliableWindow = incomingCommand->reliableSequenceNumber / ENET_PEER_RELIABLE_WINDOW_SIZE;
-				uint16_t currentWindow = channel->incomingReliableSequenceNumber / ENET_PEER_RELIABLE_WINDOW_SIZE;
+					memset(address, 0, sizeof(address->ipv4.zeros));
 
-				if (incomingCommand->reliableSequenceNumber < channel->incomingReliableSequenceNumber)
-					reliableWindow += ENET_PEER_RELIABLE_WINDOWS;
+					address->ipv4.ffff = 0xFFFF;
+					address->ipv4.ip.s_addr = sin->sin_addr.s_addr;
 
-				if (reliableWindow >= currentWindow && reliableWindow < currentWindow + ENET_PEER_FREE_RELIABLE_WINDOWS - 1)
-					break;
+					freeaddrinfo(resultList);
 
-				droppedCommand = enet_list_next(currentCommand);
+					return 0;
+				} else if (result->ai_family == AF_INET6) {
+					struct sockaddr_in6* sin = (struct sockaddr_in6*)result->ai_addr;
 
-				if (startCommand != currentCommand) {
-					enet_list_move(enet_list_end(&peer->dispatchedCommands), startCommand, enet_list_previous(currentCommand));
+					address->ipv6 = sin->sin6_addr;
 
-					if (!peer->needsDispatch) {
-						enet_list_insert(enet_list_end(&peer->host->dispatchQueue), &peer->dispatchList);
+					freeaddrinfo(resultList);
 
-						peer->needsDispatch = 1;
-					}
+					return 0;
 				}
 			}
-
-			startCommand = enet_list_next(currentCommand);
 		}
 
-		if (startCommand != currentCommand) {
-			enet_list_move(enet_list_end(&peer->dispatchedCommands), startCommand, enet_list_previous(currentCommand));
-
-			if (!peer->needsDispatch) {
-				enet_list_insert(enet_list_end(&peer->host->dispatchQueue), &peer->dispatchList);
+		if (resultList != NULL)
+			freeaddrinfo(resultList);
 
-				peer->needsDispatch = 1;
-			}
+		return enet_address_set_ip(address, name);
+	}
 
-			droppedCommand = currentCommand;
+	int enet_address_get_ip(const ENetAddress* address, char* ip, size_t ipLength) {
+		if (address->ipv4.ffff == 0xFFFF && enet_array_is_zeroed(address->ipv4.zeros, sizeof(address->ipv4.zeros)) == 0) {
+			if (inet_ntop(AF_INET, &address->ipv4.ip, ip, ipLength) == NULL)
+				return -1;
+		} else if (inet_ntop(AF_INET6, &address->ipv6, ip, ipLength) == NULL) {
+			return -1;
 		}
 
-		enet_peer_remove_incoming_commands(&channel->incomingUnreliableCommands, enet_list_begin(&channel->incomingUnreliableCommands), droppedCommand, queuedCommand);
+		return 0;
 	}
 
-	void enet_peer_dispatch_incoming_reliable_commands(ENetPeer* peer, ENetChannel* channel, ENetIncomingCommand* queuedCommand) {
-		ENetListIterator currentCommand;
+	int enet_address_get_hostname(const ENetAddress* address, char* name, size_t nameLength) {
+		struct sockaddr_in6 sin;
+		int err;
 
-		for (currentCommand = enet_list_begin(&channel->incomingReliableCommands); currentCommand != enet_list_end(&channel->incomingReliableCommands); currentCommand = enet_list_next(currentCommand)) {
-			ENetIncomingCommand* incomingCommand = (ENetIncomingCommand*)currentCommand;
+		memset(&sin, 0, sizeof(struct sockaddr_in6));
 
-			if (incomingCommand->fragmentsRemaining > 0 || incomingCommand->reliableSequenceNumber != (uint16_t)(channel->incomingReliableSequenceNumber + 1))
-				break;
+		sin.sin6_family = AF_INET6;
+		sin.sin6_port = ENET_HOST_TO_NET_16(address->port);
+		sin.sin6_addr = address->ipv6;
 
-			channel->incomingReliableSequenceNumber = incomingCommand->reliableSequenceNumber;
+		err = getnameinfo((struct sockaddr*)&sin, sizeof(sin), name, nameLength, NULL, 0, NI_NAMEREQD);
 
-			if (incomingCommand->fragmentCount > 0)
-				channel->incomingReliableSequenceNumber += incomingCommand->fragmentCount - 1;
-		}
+		if (!err) {
+			if (name != NULL && nameLength > 0 && !memchr(name, '\0', nameLength))
+				return -1;
 
-		if (currentCommand == enet_list_begin(&channel->incomingReliableCommands))
-			return;
+			return 0;
+		}
 
-		channel->incomingUnreliableSequenceNumber = 0;
+		if (err != EAI_NONAME)
+			return -1;
 
-		enet_list_move(enet_list_end(&peer->dispatchedCommands), enet_list_begin(&channel->incomingReliableCommands), enet_list_previous(currentCommand));
+		return enet_address_get_ip(address, name, nameLength);
+	}
 
-		if (!peer->needsDispatch) {
-			enet_list_insert(enet_list_end(&peer->host->dispatchQueue), &peer->dispatchList);
+/*
+=======================================================================
 
-			peer->needsDispatch = 1;
-		}
+	Platform-specific (Unix)
 
-		if (!enet_list_empty(&channel->incomingUnreliableCommands))
-			enet_peer_dispatch_incoming_unreliable_commands(peer, channel, queuedCommand);
-	}
+=======================================================================
+*/
 
-	ENetIncomingCommand* enet_peer_queue_incoming_command(ENetPeer* peer, const ENetProtocol* command, const void* data, size_t dataLength, uint32_t flags, uint32_t fragmentCount) {
-		static ENetIncomingCommand dummyCommand;
+	#ifndef _WIN32
+		int enet_initialize(void) {
+			enet_crc64_initialize();
+			enet_crc32c_initialize();
 
-		ENetChannel* channel = &peer->channels[command->header.channelID];
-		uint32_t unreliableSequenceNumber = 0, reliableSequenceNumber = 0;
-		uint16_t reliableWindow, currentWindow;
-		ENetIncomingCommand* incomingCommand;
-		ENetListIterator currentCommand;
-		ENetPacket* packet = NULL;
+			return 0;
+		}
 
-		if (peer->state == ENET_PEER_STATE_DISCONNECT_LATER)
-			goto discardCommand;
+		void enet_deinitialize(void) {
+			enet_packet_pool_clear();
+		}
 
-		if ((command->header.command & ENET_PROTOCOL_COMMAND_MASK) != ENET_PROTOCOL_COMMAND_SEND_UNSEQUENCED) {
-			reliableSequenceNumber = command->header.reliableSequenceNumber;
-			reliableWindow = reliableSequenceNumber / ENET_PEER_RELIABLE_WINDOW_SIZE;
-			currentWindow = channel->incomingReliableSequenceNumber / ENET_PEER_RELIABLE_WINDOW_SIZE;
+		uint64_t enet_host_random_seed(void) {
+			struct timeval timeVal;
 
-			if (reliableSequenceNumber < channel->incomingReliableSequenceNumber)
-				reliableWindow += ENET_PEER_RELIABLE_WINDOWS;
+			gettimeofday(&timeVal, NULL);
 
-			if (reliableWindow < currentWindow || reliableWindow >= currentWindow + ENET_PEER_FREE_RELIABLE_WINDOWS - 1)
-				goto discardCommand;
+			return (timeVal.tv_sec * 1000) ^ (timeVal.tv_usec / 1000);
 		}
 
-		switch (command->header.command & ENET_PROTOCOL_COMMAND_MASK) {
-			case ENET_PROTOCOL_COMMAND_SEND_FRAGMENT:
-			case ENET_PROTOCOL_COMMAND_SEND_RELIABLE:
-				if (reliableSequenceNumber == channel->incomingReliableSequenceNumber)
-					goto discardCommand;
+		int enet_random_bytes(void* data, size_t dataLength) {
+			uint8_t* position = (uint8_t*)data;
+			int result = 0, descriptor = open("/dev/urandom", O_RDONLY);
 
-				for (currentCommand = enet_list_previous(enet_list_end(&channel->incomingReliableCommands)); currentCommand != enet_list_end(&channel->incomingReliableCommands); currentCommand = enet_list_previous(currentCommand)) {
-					incomingCommand = (ENetIncomingCommand*)currentCommand;
+			if (descriptor < 0)
+				return -1;
 
-					if (reliableSequenceNumber >= channel->incomingReliableSequenceNumber) {
-						if (incomingCommand->reliableSequenceNumber < channel->incomingReliableSequenceNumber)
-							continue;
-					} else if (incomingCommand->reliableSequenceNumber >= channel->incomingReliableSequenceNumber) {
-						break;
-					}
+			while (dataLength > 0) {
+				ssize_t readLength = read(descriptor, position, dataLength);
 
-					if (incomingCommand->reliableSequenceNumber <= reliableSequenceNumber) {
-						if (incomingCommand->reliableSequenceNumber < reliableSequenceNumber)
-							break;
+				if (readLength <= 0) {
+					if (readLength < 0 && errno == EINTR)
+						continue;
 
-						goto discardCommand;
-					}
+					result = -1;
+
+					break;
 				}
 
-				break;
+				position += readLength;
+				dataLength -= (size_t)readLength;
+			}
 
-			case ENET_PROTOCOL_COMMAND_SEND_UNRELIABLE:
-			case ENET_PROTOCOL_COMMAND_SEND_UNRELIABLE_FRAGMENT:
-				unreliableSequenceNumber = ENET_NET_TO_HOST_16(command->sendUnreliable.unreliableSequenceNumber);
+			close(descriptor);
 
-				if (reliableSequenceNumber == channel->incomingReliableSequenceNumber && unreliableSequenceNumber <= channel->incomingUnreliableSequenceNumber)
-					goto discardCommand;
+			return result;
+		}
 
-				for (currentCommand = enet_list_previous(enet_list_end(&channel->incomingUnreliableCommands)); currentCommand != enet_list_end(&channel->incomingUnreliableCommands); currentCommand = enet_list_previous(currentCommand)) {
-					incomingCommand = (ENetIncomingCommand*)currentCommand;
+		int enet_socket_bind(ENetSocket socket, const ENetAddress* address) {
+			struct sockaddr_in6 sin;
 
-					if ((command->header.command & ENET_PROTOCOL_COMMAND_MASK) == ENET_PROTOCOL_COMMAND_SEND_UNSEQUENCED)
-						continue;
+			memset(&sin, 0, sizeof(struct sockaddr_in6));
 
-					if (reliableSequenceNumber >= channel->incomingReliableSequenceNumber) {
-						if (incomingCommand->reliableSequenceNumber < channel->incomingReliableSequenceNumber)
-							continue;
-					} else if (incomingCommand->reliableSequenceNumber >= channel->incomingReliableSequenceNumber) {
-						break;
-					}
+			sin.sin6_family = AF_INET6;
 
-					if (incomingCommand->reliableSequenceNumber < reliableSequenceNumber)
-						break;
+			if (address != NULL) {
+				sin.sin6_port = ENET_HOST_TO_NET_16(address->port);
+				sin.sin6_addr = address->ipv6;
+			} else {
+				sin.sin6_port = 0;
+				sin.sin6_addr = ENET_HOST_ANY;
+			}
 
-					if (incomingCommand->reliableSequenceNumber > reliableSequenceNumber)
-						continue;
+			return bind(socket, (struct sockaddr*)&sin, sizeof(struct sockaddr_in6));
+		}
 
-					if (incomingCommand->unreliableSequenceNumber <= unreliableSequenceNumber) {
-						if (incomingCommand->unreliableSequenceNumber < unreliableSequenceNumber)
-							break;
+		int enet_socket_get_address(ENetSocket socket, ENetAddress* address) {
+			struct sockaddr_storage ss;
+			socklen_t saLength = sizeof(ss);
 
-						goto discardCommand;
-					}
-				}
+			if (getsockname(socket, (struct sockaddr*)&ss, &saLength) == -1)
+				return -1;
 
-				break;
+			if (ss.ss_family == AF_INET) {
+				struct sockaddr_in* sin = (struct sockaddr_in*)&ss;
 
-			case ENET_PROTOCOL_COMMAND_SEND_UNSEQUENCED:
-				currentCommand = enet_list_end(&channel->incomingUnreliableCommands);
+				memset(address, 0, sizeof(address->ipv4.zeros));
 
-				break;
+				address->ipv4.ffff = 0xFFFF;
+				address->ipv4.ip = sin->sin_addr;
+				address->port = ENET_NET_TO_HOST_16(sin->sin_port);
+			} else if (ss.ss_family == AF_INET6) {
+				struct sockaddr_in6* sin = (struct sockaddr_in6*)&ss;
 
-			default:
-				goto discardCommand;
+				address->ipv6 = sin->sin6_addr;
+				address->port = ENET_NET_TO_HOST_16(sin->sin6_port);
+			}
+
+			return 0;
 		}
 
-		if (peer->totalWaitingData >= peer->host->maximumWaitingData)
-			goto notifyError;
+		int enet_socket_listen(ENetSocket socket, int backlog) {
+			return listen(socket, backlog < 0 ? SOMAXCONN : backlog);
+		}
 
-		packet = enet_packet_create(data, dataLength, flags);
+		ENetSocket enet_socket_create(ENetSocketType type) {
+			int socketType = (type == ENET_SOCKET_TYPE_DATAGRAM ? SOCK_DGRAM : SOCK_STREAM);
 
-		if (packet == NULL)
-			goto notifyError;
+			#ifdef SOCK_CLOEXEC
+				socketType |= SOCK_CLOEXEC;
+			#endif
+
+			return socket(PF_INET6, socketType, 0);
+		}
+
+		int enet_socket_set_option(ENetSocket socket, ENetSocketOption option, int value) {
+			int result = -1;
 
-		incomingCommand = (ENetIncomingCommand*)enet_malloc(sizeof(ENetIncomingCommand));
+			switch (option) {
+				case ENET_SOCKOPT_NONBLOCK:
+					result = fcntl(socket, F_SETFL, (value ? O_NONBLOCK : 0) | (fcntl(socket, F_GETFL) & ~O_NONBLOCK));
+
+					break;
+
+				case ENET_SOCKOPT_BROADCAST:
+					result = setsockopt(socket, SOL_SOCKET, SO_BROADCAST, (char*)&value, sizeof(int));
 
-		if (incomingCommand == NULL)
-			goto notifyError;
+					break;
 
-		incomingCommand->reliableSequenceNumber = command->header.reliableSequenceNumber;
-		incomingCommand->unreliableSequenceNumber = unreliableSequenceNumber & 0xFFFF;
-		incomingCommand->command = *command;
-		incomingCommand->fragmentCount = fragmentCount;
-		incomingCommand->fragmentsRemaining = fragmentCount;
-		incomingCommand->packet = packet;
-		incomingCommand->fragments = NULL;
+				case ENET_SOCKOPT_REUSEADDR:
+					result = setsockopt(socket, SOL_SOCKET, SO_REUSEADDR, (char*)&value, sizeof(int));
 
-		if (fragmentCount > 0) {
-			if (fragmentCount <= ENET_PROTOCOL_MAXIMUM_FRAGMENT_COUNT)
-				incomingCommand->fragments = (uint32_t*)enet_malloc((fragmentCount + 31) / 32 * sizeof(uint32_t));
+					break;
 
-			if (incomingCommand->fragments == NULL) {
-				enet_free(incomingCommand);
+				case ENET_SOCKOPT_RCVBUF:
+					result = setsockopt(socket, SOL_SOCKET, SO_RCVBUF, (char*)&value, sizeof(int));
 
-				goto notifyError;
-			}
+					break;
 
-			memset(incomingCommand->fragments, 0, (fragmentCount + 31) / 32 * sizeof(uint32_t));
-		}
+				case ENET_SOCKOPT_SNDBUF:
+					result = setsockopt(socket, SOL_SOCKET, SO_SNDBUF, (char*)&value, sizeof(int));
 
-		if (packet != NULL) {
-			++packet->referenceCount;
-			peer->totalWaitingData += packet->dataLength;
-		}
+					break;
 
-		enet_list_insert(enet_list_next(currentCommand), incomingCommand);
+				case ENET_SOCKOPT_RCVTIMEO: {
+					struct timeval timeVal;
 
-		switch (command->header.command & ENET_PROTOCOL_COMMAND_MASK) {
-			case ENET_PROTOCOL_COMMAND_SEND_FRAGMENT:
-			case ENET_PROTOCOL_COMMAND_SEND_RELIABLE:
-				enet_peer_dispatch_incoming_reliable_commands(peer, channel, incomingCommand);
+					timeVal.tv_sec = value / 1000;
+					timeVal.tv_usec = (value % 1000) * 1000;
+					result = setsockopt(socket, SOL_SOCKET, SO_RCVTIMEO, (char*)&timeVal, sizeof(struct timeval));
 
-				break;
+					break;
+				}
 
-			default:
-				enet_peer_dispatch_incoming_unreliable_commands(peer, channel, incomingCommand);
+				case ENET_SOCKOPT_SNDTIMEO: {
+					struct timeval timeVal;
 
-				break;
-		}
+					timeVal.tv_sec = value / 1000;
+					timeVal.tv_usec = (value % 1000) * 1000;
+					result = setsockopt(socket, SOL_SOCKET, SO_SNDTIMEO, (char*)&timeVal, sizeof(struct timeval));
 
-		return incomingCommand;
+					break;
+				}
 
-		discardCommand:
+				case ENET_SOCKOPT_NODELAY:
+					result = setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, (char*)&value, sizeof(int));
 
-		if (fragmentCount > 0)
-			goto notifyError;
+					break;
 
-		if (packet != NULL && packet->referenceCount == 0)
-			enet_packet_destroy(packet);
+				case ENET_SOCKOPT_IPV6_V6ONLY:
+					result = setsockopt(socket, IPPROTO_IPV6, IPV6_V6ONLY, (char*)&value, sizeof(int));
 
-		return &dummyCommand;
+					break;
 
-		notifyError:
+				case ENET_SOCKOPT_TTL:
+					result = setsockopt(socket, IPPROTO_IP, IP_TTL, (char*)&value, sizeof(int));
 
-		if (packet != NULL && packet->referenceCount == 0)
-			enet_packet_destroy(packet);
+					break;
 
-		return NULL;
-	}
+				#ifdef SO_REUSEPORT
+					case ENET_SOCKOPT_REUSEPORT:
+						result = setsockopt(socket, SOL_SOCKET, SO_REUSEPORT, (char*)&value, sizeof(int));
 
-/*
-=======================================================================
+						break;
+				#endif
 
-	Host
+				#ifdef ENET_HAS_SEGMENT
+					case ENET_SOCKOPT_SEGMENT:
+						result = setsockopt(socket, IPPROTO_UDP, UDP_SEGMENT, (char*)&value, sizeof(int));
 
-=======================================================================
-*/
+						break;
 
-	ENetHost* enet_host_create(const ENetAddress* address, size_t peerCount, size_t channelLimit, uint32_t incomingBandwidth, uint32_t outgoingBandwidth, int bufferSize) {
-		ENetHost* host;
-		ENetPeer* currentPeer;
+					case ENET_SOCKOPT_GRO:
+						result = setsockopt(socket, IPPROTO_UDP, UDP_GRO, (char*)&value, sizeof(int));
 
-		if (peerCount > ENET_PROTOCOL_MAXIMUM_PEER_ID)
-			return NULL;
+						break;
+				#endif
 
-		host = (ENetHost*)enet_malloc(sizeof(ENetHost));
+				#if defined(IP_MTU_DISCOVER) && defined(IPV6_MTU_DISCOVER)
+					case ENET_SOCKOPT_DONTFRAGMENT: {
+						int discover = value ? IP_PMTUDISC_PROBE : IP_PMTUDISC_WANT, discover6 = value ? IPV6_PMTUDISC_PROBE : IPV6_PMTUDISC_WANT;
 
-		if (host == NULL)
-			return NULL;
+						result = setsockopt(socket, IPPROTO_IPV6, IPV6_MTU_DISCOVER, (char*)&discover6, sizeof(int));
 
-		memset(host, 0, sizeof(ENetHost));
+						if (result != -1)
+							setsockopt(socket, IPPROTO_IP, IP_MTU_DISCOVER, (char*)&discover, sizeof(int));
 
-		host->peers = (ENetPeer*)enet_malloc(peerCount * sizeof(ENetPeer));
+						break;
+					}
+				#endif
 
-		if (host->peers == NULL) {
-			enet_free(host);
+				#ifdef ENET_HAS_TXTIME
+					case ENET_SOCKOPT_TXTIME: {
+						/* Layout of struct sock_txtime, departure times are taken from the monotonic clock, which is the one fq expects, etf runs on CLOCK_TAI and drops them */
+						struct {
+							int32_t clockid;
+							uint32_t flags;
+						} txtime = { CLOCK_MONOTONIC, 0 };
 
-			return NULL;
-		}
+						if (value)
+							result = setsockopt(socket, SOL_SOCKET, SO_TXTIME, (char*)&txtime, sizeof(txtime));
+						else
+							result = 0;
 
-		memset(host->peers, 0, peerCount * sizeof(ENetPeer));
+						break;
+					}
+				#endif
 
-		host->socket = enet_socket_create(ENET_SOCKET_TYPE_DATAGRAM);
+				default:
+					break;
+			}
 
-		if (host->socket != ENET_SOCKET_NULL)
-			enet_socket_set_option(host->socket, ENET_SOCKOPT_IPV6_V6ONLY, 0);
+			return result == -1 ? -1 : 0;
+		}
 
-		if (host->socket == ENET_SOCKET_NULL || (address != NULL && enet_socket_bind(host->socket, address) < 0)) {
-			if (host->socket != ENET_SOCKET_NULL)
-				enet_socket_destroy(host->socket);
+		int enet_socket_get_option(ENetSocket socket, ENetSocketOption option, int* value) {
+			int result = -1;
+			socklen_t len;
 
-			enet_free(host->peers);
-			enet_free(host);
+			switch (option) {
+				case ENET_SOCKOPT_ERROR:
+					len = sizeof(int);
+					result = getsockopt(socket, SOL_SOCKET, SO_ERROR, value, &len);
 
-			return NULL;
-		}
+					break;
 
-		if (bufferSize > ENET_HOST_BUFFER_SIZE_MAX)
-			bufferSize = ENET_HOST_BUFFER_SIZE_MAX;
-		else if (bufferSize < ENET_HOST_BUFFER_SIZE_MIN)
-			bufferSize = ENET_HOST_BUFFER_SIZE_MIN;
+				case ENET_SOCKOPT_TTL:
+		   			len = sizeof(int);
+		   			result = getsockopt(socket, IPPROTO_IP, IP_TTL, (char*)value, &len);
 
-		enet_socket_set_option(host->socket, ENET_SOCKOPT_NONBLOCK, 1);
-		enet_socket_set_option(host->socket, ENET_SOCKOPT_BROADCAST, 1);
-		enet_socket_set_option(host->socket, ENET_SOCKOPT_RCVBUF, bufferSize);
-		enet_socket_set_option(host->socket, ENET_SOCKOPT_SNDBUF, bufferSize);
+					break;
 
-		if (address != NULL && enet_socket_get_address(host->socket, &host->address) < 0)
-			host->address = *address;
+				#ifdef ENET_HAS_SEGMENT
+					case ENET_SOCKOPT_SEGMENT:
+						len = sizeof(int);
+						result = getsockopt(socket, IPPROTO_UDP, UDP_SEGMENT, (char*)value, &len);
 
-		if (!channelLimit || channelLimit > ENET_PROTOCOL_MAXIMUM_CHANNEL_COUNT)
-			channelLimit = ENET_PROTOCOL_MAXIMUM_CHANNEL_COUNT;
-		else if (channelLimit < ENET_PROTOCOL_MINIMUM_CHANNEL_COUNT)
-			channelLimit = ENET_PROTOCOL_MINIMUM_CHANNEL_COUNT;
+						break;
 
-		host->randomSeed = (uint32_t)(size_t)host;
-		host->randomSeed += enet_host_random_seed();
-		host->randomSeed = (host->randomSeed << 16) | (host->randomSeed >> 16);
-		host->channelLimit = channelLimit;
-		host->incomingBandwidth = incomingBandwidth;
-		host->outgoingBandwidth = outgoingBandwidth;
-		host->bandwidthThrottleEpoch = 0;
-		host->recalculateBandwidthLimits = 0;
-		host->preventConnections = 0;
-		host->mtu = ENET_HOST_DEFAULT_MTU;
-		host->peerCount = peerCount;
-		host->commandCount = 0;
-		host->bufferCount = 0;
-		host->checksumCallback = NULL;
-		host->receivedAddress.ipv6 = ENET_HOST_ANY;
-		host->receivedAddress.port = 0;
-		host->receivedData = NULL;
-		host->receivedDataLength = 0;
-		host->totalSentData = 0;
-		host->totalSentPackets = 0;
-		host->totalReceivedData = 0;
-		host->totalReceivedPackets = 0;
-		host->totalQueued = 0;
-		host->connectedPeers = 0;
-		host->bandwidthLimitedPeers = 0;
-		host->duplicatePeers = ENET_PROTOCOL_MAXIMUM_PEER_ID;
-		host->maximumPacketSize = ENET_HOST_DEFAULT_MAXIMUM_PACKET_SIZE;
-		host->maximumWaitingData = ENET_HOST_DEFAULT_MAXIMUM_WAITING_DATA;
-		host->interceptCallback = NULL;
+					case ENET_SOCKOPT_GRO:
+						len = sizeof(int);
+						result = getsockopt(socket, IPPROTO_UDP, UDP_GRO, (char*)value, &len);
 
-		enet_list_clear(&host->dispatchQueue);
+						break;
+				#endif
 
-		for (currentPeer = host->peers; currentPeer < &host->peers[host->peerCount]; ++currentPeer) {
-			currentPeer->host = host;
-			currentPeer->incomingPeerID = currentPeer - host->peers;
-			currentPeer->outgoingSessionID = currentPeer->incomingSessionID = 0xFF;
-			currentPeer->data = NULL;
+				default:
+					break;
+			}
 
-			enet_list_clear(&currentPeer->acknowledgements);
-			enet_list_clear(&currentPeer->sentReliableCommands);
-			enet_list_clear(&currentPeer->outgoingCommands);
-			enet_list_clear(&currentPeer->outgoingSendReliableCommands);
-			enet_list_clear(&currentPeer->dispatchedCommands);
-			enet_peer_reset(currentPeer);
+			return result == -1 ? -1 : 0;
 		}
 
-		return host;
-	}
+		int enet_socket_connect(ENetSocket socket, const ENetAddress* address) {
+			int result = -1;
+			struct sockaddr_in6 sin;
 
-	void enet_host_destroy(ENetHost* host) {
-		ENetPeer* currentPeer;
+			memset(&sin, 0, sizeof(struct sockaddr_in6));
 
-		if (host == NULL)
-			return;
+			sin.sin6_family = AF_INET6;
+			sin.sin6_port = ENET_HOST_TO_NET_16(address->port);
+			sin.sin6_addr = address->ipv6;
 
-		enet_socket_destroy(host->socket);
+			result = connect(socket, (struct sockaddr*)&sin, sizeof(struct sockaddr_in6));
 
-		for (currentPeer = host->peers; currentPeer < &host->peers[host->peerCount]; ++currentPeer) {
-			enet_peer_reset(currentPeer);
-		}
+			if (result == -1 && errno == EINPROGRESS)
+				return 0;
 
-		enet_free(host->peers);
-		enet_free(host);
-	}
+			return result;
+		}
 
-	void enet_host_prevent_connections(ENetHost* host, uint8_t state) {
-		if (host == NULL)
-			return;
+		ENetSocket enet_socket_accept(ENetSocket socket, ENetAddress* address) {
+			int result = -1;
+			struct sockaddr_in6 sin;
+			socklen_t sinLength = sizeof(struct sockaddr_in6);
 
-		host->preventConnections = state;
-	}
+			result = accept(socket, address != NULL ? (struct sockaddr*)&sin : NULL, address != NULL ? &sinLength : NULL);
 
-	ENetPeer* enet_host_connect(ENetHost* host, const ENetAddress* address, size_t channelCount, uint32_t data) {
-		ENetPeer* currentPeer;
-		ENetChannel* channel;
-		ENetProtocol command;
+			if (result == -1)
+				return ENET_SOCKET_NULL;
 
-		if (channelCount < ENET_PROTOCOL_MINIMUM_CHANNEL_COUNT)
-			channelCount = ENET_PROTOCOL_MINIMUM_CHANNEL_COUNT;
-		else if (channelCount > ENET_PROTOCOL_MAXIMUM_CHANNEL_COUNT)
-			channelCount = ENET_PROTOCOL_MAXIMUM_CHANNEL_COUNT;
+			if (address != NULL) {
+				address->ipv6 = sin.sin6_addr;
+				address->port = ENET_NET_TO_HOST_16(sin.sin6_port);
+			}
 
-		for (currentPeer = host->peers; currentPeer < &host->peers[host->peerCount]; ++currentPeer) {
-			if (currentPeer->state == ENET_PEER_STATE_DISCONNECTED)
-				break;
+			return result;
 		}
 
-		if (currentPeer >= &host->peers[host->peerCount])
-			return NULL;
+		int enet_socket_shutdown(ENetSocket socket, ENetSocketShutdown how) {
+			return shutdown(socket, (int)how);
+		}
 
-		currentPeer->channels = (ENetChannel*)enet_malloc(channelCount * sizeof(ENetChannel));
+		void enet_socket_destroy(ENetSocket socket) {
+			if (socket != ENET_SOCKET_NULL)
+				close(socket);
+		}
 
-		if (currentPeer->channels == NULL)
-			return NULL;
+		int enet_socket_send(ENetSocket socket, const ENetAddress* address, const ENetBuffer* buffers, size_t bufferCount) {
+			struct msghdr msgHdr;
+			struct sockaddr_in6 sin;
+			int sentLength;
 
-		currentPeer->channelCount = channelCount;
-		currentPeer->state = ENET_PEER_STATE_CONNECTING;
-		currentPeer->address = *address;
-		currentPeer->connectID = ++host->randomSeed;
+			memset(&msgHdr, 0, sizeof(struct msghdr));
 
-		if (host->outgoingBandwidth == 0)
-			currentPeer->windowSize = ENET_PROTOCOL_MAXIMUM_WINDOW_SIZE;
-		else
-			currentPeer->windowSize = (host->outgoingBandwidth / ENET_PEER_WINDOW_SIZE_SCALE) * ENET_PROTOCOL_MINIMUM_WINDOW_SIZE;
+			if (address != NULL) {
+				memset(&sin, 0, sizeof(struct sockaddr_in6));
 
-		if (currentPeer->windowSize < ENET_PROTOCOL_MINIMUM_WINDOW_SIZE)
-			currentPeer->windowSize = ENET_PROTOCOL_MINIMUM_WINDOW_SIZE;
-		else if (currentPeer->windowSize > ENET_PROTOCOL_MAXIMUM_WINDOW_SIZE)
-			currentPeer->windowSize = ENET_PROTOCOL_MAXIMUM_WINDOW_SIZE;
+				sin.sin6_family = AF_INET6;
+				sin.sin6_port = ENET_HOST_TO_NET_16(address->port);
+				sin.sin6_addr = address->ipv6;
+				msgHdr.msg_name = &sin;
+				msgHdr.msg_namelen = sizeof(struct sockaddr_in6);
+			}
 
-		for (channel = currentPeer->channels; channel < &currentPeer->channels[channelCount]; ++channel) {
-			channel->outgoingReliableSequenceNumber = 0;
-			channel->outgoingUnreliableSequenceNumber = 0;
-			channel->incomingReliableSequenceNumber = 0;
-			channel->incomingUnreliableSequenceNumber = 0;
+			msgHdr.msg_iov = (struct iovec*)buffers;
+			msgHdr.msg_iovlen = bufferCount;
+			sentLength = sendmsg(socket, &msgHdr, MSG_NOSIGNAL);
 
-			enet_list_clear(&channel->incomingReliableCommands);
-			enet_list_clear(&channel->incomingUnreliableCommands);
+			if (sentLength == -1) {
+				if (errno == EWOULDBLOCK || errno == EMSGSIZE)
+					return 0;
 
-			channel->usedReliableWindows = 0;
+				return -1;
+			}
 
-			memset(channel->reliableWindows, 0, sizeof(channel->reliableWindows));
+			return sentLength;
 		}
 
-		command.header.command = ENET_PROTOCOL_COMMAND_CONNECT | ENET_PROTOCOL_COMMAND_FLAG_ACKNOWLEDGE;
-		command.header.channelID = 0xFF;
-		command.connect.outgoingPeerID = ENET_HOST_TO_NET_16(currentPeer->incomingPeerID);
-		command.connect.incomingSessionID = currentPeer->incomingSessionID;
-		command.connect.outgoingSessionID = currentPeer->outgoingSessionID;
-		command.connect.mtu = ENET_HOST_TO_NET_32(currentPeer->mtu);
-		command.connect.windowSize = ENET_HOST_TO_NET_32(currentPeer->windowSize);
-		command.connect.channelCount = ENET_HOST_TO_NET_32(channelCount);
-		command.connect.incomingBandwidth = ENET_HOST_TO_NET_32(host->incomingBandwidth);
-		command.connect.outgoingBandwidth = ENET_HOST_TO_NET_32(host->outgoingBandwidth);
-		command.connect.packetThrottleInterval = ENET_HOST_TO_NET_32(currentPeer->packetThrottleInterval);
-		command.connect.packetThrottleAcceleration = ENET_HOST_TO_NET_32(currentPeer->packetThrottleAcceleration);
-		command.connect.packetThrottleDeceleration = ENET_HOST_TO_NET_32(currentPeer->packetThrottleDeceleration);
-		command.connect.connectID = currentPeer->connectID;
-		command.connect.data = ENET_HOST_TO_NET_32(data);
-
-		enet_peer_queue_outgoing_command(currentPeer, &command, NULL, 0, 0);
+		int enet_socket_send_batch(ENetSocket socket, const ENetAddress* addresses, ENetBuffer* const* buffers, const size_t* bufferCounts, const size_t* segmentSizes, const uint32_t* departureDelays, int* sentLengths, size_t datagramCount) {
+			#ifdef ENET_HAS_MMSG
+				struct mmsghdr msgVec[ENET_HOST_SEND_BATCH];
+				struct sockaddr_in6 sin[ENET_HOST_SEND_BATCH];
+				size_t i, sentCount = 0;
+
+				#if defined(ENET_HAS_SEGMENT) || defined(ENET_HAS_TXTIME)
+					union {
+						struct cmsghdr header;
+						uint8_t data[CMSG_SPACE(sizeof(uint16_t)) + CMSG_SPACE(sizeof(uint64_t))];
+					} control[ENET_HOST_SEND_BATCH];
+				#endif
 
-		return currentPeer;
-	}
+				#ifdef ENET_HAS_TXTIME
+					uint64_t now = 0;
 
-	void enet_host_broadcast(ENetHost* host, uint8_t channelID, ENetPacket* packet) {
-		ENetPeer* currentPeer;
+					if (departureDelays != NULL) {
+						struct timespec ts;
 
-		if (packet->flags & ENET_PACKET_FLAG_INSTANT)
-			++packet->referenceCount;
+						clock_gettime(CLOCK_MONOTONIC, &ts);
 
-		for (currentPeer = host->peers; currentPeer < &host->peers[host->peerCount]; ++currentPeer) {
-			if (currentPeer->state != ENET_PEER_STATE_CONNECTED)
-				continue;
+						now = ts.tv_nsec + (uint64_t)ts.tv_sec * 1000000000;
+					}
+				#else
+					(void)departureDelays;
+				#endif
 
-			enet_peer_send(currentPeer, channelID, packet);
-		}
+				if (datagramCount > ENET_HOST_SEND_BATCH)
+					return -1;
 
-		if (packet->flags & ENET_PACKET_FLAG_INSTANT)
-			--packet->referenceCount;
+				memset(msgVec, 0, datagramCount * sizeof(struct mmsghdr));
+				memset(sin, 0, datagramCount * sizeof(struct sockaddr_in6));
+
+				for (i = 0; i < datagramCount; ++i) {
+					sin[i].sin6_family = AF_INET6;
+					sin[i].sin6_port = ENET_HOST_TO_NET_16(addresses[i].port);
+					sin[i].sin6_addr = addresses[i].ipv6;
+					msgVec[i].msg_hdr.msg_name = &sin[i];
+					msgVec[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in6);
+					msgVec[i].msg_hdr.msg_iov = (struct iovec*)buffers[i];
+					msgVec[i].msg_hdr.msg_iovlen = bufferCounts[i];
+					sentLengths[i] = 0;
+
+					if (segmentSizes != NULL && segmentSizes[i] > 0) {
+						#ifdef ENET_HAS_SEGMENT
+							struct cmsghdr* cmsg;
+							uint16_t segmentSize = (uint16_t)segmentSizes[i];
+
+							memset(&control[i], 0, sizeof(control[i]));
+
+							msgVec[i].msg_hdr.msg_control = control[i].data;
+							msgVec[i].msg_hdr.msg_controllen = CMSG_SPACE(sizeof(uint16_t));
+							cmsg = CMSG_FIRSTHDR(&msgVec[i].msg_hdr);
+							cmsg->cmsg_level = IPPROTO_UDP;
+							cmsg->cmsg_type = UDP_SEGMENT;
+							cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+
+							memcpy(CMSG_DATA(cmsg), &segmentSize, sizeof(uint16_t));
+						#else
+							return -1;
+						#endif
+					}
 
-		if (packet->referenceCount == 0)
-			enet_packet_destroy(packet);
-	}
+					#ifdef ENET_HAS_TXTIME
+						if (departureDelays != NULL && departureDelays[i] > 0) {
+							struct cmsghdr* cmsg;
+							uint64_t departureTime = now + (uint64_t)departureDelays[i] * 1000;
 
-	void enet_host_broadcast_exclude(ENetHost* host, uint8_t channelID, ENetPacket* packet, ENetPeer* excludedPeer) {
-		ENetPeer* currentPeer;
+							if (msgVec[i].msg_hdr.msg_control == NULL)
+								memset(&control[i], 0, sizeof(control[i]));
 
-		if (packet->flags & ENET_PACKET_FLAG_INSTANT)
-			++packet->referenceCount;
+							msgVec[i].msg_hdr.msg_control = control[i].data;
+							cmsg = (struct cmsghdr*)&control[i].data[msgVec[i].msg_hdr.msg_controllen];
+							msgVec[i].msg_hdr.msg_controllen += CMSG_SPACE(sizeof(uint64_t));
+							cmsg->cmsg_level = SOL_SOCKET;
+							cmsg->cmsg_type = SCM_TXTIME;
+							cmsg->cmsg_len = CMSG_LEN(sizeof(uint64_t));
 
-		for (currentPeer = host->peers; currentPeer < &host->peers[host->peerCount]; ++currentPeer) {
-			if (currentPeer->state != ENET_PEER_STATE_CONNECTED || currentPeer == excludedPeer)
-				continue;
+							memcpy(CMSG_DATA(cmsg), &departureTime, sizeof(uint64_t));
+						}
+					#endif
+				}
 
-			enet_peer_send(currentPeer, channelID, packet);
-		}
+				while (sentCount < datagramCount) {
+					int result = sendmmsg(socket, &msgVec[sentCount], (unsigned int)(datagramCount - sentCount), MSG_NOSIGNAL);
 
-		if (packet->flags & ENET_PACKET_FLAG_INSTANT)
-			--packet->referenceCount;
+					if (result == -1) {
+						if (errno == EWOULDBLOCK)
+							break;
 
-		if (packet->referenceCount == 0)
-			enet_packet_destroy(packet);
-	}
+						/* A datagram above the link MTU is dropped like a lost probe, the rest of the batch still goes out */
+						if (errno == EMSGSIZE) {
+							++sentCount;
 
-	void enet_host_broadcast_selective(ENetHost* host, uint8_t channelID, ENetPacket* packet, ENetPeer** peers, size_t length) {
-		ENetPeer* currentPeer;
-		size_t i;
+							continue;
+						}
 
-		if (host == NULL)
-			return;
+						return -1;
+					}
 
-		if (packet->flags & ENET_PACKET_FLAG_INSTANT)
-			++packet->referenceCount;
+					for (i = sentCount; i < sentCount + result; ++i) {
+						sentLengths[i] = (int)msgVec[i].msg_len;
+					}
 
-		for (i = 0; i < length; i++) {
-			currentPeer = peers[i];
+					sentCount += result;
+				}
 
-			if (currentPeer == NULL || currentPeer->state != ENET_PEER_STATE_CONNECTED)
-				continue;
+				return 0;
+			#else
+				size_t i;
 
-			enet_peer_send(currentPeer, channelID, packet);
-		}
+				(void)departureDelays;
 
-		if (packet->flags & ENET_PACKET_FLAG_INSTANT)
-			--packet->referenceCount;
+				for (i = 0; i < datagramCount; ++i) {
+					sentLengths[i] = 0;
+				}
 
-		if (packet->referenceCount == 0)
-			enet_packet_destroy(packet);
-	}
+				for (i = 0; i < datagramCount; ++i) {
+					if (segmentSizes != NULL && segmentSizes[i] > 0)
+						return -1;
 
-	void enet_host_channel_limit(ENetHost* host, size_t channelLimit) {
-		if (!channelLimit || channelLimit > ENET_PROTOCOL_MAXIMUM_CHANNEL_COUNT)
-			channelLimit = ENET_PROTOCOL_MAXIMUM_CHANNEL_COUNT;
-		else if (channelLimit < ENET_PROTOCOL_MINIMUM_CHANNEL_COUNT)
-			channelLimit = ENET_PROTOCOL_MINIMUM_CHANNEL_COUNT;
+					sentLengths[i] = enet_socket_send(socket, &addresses[i], buffers[i], bufferCounts[i]);
 
-		host->channelLimit = channelLimit;
-	}
+					if (sentLengths[i] < 0) {
+						sentLengths[i] = 0;
 
-	void enet_host_bandwidth_limit(ENetHost* host, uint32_t incomingBandwidth, uint32_t outgoingBandwidth) {
-		host->incomingBandwidth = incomingBandwidth;
-		host->outgoingBandwidth = outgoingBandwidth;
-		host->recalculateBandwidthLimits = 1;
-	}
+						return -1;
+					}
+				}
 
-	void enet_host_bandwidth_throttle(ENetHost* host) {
-		uint32_t timeCurrent = enet_time_get();
-		uint32_t elapsedTime = timeCurrent - host->bandwidthThrottleEpoch;
-		uint32_t peersRemaining = (uint32_t)host->connectedPeers;
-		uint32_t dataTotal = ~0;
-		uint32_t bandwidth = ~0;
-		uint32_t throttle = 0;
-		uint32_t bandwidthLimit = 0;
+				return 0;
+			#endif
+		}
 
-		int needsAdjustment = host->bandwidthLimitedPeers > 0 ? 1 : 0;
-		ENetPeer* peer;
-		ENetProtocol command;
+		int enet_socket_receive(ENetSocket socket, ENetAddress* address, ENetBuffer* buffers, size_t bufferCount) {
+			struct msghdr msgHdr;
+			struct sockaddr_in6 sin;
+			int recvLength;
 
-		if (elapsedTime < ENET_HOST_BANDWIDTH_THROTTLE_INTERVAL)
-			return;
+			memset(&msgHdr, 0, sizeof(struct msghdr));
 
-		if (host->outgoingBandwidth == 0 && host->incomingBandwidth == 0)
-			return;
+			if (address != NULL) {
+				msgHdr.msg_name = &sin;
+				msgHdr.msg_namelen = sizeof(struct sockaddr_in6);
+			}
 
-		host->bandwidthThrottleEpoch = timeCurrent;
+			msgHdr.msg_iov = (struct iovec*)buffers;
+			msgHdr.msg_iovlen = bufferCount;
+			recvLength = recvmsg(socket, &msgHdr, MSG_NOSIGNAL);
 
-		if (peersRemaining == 0)
-			return;
+			if (recvLength == -1) {
+				if (errno == EWOULDBLOCK)
+					return 0;
 
-		if (host->outgoingBandwidth != 0) {
-			dataTotal = 0;
-			bandwidth = (host->outgoingBandwidth * elapsedTime) / 1000;
+				return -1;
+			}
 
-			for (peer = host->peers; peer < &host->peers[host->peerCount]; ++peer) {
-				if (peer->state != ENET_PEER_STATE_CONNECTED && peer->state != ENET_PEER_STATE_DISCONNECT_LATER)
-					continue;
+			if (msgHdr.msg_flags & MSG_TRUNC)
+				return -2;
 
-				dataTotal += peer->outgoingDataTotal;
+			if (address != NULL) {
+				address->ipv6 = sin.sin6_addr;
+				address->port = ENET_NET_TO_HOST_16(sin.sin6_port);
 			}
-		}
 
-		while (peersRemaining > 0 && needsAdjustment != 0) {
-			needsAdjustment = 0;
+			return recvLength;
+		}
 
-			if (dataTotal <= bandwidth)
-				throttle = ENET_PEER_PACKET_THROTTLE_SCALE;
-			else
-				throttle = (bandwidth * ENET_PEER_PACKET_THROTTLE_SCALE) / dataTotal;
+		int enet_socket_receive_batch(ENetSocket socket, ENetAddress* addresses, ENetBuffer* buffers, int* receivedLengths, int* segmentSizes, size_t datagramCount) {
+			#ifdef ENET_HAS_MMSG
+				struct mmsghdr msgVec[ENET_HOST_RECEIVE_BATCH];
+				struct sockaddr_in6 sin[ENET_HOST_RECEIVE_BATCH];
+				int recvCount, i;
+
+				#ifdef ENET_HAS_SEGMENT
+					union {
+						struct cmsghdr header;
+						uint8_t data[CMSG_SPACE(sizeof(int))];
+					} control[ENET_HOST_RECEIVE_BATCH];
+					struct cmsghdr* cmsg;
+				#endif
 
-			for (peer = host->peers; peer < &host->peers[host->peerCount]; ++peer) {
-				uint32_t peerBandwidth;
+				if (datagramCount > ENET_HOST_RECEIVE_BATCH)
+					datagramCount = ENET_HOST_RECEIVE_BATCH;
 
-				if ((peer->state != ENET_PEER_STATE_CONNECTED && peer->state != ENET_PEER_STATE_DISCONNECT_LATER) || peer->incomingBandwidth == 0 || peer->outgoingBandwidthThrottleEpoch == timeCurrent)
-					continue;
+				memset(msgVec, 0, datagramCount * sizeof(struct mmsghdr));
 
-				peerBandwidth = (peer->incomingBandwidth * elapsedTime) / 1000;
+				for (i = 0; i < (int)datagramCount; ++i) {
+					msgVec[i].msg_hdr.msg_name = &sin[i];
+					msgVec[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in6);
+					msgVec[i].msg_hdr.msg_iov = (struct iovec*)&buffers[i];
+					msgVec[i].msg_hdr.msg_iovlen = 1;
 
-				if ((throttle * peer->outgoingDataTotal) / ENET_PEER_PACKET_THROTTLE_SCALE <= peerBandwidth)
-					continue;
+					#ifdef ENET_HAS_SEGMENT
+						if (segmentSizes != NULL) {
+							msgVec[i].msg_hdr.msg_control = control[i].data;
+							msgVec[i].msg_hdr.msg_controllen = sizeof(control[i].data);
+						}
+					#endif
+				}
 
-				peer->packetThrottleLimit = (peerBandwidth * ENET_PEER_PACKET_THROTTLE_SCALE) / peer->outgoingDataTotal;
+				recvCount = recvmmsg(socket, msgVec, (unsigned int)datagramCount, MSG_NOSIGNAL, NULL);
 
-				if (peer->packetThrottleLimit == 0)
-					peer->packetThrottleLimit = 1;
+				if (recvCount == -1) {
+					if (errno == EWOULDBLOCK)
+						return 0;
 
-				if (peer->packetThrottle > peer->packetThrottleLimit)
-					peer->packetThrottle = peer->packetThrottleLimit;
+					return -1;
+				}
 
-				peer->outgoingBandwidthThrottleEpoch = timeCurrent;
-				peer->incomingDataTotal = 0;
-				peer->outgoingDataTotal = 0;
-				needsAdjustment = 1;
-				--peersRemaining;
-				bandwidth -= peerBandwidth;
-				dataTotal -= peerBandwidth;
-			}
-		}
+				for (i = 0; i < recvCount; ++i) {
+					receivedLengths[i] = msgVec[i].msg_hdr.msg_flags & MSG_TRUNC ? -2 : (int)msgVec[i].msg_len;
+					addresses[i].ipv6 = sin[i].sin6_addr;
+					addresses[i].port = ENET_NET_TO_HOST_16(sin[i].sin6_port);
 
-		if (peersRemaining > 0) {
-			if (dataTotal <= bandwidth)
-				throttle = ENET_PEER_PACKET_THROTTLE_SCALE;
-			else
-				throttle = (bandwidth * ENET_PEER_PACKET_THROTTLE_SCALE) / dataTotal;
+					if (segmentSizes != NULL) {
+						segmentSizes[i] = 0;
 
-			for (peer = host->peers; peer < &host->peers[host->peerCount]; ++peer) {
-				if ((peer->state != ENET_PEER_STATE_CONNECTED && peer->state != ENET_PEER_STATE_DISCONNECT_LATER) || peer->outgoingBandwidthThrottleEpoch == timeCurrent)
-					continue;
+						#ifdef ENET_HAS_SEGMENT
+							for (cmsg = CMSG_FIRSTHDR(&msgVec[i].msg_hdr); cmsg != NULL; cmsg = CMSG_NXTHDR(&msgVec[i].msg_hdr, cmsg)) {
+								if (cmsg->cmsg_level == IPPROTO_UDP && cmsg->cmsg_type == UDP_GRO)
+									memcpy(&segmentSizes[i], CMSG_DATA(cmsg), sizeof(int));
+							}
+						#endif
+					}
+				}
 
-				peer->packetThrottleLimit = throttle;
+				return recvCount;
+			#else
+				if (datagramCount < 1)
+					return 0;
 
-				if (peer->packetThrottle > peer->packetThrottleLimit)
-					peer->packetThrottle = peer->packetThrottleLimit;
+				if (segmentSizes != NULL)
+					segmentSizes[0] = 0;
 
-				peer->incomingDataTotal = 0;
-				peer->outgoingDataTotal = 0;
-			}
-		}
+				receivedLengths[0] = enet_socket_receive(socket, addresses, buffers, 1);
 
-		if (host->recalculateBandwidthLimits) {
-			host->recalculateBandwidthLimits = 0;
-			peersRemaining = (uint32_t)host->connectedPeers;
-			bandwidth = host->incomingBandwidth;
-			needsAdjustment = 1;
+				if (receivedLengths[0] == -1)
+					return -1;
 
-			if (bandwidth == 0) {
-				bandwidthLimit = 0;
-			} else {
-				while (peersRemaining > 0 && needsAdjustment != 0) {
-					needsAdjustment = 0;
-					bandwidthLimit = bandwidth / peersRemaining;
+				return receivedLengths[0] != 0 ? 1 : 0;
+			#endif
+		}
 
-					for (peer = host->peers; peer < &host->peers[host->peerCount]; ++peer) {
-						if ((peer->state != ENET_PEER_STATE_CONNECTED && peer->state != ENET_PEER_STATE_DISCONNECT_LATER) || peer->incomingBandwidthThrottleEpoch == timeCurrent)
-							continue;
+		#ifdef ENET_HAS_URING
+			#define ENET_URING_RECEIVE 0xFFFFFFFFFFFFFFFFULL
+			#define ENET_URING_DISCARDED 0xFFFFFFFFFFFFFFFEULL
+			#define ENET_URING_BUFFER_GROUP 0
+			#define ENET_URING_BUFFER_SIZE (sizeof(struct io_uring_recvmsg_out) + sizeof(struct sockaddr_in6) + ENET_PROTOCOL_MAXIMUM_MTU)
+
+			typedef struct _ENetUring {
+				int fd;
+				ENetSocket socket;
+				uint8_t* submissionRing;
+				size_t submissionRingSize;
+				uint8_t* completionRing;
+				size_t completionRingSize;
+				struct io_uring_sqe* submissionEntries;
+				size_t submissionEntriesSize;
+				uint32_t* submissionHead;
+				uint32_t* submissionTail;
+				uint32_t submissionMask;
+				uint32_t submissionPending;
+				uint32_t* completionHead;
+				uint32_t* completionTail;
+				uint32_t completionMask;
+				struct io_uring_cqe* completionEntries;
+				struct io_uring_buf_ring* bufferRing;
+				size_t bufferRingSize;
+				uint8_t* bufferData;
+				uint16_t bufferTail;
+				struct msghdr receiveMessage;
+				int receiveArmed;
+				int receiveError;
+				uint16_t readyBuffers[ENET_URING_BUFFER_COUNT];
+				int readyLengths[ENET_URING_BUFFER_COUNT];
+				size_t readyHead;
+				size_t readyCount;
+				uint16_t consumedBuffers[ENET_HOST_RECEIVE_BATCH];
+				size_t consumedCount;
+				struct msghdr sendMessages[ENET_HOST_SEND_BATCH];
+				struct sockaddr_in6 sendAddresses[ENET_HOST_SEND_BATCH];
+				struct iovec sendVectors[ENET_HOST_SEND_BATCH];
+				uint8_t* sendData;
+				int sendBusy[ENET_HOST_SEND_BATCH];
+				size_t sendPending;
+				int sendError;
+				int failed;
+			} ENetUring;
+
+			static int enet_uring_enter(ENetUring* uring, uint32_t minComplete, uint32_t flags, void* argument, size_t argumentSize) {
+				int result = (int)syscall(__NR_io_uring_enter, uring->fd, uring->submissionPending, minComplete, flags, argument, argumentSize);
+
+				if (result >= 0)
+					uring->submissionPending -= ENET_MIN((uint32_t)result, uring->submissionPending);
+
+				return result;
+			}
 
-						if (peer->outgoingBandwidth > 0 && peer->outgoingBandwidth >= bandwidthLimit)
-							continue;
+			static struct io_uring_sqe* enet_uring_get_submission(ENetUring* uring) {
+				uint32_t tail = *uring->submissionTail;
+				struct io_uring_sqe* sqe;
 
-						peer->incomingBandwidthThrottleEpoch = timeCurrent;
-						needsAdjustment = 1;
-						--peersRemaining;
-						bandwidth -= peer->outgoingBandwidth;
-					}
+				if (tail - __atomic_load_n(uring->submissionHead, __ATOMIC_ACQUIRE) > uring->submissionMask) {
+					if (enet_uring_enter(uring, 0, 0, NULL, 0) < 0)
+						return NULL;
+
+					if (tail - __atomic_load_n(uring->submissionHead, __ATOMIC_ACQUIRE) > uring->submissionMask)
+						return NULL;
 				}
-			}
 
-			for (peer = host->peers; peer < &host->peers[host->peerCount]; ++peer) {
-				if (peer->state != ENET_PEER_STATE_CONNECTED && peer->state != ENET_PEER_STATE_DISCONNECT_LATER)
-					continue;
+				sqe = &uring->submissionEntries[tail & uring->submissionMask];
 
-				command.header.command = ENET_PROTOCOL_COMMAND_BANDWIDTH_LIMIT | ENET_PROTOCOL_COMMAND_FLAG_ACKNOWLEDGE;
-				command.header.channelID = 0xFF;
-				command.bandwidthLimit.outgoingBandwidth = ENET_HOST_TO_NET_32(host->outgoingBandwidth);
+				memset(sqe, 0, sizeof(struct io_uring_sqe));
 
-				if (peer->incomingBandwidthThrottleEpoch == timeCurrent)
-					command.bandwidthLimit.incomingBandwidth = ENET_HOST_TO_NET_32(peer->outgoingBandwidth);
-				else
-					command.bandwidthLimit.incomingBandwidth = ENET_HOST_TO_NET_32(bandwidthLimit);
+				__atomic_store_n(uring->submissionTail, tail + 1, __ATOMIC_RELEASE);
 
-				enet_peer_queue_outgoing_command(peer, &command, NULL, 0, 0);
-			}
-		}
-	}
+				++uring->submissionPending;
 
-/*
-=======================================================================
+				return sqe;
+			}
 
-	Address
+			static void enet_uring_provide_buffer(ENetUring* uring, uint16_t bufferID) {
+				struct io_uring_buf* buffer = &uring->bufferRing->bufs[uring->bufferTail & (ENET_URING_BUFFER_COUNT - 1)];
 
-=======================================================================
-*/
+				buffer->addr = (uint64_t)(uintptr_t)&uring->bufferData[bufferID * ENET_URING_BUFFER_SIZE];
+				buffer->len = ENET_URING_BUFFER_SIZE;
+				buffer->bid = bufferID;
 
-	int enet_address_set_ip(ENetAddress* address, const char* ip) {
-		int type = AF_INET6;
-		void* destination = &address->ipv6;
+				++uring->bufferTail;
+			}
 
-		if (strchr(ip, ':') == NULL) {
-			type = AF_INET;
+			static int enet_uring_arm_receive(ENetUring* uring) {
+				struct io_uring_sqe* sqe;
 
-			memset(address, 0, sizeof(address->ipv4.zeros));
+				if (uring->receiveArmed)
+					return 0;
 
-			address->ipv4.ffff = 0xFFFF;
-			destination = &address->ipv4.ip;
-		}
+				sqe = enet_uring_get_submission(uring);
 
-		if (!inet_pton(type, ip, destination))
-			return -1;
+				if (sqe == NULL)
+					return -1;
 
-		return 0;
-	}
+				sqe->opcode = IORING_OP_RECVMSG;
+				sqe->fd = uring->socket;
+				sqe->addr = (uint64_t)(uintptr_t)&uring->receiveMessage;
+				sqe->len = 1;
+				sqe->flags = IOSQE_BUFFER_SELECT;
+				sqe->buf_group = ENET_URING_BUFFER_GROUP;
+				sqe->ioprio = IORING_RECV_MULTISHOT;
+				sqe->user_data = ENET_URING_RECEIVE;
 
-	int enet_address_set_hostname(ENetAddress* address, const char* name) {
-		struct addrinfo hints, *resultList = NULL, *result = NULL;
+				uring->receiveArmed = 1;
 
-		memset(&hints, 0, sizeof(hints));
+				return 0;
+			}
 
-		hints.ai_family = AF_UNSPEC;
+			static void enet_uring_reap(ENetUring* uring) {
+				uint32_t head = *uring->completionHead, tail = __atomic_load_n(uring->completionTail, __ATOMIC_ACQUIRE);
 
-		if (getaddrinfo(name, NULL, &hints, &resultList) != 0)
-			return -1;
+				for (; head != tail; ++head) {
+					struct io_uring_cqe* cqe = &uring->completionEntries[head & uring->completionMask];
 
-		for (result = resultList; result != NULL; result = result->ai_next) {
-			if (result->ai_addr != NULL && result->ai_addrlen >= sizeof(struct sockaddr_in)) {
-				if (result->ai_family == AF_INET) {
-					struct sockaddr_in* sin = (struct sockaddr_in*)result->ai_addr;
+					if (cqe->user_data != ENET_URING_RECEIVE) {
+						if (cqe->user_data < ENET_HOST_SEND_BATCH && uring->sendBusy[cqe->user_data]) {
+							uring->sendBusy[cqe->user_data] = 0;
+							--uring->sendPending;
 
-					memset(address, 0, sizeof(address->ipv4.zeros));
+							/* A full socket or a datagram above the link MTU loses the datagram like the poll backend does, anything else is reported by the next batch */
+							if (cqe->res < 0 && cqe->res != -EAGAIN && cqe->res != -EMSGSIZE)
+								uring->sendError = -cqe->res;
+						}
 
-					address->ipv4.ffff = 0xFFFF;
-					address->ipv4.ip.s_addr = sin->sin_addr.s_addr;
+						continue;
+					}
 
-					freeaddrinfo(resultList);
+					if (!(cqe->flags & IORING_CQE_F_MORE))
+						uring->receiveArmed = 0;
 
-					return 0;
-				} else if (result->ai_family == AF_INET6) {
-					struct sockaddr_in6* sin = (struct sockaddr_in6*)result->ai_addr;
+					if (cqe->res < 0) {
+						if (cqe->res != -ENOBUFS)
+							uring->receiveError = -cqe->res;
 
-					address->ipv6 = sin->sin6_addr;
+						continue;
+					}
 
-					freeaddrinfo(resultList);
+					if (cqe->flags & IORING_CQE_F_BUFFER) {
+						size_t index = (uring->readyHead + uring->readyCount) % ENET_URING_BUFFER_COUNT;
 
-					return 0;
+						uring->readyBuffers[index] = (uint16_t)(cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+						uring->readyLengths[index] = cqe->res;
+						++uring->readyCount;
+					}
 				}
-			}
-		}
 
-		if (resultList != NULL)
-			freeaddrinfo(resultList);
+				__atomic_store_n(uring->completionHead, head, __ATOMIC_RELEASE);
+			}
 
-		return enet_address_set_ip(address, name);
-	}
+			ENetUring* enet_uring_create(ENetSocket socket) {
+				struct io_uring_params params;
+				struct io_uring_buf_reg bufferRegistration;
+				ENetUring* uring;
+				uint32_t i;
 
-	int enet_address_get_ip(const ENetAddress* address, char* ip, size_t ipLength) {
-		if (address->ipv4.ffff == 0xFFFF && enet_array_is_zeroed(address->ipv4.zeros, sizeof(address->ipv4.zeros)) == 0) {
-			if (inet_ntop(AF_INET, &address->ipv4.ip, ip, ipLength) == NULL)
-				return -1;
-		} else if (inet_ntop(AF_INET6, &address->ipv6, ip, ipLength) == NULL) {
-			return -1;
-		}
+				uring = (ENetUring*)enet_malloc(sizeof(ENetUring));
 
-		return 0;
-	}
+				if (uring == NULL)
+					return NULL;
 
-	int enet_address_get_hostname(const ENetAddress* address, char* name, size_t nameLength) {
-		struct sockaddr_in6 sin;
-		int err;
+				memset(uring, 0, sizeof(ENetUring));
+				memset(&params, 0, sizeof(struct io_uring_params));
 
-		memset(&sin, 0, sizeof(struct sockaddr_in6));
+				uring->socket = socket;
+				uring->submissionRing = (uint8_t*)MAP_FAILED;
+				uring->completionRing = (uint8_t*)MAP_FAILED;
+				uring->submissionEntries = (struct io_uring_sqe*)MAP_FAILED;
+				uring->bufferRing = (struct io_uring_buf_ring*)MAP_FAILED;
 
-		sin.sin6_family = AF_INET6;
-		sin.sin6_port = ENET_HOST_TO_NET_16(address->port);
-		sin.sin6_addr = address->ipv6;
+				params.flags = IORING_SETUP_CQSIZE;
+				params.cq_entries = ENET_URING_COMPLETION_ENTRIES;
 
-		err = getnameinfo((struct sockaddr*)&sin, sizeof(sin), name, nameLength, NULL, 0, NI_NAMEREQD);
+				uring->fd = (int)syscall(__NR_io_uring_setup, ENET_HOST_SEND_BATCH + 1, &params);
 
-		if (!err) {
-			if (name != NULL && nameLength > 0 && !memchr(name, '\0', nameLength))
-				return -1;
+				if (uring->fd < 0 || !(params.features & IORING_FEAT_EXT_ARG) || !(params.features & IORING_FEAT_NODROP))
+					goto failure;
 
-			return 0;
-		}
+				uring->submissionRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+				uring->completionRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
 
-		if (err != EAI_NONAME)
-			return -1;
+				if (params.features & IORING_FEAT_SINGLE_MMAP)
+					uring->submissionRingSize = uring->completionRingSize = ENET_MAX(uring->submissionRingSize, uring->completionRingSize);
 
-		return enet_address_get_ip(address, name, nameLength);
-	}
+				uring->submissionRing = (uint8_t*)mmap(NULL, uring->submissionRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, uring->fd, IORING_OFF_SQ_RING);
 
-/*
-=======================================================================
+				if (uring->submissionRing == MAP_FAILED)
+					goto failure;
 
-	Platform-specific (Unix)
+				if (params.features & IORING_FEAT_SINGLE_MMAP) {
+					uring->completionRing = uring->submissionRing;
+				} else {
+					uring->completionRing = (uint8_t*)mmap(NULL, uring->completionRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, uring->fd, IORING_OFF_CQ_RING);
 
-=======================================================================
-*/
+					if (uring->completionRing == MAP_FAILED)
+						goto failure;
+				}
 
-	#ifndef _WIN32
-		int enet_initialize(void) {
-			return 0;
-		}
+				uring->submissionEntriesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+				uring->submissionEntries = (struct io_uring_sqe*)mmap(NULL, uring->submissionEntriesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, uring->fd, IORING_OFF_SQES);
 
-		void enet_deinitialize(void) { }
+				if (uring->submissionEntries == MAP_FAILED)
+					goto failure;
 
-		uint64_t enet_host_random_seed(void) {
-			struct timeval timeVal;
+				uring->submissionHead = (uint32_t*)(uring->submissionRing + params.sq_off.head);
+				uring->submissionTail = (uint32_t*)(uring->submissionRing + params.sq_off.tail);
+				uring->submissionMask = *(uint32_t*)(uring->submissionRing + params.sq_off.ring_mask);
+				uring->completionHead = (uint32_t*)(uring->completionRing + params.cq_off.head);
+				uring->completionTail = (uint32_t*)(uring->completionRing + params.cq_off.tail);
+				uring->completionMask = *(uint32_t*)(uring->completionRing + params.cq_off.ring_mask);
+				uring->completionEntries = (struct io_uring_cqe*)(uring->completionRing + params.cq_off.cqes);
 
-			gettimeofday(&timeVal, NULL);
+				for (i = 0; i < params.sq_entries; ++i) {
+					((uint32_t*)(uring->submissionRing + params.sq_off.array))[i] = i;
+				}
 
-			return (timeVal.tv_sec * 1000) ^ (timeVal.tv_usec / 1000);
-		}
+				/* Received datagrams land in kernel selected buffers, they are handed back once the protocol has consumed the batch */
+				uring->bufferRingSize = ENET_URING_BUFFER_COUNT * sizeof(struct io_uring_buf);
+				uring->bufferRing = (struct io_uring_buf_ring*)mmap(NULL, uring->bufferRingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+				uring->bufferData = (uint8_t*)enet_malloc(ENET_URING_BUFFER_COUNT * ENET_URING_BUFFER_SIZE);
 
-		int enet_socket_bind(ENetSocket socket, const ENetAddress* address) {
-			struct sockaddr_in6 sin;
+				if (uring->bufferRing == MAP_FAILED || uring->bufferData == NULL)
+					goto failure;
 
-			memset(&sin, 0, sizeof(struct sockaddr_in6));
+				/* Sends are completed after the batch returned, so every datagram is copied to a slot of its own that stays untouched until its completion is reaped */
+				uring->sendData = (uint8_t*)enet_malloc(ENET_HOST_SEND_BATCH * ENET_PROTOCOL_MAXIMUM_MTU);
 
-			sin.sin6_family = AF_INET6;
+				if (uring->sendData == NULL)
+					goto failure;
 
-			if (address != NULL) {
-				sin.sin6_port = ENET_HOST_TO_NET_16(address->port);
-				sin.sin6_addr = address->ipv6;
-			} else {
-				sin.sin6_port = 0;
-				sin.sin6_addr = ENET_HOST_ANY;
-			}
+				memset(&bufferRegistration, 0, sizeof(struct io_uring_buf_reg));
 
-			return bind(socket, (struct sockaddr*)&sin, sizeof(struct sockaddr_in6));
-		}
+				bufferRegistration.ring_addr = (uint64_t)(uintptr_t)uring->bufferRing;
+				bufferRegistration.ring_entries = ENET_URING_BUFFER_COUNT;
+				bufferRegistration.bgid = ENET_URING_BUFFER_GROUP;
 
-		int enet_socket_get_address(ENetSocket socket, ENetAddress* address) {
-			struct sockaddr_storage ss;
-			socklen_t saLength = sizeof(ss);
+				if (syscall(__NR_io_uring_register, uring->fd, IORING_REGISTER_PBUF_RING, &bufferRegistration, 1) < 0)
+					goto failure;
 
-			if (getsockname(socket, (struct sockaddr*)&ss, &saLength) == -1)
-				return -1;
+				for (i = 0; i < ENET_URING_BUFFER_COUNT; ++i) {
+					enet_uring_provide_buffer(uring, (uint16_t)i);
+				}
 
-			if (ss.ss_family == AF_INET) {
-				struct sockaddr_in* sin = (struct sockaddr_in*)&ss;
+				__atomic_store_n(&uring->bufferRing->tail, uring->bufferTail, __ATOMIC_RELEASE);
 
-				memset(address, 0, sizeof(address->ipv4.zeros));
+				uring->receiveMessage.msg_namelen = sizeof(struct sockaddr_in6);
 
-				address->ipv4.ffff = 0xFFFF;
-				address->ipv4.ip = sin->sin_addr;
-				address->port = ENET_NET_TO_HOST_16(sin->sin_port);
-			} else if (ss.ss_family == AF_INET6) {
-				struct sockaddr_in6* sin = (struct sockaddr_in6*)&ss;
+				/* Kernels without multishot receive reject the request as soon as it is issued */
+				if (enet_uring_arm_receive(uring) < 0 || enet_uring_enter(uring, 0, IORING_ENTER_GETEVENTS, NULL, 0) < 0)
+					goto failure;
 
-				address->ipv6 = sin->sin6_addr;
-				address->port = ENET_NET_TO_HOST_16(sin->sin6_port);
-			}
+				enet_uring_reap(uring);
 
-			return 0;
-		}
+				if (uring->receiveError != 0 || !uring->receiveArmed)
+					goto failure;
 
-		int enet_socket_listen(ENetSocket socket, int backlog) {
-			return listen(socket, backlog < 0 ? SOMAXCONN : backlog);
-		}
+				return uring;
 
-		ENetSocket enet_socket_create(ENetSocketType type) {
-			int socketType = (type == ENET_SOCKET_TYPE_DATAGRAM ? SOCK_DGRAM : SOCK_STREAM);
+				failure:
 
-			#ifdef SOCK_CLOEXEC
-				socketType |= SOCK_CLOEXEC;
-			#endif
+				enet_uring_destroy(uring);
 
-			return socket(PF_INET6, socketType, 0);
-		}
+				return NULL;
+			}
 
-		int enet_socket_set_option(ENetSocket socket, ENetSocketOption option, int value) {
-			int result = -1;
+			void enet_uring_destroy(ENetUring* uring) {
+				if (uring->fd >= 0)
+					close(uring->fd);
 
-			switch (option) {
-				case ENET_SOCKOPT_NONBLOCK:
-					result = fcntl(socket, F_SETFL, (value ? O_NONBLOCK : 0) | (fcntl(socket, F_GETFL) & ~O_NONBLOCK));
+				if (uring->bufferData != NULL)
+					enet_free(uring->bufferData);
 
-					break;
+				if (uring->sendData != NULL)
+					enet_free(uring->sendData);
 
-				case ENET_SOCKOPT_BROADCAST:
-					result = setsockopt(socket, SOL_SOCKET, SO_BROADCAST, (char*)&value, sizeof(int));
+				if (uring->bufferRing != MAP_FAILED)
+					munmap(uring->bufferRing, uring->bufferRingSize);
 
-					break;
+				if (uring->submissionEntries != MAP_FAILED)
+					munmap(uring->submissionEntries, uring->submissionEntriesSize);
 
-				case ENET_SOCKOPT_REUSEADDR:
-					result = setsockopt(socket, SOL_SOCKET, SO_REUSEADDR, (char*)&value, sizeof(int));
+				if (uring->completionRing != MAP_FAILED && uring->completionRing != uring->submissionRing)
+					munmap(uring->completionRing, uring->completionRingSize);
 
-					break;
+				if (uring->submissionRing != MAP_FAILED)
+					munmap(uring->submissionRing, uring->submissionRingSize);
 
-				case ENET_SOCKOPT_RCVBUF:
-					result = setsockopt(socket, SOL_SOCKET, SO_RCVBUF, (char*)&value, sizeof(int));
+				enet_free(uring);
+			}
 
-					break;
+			/* Sends the kernel has not picked up yet are turned into no-ops, their slots are free again and their datagrams count as unsent */
+			static void enet_uring_discard_sends(ENetUring* uring) {
+				uint32_t head = __atomic_load_n(uring->submissionHead, __ATOMIC_ACQUIRE), tail = *uring->submissionTail;
 
-				case ENET_SOCKOPT_SNDBUF:
-					result = setsockopt(socket, SOL_SOCKET, SO_SNDBUF, (char*)&value, sizeof(int));
+				for (; head != tail; ++head) {
+					struct io_uring_sqe* sqe = &uring->submissionEntries[head & uring->submissionMask];
 
-					break;
+					if (sqe->user_data >= ENET_HOST_SEND_BATCH)
+						continue;
 
-				case ENET_SOCKOPT_RCVTIMEO: {
-					struct timeval timeVal;
+					uring->sendBusy[sqe->user_data] = 0;
+					--uring->sendPending;
 
-					timeVal.tv_sec = value / 1000;
-					timeVal.tv_usec = (value % 1000) * 1000;
-					result = setsockopt(socket, SOL_SOCKET, SO_RCVTIMEO, (char*)&timeVal, sizeof(struct timeval));
+					memset(sqe, 0, sizeof(struct io_uring_sqe));
 
-					break;
+					sqe->opcode = IORING_OP_NOP;
+					sqe->user_data = ENET_URING_DISCARDED;
 				}
+			}
 
-				case ENET_SOCKOPT_SNDTIMEO: {
-					struct timeval timeVal;
+			int enet_uring_send_batch(ENetUring* uring, const ENetAddress* addresses, ENetBuffer* const* buffers, const size_t* bufferCounts, int* sentLengths, size_t datagramCount, uint32_t timeout) {
+				struct io_uring_getevents_arg argument;
+				struct __kernel_timespec timeSpec;
+				size_t slots[ENET_HOST_SEND_BATCH];
+				size_t i, j, slot = 0;
+				uint32_t start = enet_time_get(), elapsed;
+				int result = 0;
 
-					timeVal.tv_sec = value / 1000;
-					timeVal.tv_usec = (value % 1000) * 1000;
-					result = setsockopt(socket, SOL_SOCKET, SO_SNDTIMEO, (char*)&timeVal, sizeof(struct timeval));
+				if (datagramCount > ENET_HOST_SEND_BATCH)
+					return -1;
 
-					break;
+				for (i = 0; i < datagramCount; ++i) {
+					sentLengths[i] = 0;
 				}
 
-				case ENET_SOCKOPT_NODELAY:
-					result = setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, (char*)&value, sizeof(int));
+				enet_uring_reap(uring);
 
-					break;
+				/* Completions of earlier batches are reaped lazily, the host only waits on them when this batch needs their slots and never past the service timeout */
+				while (ENET_HOST_SEND_BATCH - uring->sendPending < datagramCount) {
+					elapsed = ENET_TIME_DIFFERENCE(enet_time_get(), start);
 
-				case ENET_SOCKOPT_IPV6_V6ONLY:
-					result = setsockopt(socket, IPPROTO_IPV6, IPV6_V6ONLY, (char*)&value, sizeof(int));
+					if (elapsed >= timeout)
+						break;
 
-					break;
+					memset(&argument, 0, sizeof(struct io_uring_getevents_arg));
 
-				case ENET_SOCKOPT_TTL:
-					result = setsockopt(socket, IPPROTO_IP, IP_TTL, (char*)&value, sizeof(int));
+					timeSpec.tv_sec = (timeout - elapsed) / 1000;
+					timeSpec.tv_nsec = ((timeout - elapsed) % 1000) * 1000000;
+					argument.ts = (uint64_t)(uintptr_t)&timeSpec;
 
-					break;
+					if (enet_uring_enter(uring, 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &argument, sizeof(struct io_uring_getevents_arg)) < 0 && errno != ETIME && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+						uring->failed = 1;
 
-				default:
-					break;
-			}
+						return -1;
+					}
 
-			return result == -1 ? -1 : 0;
-		}
+					enet_uring_reap(uring);
+				}
 
-		int enet_socket_get_option(ENetSocket socket, ENetSocketOption option, int* value) {
-			int result = -1;
-			socklen_t len;
+				if (uring->sendError != 0) {
+					errno = uring->sendError;
+					uring->sendError = 0;
+					result = -1;
+				}
 
-			switch (option) {
-				case ENET_SOCKOPT_ERROR:
-					len = sizeof(int);
-					result = getsockopt(socket, SOL_SOCKET, SO_ERROR, value, &len);
+				/* Datagrams without a free slot or a submission entry are reported as unsent, like the rest of a batch that hit a full socket */
+				for (i = 0; i < datagramCount; ++i) {
+					struct io_uring_sqe* sqe;
+					size_t length = 0;
 
-					break;
+					while (slot < ENET_HOST_SEND_BATCH && uring->sendBusy[slot])
+						++slot;
 
-				case ENET_SOCKOPT_TTL:
-		   			len = sizeof(int);
-		   			result = getsockopt(socket, IPPROTO_IP, IP_TTL, (char*)value, &len);
+					if (slot == ENET_HOST_SEND_BATCH)
+						break;
 
-					break;
+					for (j = 0; j < bufferCounts[i]; ++j) {
+						length += buffers[i][j].dataLength;
+					}
 
-				default:
-					break;
-			}
+					if (length > ENET_PROTOCOL_MAXIMUM_MTU)
+						continue;
 
-			return result == -1 ? -1 : 0;
-		}
+					sqe = enet_uring_get_submission(uring);
 
-		int enet_socket_connect(ENetSocket socket, const ENetAddress* address) {
-			int result = -1;
-			struct sockaddr_in6 sin;
+					if (sqe == NULL)
+						break;
+
+					for (j = 0, length = 0; j < bufferCounts[i]; ++j) {
+						memcpy(&uring->sendData[slot * ENET_PROTOCOL_MAXIMUM_MTU + length], buffers[i][j].data, buffers[i][j].dataLength);
+
+						length += buffers[i][j].dataLength;
+					}
+
+					memset(&uring->sendAddresses[slot], 0, sizeof(struct sockaddr_in6));
+					memset(&uring->sendMessages[slot], 0, sizeof(struct msghdr));
+
+					uring->sendVectors[slot].iov_base = &uring->sendData[slot * ENET_PROTOCOL_MAXIMUM_MTU];
+					uring->sendVectors[slot].iov_len = length;
+					uring->sendAddresses[slot].sin6_family = AF_INET6;
+					uring->sendAddresses[slot].sin6_port = ENET_HOST_TO_NET_16(addresses[i].port);
+					uring->sendAddresses[slot].sin6_addr = addresses[i].ipv6;
+					uring->sendMessages[slot].msg_name = &uring->sendAddresses[slot];
+					uring->sendMessages[slot].msg_namelen = sizeof(struct sockaddr_in6);
+					uring->sendMessages[slot].msg_iov = &uring->sendVectors[slot];
+					uring->sendMessages[slot].msg_iovlen = 1;
+
+					sqe->opcode = IORING_OP_SENDMSG;
+					sqe->fd = uring->socket;
+					sqe->addr = (uint64_t)(uintptr_t)&uring->sendMessages[slot];
+					sqe->len = 1;
+					sqe->msg_flags = MSG_NOSIGNAL;
+					sqe->user_data = slot;
+
+					uring->sendBusy[slot] = 1;
+					++uring->sendPending;
+
+					slots[i] = slot;
+					sentLengths[i] = (int)length;
+				}
+
+				/* The batch is only submitted, a send the socket takes at once completes inline and the rest are reaped on the next service */
+				if (uring->submissionPending > 0 && enet_uring_enter(uring, 0, 0, NULL, 0) < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+					/* The ring cannot take submissions anymore, the caller drops it and resends on the socket what the kernel never picked up */
+					enet_uring_discard_sends(uring);
+
+					for (i = 0; i < datagramCount; ++i) {
+						if (sentLengths[i] > 0 && !uring->sendBusy[slots[i]])
+							sentLengths[i] = 0;
+					}
 
-			memset(&sin, 0, sizeof(struct sockaddr_in6));
+					uring->failed = 1;
+					result = -1;
+				}
 
-			sin.sin6_family = AF_INET6;
-			sin.sin6_port = ENET_HOST_TO_NET_16(address->port);
-			sin.sin6_addr = address->ipv6;
+				return result;
+			}
 
-			result = connect(socket, (struct sockaddr*)&sin, sizeof(struct sockaddr_in6));
+			int enet_uring_failed(const ENetUring* uring) {
+				return uring->failed;
+			}
 
-			if (result == -1 && errno == EINPROGRESS)
-				return 0;
+			int enet_uring_receive_batch(ENetUring* uring, ENetAddress* addresses, ENetBuffer* buffers, int* receivedLengths, size_t datagramCount) {
+				size_t i, receivedCount;
 
-			return result;
-		}
+				for (i = 0; i < uring->consumedCount; ++i) {
+					enet_uring_provide_buffer(uring, uring->consumedBuffers[i]);
+				}
 
-		ENetSocket enet_socket_accept(ENetSocket socket, ENetAddress* address) {
-			int result = -1;
-			struct sockaddr_in6 sin;
-			socklen_t sinLength = sizeof(struct sockaddr_in6);
+				if (uring->consumedCount > 0)
+					__atomic_store_n(&uring->bufferRing->tail, uring->bufferTail, __ATOMIC_RELEASE);
 
-			result = accept(socket, address != NULL ? (struct sockaddr*)&sin : NULL, address != NULL ? &sinLength : NULL);
+				uring->consumedCount = 0;
 
-			if (result == -1)
-				return ENET_SOCKET_NULL;
+				enet_uring_reap(uring);
 
-			if (address != NULL) {
-				address->ipv6 = sin.sin6_addr;
-				address->port = ENET_NET_TO_HOST_16(sin.sin6_port);
-			}
+				if (uring->readyCount == 0) {
+					if (enet_uring_arm_receive(uring) < 0 || (enet_uring_enter(uring, 0, IORING_ENTER_GETEVENTS, NULL, 0) < 0 && errno != EINTR))
+						return -1;
 
-			return result;
-		}
+					enet_uring_reap(uring);
+				}
 
-		int enet_socket_shutdown(ENetSocket socket, ENetSocketShutdown how) {
-			return shutdown(socket, (int)how);
-		}
+				if (uring->receiveError != 0 && uring->readyCount == 0) {
+					errno = uring->receiveError;
+					uring->receiveError = 0;
 
-		void enet_socket_destroy(ENetSocket socket) {
-			if (socket != ENET_SOCKET_NULL)
-				close(socket);
-		}
+					return -1;
+				}
 
-		int enet_socket_send(ENetSocket socket, const ENetAddress* address, const ENetBuffer* buffers, size_t bufferCount) {
-			struct msghdr msgHdr;
-			struct sockaddr_in6 sin;
-			int sentLength;
+				receivedCount = ENET_MIN(datagramCount, ENET_MIN(uring->readyCount, ENET_HOST_RECEIVE_BATCH));
 
-			memset(&msgHdr, 0, sizeof(struct msghdr));
+				for (i = 0; i < receivedCount; ++i) {
+					uint16_t bufferID = uring->readyBuffers[uring->readyHead];
+					uint8_t* data = &uring->bufferData[bufferID * ENET_URING_BUFFER_SIZE];
+					struct io_uring_recvmsg_out* out = (struct io_uring_recvmsg_out*)data;
+					struct sockaddr_in6* sin = (struct sockaddr_in6*)(data + sizeof(struct io_uring_recvmsg_out));
 
-			if (address != NULL) {
-				memset(&sin, 0, sizeof(struct sockaddr_in6));
+					buffers[i].data = data + sizeof(struct io_uring_recvmsg_out) + uring->receiveMessage.msg_namelen + uring->receiveMessage.msg_controllen;
+					buffers[i].dataLength = out->payloadlen;
+					receivedLengths[i] = out->flags & MSG_TRUNC ? -2 : (int)out->payloadlen;
+					addresses[i].ipv6 = sin->sin6_addr;
+					addresses[i].port = ENET_NET_TO_HOST_16(sin->sin6_port);
 
-				sin.sin6_family = AF_INET6;
-				sin.sin6_port = ENET_HOST_TO_NET_16(address->port);
-				sin.sin6_addr = address->ipv6;
-				msgHdr.msg_name = &sin;
-				msgHdr.msg_namelen = sizeof(struct sockaddr_in6);
+					uring->consumedBuffers[uring->consumedCount++] = bufferID;
+					uring->readyHead = (uring->readyHead + 1) % ENET_URING_BUFFER_COUNT;
+					--uring->readyCount;
+				}
+
+				return (int)receivedCount;
 			}
 
-			msgHdr.msg_iov = (struct iovec*)buffers;
-			msgHdr.msg_iovlen = bufferCount;
-			sentLength = sendmsg(socket, &msgHdr, MSG_NOSIGNAL);
+			int enet_uring_wait(ENetUring* uring, uint32_t* condition, uint64_t timeout) {
+				struct io_uring_getevents_arg argument;
+				struct __kernel_timespec timeSpec;
+
+				enet_uring_reap(uring);
+
+				if (uring->readyCount > 0) {
+					*condition = ENET_SOCKET_WAIT_RECEIVE;
 
-			if (sentLength == -1) {
-				if (errno == EWOULDBLOCK)
 					return 0;
+				}
 
-				return -1;
-			}
+				if (enet_uring_arm_receive(uring) < 0)
+					return -1;
 
-			return sentLength;
-		}
+				memset(&argument, 0, sizeof(struct io_uring_getevents_arg));
 
-		int enet_socket_receive(ENetSocket socket, ENetAddress* address, ENetBuffer* buffers, size_t bufferCount) {
-			struct msghdr msgHdr;
-			struct sockaddr_in6 sin;
-			int recvLength;
+				timeSpec.tv_sec = timeout / 1000;
+				timeSpec.tv_nsec = (timeout % 1000) * 1000000;
+				argument.ts = (uint64_t)(uintptr_t)&timeSpec;
 
-			memset(&msgHdr, 0, sizeof(struct msghdr));
+				if (enet_uring_enter(uring, 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &argument, sizeof(struct io_uring_getevents_arg)) < 0) {
+					if (errno == EINTR && *condition & ENET_SOCKET_WAIT_INTERRUPT) {
+						*condition = ENET_SOCKET_WAIT_INTERRUPT;
 
-			if (address != NULL) {
-				msgHdr.msg_name = &sin;
-				msgHdr.msg_namelen = sizeof(struct sockaddr_in6);
-			}
+						return 0;
+					}
 
-			msgHdr.msg_iov = (struct iovec*)buffers;
-			msgHdr.msg_iovlen = bufferCount;
-			recvLength = recvmsg(socket, &msgHdr, MSG_NOSIGNAL);
+					if (errno != ETIME && errno != EINTR)
+						return -1;
+				}
 
-			if (recvLength == -1) {
-				if (errno == EWOULDBLOCK)
-					return 0;
+				enet_uring_reap(uring);
 
-				return -1;
-			}
+				*condition = ENET_SOCKET_WAIT_NONE;
 
-			if (msgHdr.msg_flags & MSG_TRUNC)
-				return -2;
+				if (uring->readyCount > 0 || uring->receiveError != 0)
+					*condition = ENET_SOCKET_WAIT_RECEIVE;
 
-			if (address != NULL) {
-				address->ipv6 = sin.sin6_addr;
-				address->port = ENET_NET_TO_HOST_16(sin.sin6_port);
+				return 0;
 			}
-
-			return recvLength;
-		}
+		#endif
 
 		int enet_socket_set_select(ENetSocket maxSocket, ENetSocketSet* readSet, ENetSocketSet* writeSet, uint32_t timeout) {
 			struct timeval timeVal;
@@ -4763,10 +10201,14 @@ extern "C" {
 
 			timeBeginPeriod(1);
 
+			enet_crc64_initialize();
+			enet_crc32c_initialize();
+
 			return 0;
 		}
 
 		void enet_deinitialize(void) {
+			enet_packet_pool_clear();
 			timeEndPeriod(1);
 			WSACleanup();
 		}
@@ -4775,6 +10217,16 @@ extern "C" {
 			return (uint64_t)timeGetTime();
 		}
 
+		/* RtlGenRandom, exported by advapi32 without a header of its own */
+		#ifdef __cplusplus
+			extern "C"
+		#endif
+		BOOLEAN NTAPI SystemFunction036(PVOID, ULONG);
+
+		int enet_random_bytes(void* data, size_t dataLength) {
+			return SystemFunction036(data, (ULONG)dataLength) ? 0 : -1;
+		}
+
 		int enet_socket_bind(ENetSocket socket, const ENetAddress* address) {
 			struct sockaddr_in6 sin;
 
@@ -4883,6 +10335,16 @@ extern "C" {
 
 					break;
 
+				#ifdef IPV6_DONTFRAG
+					case ENET_SOCKOPT_DONTFRAGMENT:
+						result = setsockopt(socket, IPPROTO_IPV6, IPV6_DONTFRAG, (char*)&value, sizeof(int));
+
+						if (result != SOCKET_ERROR)
+							setsockopt(socket, IPPROTO_IP, IP_DONTFRAGMENT, (char*)&value, sizeof(int));
+
+						break;
+				#endif
+
 				default:
 					break;
 			}
@@ -4970,11 +10432,36 @@ extern "C" {
 			}
 
 			if (WSASendTo(socket, (LPWSABUF)buffers, (DWORD)bufferCount, &sentLength, 0, address != NULL ? (struct sockaddr*)&sin : NULL, address != NULL ? sizeof(struct sockaddr_in6) : 0, NULL, NULL) == SOCKET_ERROR)
-				return (WSAGetLastError() == WSAEWOULDBLOCK) ? 0 : -1;
+				return (WSAGetLastError() == WSAEWOULDBLOCK || WSAGetLastError() == WSAEMSGSIZE) ? 0 : -1;
 
 			return (int)sentLength;
 		}
 
+		int enet_socket_send_batch(ENetSocket socket, const ENetAddress* addresses, ENetBuffer* const* buffers, const size_t* bufferCounts, const size_t* segmentSizes, const uint32_t* departureDelays, int* sentLengths, size_t datagramCount) {
+			size_t i;
+
+			(void)departureDelays;
+
+			for (i = 0; i < datagramCount; ++i) {
+				sentLengths[i] = 0;
+			}
+
+			for (i = 0; i < datagramCount; ++i) {
+				if (segmentSizes != NULL && segmentSizes[i] > 0)
+					return -1;
+
+				sentLengths[i] = enet_socket_send(socket, &addresses[i], buffers[i], bufferCounts[i]);
+
+				if (sentLengths[i] < 0) {
+					sentLengths[i] = 0;
+
+					return -1;
+				}
+			}
+
+			return 0;
+		}
+
 		int enet_socket_receive(ENetSocket socket, ENetAddress* address, ENetBuffer* buffers, size_t bufferCount) {
 			INT sinLength = sizeof(struct sockaddr_in6);
 			DWORD flags = 0, recvLength = 0;
@@ -5003,6 +10490,21 @@ extern "C" {
 			return (int)recvLength;
 		}
 
+		int enet_socket_receive_batch(ENetSocket socket, ENetAddress* addresses, ENetBuffer* buffers, int* receivedLengths, int* segmentSizes, size_t datagramCount) {
+			if (datagramCount < 1)
+				return 0;
+
+			if (segmentSizes != NULL)
+				segmentSizes[0] = 0;
+
+			receivedLengths[0] = enet_socket_receive(socket, addresses, buffers, 1);
+
+			if (receivedLengths[0] == -1)
+				return -1;
+
+			return receivedLengths[0] != 0 ? 1 : 0;
+		}
+
 		int enet_socket_set_select(ENetSocket maxSocket, ENetSocketSet* readSet, ENetSocketSet* writeSet, uint32_t timeout) {
 			struct timeval timeVal;
 
@@ -5090,6 +10592,11 @@ extern "C" {
 		return host->connectedPeers;
 	}
 
+	/* Hosts that asked for a backend the kernel refused report the one they fell back to */
+	ENetHostBackend enet_host_get_backend(const ENetHost* host) {
+		return host->uring != NULL ? ENET_HOST_BACKEND_URING : ENET_HOST_BACKEND_POLL;
+	}
+
 	uint32_t enet_host_get_packets_sent(const ENetHost* host) {
 		return host->totalSentPackets;
 	}
@@ -5116,14 +10623,242 @@ extern "C" {
 		host->duplicatePeers = number;
 	}
 
+	void enet_host_set_mtu_callback(ENetHost* host, ENetMtuCallback callback) {
+		host->mtuCallback = callback;
+	}
+
 	void enet_host_set_intercept_callback(ENetHost* host, ENetInterceptCallback callback) {
 		host->interceptCallback = callback;
 	}
 
 	void enet_host_set_checksum_callback(ENetHost* host, ENetChecksumCallback callback) {
+		host->checksum = ENET_CHECKSUM_NONE;
 		host->checksumCallback = callback;
 	}
 
+	/* Both ends still have to enable checksums, the handshake is covered by CRC64 and the algorithm is negotiated in the connect */
+	int enet_host_set_checksum(ENetHost* host, ENetChecksumType type) {
+		if (type < ENET_CHECKSUM_NONE || type >= ENET_CHECKSUM_COUNT)
+			return -1;
+
+		host->checksum = type;
+		host->checksumCallback = type != ENET_CHECKSUM_NONE ? enet_crc64 : NULL;
+
+		return 0;
+	}
+
+	int enet_host_set_segmentation(ENetHost* host, int enabled) {
+		host->segmentation = 0;
+
+		if (!enabled)
+			return 0;
+
+		if (host->uring != NULL)
+			return -1;
+
+		if (enet_socket_set_option(host->socket, ENET_SOCKOPT_SEGMENT, 0) < 0)
+			return -1;
+
+		host->segmentation = 1;
+
+		return 0;
+	}
+
+	int enet_host_set_pacing(ENetHost* host, ENetPacingMode mode) {
+		host->pacing = ENET_PACING_NONE;
+
+		if (mode == ENET_PACING_KERNEL) {
+			/* Departure times are stamped on the monotonic clock and only honoured by the fq queueing discipline, etf expects CLOCK_TAI and drops them, other qdiscs send the datagrams right away */
+			#ifdef ENET_HAS_TXTIME
+				if (host->uring != NULL || enet_socket_set_option(host->socket, ENET_SOCKOPT_TXTIME, 1) < 0)
+					return -1;
+			#else
+				return -1;
+			#endif
+		}
+
+		host->pacing = mode;
+
+		return 0;
+	}
+
+	int enet_host_set_path_mtu_discovery(ENetHost* host, int enabled) {
+		if (!enabled) {
+			host->capabilities &= ~ENET_PROTOCOL_CAPABILITY_PATH_MTU;
+
+			return 0;
+		}
+
+		/* Probes must not be fragmented on the way, otherwise every size would look deliverable, the option is only switched on around their sends */
+		if (enet_socket_set_option(host->socket, ENET_SOCKOPT_DONTFRAGMENT, 0) < 0)
+			return -1;
+
+		host->capabilities |= ENET_PROTOCOL_CAPABILITY_PATH_MTU;
+
+		return 0;
+	}
+
+	int enet_host_set_receive_coalescing(ENetHost* host, int enabled) {
+		if (!enabled) {
+			if (host->receiveCoalescing)
+				enet_socket_set_option(host->socket, ENET_SOCKOPT_GRO, 0);
+
+			host->receiveCoalescing = 0;
+
+			return 0;
+		}
+
+		if (host->uring != NULL)
+			return -1;
+
+		#ifdef ENET_HAS_SEGMENT
+			/* The arena is kept until the host is destroyed, datagrams left over from the last read may still point into it */
+			if (host->receiveArena == NULL) {
+				host->receiveArena = (uint8_t*)enet_malloc(ENET_HOST_RECEIVE_BATCH * ENET_SEGMENT_RECEIVE_SIZE);
+
+				if (host->receiveArena == NULL)
+					return -1;
+			}
+		#endif
+
+		if (enet_socket_set_option(host->socket, ENET_SOCKOPT_GRO, 1) < 0)
+			return -1;
+
+		host->receiveCoalescing = 1;
+
+		return 0;
+	}
+
+	void enet_host_set_selective_acknowledgements(ENetHost* host, int enabled) {
+		if (enabled)
+			host->capabilities |= ENET_PROTOCOL_CAPABILITY_SELECTIVE_ACKNOWLEDGE;
+		else
+			host->capabilities &= ~ENET_PROTOCOL_CAPABILITY_SELECTIVE_ACKNOWLEDGE;
+	}
+
+	void enet_host_set_congestion_control(ENetHost* host, const ENetCongestionControl* congestionControl) {
+		ENetPeer* currentPeer;
+
+		if (congestionControl == NULL)
+			congestionControl = enet_congestion_control_get(ENET_CONGESTION_CONTROL_LEGACY);
+
+		host->congestionControl = congestionControl;
+
+		for (currentPeer = host->peers; currentPeer < &host->peers[host->peerCount]; ++currentPeer) {
+			enet_peer_reset_congestion(currentPeer);
+		}
+	}
+
+	void enet_host_set_aggregation(ENetHost* host, int enabled) {
+		if (enabled)
+			host->capabilities |= ENET_PROTOCOL_CAPABILITY_AGGREGATION;
+		else
+			host->capabilities &= ~ENET_PROTOCOL_CAPABILITY_AGGREGATION;
+	}
+
+	/* Lets connects to servers that never answer fall back to a plain channel count, dropping every capability the host offers */
+	void enet_host_set_legacy_connect(ENetHost* host, int enabled) {
+		host->legacyConnect = enabled ? 1 : 0;
+	}
+
+	/* Compression is only used towards peers that offered it in the handshake, a NULL compressor turns it off for new connections */
+	int enet_host_compress(ENetHost* host, const ENetCompressor* compressor) {
+		if (host->compressor.context != NULL && host->compressor.destroy != NULL)
+			host->compressor.destroy(host->compressor.context);
+
+		host->compressor.context = NULL;
+		host->compressionDictionary = 0;
+		host->capabilities &= ~ENET_PROTOCOL_CAPABILITY_COMPRESSION;
+
+		if (compressor == NULL || compressor->context == NULL)
+			return 0;
+
+		/* Every datagram of a send batch needs its own output buffer until the batch is flushed, the buffers are shared with encryption and kept until the host is destroyed */
+		if (host->stagingData == NULL) {
+			host->stagingData = (uint8_t*)enet_malloc(ENET_HOST_SEND_BATCH * ENET_PROTOCOL_MAXIMUM_MTU);
+
+			if (host->stagingData == NULL) {
+				if (compressor->destroy != NULL)
+					compressor->destroy(compressor->context);
+
+				return -1;
+			}
+		}
+
+		host->compressor = *compressor;
+		host->capabilities |= ENET_PROTOCOL_CAPABILITY_COMPRESSION;
+
+		return 0;
+	}
+
+	int enet_host_compress_with_lz4(ENetHost* host) {
+		ENetCompressor compressor;
+
+		compressor.context = enet_lz4_create();
+
+		if (compressor.context == NULL)
+			return -1;
+
+		compressor.compress = enet_lz4_compress;
+		compressor.decompress = enet_lz4_decompress;
+		compressor.destroy = enet_lz4_destroy;
+
+		return enet_host_compress(host, &compressor);
+	}
+
+	/* The dictionary is referenced by its ID in the handshake, peers holding a different one fall back to no compression */
+	int enet_host_compress_with_lz4_dictionary(ENetHost* host, const void* dictionary, size_t dictionaryLength) {
+		ENetCompressor compressor;
+
+		if (dictionary == NULL || dictionaryLength == 0)
+			return enet_host_compress_with_lz4(host);
+
+		compressor.context = enet_lz4_create();
+
+		if (compressor.context == NULL)
+			return -1;
+
+		compressor.compress = enet_lz4_compress;
+		compressor.decompress = enet_lz4_decompress;
+		compressor.destroy = enet_lz4_destroy;
+
+		enet_lz4_set_dictionary(compressor.context, dictionary, dictionaryLength);
+
+		if (enet_host_compress(host, &compressor) < 0)
+			return -1;
+
+		host->compressionDictionary = enet_lz4_dictionary_id(dictionary, dictionaryLength);
+
+		return 0;
+	}
+
+	/* Keys come from an X25519 exchange in the handshake, the optional pre-shared key shuts out a man in the middle */
+	int enet_host_set_encryption(ENetHost* host, int state, const uint8_t* presharedKey) {
+		if (!state) {
+			host->capabilities &= ~ENET_PROTOCOL_CAPABILITY_ENCRYPTION;
+
+			enet_cipher_wipe(host->presharedKey, sizeof(host->presharedKey));
+
+			return 0;
+		}
+
+		if (host->stagingData == NULL) {
+			host->stagingData = (uint8_t*)enet_malloc(ENET_HOST_SEND_BATCH * ENET_PROTOCOL_MAXIMUM_MTU);
+
+			if (host->stagingData == NULL)
+				return -1;
+		}
+
+		if (presharedKey != NULL)
+			memcpy(host->presharedKey, presharedKey, sizeof(host->presharedKey));
+		else
+			enet_cipher_wipe(host->presharedKey, sizeof(host->presharedKey));
+
+		host->capabilities |= ENET_PROTOCOL_CAPABILITY_ENCRYPTION;
+
+		return 0;
+	}
+
 	uint32_t enet_peer_get_id(const ENetPeer* peer) {
 		return peer->incomingPeerID;
 	}
@@ -5168,6 +10903,10 @@ extern "C" {
 		return peer->totalPacketsLost;
 	}
 
+	uint64_t enet_peer_get_fast_retransmits(const ENetPeer* peer) {
+		return peer->totalFastRetransmits;
+	}
+
 	float enet_peer_get_packets_throttle(const ENetPeer* peer) {
 		return peer->packetThrottle / (float)ENET_PEER_PACKET_THROTTLE_SCALE * 100.0f;
 	}
@@ -0,0 +1,2474 @@
+/*
+ *  ENet reliable UDP networking library
+ *  Copyright (c) 2018 Lee Salzman, Vladyslav Hrytsenko, Dominik Madarász, Stanislav Denisov
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+/*
+ *  Loopback benchmarks for the socket paths of the library.
+ *
+ *  enet_benchmark loopback [-p peers] [-t ticks] [-m messages] [-b poll|uring]
+ *
+ *  A client host with one peer per simulated player sends small unreliable messages to a server host every tick and
+ *  the server answers with a broadcast, the syscalls the server makes on its socket or its ring are counted per datagram.
+ *  enet_benchmark_unbatched is the same program built with ENET_NO_MMSG, so the batched and the unbatched socket
+ *  paths can be compared on one machine. The io_uring backend is compared with -b uring at 500, 2000 and 4000 peers.
+ *  Batching must not change the statistics, the data the server sent adds up over its peers and every peer was sent
+ *  to during the run. Where sendmmsg is used the server has to make fewer send calls than it sends datagrams. A server
+ *  that got its ring must not call recvmsg or sendmsg at all and must enter the ring less often than it moves datagrams,
+ *  a kernel without io_uring leaves the server on poll.
+ *
+ *  enet_benchmark lossy [-l loss] [-n messages] [-s size] [-f threshold] [-a delay] [-c legacy|delay|bbr] [-k none|crc64|crc32c|xxhash64] [-r 0|1]
+ *
+ *  One client peer sends reliable messages to a server while both hosts drop the given percentage of the datagrams
+ *  they receive, once with fast retransmit off and once with the given threshold. Delivery has to be complete and in
+ *  order. The run with fast retransmit has to resend early and leave fewer commands to the retransmission timeout than
+ *  the run without. The drops are seeded, so runs are repeatable. Both hosts use the congestion controller given with -c,
+ *  a controller other than the legacy one has to have sized the reliable window of the client peer by the end of a run
+ *  and, with fast retransmit, finish within half as long again as a third run with the legacy window on the same link,
+ *  which takes a packet given with -s for the window to matter.
+ *  With a checksum given with -k both peers have to agree on it, and one in a hundred of the datagrams that get through
+ *  has a bit flipped, the checksum has to keep those away from the protocol. With -s a single reliable packet of the given
+ *  size follows the messages and has to arrive intact, a packet of more fragments than one reliable window holds covers
+ *  the delivery ring of the receiver. With -a both peers hold their acknowledgements for up to the given milliseconds,
+ *  which must not make the senders resend more than a tenth of the messages on a link without loss. With -r 1 both hosts
+ *  acknowledge selectively, the server has to send selective acknowledgements, and the run with fast retransmit has to
+ *  resend fewer commands than a run on the same link with plain acknowledgements.
+ *
+ *  enet_benchmark timers [-p peers]
+ *
+ *  Idle client peers with a short ping interval have to ping the server about once per interval, then the server stops
+ *  answering and every client peer has to time out between its minimum and its maximum timeout. Both are scheduled on
+ *  the timer wheel, so peers whose deadline is late or missed show up here.
+ *
+ *  enet_benchmark aggregate [-n rounds]
+ *
+ *  Each round the client sends a packet of its own on an aggregating channel, then one packet three times, twice on the
+ *  aggregating channel and once in between on a channel without aggregation. The copies have to share a few commands,
+ *  the reused packet has to stay alive until the client is serviced and be freed once after that, and every message has
+ *  to arrive intact and in order on its channel.
+ *
+ *  enet_benchmark pmtu [-n messages]
+ *
+ *  Both hosts discover the path MTU, which on loopback has to rise above the MTU of the host. Then datagrams larger than
+ *  a limit below the MTU of the host get lost without notice, like behind a tunnel, while the client sends the given
+ *  number of large reliable packets that were cut at the raised MTU. Every packet has to arrive intact and in order, the
+ *  fragments already cut go out in pieces of the fallen back MTU, and the search has to raise the MTU of the client
+ *  peer above the minimum MTU again without passing the limit.
+ *
+ *  enet_benchmark crc [-n buffers]
+ *
+ *  The CRC-64 kernels, the bytewise table loop the library used to run, slicing-by-8 and the PCLMUL folding where the
+ *  CPU has it, have to agree on the given number of random buffers of random length and alignment, enet_crc64 also on
+ *  the same data split in two buffers. Their throughput is then printed in bytes per cycle for a few datagram sizes.
+ *
+ *  enet_benchmark compress [-n datagrams]
+ *
+ *  Random datagrams made of recurring records, one in four of plain noise, are split in up to three buffers and have to
+ *  come out of enet_lz4_decompress the way they went into enet_lz4_compress, unless the compressor gave up on them. Two
+ *  hosts with enet_host_compress_with_lz4 then have to negotiate compression and deliver reliable messages of records
+ *  intact, fragmented ones included, and the datagrams that carry them have to arrive compressed. Both steps run again
+ *  with a dictionary of the records, which has to shrink the same datagrams further. Hosts holding different
+ *  dictionaries, two of them with IDs that agree in their low twelve bits, have to deliver in the clear.
+ *
+ *  enet_benchmark pool [-n packets]
+ *
+ *  A host created with packetPoolPrewarm must leave the packet size classes of the thread alone until it is first
+ *  serviced, and fill them then. Creating and destroying the given number of packets of every size class afterwards
+ *  must not touch the heap, the time per packet is printed. Packets destroyed on another thread have to go back to the
+ *  size class of the thread that created them, and a thread that filled its size classes has to give every block back
+ *  to the heap as it exits, the next thread taking over its record instead of allocating one.
+ *
+ *  enet_benchmark cipher [-n datagrams] [-l loss]
+ *
+ *  X25519 has to reproduce the vectors of RFC 7748, ChaCha20-Poly1305 the AEAD vector of RFC 8439 with the plaintext
+ *  gathered from buffers of every split, and opening has to restore the plaintext and refuse a flipped bit. Sealing and
+ *  opening the given number of datagrams is then timed for a few sizes. Two hosts encrypting with the same preshared key
+ *  and compressing then have to connect over a link that drops the given percentage of datagrams and deliver reliable
+ *  messages of records intact, the client reporting the connection only after a sealed datagram of the server opened.
+ *  Neither host may report a connection when the preshared keys differ or only one of the hosts encrypts.
+ *
+ *  enet_benchmark pacing [-n messages]
+ *
+ *  A client with host pacing and a congestion controller that asks for a fixed rate sends the given number of reliable
+ *  messages at once, each filling a datagram of its own. The time every datagram leaves the pacer is taken, and no
+ *  datagram may leave before the burst the pacer allows plus the rate since the first one covers the bytes sent, nor
+ *  may the last leave much later than the rate requires. Every message has to arrive. Kernel pacing is left out, its
+ *  departure times need the fq queueing discipline, which loopback does not have.
+ */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+	#define _GNU_SOURCE
+#endif
+
+#ifdef __linux__
+	#include <stdarg.h>
+	#include <stdint.h>
+	#include <sys/socket.h>
+	#include <sys/syscall.h>
+	#include <unistd.h>
+
+	/* Calls on the server socket are counted by wrapping the socket functions before the implementation is compiled */
+	static int benchmarkSocket = -1;
+	static uint64_t benchmarkReceiveCalls;
+	static uint64_t benchmarkSendCalls;
+	static int benchmarkRing = -1;
+	static uint64_t benchmarkRingCalls;
+
+	static ssize_t enet_benchmark_recvmsg(int socket, struct msghdr* message, int flags) {
+		if (socket == benchmarkSocket)
+			++benchmarkReceiveCalls;
+
+		return recvmsg(socket, message, flags);
+	}
+
+	#ifndef ENET_NO_MMSG
+		static int enet_benchmark_recvmmsg(int socket, struct mmsghdr* messages, unsigned int count, int flags, struct timespec* timeout) {
+			if (socket == benchmarkSocket)
+				++benchmarkReceiveCalls;
+
+			return recvmmsg(socket, messages, count, flags, timeout);
+		}
+
+		static int enet_benchmark_sendmmsg(int socket, struct mmsghdr* messages, unsigned int count, int flags) {
+			if (socket == benchmarkSocket)
+				++benchmarkSendCalls;
+
+			return sendmmsg(socket, messages, count, flags);
+		}
+	#endif
+
+	static ssize_t enet_benchmark_sendmsg(int socket, const struct msghdr* message, int flags) {
+		if (socket == benchmarkSocket)
+			++benchmarkSendCalls;
+
+		return sendmsg(socket, message, flags);
+	}
+
+	static long enet_benchmark_syscall(long number, ...) {
+		long arguments[6] = { 0 };
+		int i, count = number == SYS_io_uring_setup ? 2 : number == SYS_io_uring_register ? 4 : 6;
+		va_list list;
+
+		va_start(list, number);
+
+		for (i = 0; i < count; ++i) {
+			arguments[i] = va_arg(list, long);
+		}
+
+		va_end(list);
+
+		if (number == SYS_io_uring_enter && (int)arguments[0] == benchmarkRing)
+			++benchmarkRingCalls;
+
+		return syscall(number, arguments[0], arguments[1], arguments[2], arguments[3], arguments[4], arguments[5]);
+	}
+
+	#define recvmsg(...) enet_benchmark_recvmsg(__VA_ARGS__)
+	#define sendmsg(...) enet_benchmark_sendmsg(__VA_ARGS__)
+
+	#ifndef ENET_NO_MMSG
+		#define recvmmsg(...) enet_benchmark_recvmmsg(__VA_ARGS__)
+		#define sendmmsg(...) enet_benchmark_sendmmsg(__VA_ARGS__)
+	#endif
+	#define syscall(...) enet_benchmark_syscall(__VA_ARGS__)
+
+	#define ENET_BENCHMARK_COUNTS_SYSCALLS
+#endif
+
+#define ENET_IMPLEMENTATION
+#include "../enet.h"
+#include <stdio.h>
+
+#if defined(__x86_64__) || defined(_M_X64)
+	#ifdef _MSC_VER
+		#include <intrin.h>
+	#else
+		#include <x86intrin.h>
+	#endif
+
+	#define ENET_BENCHMARK_HAS_TSC
+#endif
+
+#define ENET_BENCHMARK_CHANNELS 2
+#define ENET_BENCHMARK_SLICE 256
+#define ENET_BENCHMARK_CONNECT_TIMEOUT 10000
+#define ENET_BENCHMARK_BUFFER_SIZE (4 * 1024 * 1024)
+#define ENET_BENCHMARK_PING_INTERVAL 60000
+#define ENET_BENCHMARK_LOSSY_TIMEOUT 30000
+#define ENET_BENCHMARK_LOSSY_DELAY 10
+#define ENET_BENCHMARK_LOSSY_WARMUP 250
+#define ENET_BENCHMARK_LOSSY_QUEUE 4096
+#define ENET_BENCHMARK_TIMERS_PING 200
+#define ENET_BENCHMARK_TIMERS_IDLE 2000
+#define ENET_BENCHMARK_TIMERS_MINIMUM 500
+#define ENET_BENCHMARK_TIMERS_MAXIMUM 1000
+#define ENET_BENCHMARK_AGGREGATE_BURST 64
+#define ENET_BENCHMARK_PMTU_LIMIT 1000
+#define ENET_BENCHMARK_PMTU_SIZE 20000
+#define ENET_BENCHMARK_CRC_LENGTH 4096
+#define ENET_BENCHMARK_CRC_BYTES (64 * 1024 * 1024)
+#define ENET_BENCHMARK_COMPRESS_RECORD 24
+#define ENET_BENCHMARK_COMPRESS_RECORDS 16
+#define ENET_BENCHMARK_COMPRESS_MESSAGES 200
+#define ENET_BENCHMARK_COMPRESS_LENGTH 3000
+#define ENET_BENCHMARK_CIPHER_MESSAGES 100
+#define ENET_BENCHMARK_CIPHER_REFUSAL 1000
+#define ENET_BENCHMARK_PACING_RATE 200000
+#define ENET_BENCHMARK_PACING_SIZE 1000
+
+	typedef struct _ENetBenchmarkSetup {
+		size_t peers;
+		size_t ticks;
+		size_t messages;
+		size_t size;
+		ENetHostBackend backend;
+		uint32_t loss;
+		uint32_t threshold;
+		uint32_t acknowledgementDelay;
+		ENetCongestionControlType congestion;
+		ENetChecksumType checksum;
+		int selective;
+	} ENetBenchmarkSetup;
+
+	typedef struct _ENetBenchmarkDatagram {
+		ENetHost* host;
+		ENetAddress address;
+		uint32_t releaseTime;
+		int length;
+		uint8_t data[ENET_PROTOCOL_MAXIMUM_MTU];
+	} ENetBenchmarkDatagram;
+
+	static uint32_t benchmarkLoss;
+	static uint32_t benchmarkRandom;
+	static uint32_t benchmarkDelay;
+	static uint32_t benchmarkCorruption;
+	static uint8_t benchmarkRecords[ENET_BENCHMARK_COMPRESS_RECORDS][ENET_BENCHMARK_COMPRESS_RECORD];
+	static uint32_t benchmarkDatagrams;
+	static uint32_t benchmarkCompressed;
+	static uint32_t benchmarkFreed;
+	static uint32_t benchmarkSelectiveAcknowledgements;
+	static int64_t benchmarkHeapBlocks;
+	static int benchmarkMtuLimit;
+	static ENetHost* benchmarkServer;
+	static ENetHost* benchmarkClient;
+	static ENetBenchmarkDatagram* benchmarkDelayed;
+	static size_t benchmarkDelayedHead;
+	static size_t benchmarkDelayedCount;
+	static uint64_t* benchmarkSendTimes;
+	static uint64_t* benchmarkSendTotals;
+	static size_t benchmarkSendCount;
+	static size_t benchmarkSendCapacity;
+	static uint64_t benchmarkSentBytes;
+
+	/* The lossy link drops a seeded share of the datagrams and holds the rest back for a fixed delay */
+	static int ENET_CALLBACK enet_benchmark_drop(ENetEvent* event, ENetAddress* address, uint8_t* receivedData, int receivedDataLength) {
+		ENetBenchmarkDatagram* datagram;
+
+		(void)event;
+
+		benchmarkRandom = benchmarkRandom * 1103515245 + 12345;
+
+		if ((benchmarkRandom >> 16) % 100 < benchmarkLoss)
+			return 1;
+
+		if (benchmarkDelay == 0)
+			return 0;
+
+		if (benchmarkDelayedCount == ENET_BENCHMARK_LOSSY_QUEUE)
+			return 1;
+
+		datagram = &benchmarkDelayed[(benchmarkDelayedHead + benchmarkDelayedCount++) % ENET_BENCHMARK_LOSSY_QUEUE];
+		datagram->host = address->port == benchmarkServer->address.port ? benchmarkClient : benchmarkServer;
+		datagram->address = *address;
+		datagram->releaseTime = enet_time_get() + benchmarkDelay;
+		datagram->length = receivedDataLength;
+
+		memcpy(datagram->data, receivedData, receivedDataLength);
+
+		benchmarkRandom = benchmarkRandom * 1103515245 + 12345;
+
+		if ((benchmarkRandom >> 16) % 100 < benchmarkCorruption)
+			datagram->data[(benchmarkRandom >> 8) % receivedDataLength] ^= (uint8_t)(1 << (benchmarkRandom % 8));
+
+		return 1;
+	}
+
+	/* The server sends the client nothing but acknowledgements and pings on the lossy link, the count stops at any other command */
+	static int ENET_CALLBACK enet_benchmark_count_selective(ENetEvent* event, ENetAddress* address, uint8_t* receivedData, int receivedDataLength) {
+		uint16_t flags;
+		size_t offset;
+
+		if (receivedDataLength >= (int)sizeof(uint16_t)) {
+			flags = ENET_NET_TO_HOST_16(((ENetProtocolHeader*)receivedData)->peerID);
+			offset = flags & ENET_PROTOCOL_HEADER_FLAG_SENT_TIME ? sizeof(ENetProtocolHeader) : (size_t)&((ENetProtocolHeader*)0)->sentTime;
+
+			while (!(flags & ENET_PROTOCOL_HEADER_FLAG_COMPRESSED) && offset + sizeof(ENetProtocolCommandHeader) <= (size_t)receivedDataLength) {
+				uint8_t commandNumber = receivedData[offset] & ENET_PROTOCOL_COMMAND_MASK;
+
+				if (commandNumber == ENET_PROTOCOL_COMMAND_SELECTIVE_ACKNOWLEDGE)
+					++benchmarkSelectiveAcknowledgements;
+				else if (commandNumber != ENET_PROTOCOL_COMMAND_ACKNOWLEDGE && commandNumber != ENET_PROTOCOL_COMMAND_PING)
+					break;
+
+				offset += enet_protocol_command_size(commandNumber);
+			}
+		}
+
+		return enet_benchmark_drop(event, address, receivedData, receivedDataLength);
+	}
+
+	/* Datagrams whose delay has passed are handed to the protocol as if they had just been read from the socket */
+	static void enet_benchmark_release(void) {
+		uint32_t now = enet_time_get();
+
+		while (benchmarkDelayedCount > 0) {
+			ENetBenchmarkDatagram* datagram = &benchmarkDelayed[benchmarkDelayedHead];
+
+			if (ENET_TIME_LESS(now, datagram->releaseTime))
+				break;
+
+			benchmarkDelayedHead = (benchmarkDelayedHead + 1) % ENET_BENCHMARK_LOSSY_QUEUE;
+			--benchmarkDelayedCount;
+
+			datagram->host->serviceTime = now;
+			datagram->host->receivedAddress = datagram->address;
+			datagram->host->receivedData = datagram->data;
+			datagram->host->receivedDataLength = datagram->length;
+
+			enet_protocol_handle_incoming_commands(datagram->host, NULL);
+		}
+	}
+
+	static uint64_t enet_benchmark_time(void) {
+		#ifdef _WIN32
+			return (uint64_t)enet_time_get() * 1000;
+		#else
+			struct timespec now;
+
+			clock_gettime(CLOCK_MONOTONIC, &now);
+
+			return (uint64_t)now.tv_sec * 1000000 + (uint64_t)now.tv_nsec / 1000;
+		#endif
+	}
+
+	static void enet_benchmark_drain(ENetHost* host) {
+		ENetEvent event;
+
+		while (enet_host_service(host, &event, 0) > 0) {
+			if (event.type == ENET_EVENT_TYPE_CONNECT)
+				enet_peer_ping_interval(event.peer, ENET_BENCHMARK_PING_INTERVAL);
+			else if (event.type == ENET_EVENT_TYPE_RECEIVE)
+				enet_packet_destroy(event.packet);
+		}
+	}
+
+	static int enet_benchmark_connect(ENetHost* server, ENetHost* client, ENetPeer** peers, size_t peerCount) {
+		ENetAddress address;
+		uint32_t start = enet_time_get();
+		size_t connected = 0, i = 0;
+		ENetEvent event;
+
+		memset(&address, 0, sizeof(address));
+		enet_address_set_ip(&address, "127.0.0.1");
+		address.port = server->address.port;
+
+		/* Connecting in slices keeps the handshakes within the socket buffers */
+		while (connected < peerCount) {
+			for (; i < peerCount && i < connected + ENET_BENCHMARK_SLICE; ++i) {
+				peers[i] = enet_host_connect(client, &address, ENET_BENCHMARK_CHANNELS, 0);
+
+				if (peers[i] == NULL)
+					return -1;
+
+				/* Both hosts share one thread, pings would time out behind the other host's service calls and be resent */
+				enet_peer_ping_interval(peers[i], ENET_BENCHMARK_PING_INTERVAL);
+			}
+
+			if (enet_time_get() - start > ENET_BENCHMARK_CONNECT_TIMEOUT)
+				return -1;
+
+			enet_benchmark_release();
+			enet_benchmark_drain(server);
+
+			while (enet_host_service(client, &event, 1) > 0) {
+				if (event.type == ENET_EVENT_TYPE_CONNECT)
+					++connected;
+				else if (event.type == ENET_EVENT_TYPE_DISCONNECT || event.type == ENET_EVENT_TYPE_DISCONNECT_TIMEOUT)
+					return -1;
+			}
+		}
+
+		/* The server reports a peer once the client acknowledged the verify and starts its statistics over then */
+		while (server->connectedPeers < peerCount) {
+			if (enet_time_get() - start > ENET_BENCHMARK_CONNECT_TIMEOUT)
+				return -1;
+
+			enet_benchmark_release();
+			enet_benchmark_drain(client);
+			enet_benchmark_drain(server);
+		}
+
+		return 0;
+	}
+
+	static int enet_benchmark_loopback(const ENetBenchmarkSetup* setup) {
+		ENetHost* server;
+		ENetHost* client;
+		ENetPeer** peers;
+		ENetAddress address;
+		ENetHostOptions options;
+		uint8_t message[32];
+		uint32_t receivedPackets, sentPackets, sentData, startTime;
+		uint64_t start, elapsed, peerData = 0;
+		size_t tick, i, j;
+		int result = -1;
+
+		memset(&address, 0, sizeof(address));
+		address.ipv6 = ENET_HOST_ANY;
+
+		memset(&options, 0, sizeof(options));
+		options.backend = setup->backend;
+
+		server = enet_host_create_with_options(&address, setup->peers, ENET_BENCHMARK_CHANNELS, 0, 0, ENET_BENCHMARK_BUFFER_SIZE, &options);
+		client = enet_host_create(NULL, setup->peers, ENET_BENCHMARK_CHANNELS, 0, 0, ENET_BENCHMARK_BUFFER_SIZE);
+		peers = (ENetPeer**)malloc(setup->peers * sizeof(ENetPeer*));
+
+		if (server == NULL || client == NULL || peers == NULL) {
+			fprintf(stderr, "failed to create the hosts\n");
+
+			return -1;
+		}
+
+		if (enet_benchmark_connect(server, client, peers, setup->peers) < 0) {
+			fprintf(stderr, "failed to connect %u peers\n", (unsigned int)setup->peers);
+
+			goto destroyHosts;
+		}
+
+		#ifdef ENET_BENCHMARK_COUNTS_SYSCALLS
+			benchmarkSocket = server->socket;
+			benchmarkReceiveCalls = 0;
+			benchmarkSendCalls = 0;
+			benchmarkRingCalls = 0;
+
+			#ifdef ENET_HAS_URING
+				if (server->uring != NULL)
+					benchmarkRing = server->uring->fd;
+			#endif
+		#endif
+
+		memset(message, 0xA5, sizeof(message));
+		receivedPackets = server->totalReceivedPackets;
+		sentPackets = server->totalSentPackets;
+		sentData = server->totalSentData;
+
+		for (i = 0; i < setup->peers; ++i) {
+			peerData -= server->peers[i].totalDataSent;
+		}
+
+		startTime = enet_time_get();
+		start = enet_benchmark_time();
+
+		for (tick = 0; tick < setup->ticks; ++tick) {
+			for (i = 0; i < setup->peers; ++i) {
+				for (j = 0; j < setup->messages; ++j)
+					enet_peer_send(peers[i], 0, enet_packet_create(message, sizeof(message), ENET_PACKET_FLAG_UNTHROTTLED));
+
+				if ((i + 1) % ENET_BENCHMARK_SLICE == 0 || i + 1 == setup->peers) {
+					enet_host_flush(client);
+					enet_benchmark_drain(server);
+				}
+			}
+
+			enet_host_broadcast(server, 1, enet_packet_create(message, sizeof(message), ENET_PACKET_FLAG_UNTHROTTLED));
+			enet_host_flush(server);
+			enet_benchmark_drain(client);
+		}
+
+		elapsed = enet_benchmark_time() - start;
+		receivedPackets = server->totalReceivedPackets - receivedPackets;
+		sentPackets = server->totalSentPackets - sentPackets;
+		sentData = server->totalSentData - sentData;
+
+		printf("peers %u, ticks %u, %s backend, %u datagrams received and %u sent in %.1f ms\n", (unsigned int)setup->peers, (unsigned int)setup->ticks, enet_host_get_backend(server) == ENET_HOST_BACKEND_URING ? "uring" : "poll", receivedPackets, sentPackets, elapsed / 1000.0);
+
+		#ifdef ENET_BENCHMARK_COUNTS_SYSCALLS
+			printf("receive: %llu syscalls, %.3f per datagram\n", (unsigned long long)benchmarkReceiveCalls, receivedPackets ? (double)benchmarkReceiveCalls / receivedPackets : 0.0);
+			printf("send: %llu syscalls, %.3f per datagram\n", (unsigned long long)benchmarkSendCalls, sentPackets ? (double)benchmarkSendCalls / sentPackets : 0.0);
+			printf("ring: %llu syscalls, %.3f per datagram\n", (unsigned long long)benchmarkRingCalls, receivedPackets + sentPackets ? (double)benchmarkRingCalls / (receivedPackets + sentPackets) : 0.0);
+
+			#ifndef ENET_NO_MMSG
+				if (enet_host_get_backend(server) == ENET_HOST_BACKEND_POLL && setup->peers > 1 && benchmarkSendCalls >= sentPackets) {
+					fprintf(stderr, "the server made a send call per datagram\n");
+
+					goto destroyHosts;
+				}
+			#endif
+
+			if (enet_host_get_backend(server) == ENET_HOST_BACKEND_URING && (benchmarkReceiveCalls > 0 || benchmarkSendCalls > 0 || benchmarkRingCalls >= receivedPackets + sentPackets)) {
+				fprintf(stderr, "the ring did not take over the socket calls\n");
+
+				goto destroyHosts;
+			}
+		#endif
+
+		for (i = 0; i < setup->peers; ++i) {
+			peerData += server->peers[i].totalDataSent;
+
+			if (ENET_TIME_LESS(server->peers[i].lastSendTime, startTime)) {
+				fprintf(stderr, "peer %u was not sent to during the run\n", (unsigned int)i);
+
+				goto destroyHosts;
+			}
+		}
+
+		if (peerData != sentData) {
+			fprintf(stderr, "the peers were sent %llu bytes, the host %u\n", (unsigned long long)peerData, sentData);
+
+			goto destroyHosts;
+		}
+
+		result = 0;
+
+		destroyHosts:
+
+		free(peers);
+		enet_host_destroy(client);
+		enet_host_destroy(server);
+
+		return result;
+	}
+
+	/* A packet cut into more fragments than the receiver holds in one window has to make it across the lossy link as well */
+	static int enet_benchmark_lossy_packet(const ENetBenchmarkSetup* setup, ENetHost* server, ENetHost* client, ENetPeer* peer, uint32_t start) {
+		ENetPacket* packet = enet_packet_create(NULL, setup->size, ENET_PACKET_FLAG_RELIABLE);
+		ENetEvent event;
+		size_t i;
+
+		if (packet == NULL) {
+			fprintf(stderr, "failed to create a packet of %u bytes\n", (unsigned int)setup->size);
+
+			return -1;
+		}
+
+		for (i = 0; i < setup->size; ++i) {
+			packet->data[i] = (uint8_t)(i * 7 + (i >> 8));
+		}
+
+		if (enet_peer_send(peer, 0, packet) < 0) {
+			fprintf(stderr, "failed to send a packet of %u bytes\n", (unsigned int)setup->size);
+
+			return -1;
+		}
+
+		for (;;) {
+			if (enet_time_get() - start > ENET_BENCHMARK_LOSSY_TIMEOUT) {
+				fprintf(stderr, "the packet of %u bytes was not delivered before the timeout\n", (unsigned int)setup->size);
+
+				return -1;
+			}
+
+			enet_benchmark_release();
+
+			while (enet_host_service(client, &event, 0) > 0) {
+				if (event.type == ENET_EVENT_TYPE_DISCONNECT || event.type == ENET_EVENT_TYPE_DISCONNECT_TIMEOUT) {
+					fprintf(stderr, "disconnected while sending a packet of %u bytes\n", (unsigned int)setup->size);
+
+					return -1;
+				}
+			}
+
+			while (enet_host_service(server, &event, 1) > 0) {
+				if (event.type != ENET_EVENT_TYPE_RECEIVE)
+					continue;
+
+				for (i = 0; i < setup->size && event.packet->dataLength == setup->size; ++i) {
+					if (event.packet->data[i] != (uint8_t)(i * 7 + (i >> 8)))
+						break;
+				}
+
+				enet_packet_destroy(event.packet);
+
+				if (i != setup->size) {
+					fprintf(stderr, "the packet of %u bytes arrived corrupted\n", (unsigned int)setup->size);
+
+					return -1;
+				}
+
+				return 0;
+			}
+		}
+	}
+
+	static int enet_benchmark_lossy_run(const ENetBenchmarkSetup* setup, uint32_t threshold, uint64_t* elapsed, uint64_t* timeoutRetransmits, uint64_t* fastRetransmits) {
+		ENetHost* server;
+		ENetHost* client;
+		ENetPeer* peer;
+		ENetAddress address;
+		ENetEvent event;
+		uint32_t sent = 0, received = 0, start;
+		uint64_t startTime, packetsLost, packetsFast;
+		int result = -1;
+
+		benchmarkRandom = 1;
+		benchmarkLoss = 0;
+		benchmarkDelay = 0;
+		benchmarkDelayedHead = 0;
+		benchmarkDelayedCount = 0;
+		benchmarkSelectiveAcknowledgements = 0;
+
+		memset(&address, 0, sizeof(address));
+		address.ipv6 = ENET_HOST_ANY;
+
+		server = enet_host_create(&address, 1, ENET_BENCHMARK_CHANNELS, 0, 0, 0);
+		client = enet_host_create(NULL, 1, ENET_BENCHMARK_CHANNELS, 0, 0, 0);
+
+		if (server == NULL || client == NULL) {
+			fprintf(stderr, "failed to create the hosts\n");
+
+			goto destroyHosts;
+		}
+
+		benchmarkServer = server;
+		benchmarkClient = client;
+
+		enet_host_set_intercept_callback(server, enet_benchmark_drop);
+		enet_host_set_intercept_callback(client, setup->selective ? enet_benchmark_count_selective : enet_benchmark_drop);
+		enet_host_set_selective_acknowledgements(server, setup->selective);
+		enet_host_set_selective_acknowledgements(client, setup->selective);
+		enet_host_set_congestion_control(server, enet_congestion_control_get(setup->congestion));
+		enet_host_set_congestion_control(client, enet_congestion_control_get(setup->congestion));
+		enet_host_set_checksum(server, setup->checksum);
+		enet_host_set_checksum(client, setup->checksum);
+
+		/* The handshake crosses the same link, so the checksum switch and the first round trip samples see losses as well */
+		benchmarkLoss = setup->loss;
+		benchmarkDelay = ENET_BENCHMARK_LOSSY_DELAY;
+
+		if (enet_benchmark_connect(server, client, &peer, 1) < 0) {
+			fprintf(stderr, "failed to connect\n");
+
+			goto destroyHosts;
+		}
+
+		enet_peer_fast_retransmit(peer, threshold);
+		enet_peer_acknowledgement_delay(peer, setup->acknowledgementDelay, 0);
+		enet_peer_acknowledgement_delay(&server->peers[0], setup->acknowledgementDelay, 0);
+
+		/* The client takes no round trip sample from the handshake, pings bring its retransmission timeout up to the delayed link first */
+		start = enet_time_get();
+
+		while (enet_time_get() - start < ENET_BENCHMARK_LOSSY_WARMUP) {
+			enet_peer_ping(peer);
+			enet_benchmark_release();
+			enet_benchmark_drain(client);
+
+			while (enet_host_service(server, &event, 1) > 0) {
+			}
+		}
+
+		packetsLost = enet_peer_get_packets_lost(peer);
+		packetsFast = enet_peer_get_fast_retransmits(peer);
+		if (peer->checksum != setup->checksum || server->peers[0].checksum != setup->checksum) {
+			fprintf(stderr, "the peers did not agree on the checksum\n");
+
+			goto destroyHosts;
+		}
+
+		benchmarkCorruption = setup->checksum != ENET_CHECKSUM_NONE ? 1 : 0;
+		start = enet_time_get();
+		startTime = enet_benchmark_time();
+
+		while (received < setup->messages) {
+			if (enet_time_get() - start > ENET_BENCHMARK_LOSSY_TIMEOUT) {
+				fprintf(stderr, "%u of %u messages delivered before the timeout\n", received, (unsigned int)setup->messages);
+
+				goto destroyHosts;
+			}
+
+			/* Messages are queued in small bursts, so several of them share a datagram and a millisecond */
+			for (; sent < setup->messages && sent < received + ENET_BENCHMARK_SLICE; ++sent) {
+				enet_peer_send(peer, 0, enet_packet_create(&sent, sizeof(sent), ENET_PACKET_FLAG_RELIABLE));
+			}
+
+			enet_benchmark_release();
+
+			while (enet_host_service(client, &event, 0) > 0) {
+				if (event.type == ENET_EVENT_TYPE_DISCONNECT || event.type == ENET_EVENT_TYPE_DISCONNECT_TIMEOUT) {
+					fprintf(stderr, "disconnected after %u messages\n", received);
+
+					goto destroyHosts;
+				}
+			}
+
+			while (enet_host_service(server, &event, 1) > 0) {
+				if (event.type == ENET_EVENT_TYPE_RECEIVE) {
+					uint32_t index;
+
+					memcpy(&index, event.packet->data, sizeof(index));
+					enet_packet_destroy(event.packet);
+
+					if (index != received) {
+						fprintf(stderr, "message %u delivered in place of %u\n", index, received);
+
+						goto destroyHosts;
+					}
+
+					++received;
+				}
+			}
+		}
+
+		if (setup->size > 0 && enet_benchmark_lossy_packet(setup, server, client, peer, start) < 0)
+			goto destroyHosts;
+
+		if (setup->selective && benchmarkSelectiveAcknowledgements == 0) {
+			fprintf(stderr, "the server sent no selective acknowledgements\n");
+
+			goto destroyHosts;
+		}
+
+		if (setup->congestion != ENET_CONGESTION_CONTROL_LEGACY && peer->congestion.window == 0) {
+			fprintf(stderr, "the congestion controller did not size the window\n");
+
+			goto destroyHosts;
+		}
+
+		*elapsed = enet_benchmark_time() - startTime;
+		*fastRetransmits = enet_peer_get_fast_retransmits(peer) - packetsFast;
+		*timeoutRetransmits = enet_peer_get_packets_lost(peer) - packetsLost - *fastRetransmits;
+		result = 0;
+
+		destroyHosts:
+
+		benchmarkLoss = 0;
+		benchmarkDelay = 0;
+		benchmarkCorruption = 0;
+		benchmarkDelayedCount = 0;
+
+		if (client != NULL)
+			enet_host_destroy(client);
+
+		if (server != NULL)
+			enet_host_destroy(server);
+
+		return result;
+	}
+
+	static int enet_benchmark_lossy(const ENetBenchmarkSetup* setup) {
+		ENetBenchmarkSetup baselineSetup = *setup;
+		uint64_t timeoutElapsed, fastElapsed, baselineElapsed = 0, timeoutRetransmits[3], fastRetransmits[3];
+		int result;
+
+		benchmarkDelayed = (ENetBenchmarkDatagram*)malloc(ENET_BENCHMARK_LOSSY_QUEUE * sizeof(ENetBenchmarkDatagram));
+
+		if (benchmarkDelayed == NULL)
+			return -1;
+
+		result = enet_benchmark_lossy_run(setup, 0, &timeoutElapsed, &timeoutRetransmits[0], &fastRetransmits[0]);
+
+		if (result == 0)
+			result = enet_benchmark_lossy_run(setup, setup->threshold, &fastElapsed, &timeoutRetransmits[1], &fastRetransmits[1]);
+
+		/* The same link with the legacy window and plain acknowledgements is the baseline the controller and selective acknowledgements are held to */
+		if (result == 0 && (setup->congestion != ENET_CONGESTION_CONTROL_LEGACY || setup->selective)) {
+			baselineSetup.congestion = ENET_CONGESTION_CONTROL_LEGACY;
+			baselineSetup.selective = 0;
+			result = enet_benchmark_lossy_run(&baselineSetup, setup->threshold, &baselineElapsed, &timeoutRetransmits[2], &fastRetransmits[2]);
+		}
+
+		free(benchmarkDelayed);
+
+		benchmarkDelayed = NULL;
+
+		if (result < 0)
+			return -1;
+
+		printf("loss %u%%, %u reliable messages delivered in order\n", setup->loss, (unsigned int)setup->messages);
+		printf("timeout retransmit: %.1f ms, %llu timeout resends\n", timeoutElapsed / 1000.0, (unsigned long long)timeoutRetransmits[0]);
+		printf("fast retransmit after %u acknowledgements: %.1f ms, %llu timeout resends, %llu fast resends\n", setup->threshold, fastElapsed / 1000.0, (unsigned long long)timeoutRetransmits[1], (unsigned long long)fastRetransmits[1]);
+
+		if (setup->congestion != ENET_CONGESTION_CONTROL_LEGACY || setup->selective) {
+			printf("%s with fast retransmit: %.1f ms, %llu timeout resends, %llu fast resends\n", setup->selective ? "plain acknowledgements" : "legacy window", baselineElapsed / 1000.0, (unsigned long long)timeoutRetransmits[2], (unsigned long long)fastRetransmits[2]);
+		}
+
+		if (setup->congestion != ENET_CONGESTION_CONTROL_LEGACY) {
+			/* Random loss is no congestion signal, a controller that shrinks its window for it falls behind the legacy window */
+			if (fastElapsed > baselineElapsed + baselineElapsed / 2) {
+				fprintf(stderr, "the congestion controller took %.1f ms where the legacy window took %.1f ms\n", fastElapsed / 1000.0, baselineElapsed / 1000.0);
+
+				return -1;
+			}
+		}
+
+		/* A selective acknowledgement also reports the commands received past a gap, so the sender resends only what is missing */
+		if (setup->selective && setup->loss > 0 && timeoutRetransmits[1] + fastRetransmits[1] >= timeoutRetransmits[2] + fastRetransmits[2]) {
+			fprintf(stderr, "selective acknowledgements did not reduce the resends\n");
+
+			return -1;
+		}
+
+		/* A burst is resent now and then when a round trip sample lags behind the delayed link, a hold that outlasts the retransmission timeout resends nearly every message */
+		if (setup->loss == 0 && (timeoutRetransmits[0] > setup->messages / 10 || timeoutRetransmits[1] > setup->messages / 10)) {
+			fprintf(stderr, "commands were resent on a link without loss\n");
+
+			return -1;
+		}
+
+		if (setup->loss > 0 && (fastRetransmits[0] != 0 || fastRetransmits[1] == 0 || timeoutRetransmits[1] >= timeoutRetransmits[0])) {
+			fprintf(stderr, "fast retransmit did not replace timeout resends\n");
+
+			return -1;
+		}
+
+		return 0;
+	}
+
+	static int enet_benchmark_timers(const ENetBenchmarkSetup* setup) {
+		ENetHost* server;
+		ENetHost* client;
+		ENetPeer** peers;
+		ENetAddress address;
+		ENetEvent event;
+		uint32_t start, elapsed, pings, earliest = ~0u, latest = 0;
+		size_t timedOut = 0, i;
+		int result = -1;
+
+		memset(&address, 0, sizeof(address));
+		address.ipv6 = ENET_HOST_ANY;
+
+		server = enet_host_create(&address, setup->peers, ENET_BENCHMARK_CHANNELS, 0, 0, ENET_BENCHMARK_BUFFER_SIZE);
+		client = enet_host_create(NULL, setup->peers, ENET_BENCHMARK_CHANNELS, 0, 0, ENET_BENCHMARK_BUFFER_SIZE);
+		peers = (ENetPeer**)malloc(setup->peers * sizeof(ENetPeer*));
+
+		if (server == NULL || client == NULL || peers == NULL) {
+			fprintf(stderr, "failed to create the hosts\n");
+
+			goto destroyHosts;
+		}
+
+		if (enet_benchmark_connect(server, client, peers, setup->peers) < 0) {
+			fprintf(stderr, "failed to connect %u peers\n", (unsigned int)setup->peers);
+
+			goto destroyHosts;
+		}
+
+		for (i = 0; i < setup->peers; ++i) {
+			enet_peer_ping_interval(peers[i], ENET_BENCHMARK_TIMERS_PING);
+			enet_peer_timeout(peers[i], 0, ENET_BENCHMARK_TIMERS_MINIMUM, ENET_BENCHMARK_TIMERS_MAXIMUM);
+		}
+
+		pings = server->totalReceivedPackets;
+		start = enet_time_get();
+
+		while (enet_time_get() - start < ENET_BENCHMARK_TIMERS_IDLE) {
+			enet_benchmark_drain(client);
+
+			while (enet_host_service(server, &event, 1) > 0) {
+			}
+		}
+
+		enet_benchmark_drain(client);
+		enet_benchmark_drain(server);
+
+		pings = server->totalReceivedPackets - pings;
+
+		printf("%u peers sent %u datagrams in %u ms with a ping interval of %u ms\n", (unsigned int)setup->peers, pings, ENET_BENCHMARK_TIMERS_IDLE, ENET_BENCHMARK_TIMERS_PING);
+
+		/* Loopback has no round trip sample to start from, so spurious resends only ever add datagrams, a peer whose ping deadline is lost in the timer wheel shows up as too few */
+		if (pings < setup->peers * (ENET_BENCHMARK_TIMERS_IDLE / ENET_BENCHMARK_TIMERS_PING) / 2) {
+			fprintf(stderr, "the peers did not ping once per interval\n");
+
+			goto destroyHosts;
+		}
+
+		/* The server is no longer serviced, so nothing gets acknowledged */
+		start = enet_time_get();
+
+		while (timedOut < setup->peers) {
+			elapsed = enet_time_get() - start;
+
+			if (elapsed > ENET_BENCHMARK_TIMERS_MAXIMUM * 4) {
+				fprintf(stderr, "%u of %u peers timed out\n", (unsigned int)timedOut, (unsigned int)setup->peers);
+
+				goto destroyHosts;
+			}
+
+			while (enet_host_service(client, &event, 1) > 0) {
+				if (event.type != ENET_EVENT_TYPE_DISCONNECT_TIMEOUT)
+					continue;
+
+				elapsed = enet_time_get() - start;
+				earliest = ENET_MIN(earliest, elapsed);
+				latest = ENET_MAX(latest, elapsed);
+
+				++timedOut;
+			}
+		}
+
+		printf("%u peers timed out after %u to %u ms\n", (unsigned int)setup->peers, earliest, latest);
+
+		if (earliest < ENET_BENCHMARK_TIMERS_MINIMUM || latest > ENET_BENCHMARK_TIMERS_MAXIMUM + ENET_BENCHMARK_TIMERS_PING) {
+			fprintf(stderr, "the peers timed out outside %u to %u ms\n", ENET_BENCHMARK_TIMERS_MINIMUM, ENET_BENCHMARK_TIMERS_MAXIMUM + ENET_BENCHMARK_TIMERS_PING);
+
+			goto destroyHosts;
+		}
+
+		result = 0;
+
+		destroyHosts:
+
+		free(peers);
+
+		if (client != NULL)
+			enet_host_destroy(client);
+
+		if (server != NULL)
+			enet_host_destroy(server);
+
+		return result;
+	}
+
+	static void ENET_CALLBACK enet_benchmark_count_free(void* packet) {
+		(void)packet;
+
+		++benchmarkFreed;
+	}
+
+	static int enet_benchmark_aggregate(const ENetBenchmarkSetup* setup) {
+		ENetHost* server;
+		ENetHost* client;
+		ENetPeer* peer;
+		ENetAddress address;
+		ENetEvent event;
+		uint32_t message[2], start, sent = 0, freed, received[ENET_BENCHMARK_CHANNELS] = { 0 };
+		size_t queued;
+		int result = -1;
+
+		memset(&address, 0, sizeof(address));
+		address.ipv6 = ENET_HOST_ANY;
+
+		server = enet_host_create(&address, 1, ENET_BENCHMARK_CHANNELS, 0, 0, 0);
+		client = enet_host_create(NULL, 1, ENET_BENCHMARK_CHANNELS, 0, 0, 0);
+
+		if (server == NULL || client == NULL) {
+			fprintf(stderr, "failed to create the hosts\n");
+
+			goto destroyHosts;
+		}
+
+		enet_host_set_aggregation(server, 1);
+		enet_host_set_aggregation(client, 1);
+
+		if (enet_benchmark_connect(server, client, &peer, 1) < 0) {
+			fprintf(stderr, "failed to connect\n");
+
+			goto destroyHosts;
+		}
+
+		if (!(peer->capabilities & ENET_PROTOCOL_CAPABILITY_AGGREGATION)) {
+			fprintf(stderr, "the peers did not negotiate aggregation\n");
+
+			goto destroyHosts;
+		}
+
+		enet_peer_channel_aggregation(peer, 0, 1);
+
+		benchmarkFreed = 0;
+		start = enet_time_get();
+
+		while (received[1] < setup->messages) {
+			if (enet_time_get() - start > ENET_BENCHMARK_LOSSY_TIMEOUT) {
+				fprintf(stderr, "%u of %u rounds delivered before the timeout\n", received[1], (unsigned int)setup->messages);
+
+				goto destroyHosts;
+			}
+
+			if (sent == received[1]) {
+				queued = enet_list_size(&peer->outgoingSendReliableCommands);
+				freed = benchmarkFreed;
+
+				for (; sent < setup->messages && sent < received[1] + ENET_BENCHMARK_AGGREGATE_BURST; ++sent) {
+					ENetPacket* packet;
+
+					message[0] = sent;
+					message[1] = 0;
+
+					enet_peer_send(peer, 0, enet_packet_create(message, sizeof(message), ENET_PACKET_FLAG_RELIABLE));
+
+					message[1] = 1;
+					packet = enet_packet_create(message, sizeof(message), ENET_PACKET_FLAG_RELIABLE);
+					packet->freeCallback = enet_benchmark_count_free;
+
+					if (enet_peer_send(peer, 0, packet) < 0 || enet_peer_send(peer, 1, packet) < 0 || enet_peer_send(peer, 0, packet) < 0) {
+						fprintf(stderr, "failed to send round %u\n", sent);
+
+						goto destroyHosts;
+					}
+				}
+
+				queued = enet_list_size(&peer->outgoingSendReliableCommands) - queued;
+
+				/* Channel 1 takes a command per round, channel 0 should need no more than a few for the whole burst */
+				if (queued >= 2 * (sent - received[1])) {
+					fprintf(stderr, "%u messages took %u commands\n", 4 * (sent - received[1]), (unsigned int)queued);
+
+					goto destroyHosts;
+				}
+
+				if (benchmarkFreed != freed) {
+					fprintf(stderr, "a packet was freed before the client was serviced\n");
+
+					goto destroyHosts;
+				}
+			}
+
+			while (enet_host_service(client, &event, 0) > 0) {
+				if (event.type == ENET_EVENT_TYPE_DISCONNECT || event.type == ENET_EVENT_TYPE_DISCONNECT_TIMEOUT) {
+					fprintf(stderr, "disconnected after %u rounds\n", received[1]);
+
+					goto destroyHosts;
+				}
+			}
+
+			while (enet_host_service(server, &event, 1) > 0) {
+				uint32_t expected[2];
+
+				if (event.type != ENET_EVENT_TYPE_RECEIVE)
+					continue;
+
+				/* Channel 0 carries a packet of its own and the reused one twice per round */
+				expected[0] = event.channelID == 0 ? received[0] / 3 : received[1];
+				expected[1] = event.channelID == 0 ? (received[0] % 3 != 0) : 1;
+
+				if (event.packet->dataLength != sizeof(message) || memcmp(event.packet->data, expected, sizeof(expected)) != 0) {
+					fprintf(stderr, "channel %u delivered a wrong message after %u\n", event.channelID, received[event.channelID]);
+
+					enet_packet_destroy(event.packet);
+
+					goto destroyHosts;
+				}
+
+				enet_packet_destroy(event.packet);
+
+				++received[event.channelID];
+			}
+		}
+
+		enet_benchmark_drain(client);
+
+		printf("%u rounds of 4 messages delivered, %u reused packets freed\n", (unsigned int)setup->messages, benchmarkFreed);
+
+		if (received[0] != 3 * setup->messages || benchmarkFreed != setup->messages) {
+			fprintf(stderr, "%u messages on the aggregating channel, %u reused packets freed\n", received[0], benchmarkFreed);
+
+			goto destroyHosts;
+		}
+
+		result = 0;
+
+		destroyHosts:
+
+		if (client != NULL)
+			enet_host_destroy(client);
+
+		if (server != NULL)
+			enet_host_destroy(server);
+
+		return result;
+	}
+
+	typedef uint64_t (*ENetBenchmarkCrc)(uint64_t crc, const uint8_t* data, size_t length);
+
+	typedef struct _ENetBenchmarkCrcKernel {
+		const char* name;
+		ENetBenchmarkCrc function;
+	} ENetBenchmarkCrcKernel;
+
+	static uint32_t enet_benchmark_random(void) {
+		benchmarkRandom = benchmarkRandom * 1103515245 + 12345;
+
+		return benchmarkRandom >> 16;
+	}
+
+	static uint64_t enet_benchmark_crc_bytewise(uint64_t crc, const uint8_t* data, size_t length) {
+		while (length-- > 0) {
+			crc = (crc >> 8) ^ crcTable[(uint8_t)crc ^ *data++];
+		}
+
+		return crc;
+	}
+
+	#ifdef ENET_HAS_PCLMUL
+		/* The folding needs one whole lane, enet_crc64 hands shorter buffers to the tables as well */
+		static uint64_t enet_benchmark_crc_pclmul(uint64_t crc, const uint8_t* data, size_t length) {
+			if (length < 16)
+				return enet_crc64_slice(crc, data, length);
+
+			return enet_crc64_pclmul(crc, data, length);
+		}
+	#endif
+
+	static uint64_t enet_benchmark_cycles(void) {
+		#ifdef ENET_BENCHMARK_HAS_TSC
+			return __rdtsc();
+		#else
+			return enet_benchmark_time() * 1000;
+		#endif
+	}
+
+	/* The black hole drops every datagram above the limit without a word, as routers do with don't fragment set */
+	static int ENET_CALLBACK enet_benchmark_black_hole(ENetEvent* event, ENetAddress* address, uint8_t* receivedData, int receivedDataLength) {
+		(void)event;
+		(void)address;
+		(void)receivedData;
+
+		return benchmarkMtuLimit != 0 && receivedDataLength > benchmarkMtuLimit;
+	}
+
+	static int enet_benchmark_pmtu(const ENetBenchmarkSetup* setup) {
+		ENetHost* server;
+		ENetHost* client;
+		ENetPeer* peer;
+		ENetAddress address;
+		ENetEvent event;
+		ENetPacket* packet;
+		uint8_t* data = NULL;
+		uint32_t start, discovered, received = 0;
+		size_t i, j;
+		int result = -1;
+
+		memset(&address, 0, sizeof(address));
+		address.ipv6 = ENET_HOST_ANY;
+
+		server = enet_host_create(&address, 1, 1, 0, 0, 0);
+		client = enet_host_create(NULL, 1, 1, 0, 0, 0);
+		data = (uint8_t*)malloc(ENET_BENCHMARK_PMTU_SIZE);
+
+		if (server == NULL || client == NULL || data == NULL) {
+			fprintf(stderr, "failed to create the hosts\n");
+
+			goto destroyHosts;
+		}
+
+		if (enet_host_set_path_mtu_discovery(server, 1) < 0 || enet_host_set_path_mtu_discovery(client, 1) < 0) {
+			fprintf(stderr, "failed to enable path MTU discovery\n");
+
+			goto destroyHosts;
+		}
+
+		benchmarkMtuLimit = 0;
+		enet_host_set_intercept_callback(server, enet_benchmark_black_hole);
+
+		if (enet_benchmark_connect(server, client, &peer, 1) < 0) {
+			fprintf(stderr, "failed to connect\n");
+
+			goto destroyHosts;
+		}
+
+		start = enet_time_get();
+
+		while (peer->mtu <= client->mtu) {
+			if (enet_time_get() - start > ENET_BENCHMARK_CONNECT_TIMEOUT) {
+				fprintf(stderr, "the MTU stayed at %u\n", peer->mtu);
+
+				goto destroyHosts;
+			}
+
+			enet_benchmark_drain(client);
+
+			if (enet_host_service(server, &event, 1) > 0 && event.type == ENET_EVENT_TYPE_RECEIVE)
+				enet_packet_destroy(event.packet);
+		}
+
+		discovered = peer->mtu;
+		benchmarkMtuLimit = ENET_BENCHMARK_PMTU_LIMIT;
+
+		/* Every packet is cut at the discovered MTU before the black hole shows */
+		for (i = 0; i < setup->messages; ++i) {
+			for (j = 0; j < ENET_BENCHMARK_PMTU_SIZE; ++j) {
+				data[j] = (uint8_t)(i * 7 + j + (j >> 8));
+			}
+
+			if (enet_peer_send(peer, 0, enet_packet_create(data, ENET_BENCHMARK_PMTU_SIZE, ENET_PACKET_FLAG_RELIABLE)) < 0) {
+				fprintf(stderr, "failed to send packet %u\n", (unsigned int)i);
+
+				goto destroyHosts;
+			}
+		}
+
+		start = enet_time_get();
+
+		while (received < setup->messages) {
+			if (enet_time_get() - start > ENET_BENCHMARK_LOSSY_TIMEOUT) {
+				fprintf(stderr, "%u of %u packets delivered behind the black hole, the MTU is %u\n", received, (unsigned int)setup->messages, peer->mtu);
+
+				goto destroyHosts;
+			}
+
+			while (enet_host_service(client, &event, 0) > 0) {
+				if (event.type == ENET_EVENT_TYPE_DISCONNECT || event.type == ENET_EVENT_TYPE_DISCONNECT_TIMEOUT) {
+					fprintf(stderr, "disconnected after %u packets\n", received);
+
+					goto destroyHosts;
+				}
+			}
+
+			while (enet_host_service(server, &event, 1) > 0) {
+				if (event.type != ENET_EVENT_TYPE_RECEIVE)
+					continue;
+
+				packet = event.packet;
+
+				for (j = 0; j < ENET_BENCHMARK_PMTU_SIZE; ++j) {
+					data[j] = (uint8_t)(received * 7 + j + (j >> 8));
+				}
+
+				if (packet->dataLength != ENET_BENCHMARK_PMTU_SIZE || memcmp(packet->data, data, ENET_BENCHMARK_PMTU_SIZE) != 0) {
+					fprintf(stderr, "packet %u arrived damaged\n", received);
+
+					enet_packet_destroy(packet);
+
+					goto destroyHosts;
+				}
+
+				enet_packet_destroy(packet);
+
+				++received;
+			}
+		}
+
+		printf("MTU discovered at %u, %u packets of %u bytes delivered in %u ms behind a black hole above %u\n", discovered, received, ENET_BENCHMARK_PMTU_SIZE, enet_time_get() - start, ENET_BENCHMARK_PMTU_LIMIT);
+
+		start = enet_time_get();
+
+		/* The fallback starts from the minimum MTU, the search has to find its way back up to the limit */
+		while (peer->mtu <= ENET_PROTOCOL_MINIMUM_MTU && enet_time_get() - start < ENET_BENCHMARK_CONNECT_TIMEOUT) {
+			enet_benchmark_drain(client);
+
+			if (enet_host_service(server, &event, 1) > 0 && event.type == ENET_EVENT_TYPE_RECEIVE)
+				enet_packet_destroy(event.packet);
+		}
+
+		printf("MTU back up to %u\n", peer->mtu);
+
+		if (peer->mtu <= ENET_PROTOCOL_MINIMUM_MTU || peer->mtu > ENET_BENCHMARK_PMTU_LIMIT) {
+			fprintf(stderr, "the MTU is %u instead of above %u and at most %u\n", peer->mtu, ENET_PROTOCOL_MINIMUM_MTU, ENET_BENCHMARK_PMTU_LIMIT);
+
+			goto destroyHosts;
+		}
+
+		result = 0;
+
+		destroyHosts:
+
+		benchmarkMtuLimit = 0;
+
+		if (client != NULL)
+			enet_host_destroy(client);
+
+		if (server != NULL)
+			enet_host_destroy(server);
+
+		free(data);
+
+		return result;
+	}
+
+	static int enet_benchmark_crc(const ENetBenchmarkSetup* setup) {
+		static const size_t lengths[] = { 64, 256, 1400, 4096 };
+		ENetBenchmarkCrcKernel kernels[3];
+		size_t kernelCount = 0, i, j, k;
+		uint8_t* data;
+		int result = -1;
+
+		benchmarkRandom = 1;
+		kernels[kernelCount].name = "bytewise";
+		kernels[kernelCount++].function = enet_benchmark_crc_bytewise;
+		kernels[kernelCount].name = "slicing-by-8";
+		kernels[kernelCount++].function = enet_crc64_slice;
+
+		#ifdef ENET_HAS_PCLMUL
+			if (crcKernel == ENET_CRC64_KERNEL_PCLMUL) {
+				kernels[kernelCount].name = "pclmul";
+				kernels[kernelCount++].function = enet_benchmark_crc_pclmul;
+			}
+		#endif
+
+		data = (uint8_t*)malloc(ENET_BENCHMARK_CRC_LENGTH + 16);
+
+		if (data == NULL)
+			return -1;
+
+		/* Lengths and offsets are random, so every tail length and every alignment of the vector loads is covered */
+		for (i = 0; i < setup->messages; ++i) {
+			size_t length = enet_benchmark_random() % (ENET_BENCHMARK_CRC_LENGTH + 1), offset = enet_benchmark_random() % 16, split = length > 0 ? enet_benchmark_random() % length : 0;
+			uint64_t expected;
+			ENetBuffer buffers[2];
+
+			for (j = 0; j < length; ++j) {
+				data[offset + j] = (uint8_t)enet_benchmark_random();
+			}
+
+			expected = enet_benchmark_crc_bytewise(0xFFFFFFFFFFFFFFFF, &data[offset], length);
+
+			for (k = 1; k < kernelCount; ++k) {
+				if (kernels[k].function(0xFFFFFFFFFFFFFFFF, &data[offset], length) != expected) {
+					fprintf(stderr, "%s differs from the bytewise loop on %u bytes at offset %u\n", kernels[k].name, (unsigned int)length, (unsigned int)offset);
+
+					goto freeData;
+				}
+			}
+
+			buffers[0].data = &data[offset];
+			buffers[0].dataLength = split;
+			buffers[1].data = &data[offset + split];
+			buffers[1].dataLength = length - split;
+
+			if (enet_crc64(buffers, 2) != ENET_HOST_TO_NET_64(~expected)) {
+				fprintf(stderr, "enet_crc64 differs from the bytewise loop on %u bytes split after %u\n", (unsigned int)length, (unsigned int)split);
+
+				goto freeData;
+			}
+		}
+
+		printf("%u random buffers agree across %u kernels\n", (unsigned int)setup->messages, (unsigned int)kernelCount);
+
+		for (i = 0; i < sizeof(lengths) / sizeof(lengths[0]); ++i) {
+			size_t rounds = ENET_BENCHMARK_CRC_BYTES / lengths[i];
+
+			printf("%4u bytes:", (unsigned int)lengths[i]);
+
+			for (k = 0; k < kernelCount; ++k) {
+				volatile uint64_t crc = 0;
+				uint64_t start = enet_benchmark_cycles(), elapsed;
+
+				for (j = 0; j < rounds; ++j) {
+					crc = kernels[k].function(crc, data, lengths[i]);
+				}
+
+				elapsed = enet_benchmark_cycles() - start;
+
+				printf(" %s %.2f", kernels[k].name, (double)(rounds * lengths[i]) / (double)(elapsed > 0 ? elapsed : 1));
+			}
+
+			#ifdef ENET_BENCHMARK_HAS_TSC
+				printf(" bytes per cycle\n");
+			#else
+				printf(" bytes per ns\n");
+			#endif
+		}
+
+		result = 0;
+
+		freeData:
+
+		free(data);
+
+		return result;
+	}
+
+	/* Game state compresses because the same records recur with a few bytes changed */
+	static void enet_benchmark_compress_fill(uint8_t* data, size_t length, int noise) {
+		size_t i;
+
+		if (noise && enet_benchmark_random() % 4 == 0) {
+			for (i = 0; i < length; ++i) {
+				data[i] = (uint8_t)enet_benchmark_random();
+			}
+
+			return;
+		}
+
+		for (i = 0; i < length; i += ENET_BENCHMARK_COMPRESS_RECORD) {
+			memcpy(&data[i], benchmarkRecords[enet_benchmark_random() % ENET_BENCHMARK_COMPRESS_RECORDS], ENET_MIN(length - i, (size_t)ENET_BENCHMARK_COMPRESS_RECORD));
+
+			data[i] = (uint8_t)enet_benchmark_random();
+		}
+	}
+
+	static int enet_benchmark_compress_codec(const ENetBenchmarkSetup* setup, const uint8_t* dictionary, size_t dictionaryLength, size_t* inputTotal, size_t* outputTotal) {
+		uint8_t data[ENET_PROTOCOL_MAXIMUM_MTU], compressed[ENET_PROTOCOL_MAXIMUM_MTU], decompressed[ENET_PROTOCOL_MAXIMUM_MTU];
+		void* compressor = enet_lz4_create();
+		void* decompressor = enet_lz4_create();
+		size_t i;
+		int result = -1;
+
+		if (compressor == NULL || decompressor == NULL)
+			goto destroyContexts;
+
+		if (dictionary != NULL) {
+			enet_lz4_set_dictionary(compressor, dictionary, dictionaryLength);
+			enet_lz4_set_dictionary(decompressor, dictionary, dictionaryLength);
+		}
+
+		*inputTotal = 0;
+		*outputTotal = 0;
+
+		for (i = 0; i < setup->messages; ++i) {
+			size_t length = 1 + enet_benchmark_random() % ENET_PROTOCOL_MAXIMUM_MTU, first, second, compressedLength, decompressedLength;
+			ENetBuffer buffers[3];
+
+			enet_benchmark_compress_fill(data, length, 1);
+
+			first = enet_benchmark_random() % (length + 1);
+			second = first + enet_benchmark_random() % (length - first + 1);
+			buffers[0].data = data;
+			buffers[0].dataLength = first;
+			buffers[1].data = &data[first];
+			buffers[1].dataLength = second - first;
+			buffers[2].data = &data[second];
+			buffers[2].dataLength = length - second;
+			compressedLength = enet_lz4_compress(compressor, buffers, 3, length, compressed, length);
+			*inputTotal += length;
+
+			/* Giving up is allowed, the host then sends the datagram as it is */
+			if (compressedLength == 0) {
+				*outputTotal += length;
+
+				continue;
+			}
+
+			decompressedLength = enet_lz4_decompress(decompressor, compressed, compressedLength, decompressed, sizeof(decompressed));
+
+			if (decompressedLength != length || memcmp(decompressed, data, length) != 0) {
+				fprintf(stderr, "a datagram of %u bytes did not survive the round trip%s\n", (unsigned int)length, dictionary != NULL ? " with the dictionary" : "");
+
+				goto destroyContexts;
+			}
+
+			*outputTotal += compressedLength;
+		}
+
+		result = 0;
+
+		destroyContexts:
+
+		if (compressor != NULL)
+			enet_lz4_destroy(compressor);
+
+		if (decompressor != NULL)
+			enet_lz4_destroy(decompressor);
+
+		return result;
+	}
+
+	static int ENET_CALLBACK enet_benchmark_count_compressed(ENetEvent* event, ENetAddress* address, uint8_t* receivedData, int receivedDataLength) {
+		(void)event;
+		(void)address;
+
+		++benchmarkDatagrams;
+
+		if (receivedDataLength >= (int)sizeof(uint16_t) && ENET_NET_TO_HOST_16(((ENetProtocolHeader*)receivedData)->peerID) & ENET_PROTOCOL_HEADER_FLAG_COMPRESSED)
+			++benchmarkCompressed;
+
+		return 0;
+	}
+
+	static int enet_benchmark_compress_hosts(const uint8_t* serverDictionary, const uint8_t* clientDictionary, size_t dictionaryLength, int compressed) {
+		ENetHost* server;
+		ENetHost* client;
+		ENetPeer* peer;
+		ENetAddress address;
+		ENetEvent event;
+		uint8_t* data = (uint8_t*)malloc(ENET_BENCHMARK_COMPRESS_LENGTH);
+		uint32_t start;
+		size_t i;
+		int result = -1;
+
+		memset(&address, 0, sizeof(address));
+		address.ipv6 = ENET_HOST_ANY;
+
+		server = enet_host_create(&address, 1, ENET_BENCHMARK_CHANNELS, 0, 0, 0);
+		client = enet_host_create(NULL, 1, ENET_BENCHMARK_CHANNELS, 0, 0, 0);
+
+		if (server == NULL || client == NULL || data == NULL || enet_host_compress_with_lz4_dictionary(server, serverDictionary, dictionaryLength) < 0 || enet_host_compress_with_lz4_dictionary(client, clientDictionary, dictionaryLength) < 0) {
+			fprintf(stderr, "failed to create the hosts\n");
+
+			goto destroyHosts;
+		}
+
+		if (enet_benchmark_connect(server, client, &peer, 1) < 0) {
+			fprintf(stderr, "failed to connect\n");
+
+			goto destroyHosts;
+		}
+
+		if (!(peer->capabilities & ENET_PROTOCOL_CAPABILITY_COMPRESSION) != !compressed || !(server->peers[0].capabilities & ENET_PROTOCOL_CAPABILITY_COMPRESSION) != !compressed) {
+			fprintf(stderr, compressed ? "the peers did not negotiate compression\n" : "the peers negotiated compression with different dictionaries\n");
+
+			goto destroyHosts;
+		}
+
+		benchmarkDatagrams = 0;
+		benchmarkCompressed = 0;
+
+		enet_host_set_intercept_callback(server, enet_benchmark_count_compressed);
+
+		/* One message at a time, so the one that arrives can be compared with the one still in the buffer */
+		for (i = 0; i < ENET_BENCHMARK_COMPRESS_MESSAGES; ++i) {
+			size_t length = 1 + enet_benchmark_random() % ENET_BENCHMARK_COMPRESS_LENGTH;
+			int received = 0;
+
+			enet_benchmark_compress_fill(data, length, 0);
+			enet_peer_send(peer, 0, enet_packet_create(data, length, ENET_PACKET_FLAG_RELIABLE));
+
+			start = enet_time_get();
+
+			while (!received) {
+				if (enet_time_get() - start > ENET_BENCHMARK_CONNECT_TIMEOUT) {
+					fprintf(stderr, "message %u was not delivered\n", (unsigned int)i);
+
+					goto destroyHosts;
+				}
+
+				enet_benchmark_drain(client);
+
+				while (enet_host_service(server, &event, 1) > 0) {
+					if (event.type != ENET_EVENT_TYPE_RECEIVE)
+						continue;
+
+					received = event.packet->dataLength == length && memcmp(event.packet->data, data, length) == 0;
+
+					enet_packet_destroy(event.packet);
+
+					if (!received) {
+						fprintf(stderr, "message %u of %u bytes arrived damaged\n", (unsigned int)i, (unsigned int)length);
+
+						goto destroyHosts;
+					}
+				}
+			}
+		}
+
+		printf("%u messages delivered, %u of %u datagrams compressed\n", ENET_BENCHMARK_COMPRESS_MESSAGES, benchmarkCompressed, benchmarkDatagrams);
+
+		if ((benchmarkCompressed != 0) != compressed) {
+			fprintf(stderr, compressed ? "no datagram arrived compressed\n" : "datagrams arrived compressed with different dictionaries\n");
+
+			goto destroyHosts;
+		}
+
+		result = 0;
+
+		destroyHosts:
+
+		if (client != NULL)
+			enet_host_destroy(client);
+
+		if (server != NULL)
+			enet_host_destroy(server);
+
+		free(data);
+
+		return result;
+	}
+
+	static int enet_benchmark_compress(const ENetBenchmarkSetup* setup) {
+		uint8_t* dictionary = &benchmarkRecords[0][0];
+		uint8_t other[sizeof(benchmarkRecords)];
+		size_t inputTotal, outputTotal, dictionaryTotal, i, j;
+		uint32_t variant;
+
+		benchmarkRandom = 1;
+
+		for (i = 0; i < ENET_BENCHMARK_COMPRESS_RECORDS; ++i) {
+			for (j = 0; j < ENET_BENCHMARK_COMPRESS_RECORD; ++j) {
+				benchmarkRecords[i][j] = (uint8_t)enet_benchmark_random();
+			}
+		}
+
+		/* Both runs see the same datagrams */
+		benchmarkRandom = 2;
+
+		if (enet_benchmark_compress_codec(setup, NULL, 0, &inputTotal, &outputTotal) < 0)
+			return -1;
+
+		benchmarkRandom = 2;
+
+		if (enet_benchmark_compress_codec(setup, dictionary, sizeof(benchmarkRecords), &inputTotal, &dictionaryTotal) < 0)
+			return -1;
+
+		printf("%u datagrams of %u bytes compressed to %u bytes, %u with the dictionary\n", (unsigned int)setup->messages, (unsigned int)inputTotal, (unsigned int)outputTotal, (unsigned int)dictionaryTotal);
+
+		if (dictionaryTotal >= outputTotal) {
+			fprintf(stderr, "the dictionary did not improve compression\n");
+
+			return -1;
+		}
+
+		if (enet_benchmark_compress_hosts(NULL, NULL, 0, 1) < 0 || enet_benchmark_compress_hosts(dictionary, dictionary, sizeof(benchmarkRecords), 1) < 0 || enet_benchmark_compress_hosts(dictionary, NULL, sizeof(benchmarkRecords), 0) < 0)
+			return -1;
+
+		/* A dictionary whose ID agrees in the low twelve bits, the width the handshake used to carry */
+		memcpy(other, dictionary, sizeof(other));
+
+		for (variant = 0; ; ++variant) {
+			memcpy(&other[sizeof(other) - sizeof(variant)], &variant, sizeof(variant));
+
+			if (memcmp(other, dictionary, sizeof(other)) != 0 && ((enet_lz4_dictionary_id(other, sizeof(other)) ^ enet_lz4_dictionary_id(dictionary, sizeof(other))) & 0xFFF) == 0)
+				break;
+		}
+
+		return enet_benchmark_compress_hosts(dictionary, other, sizeof(other), 0);
+	}
+
+	typedef struct _ENetBenchmarkPoolJob {
+		ENetPacket** packets;
+		size_t count;
+	} ENetBenchmarkPoolJob;
+
+	static void* ENET_CALLBACK enet_benchmark_count_malloc(size_t size) {
+		ENET_ATOMIC_INC(&benchmarkHeapBlocks);
+
+		return malloc(size);
+	}
+
+	static void ENET_CALLBACK enet_benchmark_count_heap_free(void* memory) {
+		if (memory != NULL)
+			ENET_ATOMIC_DEC(&benchmarkHeapBlocks);
+
+		free(memory);
+	}
+
+	/* Given packets the thread destroys them, otherwise it fills every size class of its own */
+	static void enet_benchmark_pool_job(ENetBenchmarkPoolJob* job) {
+		size_t sizeClass, i;
+
+		if (job->packets != NULL) {
+			for (i = 0; i < job->count; ++i) {
+				enet_packet_destroy(job->packets[i]);
+			}
+
+			return;
+		}
+
+		for (sizeClass = 0; sizeClass < ENET_PACKET_POOL_CLASSES; ++sizeClass) {
+			ENetPacketPoolStats stats;
+			ENetPacket* packets[ENET_PACKET_POOL_HIGH_WATER_MARK];
+
+			enet_packet_pool_get_stats(sizeClass, &stats);
+
+			for (i = 0; i < job->count && i < ENET_PACKET_POOL_HIGH_WATER_MARK; ++i) {
+				packets[i] = enet_packet_create(NULL, stats.dataSize, ENET_PACKET_FLAG_NONE);
+			}
+
+			while (i > 0) {
+				enet_packet_destroy(packets[--i]);
+			}
+		}
+	}
+
+	#ifdef _WIN32
+		static DWORD WINAPI enet_benchmark_pool_thread(LPVOID job) {
+			enet_benchmark_pool_job((ENetBenchmarkPoolJob*)job);
+
+			return 0;
+		}
+
+		static int enet_benchmark_pool_run(ENetBenchmarkPoolJob* job) {
+			HANDLE thread = CreateThread(NULL, 0, enet_benchmark_pool_thread, job, 0, NULL);
+
+			if (thread == NULL)
+				return -1;
+
+			WaitForSingleObject(thread, INFINITE);
+			CloseHandle(thread);
+
+			return 0;
+		}
+	#else
+		static void* enet_benchmark_pool_thread(void* job) {
+			enet_benchmark_pool_job((ENetBenchmarkPoolJob*)job);
+
+			return NULL;
+		}
+
+		static int enet_benchmark_pool_run(ENetBenchmarkPoolJob* job) {
+			pthread_t thread;
+
+			if (pthread_create(&thread, NULL, enet_benchmark_pool_thread, job) != 0)
+				return -1;
+
+			return pthread_join(thread, NULL) == 0 ? 0 : -1;
+		}
+	#endif
+
+	static int enet_benchmark_pool(const ENetBenchmarkSetup* setup) {
+		ENetHost* host;
+		ENetHostOptions options;
+		ENetPacketPoolStats stats[ENET_PACKET_POOL_CLASSES];
+		ENetPacket** packets = (ENetPacket**)malloc(setup->messages * sizeof(ENetPacket*));
+		ENetBenchmarkPoolJob job;
+		size_t sizeClass, i, freeCount;
+		uint64_t heapFrees;
+		int64_t heapBlocks;
+		int result = -1;
+
+		memset(&options, 0, sizeof(options));
+		options.packetPoolPrewarm = setup->messages;
+
+		host = enet_host_create_with_options(NULL, 1, ENET_BENCHMARK_CHANNELS, 0, 0, 0, &options);
+
+		if (host == NULL || packets == NULL) {
+			fprintf(stderr, "failed to create the host\n");
+
+			goto destroyHost;
+		}
+
+		for (sizeClass = 0; sizeClass < ENET_PACKET_POOL_CLASSES; ++sizeClass) {
+			if (enet_packet_pool_get_stats(sizeClass, &stats[sizeClass]) < 0 || stats[sizeClass].freeCount != 0) {
+				fprintf(stderr, "the size classes were filled before the host was serviced\n");
+
+				goto destroyHost;
+			}
+		}
+
+		enet_host_service(host, NULL, 0);
+
+		for (sizeClass = 0; sizeClass < ENET_PACKET_POOL_CLASSES; ++sizeClass) {
+			uint64_t start, elapsed;
+
+			enet_packet_pool_get_stats(sizeClass, &stats[sizeClass]);
+
+			if (stats[sizeClass].freeCount != ENET_MIN(setup->messages, stats[sizeClass].highWaterMark)) {
+				fprintf(stderr, "the %u byte size class holds %u packets after the first service\n", (unsigned int)stats[sizeClass].dataSize, (unsigned int)stats[sizeClass].freeCount);
+
+				goto destroyHost;
+			}
+
+			start = enet_benchmark_time();
+
+			for (i = 0; i < stats[sizeClass].freeCount; ++i) {
+				packets[i] = enet_packet_create(NULL, stats[sizeClass].dataSize, ENET_PACKET_FLAG_NONE);
+			}
+
+			for (i = 0; i < stats[sizeClass].freeCount; ++i) {
+				enet_packet_destroy(packets[i]);
+			}
+
+			elapsed = enet_benchmark_time() - start;
+
+			if (enet_packet_pool_get_stats(sizeClass, &stats[sizeClass]) < 0 || stats[sizeClass].heapAllocations != 0) {
+				fprintf(stderr, "the %u byte size class went to the heap after the prewarm\n", (unsigned int)stats[sizeClass].dataSize);
+
+				goto destroyHost;
+			}
+
+			printf("%4u bytes: %u packets, %.1f ns per packet\n", (unsigned int)stats[sizeClass].dataSize, (unsigned int)stats[sizeClass].freeCount, stats[sizeClass].freeCount > 0 ? elapsed * 1000.0 / stats[sizeClass].freeCount : 0.0);
+		}
+
+		/* Packets of the smallest size class are handed to another thread to be destroyed, as a host group broadcast does */
+		job.packets = packets;
+		job.count = stats[0].freeCount;
+
+		for (i = 0; i < job.count; ++i) {
+			packets[i] = enet_packet_create(NULL, stats[0].dataSize, ENET_PACKET_FLAG_NONE);
+		}
+
+		if (enet_benchmark_pool_run(&job) < 0) {
+			fprintf(stderr, "failed to run a thread\n");
+
+			goto destroyHost;
+		}
+
+		freeCount = stats[0].freeCount;
+		heapFrees = stats[0].heapFrees;
+
+		if (enet_packet_pool_get_stats(0, &stats[0]) < 0 || stats[0].freeCount != freeCount || stats[0].heapFrees != heapFrees) {
+			fprintf(stderr, "%u of %u packets destroyed on another thread came back, %u went to the heap\n", (unsigned int)stats[0].freeCount, (unsigned int)freeCount, (unsigned int)(stats[0].heapFrees - heapFrees));
+
+			goto destroyHost;
+		}
+
+		/* Threads that fill their size classes and exit must leave no more on the heap than the record the next one takes over */
+		job.packets = NULL;
+		job.count = setup->messages;
+		heapBlocks = ENET_ATOMIC_READ(&benchmarkHeapBlocks);
+
+		for (i = 0; i < 2; ++i) {
+			if (enet_benchmark_pool_run(&job) < 0) {
+				fprintf(stderr, "failed to run a thread\n");
+
+				goto destroyHost;
+			}
+
+			if (ENET_ATOMIC_READ(&benchmarkHeapBlocks) > heapBlocks + 1) {
+				fprintf(stderr, "thread %u left %d blocks on the heap\n", (unsigned int)i + 1, (int)(ENET_ATOMIC_READ(&benchmarkHeapBlocks) - heapBlocks));
+
+				goto destroyHost;
+			}
+		}
+
+		printf("packets destroyed on another thread came back, exited threads left %d blocks on the heap\n", (int)(ENET_ATOMIC_READ(&benchmarkHeapBlocks) - heapBlocks));
+
+		result = 0;
+
+		destroyHost:
+
+		if (host != NULL)
+			enet_host_destroy(host);
+
+		free(packets);
+
+		return result;
+	}
+
+	static size_t enet_benchmark_hex(const char* hex, uint8_t* out) {
+		size_t length = 0;
+		unsigned int value;
+
+		while (hex[0] != '\0' && sscanf(hex, "%2x", &value) == 1) {
+			out[length++] = (uint8_t)value;
+			hex += 2;
+		}
+
+		return length;
+	}
+
+	static int enet_benchmark_x25519(void) {
+		static const char* vectors[][3] = {
+			/* Section 5.2, scalar, u-coordinate, result */
+			{ "a546e36bf0527c9d3b16154b82465edd62144c0ac1fc5a18506a2244ba449ac4", "e6db6867583030db3594c1a424b15f7c726624ec26b3353b10a903a6d0ab1c4c", "c3da55379de9c6908e94ea4df28d084f32eccf03491c71f754b4075577a28552" },
+			/* Section 6.1, the public keys of Alice and Bob and their shared secret */
+			{ "77076d0a7318a57d3c16c17251b26645df4c2f87ebc0992ab177fba51db92c2a", "0900000000000000000000000000000000000000000000000000000000000000", "8520f0098930a754748b7ddcb43ef75a0dbf3a0d26381af4eba4a98eaa9b4e6a" },
+			{ "5dab087e624a8a4b79e17f8b83800ee66f3bb1292618b6fd1c2f8b27ff88e0eb", "0900000000000000000000000000000000000000000000000000000000000000", "de9edb7d7b7dc1b4d35b61c2ece435373f8343c85b78674dadfc7e146f882b4f" },
+			{ "77076d0a7318a57d3c16c17251b26645df4c2f87ebc0992ab177fba51db92c2a", "de9edb7d7b7dc1b4d35b61c2ece435373f8343c85b78674dadfc7e146f882b4f", "4a5d9d5ba4ce2de1728e3bf480350f25e07e21c947d19e3376f09b3c1e161742" },
+			{ "5dab087e624a8a4b79e17f8b83800ee66f3bb1292618b6fd1c2f8b27ff88e0eb", "8520f0098930a754748b7ddcb43ef75a0dbf3a0d26381af4eba4a98eaa9b4e6a", "4a5d9d5ba4ce2de1728e3bf480350f25e07e21c947d19e3376f09b3c1e161742" }
+		};
+		uint8_t scalar[32], point[32], expected[32], result[32];
+		size_t i;
+
+		for (i = 0; i < sizeof(vectors) / sizeof(vectors[0]); ++i) {
+			enet_benchmark_hex(vectors[i][0], scalar);
+			enet_benchmark_hex(vectors[i][1], point);
+			enet_benchmark_hex(vectors[i][2], expected);
+			enet_x25519(result, scalar, point);
+
+			if (memcmp(result, expected, sizeof(result)) != 0) {
+				fprintf(stderr, "X25519 differs from vector %u of RFC 7748\n", (unsigned int)i);
+
+				return -1;
+			}
+		}
+
+		return 0;
+	}
+
+	/* Section 2.8.2 of RFC 8439 */
+	static int enet_benchmark_aead(void) {
+		static const char plaintext[] = "Ladies and Gentlemen of the class of '99: If I could offer you only one tip for the future, sunscreen would be it.";
+		static const char* ciphertextHex =
+			"d31a8d34648e60db7b86afbc53ef7ec2a4aded51296e08fea9e2b5a736ee62d6"
+			"3dbea45e8ca9671282fafb69da92728b1a71de0a9e060b2905d6a5b67ecd3b36"
+			"92ddbd7f2d778b8c9803aee328091b58fab324e4fad675945585808b4831d7bc"
+			"3ff4def08e4b7a9de576d26586cec64b6116";
+		uint8_t key[32], nonce[12], additionalData[12], expected[sizeof(plaintext) - 1], expectedTag[16], sealed[sizeof(plaintext) - 1], tag[16];
+		size_t length = sizeof(plaintext) - 1, first, second, i;
+		ENetBuffer buffers[3];
+
+		for (i = 0; i < sizeof(key); ++i) {
+			key[i] = (uint8_t)(0x80 + i);
+		}
+
+		enet_benchmark_hex("070000004041424344454647", nonce);
+		enet_benchmark_hex("50515253c0c1c2c3c4c5c6c7", additionalData);
+		enet_benchmark_hex(ciphertextHex, expected);
+		enet_benchmark_hex("1ae10b594f09e26a7e902ecbd0600691", expectedTag);
+
+		/* Every split of the plaintext into three buffers, so each keystream and Poly1305 block boundary falls inside a buffer and between two */
+		for (first = 0; first <= length; ++first) {
+			for (second = first; second <= length; ++second) {
+				buffers[0].data = (void*)plaintext;
+				buffers[0].dataLength = first;
+				buffers[1].data = (void*)&plaintext[first];
+				buffers[1].dataLength = second - first;
+				buffers[2].data = (void*)&plaintext[second];
+				buffers[2].dataLength = length - second;
+
+				if (enet_aead_seal(key, nonce, additionalData, sizeof(additionalData), buffers, 3, sealed, tag) != length || memcmp(sealed, expected, length) != 0 || memcmp(tag, expectedTag, sizeof(tag)) != 0) {
+					fprintf(stderr, "ChaCha20-Poly1305 differs from RFC 8439 with the plaintext split after %u and %u bytes\n", (unsigned int)first, (unsigned int)second);
+
+					return -1;
+				}
+			}
+		}
+
+		if (enet_aead_open(key, nonce, additionalData, sizeof(additionalData), sealed, length, tag) < 0 || memcmp(sealed, plaintext, length) != 0) {
+			fprintf(stderr, "the RFC 8439 ciphertext did not open to its plaintext\n");
+
+			return -1;
+		}
+
+		for (i = 0; i < length * 8; ++i) {
+			memcpy(sealed, expected, length);
+
+			sealed[i / 8] ^= (uint8_t)(1 << (i % 8));
+
+			if (enet_aead_open(key, nonce, additionalData, sizeof(additionalData), sealed, length, expectedTag) == 0) {
+				fprintf(stderr, "a ciphertext with bit %u flipped was opened\n", (unsigned int)i);
+
+				return -1;
+			}
+
+			if (memcmp(sealed, expected, i / 8) != 0) {
+				fprintf(stderr, "a refused ciphertext was decrypted\n");
+
+				return -1;
+			}
+		}
+
+		return 0;
+	}
+
+	/* A host without a preshared key does not encrypt, the client is expected to connect only if both keys agree */
+	static int enet_benchmark_cipher_hosts(const ENetBenchmarkSetup* setup, const uint8_t* serverKey, const uint8_t* clientKey) {
+		ENetHost* server;
+		ENetHost* client;
+		ENetPeer* peer;
+		ENetAddress address;
+		ENetEvent event;
+		uint8_t* messages = (uint8_t*)malloc(ENET_BENCHMARK_CIPHER_MESSAGES * ENET_BENCHMARK_COMPRESS_LENGTH);
+		size_t lengths[ENET_BENCHMARK_CIPHER_MESSAGES];
+		uint32_t sent = 0, received = 0, start;
+		int connects = serverKey != NULL && clientKey != NULL && memcmp(serverKey, clientKey, ENET_PEER_CIPHER_KEY_SIZE) == 0;
+		int connected = 0, result = -1;
+
+		memset(&address, 0, sizeof(address));
+		address.ipv6 = ENET_HOST_ANY;
+
+		server = enet_host_create(&address, 1, ENET_BENCHMARK_CHANNELS, 0, 0, 0);
+		client = enet_host_create(NULL, 1, ENET_BENCHMARK_CHANNELS, 0, 0, 0);
+
+		if (server == NULL || client == NULL || messages == NULL || enet_host_compress_with_lz4(server) < 0 || enet_host_compress_with_lz4(client) < 0 || (serverKey != NULL && enet_host_set_encryption(server, 1, serverKey) < 0) || (clientKey != NULL && enet_host_set_encryption(client, 1, clientKey) < 0)) {
+			fprintf(stderr, "failed to create the hosts\n");
+
+			goto destroyHosts;
+		}
+
+		for (sent = 0; sent < ENET_BENCHMARK_CIPHER_MESSAGES; ++sent) {
+			lengths[sent] = 1 + enet_benchmark_random() % ENET_BENCHMARK_COMPRESS_LENGTH;
+
+			enet_benchmark_compress_fill(&messages[sent * ENET_BENCHMARK_COMPRESS_LENGTH], lengths[sent], 0);
+		}
+
+		benchmarkServer = server;
+		benchmarkClient = client;
+		benchmarkRandom = 1;
+		benchmarkLoss = setup->loss;
+		benchmarkDelay = ENET_BENCHMARK_LOSSY_DELAY;
+		benchmarkDelayedHead = 0;
+		benchmarkDelayedCount = 0;
+
+		enet_host_set_intercept_callback(server, enet_benchmark_drop);
+		enet_host_set_intercept_callback(client, enet_benchmark_drop);
+		enet_address_set_ip(&address, "127.0.0.1");
+
+		address.port = server->address.port;
+		peer = enet_host_connect(client, &address, ENET_BENCHMARK_CHANNELS, 0);
+
+		if (peer == NULL) {
+			fprintf(stderr, "failed to connect\n");
+
+			goto destroyHosts;
+		}
+
+		enet_peer_ping_interval(peer, ENET_BENCHMARK_PING_INTERVAL);
+
+		/* A refused client gives up quickly instead of resending its handshake for the default timeout */
+		if (!connects)
+			enet_peer_timeout(peer, 0, ENET_BENCHMARK_CIPHER_REFUSAL, ENET_BENCHMARK_CIPHER_REFUSAL);
+
+		start = enet_time_get();
+
+		while (!connected) {
+			if (enet_time_get() - start > ENET_BENCHMARK_CONNECT_TIMEOUT) {
+				fprintf(stderr, "the client neither connected nor gave up\n");
+
+				goto destroyHosts;
+			}
+
+			enet_benchmark_release();
+
+			while (enet_host_service(server, &event, 0) > 0) {
+				if (event.type == ENET_EVENT_TYPE_CONNECT && !connects) {
+					fprintf(stderr, "the server connected a client it cannot authenticate\n");
+
+					goto destroyHosts;
+				}
+			}
+
+			while (enet_host_service(client, &event, 1) > 0) {
+				if (event.type == ENET_EVENT_TYPE_DISCONNECT || event.type == ENET_EVENT_TYPE_DISCONNECT_TIMEOUT) {
+					if (connects) {
+						fprintf(stderr, "failed to connect\n");
+
+						goto destroyHosts;
+					}
+
+					printf("a client with %s was refused\n", serverKey != NULL && clientKey != NULL ? "a different preshared key" : "a different encryption setting");
+
+					result = 0;
+
+					goto destroyHosts;
+				} else if (event.type == ENET_EVENT_TYPE_CONNECT) {
+					if (!connects) {
+						fprintf(stderr, "the client connected to a server it cannot authenticate\n");
+
+						goto destroyHosts;
+					}
+
+					if (peer->cipher == NULL || peer->cipher->receiveCounter == 0) {
+						fprintf(stderr, "the client connected before a sealed datagram of the server opened\n");
+
+						goto destroyHosts;
+					}
+
+					connected = 1;
+				}
+			}
+		}
+
+		if (!(peer->capabilities & ENET_PROTOCOL_CAPABILITY_COMPRESSION) || !(peer->capabilities & ENET_PROTOCOL_CAPABILITY_ENCRYPTION)) {
+			fprintf(stderr, "the peers did not negotiate compression and encryption\n");
+
+			goto destroyHosts;
+		}
+
+		start = enet_time_get();
+
+		for (sent = 0; sent < ENET_BENCHMARK_CIPHER_MESSAGES; ++sent) {
+			enet_peer_send(peer, 0, enet_packet_create(&messages[sent * ENET_BENCHMARK_COMPRESS_LENGTH], lengths[sent], ENET_PACKET_FLAG_RELIABLE));
+		}
+
+		while (received < ENET_BENCHMARK_CIPHER_MESSAGES) {
+			if (enet_time_get() - start > ENET_BENCHMARK_LOSSY_TIMEOUT) {
+				fprintf(stderr, "%u of %u messages delivered before the timeout\n", received, ENET_BENCHMARK_CIPHER_MESSAGES);
+
+				goto destroyHosts;
+			}
+
+			enet_benchmark_release();
+
+			while (enet_host_service(client, &event, 0) > 0) {
+				if (event.type == ENET_EVENT_TYPE_DISCONNECT || event.type == ENET_EVENT_TYPE_DISCONNECT_TIMEOUT) {
+					fprintf(stderr, "disconnected after %u messages\n", received);
+
+					goto destroyHosts;
+				}
+			}
+
+			while (enet_host_service(server, &event, 1) > 0) {
+				if (event.type != ENET_EVENT_TYPE_RECEIVE)
+					continue;
+
+				if (event.packet->dataLength != lengths[received] || memcmp(event.packet->data, &messages[received * ENET_BENCHMARK_COMPRESS_LENGTH], lengths[received]) != 0) {
+					fprintf(stderr, "message %u of %u bytes arrived damaged\n", received, (unsigned int)lengths[received]);
+
+					enet_packet_destroy(event.packet);
+
+					goto destroyHosts;
+				}
+
+				enet_packet_destroy(event.packet);
+
+				++received;
+			}
+		}
+
+		printf("loss %u%%, %u sealed and compressed messages delivered intact\n", setup->loss, ENET_BENCHMARK_CIPHER_MESSAGES);
+
+		result = 0;
+
+		destroyHosts:
+
+		benchmarkLoss = 0;
+		benchmarkDelay = 0;
+		benchmarkDelayedCount = 0;
+
+		if (client != NULL)
+			enet_host_destroy(client);
+
+		if (server != NULL)
+			enet_host_destroy(server);
+
+		free(messages);
+
+		return result;
+	}
+
+	static int enet_benchmark_cipher(const ENetBenchmarkSetup* setup) {
+		static const size_t lengths[] = { 64, 256, 1400 };
+		uint8_t key[32] = { 0 }, nonce[12] = { 0 }, tag[16], data[1400], sealed[1400], presharedKey[ENET_PEER_CIPHER_KEY_SIZE], otherKey[ENET_PEER_CIPHER_KEY_SIZE];
+		size_t i, j;
+		int result;
+
+		if (enet_benchmark_x25519() < 0 || enet_benchmark_aead() < 0)
+			return -1;
+
+		printf("X25519 and ChaCha20-Poly1305 reproduce RFC 7748 and RFC 8439\n");
+
+		memset(data, 0xA5, sizeof(data));
+
+		for (i = 0; i < sizeof(lengths) / sizeof(lengths[0]); ++i) {
+			ENetBuffer buffer;
+			uint64_t start, elapsed;
+
+			buffer.data = data;
+			buffer.dataLength = lengths[i];
+			start = enet_benchmark_cycles();
+
+			for (j = 0; j < setup->messages; ++j) {
+				enet_cipher_store64(&nonce[4], j);
+				enet_aead_seal(key, nonce, nonce, sizeof(nonce), &buffer, 1, sealed, tag);
+
+				if (enet_aead_open(key, nonce, nonce, sizeof(nonce), sealed, lengths[i], tag) < 0) {
+					fprintf(stderr, "a sealed datagram of %u bytes did not open\n", (unsigned int)lengths[i]);
+
+					return -1;
+				}
+			}
+
+			elapsed = enet_benchmark_cycles() - start;
+
+			#ifdef ENET_BENCHMARK_HAS_TSC
+				printf("%4u bytes: sealed and opened at %.2f bytes per cycle\n", (unsigned int)lengths[i], (double)(setup->messages * lengths[i]) / (double)(elapsed > 0 ? elapsed : 1));
+			#else
+				printf("%4u bytes: sealed and opened at %.2f bytes per ns\n", (unsigned int)lengths[i], (double)(setup->messages * lengths[i]) / (double)(elapsed > 0 ? elapsed : 1));
+			#endif
+		}
+
+		benchmarkRandom = 1;
+
+		for (i = 0; i < ENET_BENCHMARK_COMPRESS_RECORDS; ++i) {
+			for (j = 0; j < ENET_BENCHMARK_COMPRESS_RECORD; ++j) {
+				benchmarkRecords[i][j] = (uint8_t)enet_benchmark_random();
+			}
+		}
+
+		for (i = 0; i < sizeof(presharedKey); ++i) {
+			presharedKey[i] = (uint8_t)enet_benchmark_random();
+			otherKey[i] = presharedKey[i];
+		}
+
+		otherKey[0] ^= 1;
+		benchmarkDelayed = (ENetBenchmarkDatagram*)malloc(ENET_BENCHMARK_LOSSY_QUEUE * sizeof(ENetBenchmarkDatagram));
+
+		if (benchmarkDelayed == NULL)
+			return -1;
+
+		result = enet_benchmark_cipher_hosts(setup, presharedKey, presharedKey);
+
+		if (result == 0)
+			result = enet_benchmark_cipher_hosts(setup, presharedKey, otherKey);
+
+		if (result == 0)
+			result = enet_benchmark_cipher_hosts(setup, presharedKey, NULL);
+
+		if (result == 0)
+			result = enet_benchmark_cipher_hosts(setup, NULL, presharedKey);
+
+		free(benchmarkDelayed);
+
+		benchmarkDelayed = NULL;
+
+		return result;
+	}
+
+	static void ENET_CALLBACK enet_benchmark_paced_acknowledge(ENetPeer* peer, uint32_t roundTripTime, uint32_t acknowledgedBytes) {
+		(void)peer;
+		(void)roundTripTime;
+		(void)acknowledgedBytes;
+	}
+
+	/* Acknowledgements and pings draw on the same credit, only the datagrams that carry a message are timed */
+	static void ENET_CALLBACK enet_benchmark_paced_send(ENetPeer* peer, uint32_t sentBytes) {
+		(void)peer;
+
+		benchmarkSentBytes += sentBytes;
+
+		if (sentBytes >= ENET_BENCHMARK_PACING_SIZE && benchmarkSendCount < benchmarkSendCapacity) {
+			benchmarkSendTimes[benchmarkSendCount] = enet_benchmark_time();
+			benchmarkSendTotals[benchmarkSendCount++] = benchmarkSentBytes;
+		}
+	}
+
+	static uint32_t ENET_CALLBACK enet_benchmark_paced_window(ENetPeer* peer) {
+		return peer->windowSize;
+	}
+
+	static uint32_t ENET_CALLBACK enet_benchmark_paced_rate(ENetPeer* peer) {
+		(void)peer;
+
+		return ENET_BENCHMARK_PACING_RATE;
+	}
+
+	static int enet_benchmark_pacing(const ENetBenchmarkSetup* setup) {
+		static const ENetCongestionControl pacedControl = { NULL, enet_benchmark_paced_acknowledge, NULL, enet_benchmark_paced_send, enet_benchmark_paced_window, enet_benchmark_paced_rate };
+		ENetHost* server;
+		ENetHost* client;
+		ENetPeer* peer;
+		ENetAddress address;
+		ENetEvent event;
+		uint8_t message[ENET_BENCHMARK_PACING_SIZE];
+		uint64_t burst, base, expected, elapsed;
+		size_t received = 0, i;
+		uint32_t start;
+		int result = -1;
+
+		memset(&address, 0, sizeof(address));
+		address.ipv6 = ENET_HOST_ANY;
+
+		server = enet_host_create(&address, 1, ENET_BENCHMARK_CHANNELS, 0, 0, 0);
+		client = enet_host_create(NULL, 1, ENET_BENCHMARK_CHANNELS, 0, 0, 0);
+		benchmarkSendTimes = (uint64_t*)malloc(setup->messages * sizeof(uint64_t));
+		benchmarkSendTotals = (uint64_t*)malloc(setup->messages * sizeof(uint64_t));
+		benchmarkSendCapacity = setup->messages;
+
+		if (server == NULL || client == NULL || benchmarkSendTimes == NULL || benchmarkSendTotals == NULL || enet_host_set_pacing(client, ENET_PACING_HOST) < 0) {
+			fprintf(stderr, "failed to create the hosts\n");
+
+			goto destroyHosts;
+		}
+
+		enet_host_set_congestion_control(client, &pacedControl);
+
+		if (enet_benchmark_connect(server, client, &peer, 1) < 0) {
+			fprintf(stderr, "failed to connect\n");
+
+			goto destroyHosts;
+		}
+
+		memset(message, 0x5A, sizeof(message));
+
+		benchmarkSendCount = 0;
+
+		for (i = 0; i < setup->messages; ++i) {
+			enet_peer_send(peer, 0, enet_packet_create(message, sizeof(message), ENET_PACKET_FLAG_RELIABLE));
+		}
+
+		start = enet_time_get();
+
+		while (received < setup->messages) {
+			if (enet_time_get() - start > ENET_BENCHMARK_CONNECT_TIMEOUT) {
+				fprintf(stderr, "%u of %u messages delivered before the timeout\n", (unsigned int)received, (unsigned int)setup->messages);
+
+				goto destroyHosts;
+			}
+
+			enet_benchmark_drain(client);
+
+			while (enet_host_service(server, &event, 1) > 0) {
+				if (event.type == ENET_EVENT_TYPE_RECEIVE) {
+					enet_packet_destroy(event.packet);
+
+					++received;
+				}
+			}
+		}
+
+		if (benchmarkSendCount == 0 || benchmarkSendCount != setup->messages) {
+			fprintf(stderr, "%u of %u messages left the pacer in datagrams of their own\n", (unsigned int)benchmarkSendCount, (unsigned int)setup->messages);
+
+			goto destroyHosts;
+		}
+
+		/* The credit tops out at the burst and a send may overdraw it by its datagram, the millisecond clock of the host and stray acknowledgements get a datagram of slack */
+		burst = (uint64_t)ENET_PEER_PACING_BURST * peer->mtu + 2 * peer->mtu;
+		base = benchmarkSendTotals[0] - ENET_BENCHMARK_PACING_SIZE;
+
+		for (i = 1; i < benchmarkSendCount; ++i) {
+			elapsed = benchmarkSendTimes[i] - benchmarkSendTimes[0];
+
+			if (benchmarkSendTotals[i] - base > burst + (uint64_t)ENET_BENCHMARK_PACING_RATE * (elapsed + 1000) / 1000000) {
+				fprintf(stderr, "datagram %u left %.1f ms after the first with %u bytes sent, ahead of the rate\n", (unsigned int)i, elapsed / 1000.0, (unsigned int)(benchmarkSendTotals[i] - base));
+
+				goto destroyHosts;
+			}
+		}
+
+		elapsed = benchmarkSendTimes[benchmarkSendCount - 1] - benchmarkSendTimes[0];
+		expected = benchmarkSendTotals[benchmarkSendCount - 1] - base > burst ? (benchmarkSendTotals[benchmarkSendCount - 1] - base - burst) * 1000000 / ENET_BENCHMARK_PACING_RATE : 0;
+
+		printf("%u datagrams paced at %u bytes per second: %.1f ms, %.1f ms at least\n", (unsigned int)benchmarkSendCount, ENET_BENCHMARK_PACING_RATE, elapsed / 1000.0, expected / 1000.0);
+
+		if (elapsed > 2 * expected + 50000) {
+			fprintf(stderr, "the pacer held the datagrams back longer than the rate requires\n");
+
+			goto destroyHosts;
+		}
+
+		result = 0;
+
+		destroyHosts:
+
+		if (client != NULL)
+			enet_host_destroy(client);
+
+		if (server != NULL)
+			enet_host_destroy(server);
+
+		free(benchmarkSendTimes);
+		free(benchmarkSendTotals);
+
+		benchmarkSendTimes = NULL;
+		benchmarkSendTotals = NULL;
+		benchmarkSendCapacity = 0;
+
+		return result;
+	}
+
+	static void enet_benchmark_usage(void) {
+		fprintf(stderr, "usage: enet_benchmark loopback [-p peers] [-t ticks] [-m messages] [-b poll|uring]\n");
+		fprintf(stderr, "       enet_benchmark lossy [-l loss] [-n messages] [-s size] [-f threshold] [-a delay] [-c legacy|delay|bbr] [-k none|crc64|crc32c|xxhash64] [-r 0|1]\n");
+		fprintf(stderr, "       enet_benchmark timers [-p peers]\n");
+		fprintf(stderr, "       enet_benchmark aggregate [-n rounds]\n");
+		fprintf(stderr, "       enet_benchmark pmtu [-n messages]\n");
+		fprintf(stderr, "       enet_benchmark crc [-n buffers]\n");
+		fprintf(stderr, "       enet_benchmark compress [-n datagrams]\n");
+		fprintf(stderr, "       enet_benchmark pool [-n packets]\n");
+		fprintf(stderr, "       enet_benchmark cipher [-n datagrams] [-l loss]\n");
+		fprintf(stderr, "       enet_benchmark pacing [-n messages]\n");
+	}
+
+	int main(int argc, char** argv) {
+		ENetBenchmarkSetup setup;
+		int i, lossy, timers, aggregate, pmtu, crc, compress, pool, cipher, pacing, result;
+
+		if (argc < 2 || (strcmp(argv[1], "loopback") != 0 && strcmp(argv[1], "lossy") != 0 && strcmp(argv[1], "timers") != 0 && strcmp(argv[1], "aggregate") != 0 && strcmp(argv[1], "pmtu") != 0 && strcmp(argv[1], "crc") != 0 && strcmp(argv[1], "compress") != 0 && strcmp(argv[1], "pool") != 0 && strcmp(argv[1], "cipher") != 0 && strcmp(argv[1], "pacing") != 0)) {
+			enet_benchmark_usage();
+
+			return 1;
+		}
+
+		lossy = strcmp(argv[1], "lossy") == 0;
+		timers = strcmp(argv[1], "timers") == 0;
+		aggregate = strcmp(argv[1], "aggregate") == 0;
+		pmtu = strcmp(argv[1], "pmtu") == 0;
+		crc = strcmp(argv[1], "crc") == 0;
+		compress = strcmp(argv[1], "compress") == 0;
+		pool = strcmp(argv[1], "pool") == 0;
+		cipher = strcmp(argv[1], "cipher") == 0;
+		pacing = strcmp(argv[1], "pacing") == 0;
+		setup.peers = 1000;
+		setup.ticks = 60;
+		setup.messages = lossy || aggregate || crc || compress || cipher ? 10000 : pmtu || pacing ? 100 : pool ? ENET_PACKET_POOL_HIGH_WATER_MARK : 1;
+		setup.size = 0;
+		setup.backend = ENET_HOST_BACKEND_POLL;
+		setup.loss = 10;
+		setup.threshold = 3;
+		setup.acknowledgementDelay = 0;
+		setup.congestion = ENET_CONGESTION_CONTROL_LEGACY;
+		setup.checksum = ENET_CHECKSUM_NONE;
+		setup.selective = 0;
+
+		for (i = 2; i + 1 < argc; i += 2) {
+			if ((lossy || cipher) && strcmp(argv[i], "-l") == 0) {
+				setup.loss = (uint32_t)atoi(argv[i + 1]);
+			} else if ((lossy || aggregate || pmtu || crc || compress || pool || cipher || pacing) && strcmp(argv[i], "-n") == 0) {
+				setup.messages = (size_t)atoi(argv[i + 1]);
+			} else if (lossy && strcmp(argv[i], "-s") == 0) {
+				setup.size = (size_t)atoi(argv[i + 1]);
+			} else if (lossy && strcmp(argv[i], "-a") == 0) {
+				setup.acknowledgementDelay = (uint32_t)atoi(argv[i + 1]);
+			} else if (lossy && strcmp(argv[i], "-f") == 0) {
+				setup.threshold = (uint32_t)atoi(argv[i + 1]);
+			} else if (lossy && strcmp(argv[i], "-c") == 0 && strcmp(argv[i + 1], "legacy") == 0) {
+				setup.congestion = ENET_CONGESTION_CONTROL_LEGACY;
+			} else if (lossy && strcmp(argv[i], "-c") == 0 && strcmp(argv[i + 1], "delay") == 0) {
+				setup.congestion = ENET_CONGESTION_CONTROL_DELAY;
+			} else if (lossy && strcmp(argv[i], "-c") == 0 && strcmp(argv[i + 1], "bbr") == 0) {
+				setup.congestion = ENET_CONGESTION_CONTROL_BBR;
+			} else if (lossy && strcmp(argv[i], "-r") == 0) {
+				setup.selective = atoi(argv[i + 1]) != 0;
+			} else if (lossy && strcmp(argv[i], "-k") == 0 && strcmp(argv[i + 1], "none") == 0) {
+				setup.checksum = ENET_CHECKSUM_NONE;
+			} else if (lossy && strcmp(argv[i], "-k") == 0 && strcmp(argv[i + 1], "crc64") == 0) {
+				setup.checksum = ENET_CHECKSUM_CRC64;
+			} else if (lossy && strcmp(argv[i], "-k") == 0 && strcmp(argv[i + 1], "crc32c") == 0) {
+				setup.checksum = ENET_CHECKSUM_CRC32C;
+			} else if (lossy && strcmp(argv[i], "-k") == 0 && strcmp(argv[i + 1], "xxhash64") == 0) {
+				setup.checksum = ENET_CHECKSUM_XXHASH64;
+			} else if (!lossy && !aggregate && !pmtu && !crc && !compress && !pool && !cipher && !pacing && strcmp(argv[i], "-p") == 0) {
+				setup.peers = (size_t)atoi(argv[i + 1]);
+			} else if (!lossy && !timers && !aggregate && !pmtu && !crc && !compress && !pool && !cipher && !pacing && strcmp(argv[i], "-t") == 0) {
+				setup.ticks = (size_t)atoi(argv[i + 1]);
+			} else if (!lossy && !timers && !aggregate && !pmtu && !crc && !compress && !pool && !cipher && !pacing && strcmp(argv[i], "-m") == 0) {
+				setup.messages = (size_t)atoi(argv[i + 1]);
+			} else if (!lossy && !timers && !aggregate && !pmtu && !crc && !compress && !pool && !cipher && !pacing && strcmp(argv[i], "-b") == 0 && strcmp(argv[i + 1], "poll") == 0) {
+				setup.backend = ENET_HOST_BACKEND_POLL;
+			} else if (!lossy && !timers && !aggregate && !pmtu && !crc && !compress && !pool && !cipher && !pacing && strcmp(argv[i], "-b") == 0 && strcmp(argv[i + 1], "uring") == 0) {
+				setup.backend = ENET_HOST_BACKEND_URING;
+			} else {
+				enet_benchmark_usage();
+
+				return 1;
+			}
+		}
+
+		if (i != argc || setup.peers == 0 || setup.peers > ENET_PROTOCOL_MAXIMUM_PEER_ID || setup.loss >= 100 || setup.threshold == 0) {
+			enet_benchmark_usage();
+
+			return 1;
+		}
+
+		/* The pool benchmark counts the blocks the library holds on the heap */
+		if (pool) {
+			ENetCallbacks callbacks;
+
+			callbacks.malloc = enet_benchmark_count_malloc;
+			callbacks.free = enet_benchmark_count_heap_free;
+			callbacks.noMemory = NULL;
+
+			result = enet_initialize_with_callbacks(ENET_VERSION, &callbacks);
+		} else {
+			result = enet_initialize();
+		}
+
+		if (result != 0) {
+			fprintf(stderr, "failed to initialize ENet\n");
+
+			return 1;
+		}
+
+		if (timers)
+			result = enet_benchmark_timers(&setup);
+		else if (aggregate)
+			result = enet_benchmark_aggregate(&setup);
+		else if (pmtu)
+			result = enet_benchmark_pmtu(&setup);
+		else if (crc)
+			result = enet_benchmark_crc(&setup);
+		else if (compress)
+			result = enet_benchmark_compress(&setup);
+		else if (pool)
+			result = enet_benchmark_pool(&setup);
+		else if (cipher)
+			result = enet_benchmark_cipher(&setup);
+		else if (pacing)
+			result = enet_benchmark_pacing(&setup);
+		else
+			result = lossy ? enet_benchmark_lossy(&setup) : enet_benchmark_loopback(&setup);
+
+		enet_deinitialize();
+
+		return result < 0 ? 1 : 0;
+	}
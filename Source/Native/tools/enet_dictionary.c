@@ -0,0 +1,543 @@
+/*
+ *  ENet reliable UDP networking library
+ *  Copyright (c) 2018 Lee Salzman, Vladyslav Hrytsenko, Dominik Madarász, Stanislav Denisov
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+/*
+ *  Builds a dictionary for enet_host_compress_with_lz4_dictionary from a pcap capture of ENet traffic.
+ *
+ *  enet_dictionary [-p port] [-c checksum bytes] [-s dictionary size] [-k segment size] capture.pcap dictionary.bin
+ *
+ *  The commands of every uncompressed datagram are used as a sample. Segments are picked the way the COVER
+ *  trainer does it: the samples are split into one epoch per segment and every epoch contributes the segment
+ *  whose distinct 8 byte strings occur in the most samples, strings that were already picked no longer count.
+ */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+	#define _GNU_SOURCE
+#endif
+
+#define ENET_IMPLEMENTATION
+#include "../enet.h"
+#include <stdio.h>
+
+#define ENET_DICTIONARY_DMER 8
+#define ENET_DICTIONARY_NO_DMER 0xFFFFFFFF
+
+	typedef struct _ENetSamples {
+		uint8_t* data;
+		size_t length;
+		size_t capacity;
+		size_t* offsets;
+		size_t count;
+		size_t offsetCapacity;
+	} ENetSamples;
+
+	typedef struct _ENetDmer {
+		uint64_t key;
+		uint32_t frequency;
+		uint32_t lastSample;
+		uint32_t active;
+		uint8_t used;
+	} ENetDmer;
+
+	static uint16_t read16(const uint8_t* data) {
+		return (uint16_t)((data[0] << 8) | data[1]);
+	}
+
+	static uint32_t read32(const uint8_t* data, int swapped) {
+		uint32_t value;
+
+		memcpy(&value, data, sizeof(value));
+
+		if (swapped)
+			value = (value >> 24) | ((value >> 8) & 0xFF00) | ((value << 8) & 0xFF0000) | (value << 24);
+
+		return value;
+	}
+
+	static uint8_t* read_file(const char* path, size_t* length) {
+		FILE* file = fopen(path, "rb");
+		uint8_t* data;
+		long size;
+
+		if (file == NULL)
+			return NULL;
+
+		if (fseek(file, 0, SEEK_END) != 0 || (size = ftell(file)) < 0 || fseek(file, 0, SEEK_SET) != 0) {
+			fclose(file);
+
+			return NULL;
+		}
+
+		data = (uint8_t*)malloc(size > 0 ? (size_t)size : 1);
+
+		if (data == NULL || fread(data, 1, (size_t)size, file) != (size_t)size) {
+			free(data);
+			fclose(file);
+
+			return NULL;
+		}
+
+		fclose(file);
+
+		*length = (size_t)size;
+
+		return data;
+	}
+
+	static int samples_add(ENetSamples* samples, const uint8_t* data, size_t length) {
+		if (samples->length + length > samples->capacity) {
+			size_t capacity = samples->capacity > 0 ? samples->capacity * 2 : 64 * 1024;
+			uint8_t* grown;
+
+			while (capacity < samples->length + length) {
+				capacity *= 2;
+			}
+
+			grown = (uint8_t*)realloc(samples->data, capacity);
+
+			if (grown == NULL)
+				return -1;
+
+			samples->data = grown;
+			samples->capacity = capacity;
+		}
+
+		if (samples->count + 1 >= samples->offsetCapacity) {
+			size_t capacity = samples->offsetCapacity > 0 ? samples->offsetCapacity * 2 : 1024;
+			size_t* grown = (size_t*)realloc(samples->offsets, capacity * sizeof(size_t));
+
+			if (grown == NULL)
+				return -1;
+
+			samples->offsets = grown;
+			samples->offsetCapacity = capacity;
+		}
+
+		memcpy(&samples->data[samples->length], data, length);
+
+		samples->offsets[samples->count++] = samples->length;
+		samples->length += length;
+		samples->offsets[samples->count] = samples->length;
+
+		return 0;
+	}
+
+	/* Returns the UDP payload of a captured frame, or NULL for anything else */
+	static const uint8_t* frame_payload(uint32_t linkType, const uint8_t* frame, size_t frameLength, int port, size_t* payloadLength) {
+		size_t offset, headerLength, udpLength;
+		uint8_t protocol;
+
+		switch (linkType) {
+			case 0:
+			case 108:
+				offset = 4;
+
+				break;
+
+			case 1:
+				offset = 14;
+
+				if (frameLength < offset)
+					return NULL;
+
+				while (frameLength >= offset && (read16(&frame[offset - 2]) == 0x8100 || read16(&frame[offset - 2]) == 0x88A8)) {
+					offset += 4;
+				}
+
+				break;
+
+			case 12:
+			case 14:
+			case 101:
+				offset = 0;
+
+				break;
+
+			case 113:
+				offset = 16;
+
+				break;
+
+			case 276:
+				offset = 20;
+
+				break;
+
+			default:
+				return NULL;
+		}
+
+		if (frameLength < offset + 1)
+			return NULL;
+
+		frame += offset;
+		frameLength -= offset;
+
+		if ((frame[0] >> 4) == 4) {
+			if (frameLength < 20)
+				return NULL;
+
+			headerLength = (size_t)(frame[0] & 0x0F) * 4;
+			protocol = frame[9];
+
+			/* Fragments are skipped, the capture rarely holds all of them */
+			if (headerLength < 20 || (read16(&frame[6]) & 0x3FFF) != 0)
+				return NULL;
+		} else if ((frame[0] >> 4) == 6) {
+			if (frameLength < 40)
+				return NULL;
+
+			headerLength = 40;
+			protocol = frame[6];
+
+			while (protocol == 0 || protocol == 43 || protocol == 60) {
+				if (frameLength < headerLength + 8)
+					return NULL;
+
+				protocol = frame[headerLength];
+				headerLength += ((size_t)frame[headerLength + 1] + 1) * 8;
+			}
+		} else {
+			return NULL;
+		}
+
+		if (protocol != 17 || frameLength < headerLength + 8)
+			return NULL;
+
+		frame += headerLength;
+		frameLength -= headerLength;
+
+		if (port != 0 && read16(&frame[0]) != port && read16(&frame[2]) != port)
+			return NULL;
+
+		udpLength = read16(&frame[4]);
+
+		if (udpLength < 8 || udpLength > frameLength)
+			return NULL;
+
+		*payloadLength = udpLength - 8;
+
+		return frame + 8;
+	}
+
+	static int load_capture(const char* path, int port, size_t checksumSize, ENetSamples* samples) {
+		size_t captureLength, offset = 24;
+		uint8_t* capture = read_file(path, &captureLength);
+		uint32_t magic, linkType;
+		int swapped;
+
+		if (capture == NULL) {
+			fprintf(stderr, "Unable to read %s\n", path);
+
+			return -1;
+		}
+
+		magic = captureLength >= 24 ? read32(capture, 0) : 0;
+
+		if (magic == 0xA1B2C3D4 || magic == 0xA1B23C4D) {
+			swapped = 0;
+		} else if (magic == 0xD4C3B2A1 || magic == 0x4D3CB2A1) {
+			swapped = 1;
+		} else {
+			fprintf(stderr, "%s is not a pcap capture, pcapng files can be converted with editcap -F pcap\n", path);
+			free(capture);
+
+			return -1;
+		}
+
+		linkType = read32(&capture[20], swapped) & 0xFFFF;
+
+		while (offset + 16 <= captureLength) {
+			size_t frameLength = read32(&capture[offset + 8], swapped), payloadLength = 0, headerSize;
+			const uint8_t* payload;
+
+			offset += 16;
+
+			if (frameLength > captureLength - offset)
+				break;
+
+			payload = frame_payload(linkType, &capture[offset], frameLength, port, &payloadLength);
+			offset += frameLength;
+
+			if (payload == NULL || payloadLength < 2)
+				continue;
+
+			/* Compressed datagrams carry nothing to learn from */
+			if (read16(payload) & ENET_PROTOCOL_HEADER_FLAG_COMPRESSED)
+				continue;
+
+			headerSize = (read16(payload) & ENET_PROTOCOL_HEADER_FLAG_SENT_TIME ? sizeof(ENetProtocolHeader) : (size_t)&((ENetProtocolHeader*)0)->sentTime) + checksumSize;
+
+			if (payloadLength <= headerSize || payloadLength - headerSize > ENET_PROTOCOL_MAXIMUM_MTU)
+				continue;
+
+			if (samples_add(samples, payload + headerSize, payloadLength - headerSize) < 0) {
+				free(capture);
+
+				return -1;
+			}
+		}
+
+		free(capture);
+
+		return 0;
+	}
+
+	static uint64_t dmer_key(const uint8_t* data) {
+		uint64_t key;
+
+		memcpy(&key, data, sizeof(key));
+
+		return key;
+	}
+
+	static size_t dmer_find(ENetDmer* dmers, size_t mask, uint64_t key) {
+		size_t slot = (size_t)((key * UINT64_C(0x9E3779B97F4A7C15)) >> 32) & mask;
+
+		while (dmers[slot].used && dmers[slot].key != key) {
+			slot = (slot + 1) & mask;
+		}
+
+		return slot;
+	}
+
+	/* Fills the dictionary from its end, so the best segments land where the trimmed tail of a dictionary is kept */
+	static size_t train(const ENetSamples* samples, uint8_t* dictionary, size_t dictionarySize, size_t segmentSize) {
+		size_t capacity = 1024, mask, position, epoch, epochs, epochSize, sample = 0, dictionaryLength = 0;
+		uint32_t* dmerIndex;
+		ENetDmer* dmers;
+
+		if (samples->length < segmentSize)
+			return 0;
+
+		while (capacity < samples->length * 2) {
+			capacity *= 2;
+		}
+
+		mask = capacity - 1;
+		dmers = (ENetDmer*)calloc(capacity, sizeof(ENetDmer));
+		dmerIndex = (uint32_t*)malloc(samples->length * sizeof(uint32_t));
+
+		if (dmers == NULL || dmerIndex == NULL) {
+			free(dmers);
+			free(dmerIndex);
+
+			return 0;
+		}
+
+		/* Frequencies count the samples a string occurs in, not its occurrences */
+		for (position = 0; position < samples->length; ++position) {
+			size_t slot;
+
+			while (position >= samples->offsets[sample + 1]) {
+				++sample;
+			}
+
+			if (position + ENET_DICTIONARY_DMER > samples->offsets[sample + 1]) {
+				dmerIndex[position] = ENET_DICTIONARY_NO_DMER;
+
+				continue;
+			}
+
+			slot = dmer_find(dmers, mask, dmer_key(&samples->data[position]));
+
+			if (!dmers[slot].used) {
+				dmers[slot].used = 1;
+				dmers[slot].key = dmer_key(&samples->data[position]);
+				dmers[slot].lastSample = (uint32_t)sample;
+				dmers[slot].frequency = 1;
+			} else if (dmers[slot].lastSample != (uint32_t)sample) {
+				dmers[slot].lastSample = (uint32_t)sample;
+				dmers[slot].frequency++;
+			}
+
+			dmerIndex[position] = (uint32_t)slot;
+		}
+
+		epochs = dictionarySize / segmentSize;
+		epochSize = samples->length / (epochs > 0 ? epochs : 1);
+
+		if (epochSize < segmentSize) {
+			epochs = samples->length / segmentSize;
+			epochSize = segmentSize;
+		}
+
+		for (epoch = 0; epoch < epochs && dictionaryLength + segmentSize <= dictionarySize; ++epoch) {
+			size_t begin = epoch * epochSize, end = ENET_MIN(begin + epochSize, samples->length), best = begin, window = segmentSize - ENET_DICTIONARY_DMER + 1;
+			uint64_t score = 0, bestScore = 0;
+
+			/* The window slides over the epoch and scores the distinct strings it covers */
+			for (position = begin; position < end; ++position) {
+				uint32_t slot = dmerIndex[position];
+
+				if (slot != ENET_DICTIONARY_NO_DMER && dmers[slot].active++ == 0)
+					score += dmers[slot].frequency;
+
+				if (position >= begin + window) {
+					slot = dmerIndex[position - window];
+
+					if (slot != ENET_DICTIONARY_NO_DMER && --dmers[slot].active == 0)
+						score -= dmers[slot].frequency;
+				}
+
+				if (position + 1 >= begin + window && position + ENET_DICTIONARY_DMER <= samples->length && score > bestScore) {
+					bestScore = score;
+					best = position + 1 - window;
+				}
+			}
+
+			for (position = (end > begin + window ? end - window : begin); position < end; ++position) {
+				if (dmerIndex[position] != ENET_DICTIONARY_NO_DMER)
+					dmers[dmerIndex[position]].active--;
+			}
+
+			if (bestScore == 0)
+				continue;
+
+			for (position = best; position < best + window; ++position) {
+				if (dmerIndex[position] != ENET_DICTIONARY_NO_DMER)
+					dmers[dmerIndex[position]].frequency = 0;
+			}
+
+			dictionaryLength += segmentSize;
+
+			memcpy(&dictionary[dictionarySize - dictionaryLength], &samples->data[best], segmentSize);
+		}
+
+		memmove(dictionary, &dictionary[dictionarySize - dictionaryLength], dictionaryLength);
+
+		free(dmers);
+		free(dmerIndex);
+
+		return dictionaryLength;
+	}
+
+	static size_t compressed_size(void* context, const ENetSamples* samples) {
+		uint8_t output[ENET_PROTOCOL_MAXIMUM_MTU];
+		size_t sample, total = 0;
+
+		for (sample = 0; sample < samples->count; ++sample) {
+			ENetBuffer buffer;
+			size_t length = samples->offsets[sample + 1] - samples->offsets[sample], compressedLength;
+
+			buffer.data = &samples->data[samples->offsets[sample]];
+			buffer.dataLength = length;
+			compressedLength = enet_lz4_compress(context, &buffer, 1, length, output, length);
+			total += compressedLength > 0 && compressedLength < length ? compressedLength : length;
+		}
+
+		return total;
+	}
+
+	static int usage(void) {
+		fprintf(stderr, "Usage: enet_dictionary [-p port] [-c checksum bytes] [-s dictionary size] [-k segment size] capture.pcap dictionary.bin\n");
+
+		return 1;
+	}
+
+	int main(int argc, char** argv) {
+		ENetSamples samples = { 0 };
+		size_t checksumSize = 0, dictionarySize = 16 * 1024, segmentSize = 64, dictionaryLength;
+		uint8_t* dictionary;
+		void* context;
+		FILE* file;
+		int port = 0, i;
+
+		for (i = 1; i + 1 < argc && argv[i][0] == '-'; i += 2) {
+			switch (argv[i][1]) {
+				case 'p':
+					port = atoi(argv[i + 1]);
+
+					break;
+
+				case 'c':
+					checksumSize = (size_t)atoi(argv[i + 1]);
+
+					break;
+
+				case 's':
+					dictionarySize = (size_t)atoi(argv[i + 1]);
+
+					break;
+
+				case 'k':
+					segmentSize = (size_t)atoi(argv[i + 1]);
+
+					break;
+
+				default:
+					return usage();
+			}
+		}
+
+		if (argc - i != 2 || (checksumSize != 0 && checksumSize != 4 && checksumSize != 8) || dictionarySize == 0 || dictionarySize > ENET_HOST_DICTIONARY_MAXIMUM || segmentSize < ENET_DICTIONARY_DMER || segmentSize > dictionarySize)
+			return usage();
+
+		if (load_capture(argv[i], port, checksumSize, &samples) < 0)
+			return 1;
+
+		if (samples.count == 0) {
+			fprintf(stderr, "No ENet datagrams found in %s\n", argv[i]);
+
+			return 1;
+		}
+
+		dictionary = (uint8_t*)malloc(dictionarySize);
+		context = enet_lz4_create();
+
+		if (dictionary == NULL || context == NULL)
+			return 1;
+
+		dictionaryLength = train(&samples, dictionary, dictionarySize, segmentSize);
+
+		if (dictionaryLength == 0) {
+			fprintf(stderr, "Not enough data to build a dictionary\n");
+
+			return 1;
+		}
+
+		file = fopen(argv[i + 1], "wb");
+
+		if (file == NULL || fwrite(dictionary, 1, dictionaryLength, file) != dictionaryLength) {
+			fprintf(stderr, "Unable to write %s\n", argv[i + 1]);
+
+			return 1;
+		}
+
+		fclose(file);
+
+		printf("Samples: %lu datagrams, %lu bytes\n", (unsigned long)samples.count, (unsigned long)samples.length);
+		printf("Without dictionary: %lu bytes\n", (unsigned long)compressed_size(context, &samples));
+
+		enet_lz4_set_dictionary(context, dictionary, dictionaryLength);
+
+		printf("With dictionary: %lu bytes\n", (unsigned long)compressed_size(context, &samples));
+		printf("Dictionary: %lu bytes, ID %u\n", (unsigned long)dictionaryLength, (unsigned int)enet_lz4_dictionary_id(dictionary, dictionaryLength));
+
+		enet_lz4_destroy(context);
+		free(dictionary);
+		free(samples.data);
+		free(samples.offsets);
+
+		return 0;
+	}